@@ -130,6 +130,10 @@ typedef can_timestamp_t CANAPI_Timestamp_t;
 //
 typedef can_message_t CANAPI_Message_t;
 
+/// \brief  CAN Event (with Time-stamp)
+//
+typedef can_event_t CANAPI_Event_t;
+
 /// \brief  CAN Device handle (internally)
 //
 typedef int CANAPI_Handle_t;
@@ -266,6 +266,14 @@ extern "C" {
 #define CANSTAT_QUE_OVR           0x01U /**< CAN status: event-queue overrun */
 /** @} */
 
+/** @name  CAN Event Types
+ *  @brief Events reported by the CAN controller (see can_event_t)
+ *  @{ */
+#define CANEVT_BUS_STATE          0x01U /**< CAN event: bus state changed (warning, passive, busoff) */
+#define CANEVT_ERR_FRAME          0x02U /**< CAN event: error frame (error counters) */
+#define CANEVT_OVERRUN            0x04U /**< CAN event: message lost (receive overrun) */
+/** @} */
+
 /** @name  Board Test Codes
  *  @brief Results of the board test
  *  @{ */
@@ -533,6 +541,17 @@ typedef struct can_message_t_ {
     can_timestamp_t timestamp;          /**< time-stamp { sec, nsec } */
 } can_message_t;
 
+/** @brief       CAN Event (with Time-stamp):
+ */
+typedef struct can_event_t_ {
+    uint8_t type;                       /**< event type (CANEVT_xyz) */
+    uint8_t status;                     /**< status register after the event */
+    uint8_t rx_err;                     /**< receive error counter (error frames) */
+    uint8_t tx_err;                     /**< transmit error counter (error frames) */
+    uint32_t flags;                     /**< vendor-specific event flags */
+    can_timestamp_t timestamp;          /**< time-stamp { sec, nsec } */
+} can_event_t;
+
 
 #ifdef __cplusplus
 }
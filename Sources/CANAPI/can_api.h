@@ -352,6 +352,63 @@ CANAPI int can_write(int handle, const can_message_t *message, uint16_t timeout)
 CANAPI int can_read(int handle, can_message_t *message, uint16_t timeout);
 
 
+/** @brief       reads up to 'count' events (bus state changes, error frames
+ *               and overruns) from the event queue of the CAN interface.
+ *
+ *  @note        Events are recorded by can_read() while it reads the receive
+ *               queue, in the order they were received (with time-stamp).
+ *               No additional request is made to the CAN interface. When the
+ *               event queue is full, new events are discarded and the status
+ *               bit 'queue_overrun' is set until the queue has been read.
+ *
+ *  @param[in]   handle  - handle of the CAN interface
+ *  @param[out]  events  - array of 'count' events
+ *  @param[in]   count   - maximum number of events to be read
+ *
+ *  @returns     the number of events read (0 if the queue is empty), or
+ *               a negative value on error.
+ *
+ *  @retval      CANERR_NOTINIT   - library not initialized
+ *  @retval      CANERR_HANDLE    - invalid interface handle
+ *  @retval      CANERR_NULLPTR   - null-pointer assignment
+ *  @retval      CANERR_NOTSUPP   - function not supported
+ *  @retval      others           - vendor-specific
+ */
+CANAPI int can_event(int handle, can_event_t *events, uint16_t count);
+
+
+/** @brief       waits until one or more of the given CAN interfaces have
+ *               received messages, or until the time-out has expired.
+ *
+ *  @note        A handle is reported as ready when messages have arrived
+ *               since its receive queue was last found empty; read it with
+ *               can_read(handle, msg, 0) until CANERR_RX_EMPTY is returned.
+ *               A handle can be reported ready without any message pending
+ *               (e.g. after can_kill).
+ *
+ *  @param[in]   handles - array of 'n' handles of CAN interfaces
+ *  @param[in]   n       - number of handles (1 .. 32)
+ *  @param[in]   timeout - time to wait for the reception of a message:
+ *                              0 means the function returns immediately,
+ *                              65535 means blocking read, and any other
+ *                              value means the time to wait in milliseconds
+ *  @param[out]  ready_mask - bit i is set when handles[i] is ready
+ *
+ *  @returns     the number of ready handles (0 on time-out), or a negative
+ *               value on error.
+ *
+ *  @retval      CANERR_NOTINIT   - library not initialized
+ *  @retval      CANERR_HANDLE    - invalid interface handle
+ *  @retval      CANERR_NULLPTR   - null-pointer assignment
+ *  @retval      CANERR_ILLPARA   - illegal number of handles, or a handle
+ *                                 given more than once
+ *  @retval      CANERR_OFFLINE   - interface not started
+ *  @retval      CANERR_NOTSUPP   - function not supported
+ *  @retval      others           - vendor-specific
+ */
+CANAPI int can_select(const int *handles, size_t n, uint16_t timeout, uint32_t *ready_mask);
+
+
 /** @brief       retrieves the status register of the CAN interface.
  *
  *  @param[in]   handle  - handle of the CAN interface.
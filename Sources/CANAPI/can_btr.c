@@ -82,6 +82,8 @@
 #include <assert.h>
 #if defined(_WIN32) || defined(_WIN64)
 #include <windows.h>
+#else
+#include <pthread.h>
 #endif
 
 /*  -----------  defines  ------------------------------------------------
@@ -94,6 +96,32 @@
 
 #define BTR_SJA1000_MAX_INDEX   10
 
+#define BTR_SAMPLEPOINT_DEFAULT 0.8f    // sample-point when not specified
+#define BTR_EPSILON_SPEED       1.0e-9  // bit-rate deviations below are equal
+#define BTR_EPSILON_SP          1.0e-6  // sample-point deviations below are equal
+
+#ifndef OPTION_CANBTR_CACHE_SIZE
+#define BTR_CACHE_SIZE          8       // last N string conversions
+#else
+#define BTR_CACHE_SIZE          OPTION_CANBTR_CACHE_SIZE
+#endif
+#define BTR_HASH_INIT           0x811C9DC5U  // FNV-1a offset basis
+#define BTR_HASH_PRIME          0x01000193U  // FNV-1a prime
+
+#define BTR_KEY_UNKNOWN         (-1)
+#define BTR_KEY_F_CLOCK         0
+#define BTR_KEY_F_CLOCK_MHZ     1
+#define BTR_KEY_NOM_BRP         2
+#define BTR_KEY_NOM_TSEG1       3
+#define BTR_KEY_NOM_TSEG2       4
+#define BTR_KEY_NOM_SJW         5
+#define BTR_KEY_NOM_SAM         6
+#define BTR_KEY_DATA_BRP        7
+#define BTR_KEY_DATA_TSEG1      8
+#define BTR_KEY_DATA_TSEG2      9
+#define BTR_KEY_DATA_SJW        10
+#define BTR_KEY_DATA_SSP_OFFSET 11
+
 /*  - - - - - -  helper macros   - - - - - - - - - - - - - - - - - - - - -
  */
 #define BTR_SJW(btr0btr1)       (((uint16_t)(btr0btr1) & 0xC000u) >> 14)
@@ -107,15 +135,53 @@
                                  (((uint16_t)(sam) & 0x0001) << 7)   | \
                                  (((uint16_t)(tseg2) & 0x0007) << 4) | \
                                  (((uint16_t)(tseg1) & 0x000F) << 0))
-#ifdef _MSC_VER
-//not #if defined(_WIN32) || defined(_WIN64) because we have strncasecmp in mingw
-#define strncasecmp _strnicmp
-#define strcasecmp _stricmp
+#define BTR_HASH_STEP(hash,chr) (((hash) ^ (uint32_t)(uint8_t)(chr)) * BTR_HASH_PRIME)
+#define TO_LOWER(chr)           ((('A' <= (chr)) && ((chr) <= 'Z')) ? ((chr) + ('a' - 'A')) : (chr))
+#define IS_KEY_CHAR(chr)        ((('a' <= (chr)) && ((chr) <= 'z')) || (('A' <= (chr)) && ((chr) <= 'Z')) || \
+                                 (('0' <= (chr)) && ((chr) <= '9')) || ((chr) == '_'))
+#if (BTR_CACHE_SIZE != 0)
+#if defined(_WIN32) || defined(_WIN64)
+#define CACHE_LOCK()            AcquireSRWLockExclusive(&cache.lock)
+#define CACHE_UNLOCK()          ReleaseSRWLockExclusive(&cache.lock)
+#else
+#define CACHE_LOCK()            pthread_mutex_lock(&cache.lock)
+#define CACHE_UNLOCK()          pthread_mutex_unlock(&cache.lock)
+#endif
 #endif
 
 /*  -----------  types  --------------------------------------------------
  */
 
+typedef struct btr_limits_t_ {          // bit-timing limits:
+    uint16_t brp_min, brp_max;          //   bit-rate prescaler
+    uint16_t tseg1_min, tseg1_max;      //   time segment 1
+    uint16_t tseg2_min, tseg2_max;      //   time segment 2
+    uint16_t sjw_min, sjw_max;          //   synchronization jump width
+} btr_limits_t;
+
+typedef struct btr_timing_t_ {          // bit-timing candidate:
+    uint16_t brp, tseg1, tseg2, sjw;    //   register settings
+    double error;                       //   bit-rate deviation (relative)
+    double sp_error;                    //   sample-point deviation (absolute)
+    double tolerance;                   //   oscillator tolerance (relative)
+} btr_timing_t;
+
+typedef struct btr_keyword_t_ {         // keyword of the bit-rate string:
+    const char *name;                   //   key (lower case)
+    size_t length;                      //   length of the key
+    uint32_t hash;                      //   FNV-1a hash of the key
+    int id;                             //   key identifier
+} btr_keyword_t;
+
+#if (BTR_CACHE_SIZE != 0)
+typedef struct btr_cache_entry_t_ {     // cached string conversion:
+    uint32_t stamp;                     //   LRU stamp (0 = unused)
+    uint32_t hash;                      //   FNV-1a hash of the string
+    bool brse;                          //   bit-rate switch enabled
+    btr_bitrate_t bitrate;              //   bit-rate settings
+    char string[BTR_STRING_LENGTH];     //   bit-rate string
+} btr_cache_entry_t;
+#endif
 
 /*  -----------  prototypes  ---------------------------------------------
  */
@@ -123,9 +189,23 @@
 static int print_bitrate(const btr_bitrate_t *bitrate, bool brse, btr_string_t string);
 static int scan_bitrate(const btr_string_t string, btr_bitrate_t *bitrate, bool *brse);
 
-static char *scan_key(char *str);
-static char *scan_value(char *str);
-static char *skip_blanks(char *str);
+static int solve_timing(int32_t frequency, float speed, float samplepoint,
+                        const btr_limits_t *limits, btr_timing_t *timing);
+static bool better_timing(const btr_timing_t *candidate, const btr_timing_t *best);
+static float norm_samplepoint(float samplepoint);
+static const char *scan_speed(const char *str, float *speed);
+static const char *scan_samplepoint(const char *str, float *samplepoint);
+static const char *skip_spaces(const char *str);
+
+static bool print_value(char *string, size_t *pos, const char *key, uint32_t value);
+static int lookup_key(const char *key, size_t length, uint32_t hash);
+#if (BTR_CACHE_SIZE != 0)
+static uint32_t hash_string(const char *string, size_t *length);
+static bool cache_string2bitrate(const char *string, uint32_t hash, btr_bitrate_t *bitrate, bool *brse);
+static bool cache_bitrate2string(const btr_bitrate_t *bitrate, bool brse, char *string);
+static void cache_insert(btr_cache_entry_t *table, const char *string, uint32_t hash, const btr_bitrate_t *bitrate, bool brse);
+static bool same_bitrate(const btr_bitrate_t *a, const btr_bitrate_t *b);
+#endif
 
 
 /*  -----------  variables  ----------------------------------------------
@@ -144,6 +224,56 @@ static const btr_sja1000_t sja1000_btr0btr1[BTR_SJA1000_MAX_INDEX] = {
     0x7F7FU   //    5 kbps (SP=68.0%, SJW=2)
 };
 
+static const btr_keyword_t keywords[] = {
+    { "f_clock",         7, 0x67B5488CU, BTR_KEY_F_CLOCK },
+    { "f_clock_mhz",    11, 0x516838A2U, BTR_KEY_F_CLOCK_MHZ },
+    { "nom_brp",         7, 0x775ED626U, BTR_KEY_NOM_BRP },
+    { "nom_tseg1",       9, 0xC21DA076U, BTR_KEY_NOM_TSEG1 },
+    { "nom_tseg2",       9, 0xC11D9EE3U, BTR_KEY_NOM_TSEG2 },
+    { "nom_sjw",         7, 0x19ABD4D0U, BTR_KEY_NOM_SJW },
+    { "nom_sam",         7, 0x139A823DU, BTR_KEY_NOM_SAM },
+    { "data_brp",        8, 0xBE44D7B6U, BTR_KEY_DATA_BRP },
+    { "data_tseg1",     10, 0xA20AE626U, BTR_KEY_DATA_TSEG1 },
+    { "data_tseg2",     10, 0xA10AE493U, BTR_KEY_DATA_TSEG2 },
+    { "data_sjw",        8, 0xFB3B90E0U, BTR_KEY_DATA_SJW },
+    { "data_ssp_offset",15, 0x0AB67F9EU, BTR_KEY_DATA_SSP_OFFSET }
+};
+
+#if (BTR_CACHE_SIZE != 0)
+static struct {                         // cache of the last conversions:
+    btr_cache_entry_t string2bitrate[BTR_CACHE_SIZE];
+    btr_cache_entry_t bitrate2string[BTR_CACHE_SIZE];
+    uint32_t clock;                     //   LRU clock
+#if defined(_WIN32) || defined(_WIN64)
+    SRWLOCK lock;                       //   slim reader/writer lock
+} cache = { {{0}}, {{0}}, 0U, SRWLOCK_INIT };
+#else
+    pthread_mutex_t lock;               //   mutex
+} cache = { {{0}}, {{0}}, 0U, PTHREAD_MUTEX_INITIALIZER };
+#endif
+#endif
+
+static const btr_limits_t nominal_limits = {
+    BTR_NOMINAL_BRP_MIN, BTR_NOMINAL_BRP_MAX,
+    BTR_NOMINAL_TSEG1_MIN, BTR_NOMINAL_TSEG1_MAX,
+    BTR_NOMINAL_TSEG2_MIN, BTR_NOMINAL_TSEG2_MAX,
+    BTR_NOMINAL_SJW_MIN, BTR_NOMINAL_SJW_MAX
+};
+#if (OPTION_CAN_2_0_ONLY == 0)
+static const btr_limits_t data_limits = {
+    BTR_DATA_BRP_MIN, BTR_DATA_BRP_MAX,
+    BTR_DATA_TSEG1_MIN, BTR_DATA_TSEG1_MAX,
+    BTR_DATA_TSEG2_MIN, BTR_DATA_TSEG2_MAX,
+    BTR_DATA_SJW_MIN, BTR_DATA_SJW_MAX
+};
+#endif
+static const btr_limits_t sja1000_limits = {
+    BTR_SJA1000_BRP_MIN, BTR_SJA1000_BRP_MAX,
+    BTR_SJA1000_TSEG1_MIN, BTR_SJA1000_TSEG1_MAX,
+    BTR_SJA1000_TSEG2_MIN, BTR_SJA1000_TSEG2_MAX,
+    BTR_SJA1000_SJW_MIN, BTR_SJA1000_SJW_MAX
+};
+
 /*  -----------  functions  ----------------------------------------------
  */
 
@@ -223,12 +353,75 @@ int btr_bitrate2speed(const btr_bitrate_t *bitrate, bool fdoe, bool brse, btr_sp
 
 int btr_speed2bitrate(const btr_speed_t *speed, btr_bitrate_t *bitrate)
 {
+    const btr_limits_t *limits = &nominal_limits;
+    btr_timing_t nominal;               // best nominal bit-timing
+#if (OPTION_CAN_2_0_ONLY == 0)
+    btr_limits_t same_brp;              // data limits with nominal BRP
+    btr_timing_t data;                  // best data bit-timing
+    bool fdoe = speed ? speed->nominal.fdoe : false;
+    bool brse = speed ? speed->data.brse : false;
+#else
+    bool fdoe = false;
+#endif
+    int32_t frequency;                  // clock domain (in [Hz])
+    int rc = BTRERR_FATAL;              // return value
+
     if(!bitrate || !speed)              // check for null-pointer
         return BTRERR_NULLPTR;
 
-    /* note: there could be serveral settings to match the speed! */
+    /* note: there could be serveral settings to match the speed, so we take
+     *       the frequency from the given bit-rate settings (or a default one)
+     *       and search for the best settings within the register limits.
+     */
+    if(bitrate->btr.frequency > 0)
+        frequency = bitrate->btr.frequency;
+    else
+        frequency = fdoe ? BTR_FREQ_80MHz : BTR_FREQ_SJA1000;
+    if(((uint32_t)frequency < BTR_FREQUENCY_MIN) || (BTR_FREQUENCY_MAX < (uint32_t)frequency))
+        return BTRERR_BAUDRATE;
+    if((frequency == BTR_FREQ_SJA1000) && !fdoe)
+        limits = &sja1000_limits;       //   CAN 2.0 with SJA1000 registers
 
-    return BTRERR_NOTSUPP;              // sorry, not realized yet!
+    /* nominal bit-rate */
+    if((speed->nominal.speed < BTR_NOMINAL_SPEED_MIN) || (BTR_NOMINAL_SPEED_MAX < speed->nominal.speed))
+        return BTRERR_BAUDRATE;
+    if((rc = solve_timing(frequency, speed->nominal.speed, norm_samplepoint(speed->nominal.samplepoint),
+                          limits, &nominal)) != BTRERR_NOERROR)
+        return rc;
+#if (OPTION_CAN_2_0_ONLY == 0)
+    /* data bit-rate (CAN FD only) */
+    if(fdoe && brse) {
+        if((speed->data.speed < BTR_DATA_SPEED_MIN) || (BTR_DATA_SPEED_MAX < speed->data.speed))
+            return BTRERR_BAUDRATE;
+        /* note: the same prescaler in both phases is recommended by CiA 601-3 */
+        memcpy(&same_brp, &data_limits, sizeof(btr_limits_t));
+        same_brp.brp_min = same_brp.brp_max = nominal.brp;
+        if((nominal.brp > data_limits.brp_max) ||
+           (solve_timing(frequency, speed->data.speed, norm_samplepoint(speed->data.samplepoint),
+                         &same_brp, &data) != BTRERR_NOERROR) ||
+           (data.error > BTR_EPSILON_SPEED)) {
+            if((rc = solve_timing(frequency, speed->data.speed, norm_samplepoint(speed->data.samplepoint),
+                                  &data_limits, &data)) != BTRERR_NOERROR)
+                return rc;
+        }
+    }
+#endif
+    memset(bitrate, 0, sizeof(btr_bitrate_t));
+    bitrate->btr.frequency = frequency;
+    bitrate->btr.nominal.brp = nominal.brp;
+    bitrate->btr.nominal.tseg1 = nominal.tseg1;
+    bitrate->btr.nominal.tseg2 = nominal.tseg2;
+    bitrate->btr.nominal.sjw = nominal.sjw;
+    bitrate->btr.nominal.sam = 0u;      // sample once
+#if (OPTION_CAN_2_0_ONLY == 0)
+    if(fdoe && brse) {                  // data settings only when brse flag
+        bitrate->btr.data.brp = data.brp;
+        bitrate->btr.data.tseg1 = data.tseg1;
+        bitrate->btr.data.tseg2 = data.tseg2;
+        bitrate->btr.data.sjw = data.sjw;
+    }
+#endif
+    return BTRERR_NOERROR;
 }
 
 int btr_index2bitrate(const btr_index_t index, btr_bitrate_t *bitrate)
@@ -274,10 +467,34 @@ int btr_bitrate2index(const btr_bitrate_t *bitrate, btr_index_t *index)
 
 int btr_string2bitrate(const btr_string_t string, btr_bitrate_t *bitrate, bool *brse)
 {
+    int rc = BTRERR_FATAL;              // return value
+#if (BTR_CACHE_SIZE != 0)
+    uint32_t hash;                      // hash of the string
+    size_t length;                      // length of the string
+#endif
     if(!bitrate || !string || !brse)    // check for null-pointer
         return BTRERR_NULLPTR;
 
-    return scan_bitrate(string, bitrate, brse);
+#if (BTR_CACHE_SIZE != 0)
+    /* look in the cache of the last conversions first */
+    hash = hash_string(string, &length);
+    if(length >= BTR_STRING_LENGTH)
+        return BTRERR_BAUDRATE;
+    CACHE_LOCK();
+    if(cache_string2bitrate(string, hash, bitrate, brse)) {
+        CACHE_UNLOCK();
+        return BTRERR_NOERROR;
+    }
+    CACHE_UNLOCK();
+#endif
+    if((rc = scan_bitrate(string, bitrate, brse)) != BTRERR_NOERROR)
+        return rc;
+#if (BTR_CACHE_SIZE != 0)
+    CACHE_LOCK();
+    cache_insert(cache.string2bitrate, string, hash, bitrate, *brse);
+    CACHE_UNLOCK();
+#endif
+    return BTRERR_NOERROR;
 }
 
 int btr_bitrate2string(const btr_bitrate_t *bitrate, bool brse, btr_string_t string)
@@ -326,7 +543,23 @@ int btr_bitrate2string(const btr_bitrate_t *bitrate, bool brse, btr_string_t str
         temporary.btr.data.sjw = temporary.btr.nominal.sjw;
     }
 #endif
-    return print_bitrate(&temporary, data, string);
+#if (BTR_CACHE_SIZE != 0)
+    /* look in the cache of the last conversions first */
+    CACHE_LOCK();
+    if(cache_bitrate2string(&temporary, data, string)) {
+        CACHE_UNLOCK();
+        return BTRERR_NOERROR;
+    }
+    CACHE_UNLOCK();
+#endif
+    if((rc = print_bitrate(&temporary, data, string)) != BTRERR_NOERROR)
+        return rc;
+#if (BTR_CACHE_SIZE != 0)
+    CACHE_LOCK();
+    cache_insert(cache.bitrate2string, string, 0U, &temporary, data);
+    CACHE_UNLOCK();
+#endif
+    return BTRERR_NOERROR;
 }
 
 int btr_sja10002bitrate(const btr_sja1000_t btr0btr1, btr_bitrate_t *bitrate)
@@ -398,113 +631,173 @@ int btr_index2sja1000(const btr_index_t index, btr_sja1000_t *btr0btr1)
     return rc;
 }
 
+int btr_string2speed(const btr_string_t string, btr_speed_t *speed)
+{
+    btr_speed_t temporary;              // bus speed
+    const char *ptr;                    // string pointer
+    bool data = false;                  // data bit-rate given
+
+    if(!string || !speed)               // check for null-pointer
+        return BTRERR_NULLPTR;
+
+    memset(&temporary, 0, sizeof(btr_speed_t));
+
+    /* syntax: <nom_speed> ['/' <data_speed>] ['@' <nom_sp> ['/' <data_sp>]] */
+    if(!(ptr = scan_speed(string, &temporary.nominal.speed)))
+        return BTRERR_BAUDRATE;
+    if(*ptr == '/') {
+        if(!(ptr = scan_speed(ptr + 1, &temporary.data.speed)))
+            return BTRERR_BAUDRATE;
+        data = true;
+    }
+    if(*ptr == '@') {
+        if(!(ptr = scan_samplepoint(ptr + 1, &temporary.nominal.samplepoint)))
+            return BTRERR_BAUDRATE;
+        if(*ptr == '/') {
+            if(!data || !(ptr = scan_samplepoint(ptr + 1, &temporary.data.samplepoint)))
+                return BTRERR_BAUDRATE;
+        }
+        else
+            temporary.data.samplepoint = temporary.nominal.samplepoint;
+    }
+    else {
+        temporary.nominal.samplepoint = BTR_SAMPLEPOINT_DEFAULT;
+        temporary.data.samplepoint = BTR_SAMPLEPOINT_DEFAULT;
+    }
+    if(*ptr != '\0')                    // trailing garbage
+        return BTRERR_BAUDRATE;
+
+    if((temporary.nominal.speed < BTR_NOMINAL_SPEED_MIN) || (BTR_NOMINAL_SPEED_MAX < temporary.nominal.speed))
+        return BTRERR_BAUDRATE;
+    if((temporary.nominal.samplepoint < BTR_NOMINAL_SP_MIN) || (BTR_NOMINAL_SP_MAX < temporary.nominal.samplepoint))
+        return BTRERR_BAUDRATE;
+#if (OPTION_CAN_2_0_ONLY == 0)
+    if(data) {
+        if((temporary.data.speed < BTR_DATA_SPEED_MIN) || (BTR_DATA_SPEED_MAX < temporary.data.speed))
+            return BTRERR_BAUDRATE;
+        if((temporary.data.samplepoint < BTR_DATA_SP_MIN) || (BTR_DATA_SP_MAX < temporary.data.samplepoint))
+            return BTRERR_BAUDRATE;
+        temporary.nominal.fdoe = true;
+        temporary.data.brse = true;
+    }
+    else {
+        temporary.data.speed = temporary.nominal.speed;
+    }
+#else
+    if(data)                            // no CAN FD, no data bit-rate
+        return BTRERR_BAUDRATE;
+#endif
+    memcpy(speed, &temporary, sizeof(btr_speed_t));
+
+    return BTRERR_NOERROR;
+}
+
 /*  -----------  local functions  ----------------------------------------
  */
 
 static int print_bitrate(const btr_bitrate_t *bitrate, bool brse, btr_string_t string)
 {
+    size_t pos = 0;                     // string position
+
     assert(bitrate && string);          // just to make sure
 
     /* note: all fields have been checked for their limits before */
 
+    string[0] = '\0';
+    if(!print_value(string, &pos, "f_clock=", (uint32_t)bitrate->btr.frequency) ||
+       !print_value(string, &pos, ",nom_brp=", bitrate->btr.nominal.brp) ||
+       !print_value(string, &pos, ",nom_tseg1=", bitrate->btr.nominal.tseg1) ||
+       !print_value(string, &pos, ",nom_tseg2=", bitrate->btr.nominal.tseg2) ||
+       !print_value(string, &pos, ",nom_sjw=", bitrate->btr.nominal.sjw))
+        return BTRERR_BAUDRATE;
     if(bitrate->btr.frequency == BTR_FREQ_SJA1000) { // CAN 2.0
-        if(sprintf(string, "f_clock=%i,nom_brp=%u,nom_tseg1=%u,nom_tseg2=%u,nom_sjw=%u,nom_sam=%u",
-                   bitrate->btr.frequency,
-                   bitrate->btr.nominal.brp,
-                   bitrate->btr.nominal.tseg1,
-                   bitrate->btr.nominal.tseg2,
-                   bitrate->btr.nominal.sjw,
-                   bitrate->btr.nominal.sam) < 0)
-                   return BTRERR_BAUDRATE;
-    }
-#if (OPTION_CAN_2_0_ONLY == 0)
-    else if(!brse) {                    // CAN FD: long frames only
-        if(sprintf(string, "f_clock=%i,nom_brp=%u,nom_tseg1=%u,nom_tseg2=%u,nom_sjw=%u",
-                   bitrate->btr.frequency,
-                   bitrate->btr.nominal.brp,
-                   bitrate->btr.nominal.tseg1,
-                   bitrate->btr.nominal.tseg2,
-                   bitrate->btr.nominal.sjw) < 0)
+        if(!print_value(string, &pos, ",nom_sam=", bitrate->btr.nominal.sam))
             return BTRERR_BAUDRATE;
     }
-    else {                              // CAN FD: long and fast frames
-        if(sprintf(string, "f_clock=%i,nom_brp=%u,nom_tseg1=%u,nom_tseg2=%u,nom_sjw=%u,"
-                                     "data_brp=%u,data_tseg1=%u,data_tseg2=%u,data_sjw=%u",
-                   bitrate->btr.frequency,
-                   bitrate->btr.nominal.brp,
-                   bitrate->btr.nominal.tseg1,
-                   bitrate->btr.nominal.tseg2,
-                   bitrate->btr.nominal.sjw,
-                   bitrate->btr.data.brp,
-                   bitrate->btr.data.tseg1,
-                   bitrate->btr.data.tseg2,
-                   bitrate->btr.data.sjw) < 0)
+#if (OPTION_CAN_2_0_ONLY == 0)
+    else if(brse) {                     // CAN FD: long and fast frames
+        if(!print_value(string, &pos, ",data_brp=", bitrate->btr.data.brp) ||
+           !print_value(string, &pos, ",data_tseg1=", bitrate->btr.data.tseg1) ||
+           !print_value(string, &pos, ",data_tseg2=", bitrate->btr.data.tseg2) ||
+           !print_value(string, &pos, ",data_sjw=", bitrate->btr.data.sjw))
             return BTRERR_BAUDRATE;
     }
 #else
-    else {  // FIXME!
-        if(sprintf(string, "f_clock=%i,nom_brp=%u,nom_tseg1=%u,nom_tseg2=%u,nom_sjw=%u",
-                   bitrate->btr.frequency,
-                   bitrate->btr.nominal.brp,
-                   bitrate->btr.nominal.tseg1,
-                   bitrate->btr.nominal.tseg2,
-                   bitrate->btr.nominal.sjw) < 0)
-            return BTRERR_BAUDRATE;
-    }
+    (void)brse;
 #endif
     return BTRERR_NOERROR;
 }
 
+static bool print_value(char *string, size_t *pos, const char *key, uint32_t value)
+{
+    char digits[10];                    // max. 10 decimal digits
+    int n = 0;
+
+    assert(string && pos && key);
+
+    /* <key> */
+    while(*key != '\0') {
+        if(*pos >= (BTR_STRING_LENGTH - 1))
+            return false;
+        string[(*pos)++] = *key++;
+    }
+    /* <value> (decimal, without leading zeros) */
+    do {
+        digits[n++] = (char)('0' + (value % 10u));
+        value /= 10u;
+    } while(value != 0u);
+    if((*pos + (size_t)n) >= BTR_STRING_LENGTH)
+        return false;
+    while(n > 0)
+        string[(*pos)++] = digits[--n];
+    string[*pos] = '\0';
+    return true;
+}
+
 static int scan_bitrate(const btr_string_t string, btr_bitrate_t *bitrate, bool *brse)
 {
     btr_bitrate_t temporary;            // bit rate settings
     bool data = false;                  // data bit-rate settings
+    const char *ptr = string;           // string pointer (no copy)
+    const char *key;                    // start of the key
+    size_t length;                      // length of the key
+    uint32_t hash;                      // hash value of the key
+    uint32_t tmp;                       // value
+    int digits;                         // number of digits
 
     assert(bitrate && string && brse);  // just to make sure
 
     memset(&temporary, 0, sizeof(btr_bitrate_t));
 
-    char str[BTR_STRING_LENGTH], *ptr;  // local variables
-    char *key, *value;
-    uint32_t tmp = 0u;
-#if (0)
-    uint32_t nom_speed = 0;
-    uint32_t data_speed = 0;
-    float nom_sample_point = 0.0;
-    float data_sample_point = 0.0;
-    float tmp_float = 0.0;
-#endif
-    if(strlen(string) >= BTR_STRING_LENGTH)
-        return BTRERR_BAUDRATE;
-    strncpy(str, string, BTR_STRING_LENGTH);
-    ptr = str;
-
-    while(*ptr != '\0') {               // lexical analysis:
-        // skip blanks and scan: <key> '='
-        if(!(key = skip_blanks(ptr)))
-            return BTRERR_BAUDRATE;
-        if(!(ptr = scan_key(key)))
-            return BTRERR_BAUDRATE;
-        // skip blanks and scan: <value> [',']
-        if(!(value = skip_blanks(ptr)))
+    while(*ptr != '\0') {               // single-pass analysis:
+        // skip blanks and scan: <key> (hashed on the fly)
+        ptr = skip_spaces(ptr);
+        for(key = ptr, hash = BTR_HASH_INIT; IS_KEY_CHAR(*ptr); ptr++)
+            hash = BTR_HASH_STEP(hash, TO_LOWER(*ptr));
+        length = (size_t)(ptr - key);
+        // skip blanks and scan: '='
+        ptr = skip_spaces(ptr);
+        if(*ptr != '=')
             return BTRERR_BAUDRATE;
-        if(!(ptr = scan_value(value)))
-            return BTRERR_BAUDRATE;
-        // evaluate <key> '=' <value> [',']
-        if(strlen(value) == 0 || strlen(value) > 9)
+        ptr = skip_spaces(ptr + 1);
+        // scan: <value> = [0-9]+ and less or equal '999999999'
+        for(tmp = 0u, digits = 0; ('0' <= *ptr) && (*ptr <= '9'); ptr++) {
+            if(++digits > 9)
+                return BTRERR_BAUDRATE;
+            tmp = (tmp * 10u) + (uint32_t)(*ptr - '0');
+        }
+        if(digits == 0)                 // note: no floating-point values
             return BTRERR_BAUDRATE;
-        // convert <value> = [0-9]+ and less or equal '999999999'
-        if(strchr(value, '.') == NULL)
-            tmp = (uint32_t)strtol(value, NULL, 10);
-#if (0)
-        else
-            tmp_float = (float)strtof(value, NULL) / 100.0f;
-#else
-        else
+        // skip blanks and scan: [',']
+        ptr = skip_spaces(ptr);
+        if(*ptr == ',')
+            ptr++;
+        else if(*ptr != '\0')
             return BTRERR_BAUDRATE;
-#endif
+        // evaluate <key> '=' <value>
+        switch(lookup_key(key, length, hash)) {
         // f_clock: (80000000, 60000000, 40000000, 30000000, 24000000, 20000000)
-        if(!strcasecmp(key, "f_clock")) {
+        case BTR_KEY_F_CLOCK:
 #ifndef OPTION_CANBTR_PEAK_FREQUENCIES
             if((BTR_FREQUENCY_MIN <= tmp) && (tmp <= BTR_FREQUENCY_MAX))
                 temporary.btr.frequency = (int32_t)tmp;
@@ -521,9 +814,9 @@ static int scan_bitrate(const btr_string_t string, btr_bitrate_t *bitrate, bool
             default: return BTRERR_BAUDRATE;
             }
 #endif
-        }
+            break;
         // f_clock_mhz: (80, 60, 40, 30, 24, 20)
-        else if(!strcasecmp(key, "f_clock_mhz")) {
+        case BTR_KEY_F_CLOCK_MHZ:
 #ifndef OPTION_CANBTR_PEAK_FREQUENCIES
             if((BTR_FREQUENCY_MHZ_MIN <= tmp) && (tmp <= BTR_FREQUENCY_MHZ_MAX))
                 temporary.btr.frequency = (int32_t)tmp * (int32_t)1000000;
@@ -540,210 +833,345 @@ static int scan_bitrate(const btr_string_t string, btr_bitrate_t *bitrate, bool
             default: return BTRERR_BAUDRATE;
             }
 #endif
-        }
+            break;
         // nom_brp: 1..1024
-        else if(!strcasecmp(key, "nom_brp")) {
+        case BTR_KEY_NOM_BRP:
             if((BTR_NOMINAL_BRP_MIN <= tmp) && (tmp <= BTR_NOMINAL_BRP_MAX))
                 temporary.btr.nominal.brp = (uint16_t)tmp;
             else
                 return BTRERR_BAUDRATE;
-        }
+            break;
         // nom_tseg1: 1..256
-        else if(!strcasecmp(key, "nom_tseg1")) {
+        case BTR_KEY_NOM_TSEG1:
             if((BTR_NOMINAL_TSEG1_MIN <= tmp) && (tmp <= BTR_NOMINAL_TSEG1_MAX))
                 temporary.btr.nominal.tseg1 = (uint16_t)tmp;
             else
                 return BTRERR_BAUDRATE;
-        }
+            break;
         // nom_tseg2: 1..128
-        else if(!strcasecmp(key, "nom_tseg2")) {
+        case BTR_KEY_NOM_TSEG2:
             if((BTR_NOMINAL_TSEG2_MIN <= tmp) && (tmp <= BTR_NOMINAL_TSEG2_MAX))
                 temporary.btr.nominal.tseg2 = (uint16_t)tmp;
             else
                 return BTRERR_BAUDRATE;
-        }
+            break;
         // nom_sjw: 1..128
-        else if(!strcasecmp(key, "nom_sjw")) {
+        case BTR_KEY_NOM_SJW:
             if((BTR_NOMINAL_SJW_MIN <= tmp) && (tmp <= BTR_NOMINAL_SJW_MAX))
                 temporary.btr.nominal.sjw = (uint16_t)tmp;
             else
                 return BTRERR_BAUDRATE;
-        }
+            break;
         // nom_sam: (none)
-        else if(!strcasecmp(key, "nom_sam")) {
-#if (0)
-            if((BTR_NOMINAL_SAM_MIN <= tmp) && (tmp <= BTR_NOMINAL_SAM_MAX))
-                temporary.btr.nominal.sam = (uint8_t)tmp;
-            else
-                return BTRERR_BAUDRATE;
-#else
+        case BTR_KEY_NOM_SAM:
             // FIXME: SJA1000 = {0, 1} vs. Kvaser = {1, 3}
             temporary.btr.nominal.sam = (uint8_t)tmp;
-#endif
-        }
+            break;
 #if (OPTION_CAN_2_0_ONLY == 0)
         // data_brp: 1..1024
-        else if(!strcasecmp(key, "data_brp")) {
+        case BTR_KEY_DATA_BRP:
             if((BTR_DATA_BRP_MIN <= tmp) && (tmp <= BTR_DATA_BRP_MAX))
                 temporary.btr.data.brp = (uint16_t)tmp;
             else
                 return BTRERR_BAUDRATE;
             data = true;
-        }
+            break;
         // data_tseg1: 1..32
-        else if(!strcasecmp(key, "data_tseg1")) {
+        case BTR_KEY_DATA_TSEG1:
             if((BTR_DATA_TSEG1_MIN <= tmp) && (tmp <= BTR_DATA_TSEG1_MAX))
                 temporary.btr.data.tseg1 = (uint16_t)tmp;
             else
                 return BTRERR_BAUDRATE;
             data = true;
-        }
+            break;
         // data_tseg2: 1..16
-        else if(!strcasecmp(key, "data_tseg2")) {
+        case BTR_KEY_DATA_TSEG2:
             if((BTR_DATA_TSEG2_MIN <= tmp) && (tmp <= BTR_DATA_TSEG2_MAX))
                 temporary.btr.data.tseg2 = (uint16_t)tmp;
             else
                 return BTRERR_BAUDRATE;
             data = true;
-        }
+            break;
         // data_sjw: 1..16
-        else if(!strcasecmp(key, "data_sjw")) {
+        case BTR_KEY_DATA_SJW:
             if((BTR_DATA_SJW_MIN <= tmp) && (tmp <= BTR_DATA_SJW_MAX))
                 temporary.btr.data.sjw = (uint16_t)tmp;
             else
                 return BTRERR_BAUDRATE;
             data = true;
-        }
+            break;
         // data_ssp_offset: (none)
-        else if(!strcasecmp(key, "data_ssp_offset")) {
+        case BTR_KEY_DATA_SSP_OFFSET:
             // not used
-        }
-#if (0)
-        // nom_speed: 1000..2000000
-        else if (!strcasecmp(key, "nom_speed")) {
-            if (tmp < 1000ul)
-                tmp *= 1000ul;
-            if ((BTR_NOMINAL_SPEED_MIN <= tmp) && (tmp <= BTR_NOMINAL_SPEED_MAX))
-                nom_speed = (uint32_t)tmp;
-            else
-                return BTRERR_BAUDRATE;
-        }
-        // nom_sp: 0.05..1.00
-        else if (!strcasecmp(key, "nom_sp")) {
-            if (tmp_float == 0.0)
-                tmp_float = (float)tmp / 100.0f;
-            if ((BTR_NOMINAL_SP_MIN <= tmp_float) && (tmp_float <= BTR_NOMINAL_SP_MAX))
-                nom_sample_point = tmp_float;
-            else
-                return BTRERR_BAUDRATE;
-        }
-        // data_speed: 1000..12000000
-        else if (!strcasecmp(key, "data_speed")) {
-            if (tmp < 100ul)
-                tmp *= 1000000ul;
-            if (tmp < 1000ul)
-                tmp *= 1000ul;
-            if ((BTR_DATA_SPEED_MIN <= tmp) && (tmp <= BTR_DATA_SPEED_MAX))
-                data_speed = (uint32_t)tmp;
-            else
-                return BTRERR_BAUDRATE;
-        }
-        // data_sp: 0.1..1.0
-        else if (!strcasecmp(key, "data_sp")) {
-            if (tmp_float == 0.0)
-                tmp_float = (float)tmp / 100.0f;
-            if ((BTR_DATA_SP_MIN <= tmp_float) && (tmp_float <= BTR_DATA_SP_MAX))
-                data_sample_point = tmp_float;
-            else
-                return BTRERR_BAUDRATE;
-        }
-#endif
+            break;
 #endif
-        else {
+        default:
             // unknown key
             return BTRERR_BAUDRATE;
         }
     }
-#if (0)
-    if (temporary.btr.frequency) {
-        /* f_clock=<freq>,nom_speed=<nom_speed>,nom_sp=<nom_sample_point>[,data_speed=<data_speed>,data_sp=<data_sample_point>] */
-        if ((nom_speed && (nom_sample_point != 0.0)) &&
-            !((temporary.btr.nominal.brp || temporary.btr.nominal.tseg1 || temporary.btr.nominal.tseg2 || temporary.btr.nominal.sjw || temporary.btr.nominal.sam) ||
-            (temporary.btr.data.brp || temporary.btr.data.tseg1 || temporary.btr.data.tseg2 || temporary.btr.data.sjw))) {
-            if (!btr_find_bit_timing_nominal(nom_speed, nom_sample_point, temporary.btr.frequency, btr_nominal, BTR_OPTION_TQ_FEW))
-                return BTRERR_BAUDRATE;
+    /* note: without any further verification */
+    memcpy(bitrate, &temporary, sizeof(btr_bitrate_t));
+    *brse = data;
 
-            if (data_speed && (data_sample_point != 0.0)) {
-                if (!btr_find_bit_timing_data(data_speed, data_sample_point, temporary.btr.frequency, btr_data, BTR_OPTION_TQ_FEW))
-                    return BTRERR_BAUDRATE;
-            }
-            else if (data_speed || (data_sample_point != 0.0))
-                return BTRERR_BAUDRATE;
+    return BTRERR_NOERROR;
+}
+
+static int lookup_key(const char *key, size_t length, uint32_t hash)
+{
+    size_t i, n;
+
+    assert(key);
+
+    for(i = 0; i < (sizeof(keywords) / sizeof(keywords[0])); i++) {
+        if((keywords[i].hash != hash) || (keywords[i].length != length))
+            continue;
+        /* verify the key (hash collision) */
+        for(n = 0; (n < length) && (TO_LOWER(key[n]) == keywords[i].name[n]); n++)
+            ;
+        if(n == length)
+            return keywords[i].id;
+    }
+    return BTR_KEY_UNKNOWN;
+}
+
+#if (BTR_CACHE_SIZE != 0)
+static bool cache_string2bitrate(const char *string, uint32_t hash, btr_bitrate_t *bitrate, bool *brse)
+{
+    int i;
+
+    for(i = 0; i < BTR_CACHE_SIZE; i++) {
+        if(cache.string2bitrate[i].stamp && (cache.string2bitrate[i].hash == hash) &&
+           !strcmp(cache.string2bitrate[i].string, string)) {
+            memcpy(bitrate, &cache.string2bitrate[i].bitrate, sizeof(btr_bitrate_t));
+            *brse = cache.string2bitrate[i].brse;
+            cache.string2bitrate[i].stamp = ++cache.clock;
+            return true;
         }
-        else if (nom_speed || (nom_sample_point != 0.0))
-            return BTRERR_BAUDRATE;
+    }
+    return false;
+}
+
+static bool cache_bitrate2string(const btr_bitrate_t *bitrate, bool brse, char *string)
+{
+    int i;
 
-        /* f_clock=<freq>,nom_brp=<nom_brp>,nom_tseg1=<nom_tseg1>,nom_tseg2=<nom_tseg2>,nom_sjw=<nom_sjw>[,nom_sam=<nom_sam>]
-                        [,data_brp=<data_brp>,data_tseg1=<data_tseg1>,data_tseg2=<data_tseg2>,data_sjw=<data_sjw>] */
-        if ((temporary.btr.nominal.brp && temporary.btr.nominal.tseg1 && temporary.btr.nominal.tseg2 && temporary.btr.nominal.sjw) &&
-            ((temporary.btr.data.brp && temporary.btr.data.tseg1 && temporary.btr.data.tseg2 && temporary.btr.data.sjw) ||
-            (!temporary.btr.data.brp && !temporary.btr.data.tseg1 && !temporary.btr.data.tseg2 && !temporary.btr.data.sjw)))
-            return 1;
+    for(i = 0; i < BTR_CACHE_SIZE; i++) {
+        if(cache.bitrate2string[i].stamp && (cache.bitrate2string[i].brse == brse) &&
+           same_bitrate(&cache.bitrate2string[i].bitrate, bitrate)) {
+            strcpy(string, cache.bitrate2string[i].string);
+            cache.bitrate2string[i].stamp = ++cache.clock;
+            return true;
+        }
     }
+    return false;
+}
+
+static void cache_insert(btr_cache_entry_t *table, const char *string, uint32_t hash, const btr_bitrate_t *bitrate, bool brse)
+{
+    int i, lru = 0;
+
+    /* replace the least recently used entry */
+    for(i = 1; i < BTR_CACHE_SIZE; i++) {
+        if(table[i].stamp < table[lru].stamp)
+            lru = i;
+    }
+    table[lru].hash = hash;
+    table[lru].brse = brse;
+    memcpy(&table[lru].bitrate, bitrate, sizeof(btr_bitrate_t));
+    strcpy(table[lru].string, string);  // note: length checked before
+    table[lru].stamp = ++cache.clock;
+}
+
+static bool same_bitrate(const btr_bitrate_t *a, const btr_bitrate_t *b)
+{
+    /* note: field by field, the padding bytes are undefined */
+    return (a->btr.frequency == b->btr.frequency) &&
+           (a->btr.nominal.brp == b->btr.nominal.brp) &&
+           (a->btr.nominal.tseg1 == b->btr.nominal.tseg1) &&
+           (a->btr.nominal.tseg2 == b->btr.nominal.tseg2) &&
+           (a->btr.nominal.sjw == b->btr.nominal.sjw) &&
+           (a->btr.nominal.sam == b->btr.nominal.sam)
+#if (OPTION_CAN_2_0_ONLY == 0)
+        && (a->btr.data.brp == b->btr.data.brp) &&
+           (a->btr.data.tseg1 == b->btr.data.tseg1) &&
+           (a->btr.data.tseg2 == b->btr.data.tseg2) &&
+           (a->btr.data.sjw == b->btr.data.sjw)
+#endif
+        ;
+}
+
+static uint32_t hash_string(const char *string, size_t *length)
+{
+    const char *ptr = string;
+    uint32_t hash = BTR_HASH_INIT;
+
+    assert(string && length);
+
+    while(*ptr != '\0')
+        hash = BTR_HASH_STEP(hash, (uint8_t)*ptr++);
+    *length = (size_t)(ptr - string);
+    return hash;
+}
 #endif
-    /* note: without any further verification */
-    memcpy(bitrate, &temporary, sizeof(btr_bitrate_t));
-    *brse = data;
+
+static int solve_timing(int32_t frequency, float speed, float samplepoint,
+                        const btr_limits_t *limits, btr_timing_t *timing)
+{
+    btr_timing_t candidate;             // bit-timing candidate
+    uint32_t ntq_min = 1u + limits->tseg1_min + limits->tseg2_min;
+    uint32_t ntq_max = 1u + limits->tseg1_max + limits->tseg2_max;
+    uint32_t brp, ntq;                  // prescaler and time quanta per bit
+    int32_t tseg1, tseg2;               // time segments
+    double tq_per_bit, df1, df2;        // temporary values
+    bool found = false;
+
+    assert(limits && timing);           // just to make sure
+
+    if((speed <= 0.0f) || (samplepoint <= 0.0f) || (1.0f < samplepoint))
+        return BTRERR_BAUDRATE;
+
+    /* for each prescaler take the number of time quanta closest to the speed:
+     *
+     * (1) speed = freq / (brp * (1 + tseg1 + tseg2))
+     *
+     * (2) sp = (1 + tseg1) / (1 + tseg1 + tseg2)
+     */
+    for(brp = limits->brp_min; brp <= limits->brp_max; brp++) {
+        tq_per_bit = (double)frequency / ((double)brp * (double)speed);
+        if((tq_per_bit + 0.5) < (double)ntq_min)
+            break;                      //   it won't get any better
+        ntq = (uint32_t)(tq_per_bit + 0.5);
+        if(ntq > ntq_max)
+            continue;
+        /* split the time quanta into TSEG1 and TSEG2 closest to the sample-point */
+        tseg1 = (int32_t)((double)samplepoint * (double)ntq + 0.5) - 1;
+        if(tseg1 < (int32_t)limits->tseg1_min)
+            tseg1 = (int32_t)limits->tseg1_min;
+        if(tseg1 > (int32_t)limits->tseg1_max)
+            tseg1 = (int32_t)limits->tseg1_max;
+        tseg2 = (int32_t)ntq - 1 - tseg1;
+        if(tseg2 < (int32_t)limits->tseg2_min)
+            tseg2 = (int32_t)limits->tseg2_min;
+        if(tseg2 > (int32_t)limits->tseg2_max)
+            tseg2 = (int32_t)limits->tseg2_max;
+        tseg1 = (int32_t)ntq - 1 - tseg2;
+        if((tseg1 < (int32_t)limits->tseg1_min) || ((int32_t)limits->tseg1_max < tseg1))
+            continue;
+        candidate.brp = (uint16_t)brp;
+        candidate.tseg1 = (uint16_t)tseg1;
+        candidate.tseg2 = (uint16_t)tseg2;
+        /* the SJW as large as possible (but not larger than TSEG2) */
+        candidate.sjw = (uint16_t)((tseg2 < (int32_t)limits->sjw_max) ? tseg2 : (int32_t)limits->sjw_max);
+        if(candidate.sjw < limits->sjw_min)
+            continue;
+        /* deviations from the requested bit-rate and sample-point */
+        candidate.error = ((double)frequency / (double)(brp * ntq)) - (double)speed;
+        candidate.error = ((candidate.error < 0.0) ? -candidate.error : candidate.error) / (double)speed;
+        candidate.sp_error = ((double)(1 + tseg1) / (double)ntq) - (double)samplepoint;
+        candidate.sp_error = (candidate.sp_error < 0.0) ? -candidate.sp_error : candidate.sp_error;
+        /* oscillator tolerance (ISO 11898-1):
+         *
+         * (1) df <= min(PS1, PS2) / (2 * (13 * NBT - PS2))
+         *
+         * (2) df <= SJW / (20 * NBT)
+         */
+        df1 = (double)((tseg1 < tseg2) ? tseg1 : tseg2) / (2.0 * (13.0 * (double)ntq - (double)tseg2));
+        df2 = (double)candidate.sjw / (20.0 * (double)ntq);
+        candidate.tolerance = (df1 < df2) ? df1 : df2;
+
+        if(!found || better_timing(&candidate, timing)) {
+            memcpy(timing, &candidate, sizeof(btr_timing_t));
+            found = true;
+        }
+    }
+    /* note: a deviation beyond the oscillator tolerance is not acceptable */
+    if(!found || (timing->error > timing->tolerance))
+        return BTRERR_BAUDRATE;
 
     return BTRERR_NOERROR;
 }
 
-static char *scan_key(char *str)
+static bool better_timing(const btr_timing_t *candidate, const btr_timing_t *best)
 {
-    char *ptr = str;
+    assert(candidate && best);          // just to make sure
+
+    /* 1st: the smallest bit-rate deviation */
+    if(candidate->error < (best->error - BTR_EPSILON_SPEED))
+        return true;
+    if(candidate->error > (best->error + BTR_EPSILON_SPEED))
+        return false;
+    /* 2nd: the smallest sample-point deviation */
+    if(candidate->sp_error < (best->sp_error - BTR_EPSILON_SP))
+        return true;
+    if(candidate->sp_error > (best->sp_error + BTR_EPSILON_SP))
+        return false;
+    /* 3rd: the largest oscillator tolerance */
+    return (candidate->tolerance > best->tolerance) ? true : false;
+}
 
-    assert(str);
+static float norm_samplepoint(float samplepoint)
+{
+    if(samplepoint <= 0.0f)             // not specified: take the default
+        return BTR_SAMPLEPOINT_DEFAULT;
+    if(samplepoint > 1.0f)              // given in percent
+        return samplepoint / 100.0f;
+    return samplepoint;
+}
+
+static const char *scan_speed(const char *str, float *speed)
+{
+    char *end = NULL;
+    double value;
+
+    assert(str && speed);
 
-    while (('a' <= *ptr && *ptr <= 'z') || (*ptr == '_') || ('0' <= *ptr && *ptr <= '9') || ('A' <= *ptr && *ptr <= 'Z'))
-        ptr++;
-    while (*ptr == ' ')
-        *ptr++ = '\0';
-    if ((*ptr != '='))
+    /* <number> ['k' | 'M'] (e.g. "500k", "2M", "83.333k" or "125000") */
+    str = skip_spaces(str);
+    value = strtod(str, &end);
+    if((end == str) || (value <= 0.0))
         return NULL;
-    *ptr++ = '\0';
-    return ptr;
+    if((*end == 'k') || (*end == 'K')) {
+        value *= 1000.0;
+        end++;
+    }
+    else if(*end == 'M') {
+        value *= 1000000.0;
+        end++;
+    }
+    *speed = (float)value;
+    return skip_spaces(end);
 }
 
-static char *scan_value(char *str)
+static const char *scan_samplepoint(const char *str, float *samplepoint)
 {
-    char *ptr = str;
-    int   dot = 0;
+    char *end = NULL;
+    double value;
 
-    assert(str);
+    assert(str && samplepoint);
 
-    while (('0' <= *ptr && *ptr <= '9') || (*ptr == '.')) {
-        if ((*ptr == '.') && (++dot > 1))
-            return ptr;
-        ptr++;
-    }
-    while (*ptr == ' ')
-        *ptr++ = '\0';
-    if ((*ptr != ',') && (*ptr != '\0'))
+    /* <number> ['%'] (e.g. "80%", "87.5%" or "0.75") */
+    str = skip_spaces(str);
+    value = strtod(str, &end);
+    if((end == str) || (value <= 0.0))
         return NULL;
-    if (*ptr != '\0')
-        *ptr++ = '\0';
-    return ptr;
+    if(*end == '%') {
+        value /= 100.0;
+        end++;
+    }
+    else if(value > 1.0)                // percent without '%'
+        value /= 100.0;
+    *samplepoint = (float)value;
+    return skip_spaces(end);
 }
 
-static char *skip_blanks(char *str)
+static const char *skip_spaces(const char *str)
 {
-    char *ptr = str;
-
     assert(str);
 
-    while (*ptr == ' ')
-        *ptr++ = '\0';
-    return ptr;
+    while ((*str == ' ') || (*str == '\t'))
+        str++;
+    return str;
 }
 
 /** @}
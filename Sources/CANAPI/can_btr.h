@@ -88,6 +88,10 @@ extern "C" {
 /** @note  Set define OPTION_CAN_2_0_ONLY to a non-zero value to compile
  *         with CAN 2.0 frame format only (e.g. in the build environment).
  */
+/** @note  Set define OPTION_CANBTR_CACHE_SIZE to the number of string <->
+ *         bit-rate conversions to be cached (default 8), or to zero to
+ *         compile without conversion cache (e.g. in the build environment).
+ */
 #if (OPTION_CAN_2_0_ONLY != 0)
 #warning Compilation with legacy CAN 2.0 frame format!
 #endif
@@ -349,18 +353,45 @@ typedef uint16_t btr_sja1000_t;
 int btr_bitrate2speed(const btr_bitrate_t *bitrate, bool fdoe, bool brse, btr_speed_t *speed);
 
 
-/** @brief       ...
+/** @brief       calculates the bit-timing settings (BRP, TSEG1, TSEG2 and SJW)
+ *               for the given bus speed and sample-point (nominal and data).
  *
- *  @note        Sorry, not realized yet!
+ *  @note        The clock domain is taken from field 'btr.frequency' of the
+ *               bit-rate settings, if set. Otherwise 80 MHz is taken for
+ *               CAN FD and 8 MHz (SJA1000 registers) for CAN 2.0.
  *
- *  @param[in]   speed   -
- *  @param[out]  bitrate -
+ *  @note        All prescaler values within the limits are evaluated. The
+ *               candidates are ranked by (1) the bit-rate deviation, (2) the
+ *               sample-point deviation and (3) the oscillator tolerance. The
+ *               data phase prefers the prescaler of the nominal phase.
+ *
+ *  @note        A sample-point of 0.0 selects the default (80%), a value
+ *               greater than 1.0 is taken as percent.
+ *
+ *  @param[in]   speed   - bus speed and sample-point (nominal and data)
+ *  @param[in]   bitrate - clock domain (field 'btr.frequency' or zero)
+ *  @param[out]  bitrate - bit-rate settings (nominal and data)
  *
  *  @returns     0 if successful, or a negative value on error.
  */
 int btr_speed2bitrate(const btr_speed_t *speed, btr_bitrate_t *bitrate);
 
 
+/** @brief       converts a bus speed given as string into a bus speed structure,
+ *               e.g. "250k", "500k/2M @ 80%" or "1M/8M @ 80%/75%".
+ *
+ *  @note        Syntax: <nom_speed> ['/' <data_speed>] ['@' <nom_sp> ['/' <data_sp>]]
+ *               with suffix 'k' or 'M' for the speed and '%' for the sample-point.
+ *               A data speed enables CAN FD operation with bit-rate switching.
+ *
+ *  @param[in]   string  - bus speed as zero-terminated string
+ *  @param[out]  speed   - bus speed and sample-point (nominal and data)
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ */
+int btr_string2speed(const btr_string_t string, btr_speed_t *speed);
+
+
 /** @brief       ...
  *
  *  @param[in]   index   -
@@ -134,6 +134,8 @@ CPeakCAN::CPeakCAN() {
     m_Bitrate.btr.data.tseg1 = m_Bitrate.btr.nominal.tseg1;
     m_Bitrate.btr.data.tseg2 = m_Bitrate.btr.nominal.tseg2;
     m_Bitrate.btr.data.sjw = m_Bitrate.btr.nominal.sjw;
+    memset(&m_BusSpeed, 0, sizeof(CANAPI_BusSpeed_t));
+    m_BusSpeedValid = false;
     m_Counter.u64TxMessages = 0U;
     m_Counter.u64RxMessages = 0U;
     m_Counter.u64ErrorFrames = 0U;
@@ -182,6 +184,7 @@ CANAPI_Return_t CPeakCAN::TeardownChannel() {
     CANAPI_Return_t rc = can_exit(m_pCAN->m_Handle);
     if (CANERR_NOERROR == rc) {
         m_pCAN->m_Handle = -1;  // invalidate the handle
+        m_BusSpeedValid = false;
     }
     return rc;
 }
@@ -199,13 +202,51 @@ CANAPI_Return_t CPeakCAN::StartController(CANAPI_Bitrate_t bitrate) {
     if (CANERR_NOERROR == rc) {
         m_Bitrate = bitrate;
         memset(&m_Counter, 0, sizeof(m_Counter));
+        // note: the bus speed is computed once from the accepted settings
+        m_BusSpeedValid = (CANERR_NOERROR == can_bitrate(m_pCAN->m_Handle, &m_Bitrate, &m_BusSpeed));
     }
     return rc;
 }
 
+EXPORT
+CANAPI_Return_t CPeakCAN::StartController(const SPeakCANPreset &preset) {
+    // start the CAN controller with a compile-time validated preset
+    if (preset.IsSja1000() == (m_OpMode.fdoe ? true : false)) {
+        return CANERR_BAUDRATE;  // CAN 2.0 presets vs. CAN FD presets
+    }
+    if (preset.HasData() != (m_OpMode.brse ? true : false)) {
+        return CANERR_BAUDRATE;  // data bit-rate only with bit-rate switching
+    }
+    return StartController(preset.Bitrate());
+}
+
+EXPORT
+CANAPI_Return_t CPeakCAN::StartController(const char *speed) {
+    // start the CAN controller with a bus speed given as string (e.g. "500k/2M @ 80%")
+    CANAPI_BusSpeed_t busSpeed;
+    CANAPI_Bitrate_t bitrate;
+    CANAPI_Return_t rc = MapString2Speed(speed, busSpeed);
+    if (CANERR_NOERROR != rc) {
+        return rc;
+    }
+    // a data bit-rate requires CAN FD operation with bit-rate switching
+    if (busSpeed.data.brse && !(m_OpMode.fdoe && m_OpMode.brse)) {
+        return CANERR_BAUDRATE;
+    }
+    busSpeed.nominal.fdoe = m_OpMode.fdoe ? true : false;
+    busSpeed.data.brse = m_OpMode.brse ? true : false;
+    // calculate the bit-timing (clock domain depends on the operation mode)
+    memset(&bitrate, 0, sizeof(CANAPI_Bitrate_t));
+    if (CANERR_NOERROR != (rc = MapSpeed2Bitrate(busSpeed, bitrate))) {
+        return rc;
+    }
+    return StartController(bitrate);
+}
+
 EXPORT
 CANAPI_Return_t CPeakCAN::ResetController() {
     // stop any operation of the CAN controller
+    m_BusSpeedValid = false;
     return can_reset(m_pCAN->m_Handle);
 }
 
@@ -230,6 +271,28 @@ CANAPI_Return_t CPeakCAN::ReadMessage(CANAPI_Message_t &message, uint16_t timeou
     return rc;
 }
 
+EXPORT
+CANAPI_Return_t CPeakCAN::ReadEvents(CANAPI_Event_t *events, uint16_t count) {
+    // read up to 'count' events recorded while reading messages, if any
+    return can_event(m_pCAN->m_Handle, events, count);
+}
+
+EXPORT
+CANAPI_Return_t CPeakCAN::WaitAny(CPeakCAN *const *channels, size_t count, uint32_t &ready, uint16_t timeout) {
+    // wait until one or more channels have received messages (bit i of 'ready' for channels[i])
+    int handles[32];
+    if (!channels)
+        return CANERR_NULLPTR;
+    if (!count || (count > (sizeof(handles) / sizeof(handles[0]))))
+        return CANERR_ILLPARA;
+    for (size_t i = 0; i < count; i++) {
+        if (!channels[i])
+            return CANERR_NULLPTR;
+        handles[i] = channels[i]->m_pCAN->m_Handle;
+    }
+    return can_select(handles, count, timeout, &ready);
+}
+
 EXPORT
 CANAPI_Return_t CPeakCAN::GetStatus(CANAPI_Status_t &status) {
     // retrieve the status register of the CAN interface
@@ -254,7 +317,11 @@ CANAPI_Return_t CPeakCAN::GetBitrate(CANAPI_Bitrate_t &bitrate) {
 
 EXPORT
 CANAPI_Return_t CPeakCAN::GetBusSpeed(CANAPI_BusSpeed_t &speed) {
-    // retrieve the transmission rate of the CAN interface
+    // retrieve the transmission rate of the CAN interface (cached while started)
+    if (m_BusSpeedValid) {
+        speed = m_BusSpeed;
+        return CANERR_NOERROR;
+    }
     return can_bitrate(m_pCAN->m_Handle, &m_Bitrate, &speed);
 }
 
@@ -327,6 +394,17 @@ CANAPI_Return_t CPeakCAN::MapBitrate2Speed(CANAPI_Bitrate_t bitrate, CANAPI_BusS
     return (CANAPI_Return_t)btr_bitrate2speed(&bitrate, false, false, &speed);
 }
 
+EXPORT
+CANAPI_Return_t CPeakCAN::MapSpeed2Bitrate(CANAPI_BusSpeed_t speed, CANAPI_Bitrate_t &bitrate) {
+    // note: field 'btr.frequency' selects the clock domain (zero for the default)
+    return (CANAPI_Return_t)btr_speed2bitrate(&speed, &bitrate);
+}
+
+EXPORT
+CANAPI_Return_t CPeakCAN::MapString2Speed(const char *string, CANAPI_BusSpeed_t &speed) {
+    return (CANAPI_Return_t)btr_string2speed((btr_string_t)string, &speed);
+}
+
 //  Private methodes
 //
 CANAPI_Return_t CPeakCAN::MapBitrate2Sja1000(CANAPI_Bitrate_t bitrate, uint16_t &btr0btr1) {
@@ -49,6 +49,7 @@
 #define PEAKCAN_H_INCLUDED
 
 #include "CANAPI.h"
+#include "PeakCAN_Presets.h"
 
 /// \name   PCAN
 /// \brief  PCAN dynamic library
@@ -71,6 +72,8 @@ class CANCPP CPeakCAN : public CCANAPI {
 private:
     CANAPI_OpMode_t m_OpMode;  ///< CAN operation mode
     CANAPI_Bitrate_t m_Bitrate;  ///< CAN bitrate settings
+    CANAPI_BusSpeed_t m_BusSpeed;  ///< CAN bus speed (computed once per start)
+    bool m_BusSpeedValid;  ///< bus speed valid (controller started)
     struct {
         uint64_t u64TxMessages;  ///< number of transmitted CAN messages
         uint64_t u64RxMessages;  ///< number of received CAN messages
@@ -111,10 +114,14 @@ public:
     CANAPI_Return_t SignalChannel();
 
     CANAPI_Return_t StartController(CANAPI_Bitrate_t bitrate);
+    CANAPI_Return_t StartController(const char *speed);  // e.g. "500k/2M @ 80%"
+    CANAPI_Return_t StartController(const SPeakCANPreset &preset);  // e.g. PEAKCAN_PRESET_80MHz_500K_2M
     CANAPI_Return_t ResetController();
 
     CANAPI_Return_t WriteMessage(CANAPI_Message_t message, uint16_t timeout = 0U);
     CANAPI_Return_t ReadMessage(CANAPI_Message_t &message, uint16_t timeout = CANREAD_INFINITE);
+    CANAPI_Return_t ReadEvents(CANAPI_Event_t *events, uint16_t count);  // returns number of events
+    static CANAPI_Return_t WaitAny(CPeakCAN *const *channels, size_t count, uint32_t &ready, uint16_t timeout = CANREAD_INFINITE);  // returns number of ready channels
 
     CANAPI_Return_t GetStatus(CANAPI_Status_t &status);
     CANAPI_Return_t GetBusLoad(uint8_t &load);
@@ -133,6 +140,8 @@ public:
     static CANAPI_Return_t MapString2Bitrate(const char *string, CANAPI_Bitrate_t &bitrate);
     static CANAPI_Return_t MapBitrate2String(CANAPI_Bitrate_t bitrate, char *string, size_t length);
     static CANAPI_Return_t MapBitrate2Speed(CANAPI_Bitrate_t bitrate, CANAPI_BusSpeed_t &speed);
+    static CANAPI_Return_t MapSpeed2Bitrate(CANAPI_BusSpeed_t speed, CANAPI_Bitrate_t &bitrate);
+    static CANAPI_Return_t MapString2Speed(const char *string, CANAPI_BusSpeed_t &speed);
 private:
     CANAPI_Return_t MapBitrate2Sja1000(CANAPI_Bitrate_t bitrate, uint16_t &btr0btr1);
     CANAPI_Return_t MapSja10002Bitrate(uint16_t btr0btr1, CANAPI_Bitrate_t &bitrate);
@@ -169,6 +178,12 @@ public:
 #define PEAKCAN_PROPERTY_API_VERSION         (CANPROP_GET_VENDOR_PROP + 0x05U)
 #define PEAKCAN_PROPERTY_CHANNEL_VERSION     (CANPROP_GET_VENDOR_PROP + 0x06U)
 #define PEAKCAN_PROPERTY_HARDWARE_NAME       (CANPROP_GET_VENDOR_PROP + 0x0EU)
+#define PEAKCAN_PROPERTY_STATUS_AGE          (CANPROP_GET_VENDOR_PROP + 0xF0U)
+#define PEAKCAN_PROPERTY_STATUS_MAX_AGE      (CANPROP_GET_VENDOR_PROP + 0xF1U)
+#define PEAKCAN_PROPERTY_STATUS_REFRESH      (CANPROP_GET_VENDOR_PROP + 0xF2U)
+#define PEAKCAN_PROPERTY_RX_EVENT            (CANPROP_GET_VENDOR_PROP + 0xF3U)
+#define PEAKCAN_PROPERTY_SET_STATUS_MAX_AGE  (CANPROP_SET_VENDOR_PROP + 0xF1U)
+#define PEAKCAN_PROPERTY_SET_STATUS_REFRESH  (CANPROP_SET_VENDOR_PROP + 0xF2U)
 //#define PEAKCAN_PROPERTY_BOOTLOADER_VERSION  (CANPROP_GET_VENDOR_PROP + 0x??U)
 //#define PEAKCAN_PROPERTY_SERIAL_NUMBER       (CANPROP_GET_VENDOR_PROP + 0x??U)
 //#define PEAKCAN_PROPERTY_VID_PID             (CANPROP_GET_VENDOR_PROP + 0x??U)
@@ -0,0 +1,214 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (for PEAK PCAN Interfaces)
+//
+//  Copyright (c) 2017-2021 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of PCANBasic-Wrapper.
+//
+//  PCANBasic-Wrapper is dual-licensed under the BSD 2-Clause "Simplified" License
+//  and under the GNU General Public License v3.0 (or any later version). You can
+//  choose between one of them if you use PCANBasic-Wrapper in whole or in part.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  PCANBasic-Wrapper IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF PCANBasic-Wrapper, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  PCANBasic-Wrapper is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  PCANBasic-Wrapper is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+#ifndef PEAKCAN_ASYNC_H_INCLUDED
+#define PEAKCAN_ASYNC_H_INCLUDED
+
+#include "PeakCAN.h"
+
+#if defined(__cpp_impl_coroutine) && (__cpp_impl_coroutine >= 201902L)
+#include <coroutine>
+#include <exception>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+/// \name   PeakCAN Coroutines
+/// \brief  Awaitable receive and transmit on CPeakCAN objects (C++20).
+/// \note   All coroutines of a reactor are resumed from the thread that
+///         calls CPeakCANReactor::Run/RunOnce. The reactor waits on the
+///         receive events of the channels (CPeakCAN::WaitAny) and polls
+///         pending transmissions (PCAN-Basic has no transmit event).
+/// \{
+#define PEAKCAN_REACTOR_TX_POLL  1U  ///< poll interval for a full transmit queue [ms]
+
+/// \brief  Coroutine type for detached sessions (started immediately)
+struct SPeakCANTask {
+    struct promise_type {
+        SPeakCANTask get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+class CPeakCANReactor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// \brief  pending operation of a suspended coroutine
+    class CAwaiter {
+        friend class CPeakCANReactor;
+    protected:
+        CPeakCANReactor &m_Reactor;  ///< reactor resuming the coroutine
+        CPeakCAN &m_Channel;  ///< CAN channel
+        CANAPI_Return_t m_Result;  ///< result of the operation
+        bool m_Receive;  ///< receive (or transmit) operation
+        bool m_Timed;  ///< operation with time-out
+        Clock::time_point m_Deadline;  ///< end of the time-out
+        std::coroutine_handle<> m_Handle;  ///< suspended coroutine
+
+        CAwaiter(CPeakCANReactor &reactor, CPeakCAN &channel, bool receive, uint16_t timeout)
+            : m_Reactor(reactor), m_Channel(channel), m_Result(CANERR_FATAL), m_Receive(receive),
+              m_Timed(timeout != CANREAD_INFINITE),
+              m_Deadline(Clock::now() + std::chrono::milliseconds(timeout)) {}
+        virtual ~CAwaiter() = default;
+        virtual bool TryNow() = 0;  // true when the operation is completed
+    public:
+        bool await_ready() { return TryNow(); }
+        void await_suspend(std::coroutine_handle<> handle) { m_Handle = handle; m_Reactor.m_Pending.push_back(this); }
+        CANAPI_Return_t await_resume() const noexcept { return m_Result; }
+    };
+    /// \brief  co_await Read(channel, message[, timeout]): CANERR_RX_EMPTY on time-out
+    /// \note   Error frames and status messages are skipped (as in the
+    ///         reception loops of the utilities), so a completed read
+    ///         returns a data or remote frame, or an error of the channel.
+    class CReadAwaiter : public CAwaiter {
+        CANAPI_Message_t &m_Message;
+    public:
+        CReadAwaiter(CPeakCANReactor &reactor, CPeakCAN &channel, CANAPI_Message_t &message, uint16_t timeout)
+            : CAwaiter(reactor, channel, true, timeout), m_Message(message) {}
+    protected:
+        bool TryNow() override {
+            do {
+                m_Result = m_Channel.ReadMessage(m_Message, 0U);
+            } while ((CANERR_ERR_FRAME == m_Result) || ((CANERR_NOERROR == m_Result) && m_Message.sts));
+            return (CANERR_RX_EMPTY != m_Result);
+        }
+    };
+    /// \brief  co_await Write(channel, message[, timeout]): CANERR_TX_BUSY on time-out
+    class CWriteAwaiter : public CAwaiter {
+        CANAPI_Message_t m_Message;
+    public:
+        CWriteAwaiter(CPeakCANReactor &reactor, CPeakCAN &channel, const CANAPI_Message_t &message, uint16_t timeout)
+            : CAwaiter(reactor, channel, false, timeout), m_Message(message) {}
+    protected:
+        bool TryNow() override {
+            m_Result = m_Channel.WriteMessage(m_Message, 0U);
+            return (CANERR_TX_BUSY != m_Result);
+        }
+    };
+
+    CReadAwaiter Read(CPeakCAN &channel, CANAPI_Message_t &message, uint16_t timeout = CANREAD_INFINITE) {
+        return CReadAwaiter(*this, channel, message, timeout);
+    }
+    CWriteAwaiter Write(CPeakCAN &channel, const CANAPI_Message_t &message, uint16_t timeout = CANREAD_INFINITE) {
+        return CWriteAwaiter(*this, channel, message, timeout);
+    }
+    /// \brief  number of suspended coroutines
+    size_t Pending() const { return m_Pending.size(); }
+
+    /// \brief  waits up to 'timeout' [ms] for any channel and resumes the
+    ///         coroutines whose operation has completed (or timed out).
+    /// \returns the number of resumed coroutines, or a negative error code
+    int RunOnce(uint16_t timeout = CANREAD_INFINITE) {
+        CPeakCAN *channels[32];
+        size_t count = 0;
+        bool transmit = false;
+        if (m_Pending.empty())
+            return 0;
+        // (1) collect the channels with pending receptions and the shortest wait
+        Clock::time_point now = Clock::now();
+        Clock::duration wait = (timeout != CANREAD_INFINITE) ? Clock::duration(std::chrono::milliseconds(timeout))
+                                                             : Clock::duration::max();
+        for (CAwaiter *op : m_Pending) {
+            if (op->m_Receive) {
+                if (std::find(channels, channels + count, &op->m_Channel) == (channels + count)) {
+                    if (count >= (sizeof(channels) / sizeof(channels[0])))
+                        return CANERR_RESOURCE;
+                    channels[count++] = &op->m_Channel;
+                }
+            } else
+                transmit = true;
+            if (op->m_Timed)
+                wait = std::min(wait, Clock::duration(std::max(op->m_Deadline - now, Clock::duration::zero())));
+        }
+        if (transmit)
+            wait = std::min(wait, Clock::duration(std::chrono::milliseconds(PEAKCAN_REACTOR_TX_POLL)));
+        uint16_t msec = (wait == Clock::duration::max()) ? (uint16_t)CANREAD_INFINITE
+                      : (uint16_t)std::min<long long>(std::chrono::ceil<std::chrono::milliseconds>(wait).count(),
+                                                      (long long)(CANREAD_INFINITE - 1U));
+        // (2) wait for reception on any channel (or sleep for the transmitters)
+        if (count) {
+            uint32_t ready = 0U;
+            (void)CPeakCAN::WaitAny(channels, count, ready, msec);  // note: errors are reported by TryNow
+        } else if (msec) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(msec));
+        }
+        // (3) complete the operations, then resume (resumption may suspend again)
+        std::vector<CAwaiter*> done;
+        now = Clock::now();
+        for (auto it = m_Pending.begin(); it != m_Pending.end(); ) {
+            CAwaiter *op = *it;
+            if (op->TryNow()) {
+                done.push_back(op);
+                it = m_Pending.erase(it);
+            } else if (op->m_Timed && (now >= op->m_Deadline)) {
+                done.push_back(op);  // m_Result is RX_EMPTY or TX_BUSY
+                it = m_Pending.erase(it);
+            } else
+                ++it;
+        }
+        for (CAwaiter *op : done)
+            op->m_Handle.resume();
+        return (int)done.size();
+    }
+    /// \brief  runs until Stop() is called or no coroutine is suspended
+    void Run() {
+        m_Running = true;
+        while (m_Running && !m_Pending.empty()) {
+            if (RunOnce() < 0)
+                break;
+        }
+    }
+    /// \brief  stops Run() after the current cycle (from a coroutine)
+    void Stop() { m_Running = false; }
+private:
+    std::vector<CAwaiter*> m_Pending;  ///< suspended operations (in order)
+    bool m_Running = false;  ///< flag: Run() active
+};
+/// \}
+#endif // __cpp_impl_coroutine
+#endif // PEAKCAN_ASYNC_H_INCLUDED
@@ -0,0 +1,220 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (for PEAK PCAN Interfaces)
+//
+//  Copyright (c) 2017-2021 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of PCANBasic-Wrapper.
+//
+//  PCANBasic-Wrapper is dual-licensed under the BSD 2-Clause "Simplified" License
+//  and under the GNU General Public License v3.0 (or any later version). You can
+//  choose between one of them if you use PCANBasic-Wrapper in whole or in part.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  PCANBasic-Wrapper IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF PCANBasic-Wrapper, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  PCANBasic-Wrapper is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  PCANBasic-Wrapper is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+#ifndef PEAKCAN_BUSLOAD_H_INCLUDED
+#define PEAKCAN_BUSLOAD_H_INCLUDED
+
+#include "CANAPI.h"
+
+/// \name   PeakCAN Bus Load
+/// \brief  Length of a CAN frame on the bus, for bus-load calculation.
+/// \note   CAN 2.0 frames are counted exactly: the frame is built in a bit
+///         buffer, including the CRC-15, and the stuff bits are counted.
+///         CAN FD frames are exact as well: dynamic stuffing ends with the
+///         data field, and the stuff count and CRC field have a fixed
+///         number of (fixed) stuff bits. With bit-rate switching, the bits
+///         from ESI to the end of the CRC field are sent with the data
+///         bit-rate (the switch points at BRS and CRC delimiter are taken
+///         as whole bits).
+/// \note   CRC and stuff bits are calculated a byte at a time with tables
+///         (built on first use), so a random payload costs no more than a
+///         constant one.
+/// \note   The length includes CRC delimiter, ACK slot and delimiter, end
+///         of frame and the 3-bit intermission. Status messages have none.
+/// \{
+class CPeakCANBusLoad {
+    struct STables {
+        uint16_t crc[256];  ///< CRC-15 of a byte
+        uint8_t stuff[8][256];  ///< stuff state (bits 0..2) and stuff bits (bits 3..7) after a byte
+        STables() {
+            for (unsigned i = 0U; i < 256U; i++) {
+                uint16_t value = (uint16_t)(i << 7);
+                for (unsigned k = 0U; k < 8U; k++)
+                    value = (uint16_t)(((value << 1) ^ ((value & 0x4000U) ? 0x4599U : 0U)) & 0x7FFFU);
+                crc[i] = value;
+            }
+            for (unsigned state = 0U; state < 8U; state++) {
+                for (unsigned i = 0U; i < 256U; i++) {
+                    unsigned next = state, count = 0U;
+                    for (unsigned k = 8U; k > 0U; k--)
+                        count += Stuff(next, (i >> (k - 1U)) & 1U);
+                    stuff[state][i] = (uint8_t)(next | (count << 3));
+                }
+            }
+        }
+    };
+    struct SBits {  // frame bits (MSB first)
+        uint8_t byte[80];
+        unsigned count;  ///< number of bits
+        uint32_t cache;  ///< bits not yet in the buffer
+        unsigned fill;  ///< number of bits in the cache
+
+        void Put(uint32_t value, unsigned n) {  // n <= 24
+            cache = (cache << n) | (value & ((1U << n) - 1U));
+            fill += n;
+            count += n;
+            while (fill >= 8U) {
+                fill -= 8U;
+                byte[(count - fill) / 8U - 1U] = (uint8_t)(cache >> fill);
+            }
+        }
+        void Close() {  // the last bits (left-aligned)
+            if (fill)
+                byte[count / 8U] = (uint8_t)(cache << (8U - fill));
+        }
+        unsigned Bit(unsigned index) const {
+            return (byte[index / 8U] >> (7U - (index % 8U))) & 1U;
+        }
+    };
+    static const STables &Tables() {
+        static const STables tables;  // thread-safe since C++11
+        return tables;
+    }
+    /// \brief  stuff state: last bit (bit 2) and number of equal bits in a row - 1 (bits 0..1)
+    static unsigned Stuff(unsigned &state, unsigned bit) {
+        if (bit != (state >> 2))
+            state = bit << 2;
+        else if ((state & 3U) != 3U)
+            state++;
+        else {  // 5th equal bit: stuff bit of opposite value
+            state = (bit ^ 1U) << 2;
+            return 1U;
+        }
+        return 0U;
+    }
+    /// \brief  number of stuff bits in the bits [from, to) of the buffer
+    static unsigned Stuff(const SBits &bits, unsigned from, unsigned to, unsigned &state) {
+        const STables &tables = Tables();
+        unsigned count = 0U;
+        for (; (from < to) && (from % 8U); from++)
+            count += Stuff(state, bits.Bit(from));
+        for (; (from + 8U) <= to; from += 8U) {
+            uint8_t entry = tables.stuff[state][bits.byte[from / 8U]];
+            state = entry & 7U;
+            count += entry >> 3;
+        }
+        for (; from < to; from++)
+            count += Stuff(state, bits.Bit(from));
+        return count;
+    }
+    /// \brief  CRC-15 of all bits in the buffer
+    static uint16_t Crc15(const SBits &bits) {
+        const STables &tables = Tables();
+        uint16_t crc = 0U;
+        unsigned index = 0U;
+        for (; (index + 8U) <= bits.count; index += 8U)
+            crc = (uint16_t)(((crc << 8) ^ tables.crc[((crc >> 7) ^ bits.byte[index / 8U]) & 0xFFU]) & 0x7FFFU);
+        for (; index < bits.count; index++)
+            crc = (uint16_t)(((crc << 1) ^ (((crc >> 14) ^ bits.Bit(index)) ? 0x4599U : 0U)) & 0x7FFFU);
+        return crc;
+    }
+public:
+    static const uint32_t TRAILER = 1U + 2U + 7U + 3U;  ///< CRC delimiter, ACK, EOF and intermission
+
+    /// \brief  length of a frame in bits (0 for status messages)
+    /// \param[out] fast - number of these bits sent with the data bit-rate (or NULL)
+    static uint32_t Bits(const CANAPI_Message_t &message, uint32_t *fast = NULL) {
+        SBits bits;
+        bits.count = bits.cache = bits.fill = 0U;
+        unsigned state = 1U << 2;  // bus idle (recessive)
+        if (fast)
+            *fast = 0U;
+        if (message.sts)
+            return 0U;
+        uint8_t length = CCANAPI::Dlc2Len(message.dlc);
+        bits.Put(0U, 1U);  // SOF
+        if (message.xtd) {
+            bits.Put((message.id >> 18) & 0x7FFU, 11U);
+            bits.Put(3U, 2U);  // SRR, IDE
+            bits.Put(message.id & 0x3FFFFU, 18U);
+        }
+        else
+            bits.Put(message.id & 0x7FFU, 11U);
+        if (!message.fdf) {
+            // CAN 2.0: RTR, IDE/r1, r0, DLC, data, CRC-15
+            bits.Put(message.rtr ? 1U : 0U, 1U);
+            bits.Put(0U, 2U);
+            bits.Put(message.dlc & 0xFU, 4U);
+            if (message.rtr)
+                length = 0U;
+            else if (length > CAN_MAX_LEN)
+                length = CAN_MAX_LEN;
+            for (uint8_t i = 0U; i < length; i++)
+                bits.Put(message.data[i], 8U);
+            bits.Close();
+            bits.Put(Crc15(bits), 15U);
+            bits.Close();
+            return bits.count + Stuff(bits, 0U, bits.count, state) + TRAILER;
+        }
+        // CAN FD: RRS, (IDE,) FDF, res, BRS | ESI, DLC, data
+        if (message.xtd)
+            bits.Put(0x2U, 3U);  // RRS, FDF, res
+        else
+            bits.Put(0x2U, 4U);  // RRS, IDE, FDF, res
+        bits.Put(message.brs ? 1U : 0U, 1U);
+        unsigned arbitration = bits.count;
+        bits.Put(message.esi ? 1U : 0U, 1U);
+        bits.Put(message.dlc & 0xFU, 4U);
+        for (uint8_t i = 0U; i < length; i++)
+            bits.Put(message.data[i], 8U);
+        bits.Close();
+        unsigned nominal = arbitration + Stuff(bits, 0U, arbitration, state);
+        unsigned data = (bits.count - arbitration) + Stuff(bits, arbitration, bits.count, state);
+        // stuff count and CRC-17/21 with fixed stuff bits
+        data += (length <= 16U) ? (4U + 17U + 6U) : (4U + 21U + 7U);
+        if (fast && message.brs)
+            *fast = data;
+        return nominal + data + TRAILER;
+    }
+    /// \brief  duration of a frame on the bus in [ns] (0 for status messages)
+    static uint64_t Nanoseconds(const CANAPI_Message_t &message, const CANAPI_BusSpeed_t &speed) {
+        uint32_t fast = 0U;
+        uint32_t bits = Bits(message, &fast);
+        double nominal = (speed.nominal.speed > 0.0F) ? (double)speed.nominal.speed : 1.0E6;
+        double data = (speed.data.speed > 0.0F) ? (double)speed.data.speed : nominal;
+        return (uint64_t)(((double)(bits - fast) / nominal + (double)fast / data) * 1.0E9 + 0.5);
+    }
+};
+/// \}
+
+#endif // PEAKCAN_BUSLOAD_H_INCLUDED
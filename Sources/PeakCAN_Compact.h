@@ -0,0 +1,622 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (for PEAK PCAN Interfaces)
+//
+//  Copyright (c) 2017-2021 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of PCANBasic-Wrapper.
+//
+//  PCANBasic-Wrapper is dual-licensed under the BSD 2-Clause "Simplified" License
+//  and under the GNU General Public License v3.0 (or any later version). You can
+//  choose between one of them if you use PCANBasic-Wrapper in whole or in part.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  PCANBasic-Wrapper IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF PCANBasic-Wrapper, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  PCANBasic-Wrapper is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  PCANBasic-Wrapper is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+#ifndef PEAKCAN_COMPACT_H_INCLUDED
+#define PEAKCAN_COMPACT_H_INCLUDED
+
+#include "CANAPI.h"
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <stdio.h>
+#include <string.h>
+
+/// \name   PeakCAN Compact Capture
+/// \brief  Compact capture format for long recordings: the messages are
+///         encoded in blocks, and each block is compressed on its own.
+/// \note   Encoding of a message (a few bytes instead of a CANAPI_Message_t):
+///         - flags (format bits, new identifier, time unit)
+///         - time-stamp as difference to the previous message (zigzag
+///           varint, in microseconds if possible, otherwise nanoseconds)
+///         - identifier as index into the dictionary of the block, or as
+///           literal (varint) when it occurs for the first time
+///         - DLC, and only as many data bytes as the DLC says; the data is
+///           XOR-ed with the last payload of the same identifier, which
+///           turns unchanged bytes into zeros for the compression.
+/// \note   Blocks are independent (dictionary and time base are reset), so
+///         a block can be decoded without its predecessors. The compression
+///         is a byte-oriented LZ77 with a single hash probe (LZ4-style block
+///         format); a block that does not shrink is stored as is.
+/// \note   CPeakCANCompactWriter encodes in the caller's thread; full blocks
+///         are compressed and written by a background thread.
+/// \{
+#define PEAKCAN_COMPACT_MAGIC  0x5A434350U  ///< "PCCZ"
+#define PEAKCAN_COMPACT_VERSION  1U  ///< version of the format
+#define PEAKCAN_COMPACT_BLOCK  65536U  ///< maximum size of an encoded block in bytes
+#define PEAKCAN_COMPACT_WORDS  1024U  ///< maximum number of identifiers in the dictionary of a block
+#define PEAKCAN_COMPACT_QUEUE  16U  ///< maximum number of blocks waiting for the writer thread
+
+/// \brief  encoding and compression of the compact capture format
+class CPeakCANCompact {
+public:
+    /// \brief  header of a compact capture file
+    struct SFileHeader {
+        uint32_t u32Magic;  ///< PEAKCAN_COMPACT_MAGIC
+        uint16_t u16Version;  ///< PEAKCAN_COMPACT_VERSION
+        uint16_t u16Reserved;
+        uint32_t u32BlockSize;  ///< maximum size of an encoded block
+        uint32_t u32Reserved;
+    };
+    /// \brief  header of a block
+    struct SBlockHeader {
+        uint32_t u32Messages;  ///< number of messages in the block
+        uint32_t u32RawSize;  ///< size of the encoded block
+        uint32_t u32StoredSize;  ///< size of the stored block (== u32RawSize: not compressed)
+        uint32_t u32Reserved;
+        uint64_t u64Time;  ///< time-stamp of the first message in [ns]
+    };
+    static const size_t MAX_MESSAGE = 1U + 10U + 5U + 1U + CANFD_MAX_LEN;  ///< worst case of an encoded message
+protected:
+    enum {
+        FLAG_XTD = 0x01, FLAG_RTR = 0x02, FLAG_FDF = 0x04, FLAG_BRS = 0x08,
+        FLAG_ESI = 0x10, FLAG_STS = 0x20, FLAG_LITERAL = 0x40, FLAG_MICROS = 0x80
+    };
+    static const uint32_t SLOTS = 4096U;  ///< hash slots of the dictionary (> 2 * PEAKCAN_COMPACT_WORDS)
+
+    struct SWord {  // dictionary entry
+        uint32_t key;  ///< identifier | xtd << 31
+        uint8_t data[CANFD_MAX_LEN];  ///< last payload of the identifier
+    };
+    std::vector<SWord> m_Words;  ///< dictionary of the current block
+    std::vector<uint32_t> m_Slots;  ///< hash table (index + 1, 0 = free)
+    uint64_t m_Time;  ///< time-stamp of the previous message in [ns]
+
+    CPeakCANCompact() : m_Slots(SLOTS, 0U), m_Time(0U) { m_Words.reserve(PEAKCAN_COMPACT_WORDS); }
+
+    /// \brief  starts a new block (time base 'time')
+    void Reset(uint64_t time) {
+        for (size_t i = m_Words.size(); i > 0U; i--)  // reverse order keeps the probe chains intact
+            m_Slots[Find(m_Words[i - 1U].key)] = 0U;
+        m_Words.clear();
+        m_Time = time;
+    }
+    static uint64_t Nanoseconds(const CANAPI_Message_t &message) {
+        return (uint64_t)message.timestamp.tv_sec * 1000000000U + (uint64_t)message.timestamp.tv_nsec;
+    }
+    /// \brief  slot of a key (occupied by it, or free)
+    uint32_t Find(uint32_t key) const {
+        uint32_t slot = (key * 2654435761U) >> 20;  // 12 bits
+        while (m_Slots[slot] && (m_Words[m_Slots[slot] - 1U].key != key))
+            slot = (slot + 1U) & (SLOTS - 1U);
+        return slot;
+    }
+    /// \brief  dictionary entry of a key, added if new and there is room (returns NULL otherwise)
+    SWord *Lookup(uint32_t key, bool &added) {
+        uint32_t slot = Find(key);
+        added = false;
+        if (m_Slots[slot])
+            return &m_Words[m_Slots[slot] - 1U];
+        if (m_Words.size() >= PEAKCAN_COMPACT_WORDS)
+            return NULL;
+        SWord word;
+        word.key = key;
+        memset(word.data, 0, sizeof(word.data));
+        m_Words.push_back(word);
+        m_Slots[slot] = (uint32_t)m_Words.size();
+        added = true;
+        return &m_Words.back();
+    }
+    static uint8_t *PutVarint(uint8_t *p, uint64_t value) {
+        while (value >= 0x80U) {
+            *p++ = (uint8_t)(value | 0x80U);
+            value >>= 7;
+        }
+        *p++ = (uint8_t)value;
+        return p;
+    }
+    static const uint8_t *GetVarint(const uint8_t *p, const uint8_t *end, uint64_t &value) {
+        value = 0U;
+        for (unsigned shift = 0U; (p < end) && (shift < 64U); shift += 7U) {
+            uint8_t byte = *p++;
+            value |= (uint64_t)(byte & 0x7FU) << shift;
+            if (!(byte & 0x80U))
+                return p;
+        }
+        return NULL;  // truncated
+    }
+    /// \brief  encodes a message at 'p' (MAX_MESSAGE bytes available); returns the end
+    uint8_t *Encode(uint8_t *p, const CANAPI_Message_t &message) {
+        uint8_t *flags = p++;
+        uint8_t bits = (message.xtd ? FLAG_XTD : 0) | (message.rtr ? FLAG_RTR : 0) |
+                       (message.fdf ? FLAG_FDF : 0) | (message.brs ? FLAG_BRS : 0) |
+                       (message.esi ? FLAG_ESI : 0) | (message.sts ? FLAG_STS : 0);
+        uint64_t time = Nanoseconds(message);
+        int64_t delta = (int64_t)(time - m_Time);
+        m_Time = time;
+        if (!(delta % 1000)) {
+            bits |= FLAG_MICROS;
+            delta /= 1000;
+        }
+        p = PutVarint(p, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));  // zigzag
+        bool added;
+        SWord *word = Lookup((message.id & CAN_MAX_XTD_ID) | (message.xtd ? 0x80000000U : 0U), added);
+        if (!word || added) {
+            bits |= FLAG_LITERAL;
+            p = PutVarint(p, message.id);
+        }
+        else
+            p = PutVarint(p, (uint64_t)(word - &m_Words[0]));
+        *flags = bits;
+        *p++ = message.dlc;
+        uint8_t length = CCANAPI::Dlc2Len(message.dlc);
+        if (message.rtr)
+            length = 0U;
+        if (word) {
+            for (uint8_t i = 0U; i < length; i++)
+                p[i] = message.data[i] ^ word->data[i];
+            memcpy(word->data, message.data, length);
+            memset(word->data + length, 0, CANFD_MAX_LEN - length);
+        }
+        else
+            memcpy(p, message.data, length);
+        return p + length;
+    }
+    /// \brief  decodes a message at 'p'; returns the end, or NULL if the data is corrupt
+    const uint8_t *Decode(const uint8_t *p, const uint8_t *end, CANAPI_Message_t &message) {
+        uint64_t value;
+        if (p >= end)
+            return NULL;
+        uint8_t bits = *p++;
+        if (!(p = GetVarint(p, end, value)))
+            return NULL;
+        int64_t delta = (int64_t)(value >> 1) ^ -(int64_t)(value & 1U);
+        m_Time += (uint64_t)((bits & FLAG_MICROS) ? delta * 1000 : delta);
+        memset(&message, 0, sizeof(CANAPI_Message_t));
+        message.xtd = (bits & FLAG_XTD) ? 1 : 0;
+        message.rtr = (bits & FLAG_RTR) ? 1 : 0;
+        message.fdf = (bits & FLAG_FDF) ? 1 : 0;
+        message.brs = (bits & FLAG_BRS) ? 1 : 0;
+        message.esi = (bits & FLAG_ESI) ? 1 : 0;
+        message.sts = (bits & FLAG_STS) ? 1 : 0;
+        message.timestamp.tv_sec = (time_t)(m_Time / 1000000000U);
+        message.timestamp.tv_nsec = (long)(m_Time % 1000000000U);
+        if (!(p = GetVarint(p, end, value)))
+            return NULL;
+        SWord *word;
+        if (bits & FLAG_LITERAL) {
+            bool added;
+            message.id = (uint32_t)value;
+            word = Lookup((message.id & CAN_MAX_XTD_ID) | (message.xtd ? 0x80000000U : 0U), added);
+        }
+        else {
+            if (value >= m_Words.size())
+                return NULL;
+            word = &m_Words[(size_t)value];
+            message.id = word->key & CAN_MAX_XTD_ID;
+        }
+        if (p >= end)
+            return NULL;
+        message.dlc = *p++;
+        uint8_t length = message.rtr ? 0U : CCANAPI::Dlc2Len(message.dlc);
+        if ((message.dlc > CANFD_MAX_DLC) || ((size_t)(end - p) < length))
+            return NULL;
+        if (word) {
+            for (uint8_t i = 0U; i < length; i++)
+                message.data[i] = p[i] ^ word->data[i];
+            memcpy(word->data, message.data, length);
+            memset(word->data + length, 0, CANFD_MAX_LEN - length);
+        }
+        else
+            memcpy(message.data, p, length);
+        return p + length;
+    }
+public:
+    /// \brief  compresses 'size' bytes; returns the compressed size, or 0 if it does not shrink
+    static size_t Compress(const uint8_t *source, size_t size, uint8_t *target, std::vector<uint32_t> &table) {
+        const size_t HASH_BITS = 14U;
+        table.assign((size_t)1 << HASH_BITS, 0U);  // position + 1
+        uint8_t *out = target, *limit = target + size;  // must shrink
+        size_t ip = 0U, anchor = 0U;
+        while ((size > 12U) && (ip < size - 12U)) {  // the last bytes are literals
+            uint32_t sequence;
+            memcpy(&sequence, source + ip, 4U);
+            uint32_t hash = (sequence * 2654435761U) >> (32U - HASH_BITS);
+            size_t ref = table[hash];
+            table[hash] = (uint32_t)ip + 1U;
+            if (!ref || ((ip - --ref) > 0xFFFFU) || memcmp(source + ref, source + ip, 4U)) {
+                ip++;
+                continue;
+            }
+            size_t length = 4U;
+            while ((ip + length < size - 5U) && (source[ref + length] == source[ip + length]))
+                length++;
+            if (!(out = Sequence(out, limit, source + anchor, ip - anchor, ip - ref, length)))
+                return 0U;
+            ip += length;
+            anchor = ip;
+        }
+        if (!(out = Sequence(out, limit, source + anchor, size - anchor, 0U, 0U)))
+            return 0U;
+        return (size_t)(out - target);
+    }
+    /// \brief  decompresses into exactly 'size' bytes; returns false if the data is corrupt
+    static bool Decompress(const uint8_t *source, size_t stored, uint8_t *target, size_t size) {
+        const uint8_t *ip = source, *end = source + stored;
+        uint8_t *op = target, *limit = target + size;
+        while (ip < end) {
+            uint8_t token = *ip++;
+            size_t literals = token >> 4;
+            if ((literals == 15U) && !Length(ip, end, literals))
+                return false;
+            if (((size_t)(end - ip) < literals) || ((size_t)(limit - op) < literals))
+                return false;
+            memcpy(op, ip, literals);
+            ip += literals;
+            op += literals;
+            if (ip == end)
+                break;  // last sequence: literals only
+            if ((end - ip) < 2)
+                return false;
+            size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+            ip += 2;
+            size_t length = (token & 0x0FU);
+            if ((length == 15U) && !Length(ip, end, length))
+                return false;
+            length += 4U;
+            if (!offset || (offset > (size_t)(op - target)) || ((size_t)(limit - op) < length))
+                return false;
+            const uint8_t *match = op - offset;
+            for (size_t i = 0U; i < length; i++)  // may overlap
+                op[i] = match[i];
+            op += length;
+        }
+        return (op == limit);
+    }
+private:
+    static uint8_t *Sequence(uint8_t *out, uint8_t *limit, const uint8_t *literals, size_t count, size_t offset, size_t length) {
+        size_t extra = (count / 255U) + (length / 255U) + 4U;
+        if ((size_t)(limit - out) < (1U + count + extra))
+            return NULL;
+        uint8_t *token = out++;
+        *token = (uint8_t)(((count >= 15U) ? 15U : count) << 4);
+        if (count >= 15U)
+            out = PutLength(out, count - 15U);
+        memcpy(out, literals, count);
+        out += count;
+        if (length) {
+            *out++ = (uint8_t)offset;
+            *out++ = (uint8_t)(offset >> 8);
+            length -= 4U;
+            *token |= (uint8_t)((length >= 15U) ? 15U : length);
+            if (length >= 15U)
+                out = PutLength(out, length - 15U);
+        }
+        return out;
+    }
+    static uint8_t *PutLength(uint8_t *out, size_t length) {
+        for (; length >= 255U; length -= 255U)
+            *out++ = 255U;
+        *out++ = (uint8_t)length;
+        return out;
+    }
+    static bool Length(const uint8_t *&ip, const uint8_t *end, size_t &length) {
+        uint8_t byte;
+        do {
+            if (ip >= end)
+                return false;
+            length += (byte = *ip++);
+        } while (byte == 255U);
+        return true;
+    }
+};
+/// \brief  writer of a compact capture file (encoding in the caller's thread,
+///         compression and file output in a background thread)
+class CPeakCANCompactWriter : protected CPeakCANCompact {
+public:
+    /// \brief  statistics of the writer
+    struct SStatistics {
+        uint64_t u64Messages;  ///< messages encoded
+        uint64_t u64Blocks;  ///< blocks written
+        uint64_t u64RawBytes;  ///< encoded bytes (before compression)
+        uint64_t u64StoredBytes;  ///< bytes written into the file (with headers)
+        uint64_t u64Stalls;  ///< Write() had to wait for the writer thread
+    };
+private:
+    struct SBlock {  // block handed over to the writer thread
+        SBlockHeader header;
+        std::vector<uint8_t> data;
+    };
+    FILE *m_pFile;  ///< capture file
+    SBlock m_Block;  ///< block being encoded (caller's thread)
+    std::deque<SBlock> m_Queue;  ///< blocks waiting for the writer thread
+    std::vector<std::vector<uint8_t> > m_Pool;  ///< recycled block buffers
+    std::thread m_Writer;  ///< writer thread
+    bool m_Closing;  ///< flag: no more blocks
+    std::atomic<bool> m_Failed;  ///< flag: file output failed
+    std::mutex m_Mutex;  ///< protects the queue, the pool and the statistics
+    std::condition_variable m_Cond;  ///< signals new blocks
+    std::condition_variable m_Done;  ///< signals processed blocks
+    SStatistics m_Statistics;  ///< statistics
+public:
+    CPeakCANCompactWriter() : m_pFile(NULL), m_Closing(false), m_Failed(false) {
+        memset(&m_Statistics, 0, sizeof(m_Statistics));
+        memset(&m_Block.header, 0, sizeof(m_Block.header));
+    }
+    ~CPeakCANCompactWriter() {
+        (void)Close();
+    }
+    /// \brief  creates a compact capture file
+    CANAPI_Return_t Open(const char *path) {
+        if (m_pFile)
+            return CANERR_YETINIT;
+        if (!path)
+            return CANERR_NULLPTR;
+        if (!(m_pFile = fopen(path, "wb")))
+            return CANERR_RESOURCE;
+        SFileHeader header;
+        memset(&header, 0, sizeof(header));
+        header.u32Magic = PEAKCAN_COMPACT_MAGIC;
+        header.u16Version = PEAKCAN_COMPACT_VERSION;
+        header.u32BlockSize = PEAKCAN_COMPACT_BLOCK;
+        if (fwrite(&header, sizeof(header), 1U, m_pFile) != 1U) {
+            fclose(m_pFile);
+            m_pFile = NULL;
+            return CANERR_RESOURCE;
+        }
+        memset(&m_Statistics, 0, sizeof(m_Statistics));
+        m_Statistics.u64StoredBytes = sizeof(header);
+        m_Block.header.u32Messages = 0U;
+        m_Block.data.resize(PEAKCAN_COMPACT_BLOCK);
+        m_Closing = false;
+        m_Failed = false;
+        m_Writer = std::thread(&CPeakCANCompactWriter::Writer, this);
+        return CANERR_NOERROR;
+    }
+    /// \brief  flushes the last block and closes the file
+    /// \return CANERR_FATAL if the file output has failed
+    CANAPI_Return_t Close() {
+        if (!m_pFile)
+            return CANERR_NOTINIT;
+        (void)Flush();
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Closing = true;
+        }
+        m_Cond.notify_all();
+        m_Writer.join();
+        bool failed = m_Failed || (fclose(m_pFile) != 0);
+        m_pFile = NULL;
+        m_Queue.clear();
+        m_Pool.clear();
+        return failed ? CANERR_FATAL : CANERR_NOERROR;
+    }
+    /// \brief  encodes a message (waits if the writer thread is PEAKCAN_COMPACT_QUEUE blocks behind)
+    CANAPI_Return_t Write(const CANAPI_Message_t &message) {
+        if (!m_pFile)
+            return CANERR_NOTINIT;
+        if (m_Failed)
+            return CANERR_FATAL;
+        SBlockHeader &header = m_Block.header;
+        if ((header.u32RawSize + MAX_MESSAGE) > PEAKCAN_COMPACT_BLOCK)
+            (void)Flush();
+        if (!header.u32Messages) {
+            header.u64Time = Nanoseconds(message);
+            Reset(header.u64Time);
+        }
+        uint8_t *p = &m_Block.data[header.u32RawSize];
+        header.u32RawSize += (uint32_t)(Encode(p, message) - p);
+        header.u32Messages++;
+        return CANERR_NOERROR;
+    }
+    /// \brief  hands the current block over to the writer thread
+    CANAPI_Return_t Flush() {
+        if (!m_pFile)
+            return CANERR_NOTINIT;
+        if (!m_Block.header.u32Messages)
+            return CANERR_NOERROR;
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        if (m_Queue.size() >= PEAKCAN_COMPACT_QUEUE) {
+            m_Statistics.u64Stalls++;
+            m_Done.wait(lock, [this] { return m_Queue.size() < PEAKCAN_COMPACT_QUEUE; });
+        }
+        m_Statistics.u64Messages += m_Block.header.u32Messages;
+        m_Statistics.u64RawBytes += m_Block.header.u32RawSize;
+        m_Queue.push_back(SBlock());
+        m_Queue.back().header = m_Block.header;
+        m_Queue.back().data.swap(m_Block.data);
+        if (!m_Pool.empty()) {
+            m_Block.data.swap(m_Pool.back());
+            m_Pool.pop_back();
+        }
+        lock.unlock();
+        m_Cond.notify_one();
+        m_Block.data.resize(PEAKCAN_COMPACT_BLOCK);
+        memset(&m_Block.header, 0, sizeof(m_Block.header));
+        return CANERR_NOERROR;
+    }
+    /// \brief  retrieves the statistics of the writer (handed over blocks only)
+    void GetStatistics(SStatistics &statistics) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        statistics = m_Statistics;
+    }
+private:
+    void Writer() {
+        std::vector<uint8_t> buffer(PEAKCAN_COMPACT_BLOCK);
+        std::vector<uint32_t> table;
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        for (;;) {
+            m_Cond.wait(lock, [this] { return !m_Queue.empty() || m_Closing; });
+            if (m_Queue.empty())
+                break;
+            SBlock &block = m_Queue.front();  // only the caller's thread pushes at the back
+            lock.unlock();
+            size_t size = Compress(&block.data[0], block.header.u32RawSize, &buffer[0], table);
+            block.header.u32StoredSize = size ? (uint32_t)size : block.header.u32RawSize;
+            const uint8_t *data = size ? &buffer[0] : &block.data[0];
+            bool ok = (fwrite(&block.header, sizeof(SBlockHeader), 1U, m_pFile) == 1U) &&
+                      (fwrite(data, 1U, block.header.u32StoredSize, m_pFile) == block.header.u32StoredSize);
+            lock.lock();
+            if (!ok)
+                m_Failed = true;
+            m_Statistics.u64Blocks++;
+            m_Statistics.u64StoredBytes += sizeof(SBlockHeader) + block.header.u32StoredSize;
+            m_Pool.push_back(std::vector<uint8_t>());
+            m_Pool.back().swap(block.data);
+            m_Queue.pop_front();
+            m_Done.notify_all();
+        }
+    }
+};
+
+/// \brief  decoder of a single block (e.g. from a memory-mapped file)
+class CPeakCANCompactBlock : protected CPeakCANCompact {
+    std::vector<uint8_t> m_Block;  ///< decompressed block
+    const uint8_t *m_Next;  ///< next message in the block
+    const uint8_t *m_End;  ///< end of the block
+    uint32_t m_Remaining;  ///< messages left in the block
+public:
+    CPeakCANCompactBlock() : m_Next(NULL), m_End(NULL), m_Remaining(0U) {}
+
+    /// \brief  loads a block from its stored data (which must stay valid if not compressed)
+    /// \return false if the block is corrupt or larger than 'blockSize'
+    bool Load(const SBlockHeader &header, const uint8_t *stored, uint32_t blockSize = PEAKCAN_COMPACT_BLOCK) {
+        m_Remaining = 0U;
+        if ((header.u32RawSize > blockSize) || (header.u32StoredSize > header.u32RawSize))
+            return false;
+        if (header.u32StoredSize == header.u32RawSize)
+            m_Next = stored;
+        else {
+            m_Block.resize(blockSize);
+            if (!Decompress(stored, header.u32StoredSize, &m_Block[0], header.u32RawSize))
+                return false;
+            m_Next = &m_Block[0];
+        }
+        m_End = m_Next + header.u32RawSize;
+        m_Remaining = header.u32Messages;
+        Reset(header.u64Time);
+        return true;
+    }
+    /// \brief  decodes the next message of the block
+    /// \return CANERR_RX_EMPTY at the end of the block, CANERR_ILLPARA if the block is corrupt
+    CANAPI_Return_t Next(CANAPI_Message_t &message) {
+        if (!m_Remaining)
+            return CANERR_RX_EMPTY;
+        if (!(m_Next = Decode(m_Next, m_End, message))) {
+            m_Remaining = 0U;
+            return CANERR_ILLPARA;
+        }
+        m_Remaining--;
+        return CANERR_NOERROR;
+    }
+};
+
+/// \brief  sequential reader of a compact capture file
+class CPeakCANCompactReader {
+    typedef CPeakCANCompact::SFileHeader SFileHeader;
+    typedef CPeakCANCompact::SBlockHeader SBlockHeader;
+    FILE *m_pFile;  ///< capture file
+    CPeakCANCompactBlock m_Block;  ///< current block
+    std::vector<uint8_t> m_Stored;  ///< stored block
+    uint32_t m_BlockSize;  ///< maximum size of an encoded block
+public:
+    CPeakCANCompactReader() : m_pFile(NULL), m_BlockSize(0U) {}
+    ~CPeakCANCompactReader() {
+        (void)Close();
+    }
+    /// \brief  opens a compact capture file
+    CANAPI_Return_t Open(const char *path) {
+        if (m_pFile)
+            return CANERR_YETINIT;
+        if (!path)
+            return CANERR_NULLPTR;
+        if (!(m_pFile = fopen(path, "rb")))
+            return CANERR_RESOURCE;
+        SFileHeader header;
+        if ((fread(&header, sizeof(header), 1U, m_pFile) != 1U) || (header.u32Magic != PEAKCAN_COMPACT_MAGIC) ||
+            (header.u16Version != PEAKCAN_COMPACT_VERSION) || !header.u32BlockSize) {
+            fclose(m_pFile);
+            m_pFile = NULL;
+            return CANERR_ILLPARA;
+        }
+        m_BlockSize = header.u32BlockSize;
+        m_Stored.resize(m_BlockSize);
+        SBlockHeader empty;
+        memset(&empty, 0, sizeof(empty));
+        (void)m_Block.Load(empty, &m_Stored[0], m_BlockSize);
+        return CANERR_NOERROR;
+    }
+    /// \brief  closes the file
+    CANAPI_Return_t Close() {
+        if (!m_pFile)
+            return CANERR_NOTINIT;
+        fclose(m_pFile);
+        m_pFile = NULL;
+        return CANERR_NOERROR;
+    }
+    /// \brief  reads the next message
+    /// \return CANERR_RX_EMPTY at the end of the file, CANERR_ILLPARA if the file is corrupt
+    CANAPI_Return_t Read(CANAPI_Message_t &message) {
+        if (!m_pFile)
+            return CANERR_NOTINIT;
+        CANAPI_Return_t rc;
+        while ((rc = m_Block.Next(message)) == CANERR_RX_EMPTY) {
+            SBlockHeader header;
+            if (fread(&header, sizeof(header), 1U, m_pFile) != 1U)
+                return CANERR_RX_EMPTY;  // also a block header cut off by a crash
+            if ((header.u32StoredSize > header.u32RawSize) || (header.u32RawSize > m_BlockSize))
+                return CANERR_ILLPARA;
+            if (fread(&m_Stored[0], 1U, header.u32StoredSize, m_pFile) != header.u32StoredSize)
+                return CANERR_RX_EMPTY;
+            if (!m_Block.Load(header, &m_Stored[0], m_BlockSize))
+                return CANERR_ILLPARA;
+        }
+        return rc;
+    }
+};
+/// \}
+
+#endif // PEAKCAN_COMPACT_H_INCLUDED
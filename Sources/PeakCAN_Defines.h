@@ -129,6 +129,17 @@ extern "C" {
 #define PCAN_MAX_BUFFER_SIZE     256U   /**< max. buffer size for CAN_GetValue/CAN_SetValue */
 /** @} */
 
+/** @name  CAN API Property Value (Wrapper)
+ *  @brief Parameter of the wrapper itself (not passed to PCAN-Basic)
+ *  @{ */
+#define PCAN_PROP_STATUS_AGE     0xF0U  /**< age of the cached status register in [ms] (uint32_t) */
+#define PCAN_PROP_STATUS_MAX_AGE 0xF1U  /**< max. age of the cached status register in [ms] (uint32_t) */
+#define PCAN_PROP_STATUS_REFRESH 0xF2U  /**< refresh interval of the status thread in [ms], 0 = off (uint32_t) */
+#define PCAN_PROP_RX_EVENT       0xF3U  /**< event object signaled on message reception (void*) */
+#define PCAN_STATUS_MAX_AGE        0U   /**< default: status register is read on every call */
+#define PCAN_STATUS_AGE_UNKNOWN  0xFFFFFFFFU  /**< status register not read so far */
+/** @} */
+
 
 /** @name  CAN API Library ID
  *  @brief Library ID and dynamic library names
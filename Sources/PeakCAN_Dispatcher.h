@@ -0,0 +1,330 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (for PEAK PCAN Interfaces)
+//
+//  Copyright (c) 2017-2021 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of PCANBasic-Wrapper.
+//
+//  PCANBasic-Wrapper is dual-licensed under the BSD 2-Clause "Simplified" License
+//  and under the GNU General Public License v3.0 (or any later version). You can
+//  choose between one of them if you use PCANBasic-Wrapper in whole or in part.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  PCANBasic-Wrapper IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF PCANBasic-Wrapper, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  PCANBasic-Wrapper is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  PCANBasic-Wrapper is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+#ifndef PEAKCAN_DISPATCHER_H_INCLUDED
+#define PEAKCAN_DISPATCHER_H_INCLUDED
+
+#include "PeakCAN.h"
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+
+/// \name   PeakCAN Dispatcher
+/// \brief  Receive loop with per-identifier message handlers.
+/// \note   Handlers are looked up in O(1): an array for 11-bit identifiers
+///         and a hash table for 29-bit identifiers. Each handler is called
+///         either in the receive thread (inline) or on a pool of workers.
+///         The messages of one handler are always processed in order, one
+///         at a time; different handlers run in parallel. Idle workers
+///         steal ready handlers from the other workers.
+/// \note   Handlers must be subscribed before the dispatcher is started.
+/// \{
+#define PEAKCAN_DISPATCH_BATCH  16U  ///< messages of one handler per turn (fairness)
+#define PEAKCAN_DISPATCH_IDLE   10U  ///< back-off in [ms] when the channel cannot be read (e.g. bus off)
+
+class CPeakCANDispatcher {
+public:
+    typedef std::function<void(const CANAPI_Message_t &message)> Handler;
+    typedef std::chrono::steady_clock Clock;
+
+    /// \brief  metrics of one handler (times in [ns])
+    struct SMetrics {
+        uint64_t u64Frames;  ///< number of messages handled
+        uint64_t u64DelayTotal;  ///< sum of queueing delays (reception to call)
+        uint64_t u64DelayMax;  ///< maximum queueing delay
+        uint64_t u64RuntimeTotal;  ///< sum of handler run-times
+        uint64_t u64RuntimeMax;  ///< maximum handler run-time
+    };
+private:
+    struct SEntry {
+        CANAPI_Message_t message;  ///< received message
+        Clock::time_point received;  ///< time of reception (by the dispatcher)
+    };
+    struct SSlot {
+        Handler handler;  ///< message handler
+        bool inlineCall;  ///< call in the receive thread
+        std::mutex lock;  ///< protects fifo and scheduled
+        std::deque<SEntry> fifo;  ///< messages not handled so far
+        bool scheduled;  ///< slot is in the ready queue of a worker
+        std::atomic<uint64_t> frames, delayTotal, delayMax, runtimeTotal, runtimeMax;
+        SSlot(const Handler &h, bool i) : handler(h), inlineCall(i), scheduled(false),
+            frames(0U), delayTotal(0U), delayMax(0U), runtimeTotal(0U), runtimeMax(0U) {}
+    };
+    struct SWorker {
+        std::mutex lock;  ///< protects ready
+        std::deque<SSlot*> ready;  ///< slots with pending messages
+        std::thread thread;  ///< worker thread
+    };
+    CPeakCAN &m_Channel;  ///< CAN channel (started by the application)
+    std::vector<std::unique_ptr<SSlot>> m_Slots;  ///< all handlers
+    std::vector<int32_t> m_Standard;  ///< 11-bit identifier to slot (-1 = none)
+    std::unordered_map<uint32_t, int32_t> m_Extended;  ///< 29-bit identifier to slot
+    int32_t m_Default;  ///< slot for all other messages (-1 = none)
+    std::vector<std::unique_ptr<SWorker>> m_Workers;  ///< worker pool (may be empty)
+    std::thread m_Receiver;  ///< receive thread
+    std::atomic<bool> m_Running;  ///< flag: dispatcher running
+    std::atomic<size_t> m_Ready;  ///< number of ready slots (all workers)
+    std::atomic<size_t> m_Next;  ///< next worker for scheduling (round robin)
+    std::atomic<uint64_t> m_Unhandled;  ///< messages without handler
+    std::atomic<uint64_t> m_ReadErrors;  ///< failed reads (other than empty queue or error frame)
+    std::mutex m_Mutex;  ///< for the condition variable
+    std::condition_variable m_Wakeup;  ///< wakes up idle workers
+public:
+    /// \brief  dispatcher for 'channel' with 'workers' threads (0 = all inline)
+    CPeakCANDispatcher(CPeakCAN &channel, unsigned workers = 0U)
+        : m_Channel(channel), m_Standard(CAN_MAX_STD_ID + 1, -1), m_Default(-1),
+          m_Running(false), m_Ready(0U), m_Next(0U), m_Unhandled(0U), m_ReadErrors(0U) {
+        for (unsigned i = 0U; i < workers; i++)
+            m_Workers.emplace_back(new SWorker());
+    }
+    ~CPeakCANDispatcher() { (void)Stop(); }
+
+    /// \brief  subscribes a handler for the given identifier
+    CANAPI_Return_t Subscribe(uint32_t id, bool xtd, const Handler &handler, bool inlineCall = false) {
+        if (m_Running)
+            return CANERR_ONLINE;
+        if (!handler || (id > (xtd ? CAN_MAX_XTD_ID : CAN_MAX_STD_ID)))
+            return CANERR_ILLPARA;
+        int32_t slot = (int32_t)m_Slots.size();
+        m_Slots.emplace_back(new SSlot(handler, inlineCall || m_Workers.empty()));
+        if (!xtd)
+            m_Standard[id] = slot;
+        else
+            m_Extended[id] = slot;
+        return CANERR_NOERROR;
+    }
+    /// \brief  subscribes a handler for all messages without own handler
+    CANAPI_Return_t SubscribeDefault(const Handler &handler, bool inlineCall = false) {
+        if (m_Running)
+            return CANERR_ONLINE;
+        if (!handler)
+            return CANERR_ILLPARA;
+        m_Default = (int32_t)m_Slots.size();
+        m_Slots.emplace_back(new SSlot(handler, inlineCall || m_Workers.empty()));
+        return CANERR_NOERROR;
+    }
+    /// \brief  starts the receive thread and the workers
+    CANAPI_Return_t Start() {
+        if (m_Running)
+            return CANERR_ONLINE;
+        m_Running = true;
+        for (size_t i = 0U; i < m_Workers.size(); i++)
+            m_Workers[i]->thread = std::thread(&CPeakCANDispatcher::WorkerLoop, this, i);
+        m_Receiver = std::thread(&CPeakCANDispatcher::ReceiveLoop, this);
+        return CANERR_NOERROR;
+    }
+    /// \brief  stops the receive thread; the workers handle what is queued
+    CANAPI_Return_t Stop() {
+        if (!m_Running)
+            return CANERR_OFFLINE;
+        m_Running = false;
+        (void)m_Channel.SignalChannel();  // wake up the blocking read
+        if (m_Receiver.joinable())
+            m_Receiver.join();
+        { std::lock_guard<std::mutex> lock(m_Mutex); }
+        m_Wakeup.notify_all();
+        for (auto &worker : m_Workers) {
+            if (worker->thread.joinable())
+                worker->thread.join();
+        }
+        return CANERR_NOERROR;
+    }
+    /// \brief  routes one message to its handler (called by the receive loop)
+    void Dispatch(const CANAPI_Message_t &message) {
+        int32_t index = m_Default;
+        if (!message.xtd) {
+            if ((message.id <= CAN_MAX_STD_ID) && (m_Standard[message.id] >= 0))
+                index = m_Standard[message.id];
+        } else {
+            auto it = m_Extended.find(message.id);
+            if (it != m_Extended.end())
+                index = it->second;
+        }
+        if (index < 0) {
+            m_Unhandled++;
+            return;
+        }
+        SSlot *slot = m_Slots[(size_t)index].get();
+        SEntry entry = { message, Clock::now() };
+        if (slot->inlineCall) {
+            Execute(slot, entry);
+            return;
+        }
+        bool schedule = false;
+        {
+            std::lock_guard<std::mutex> lock(slot->lock);
+            slot->fifo.push_back(entry);
+            if (!slot->scheduled)
+                slot->scheduled = schedule = true;
+        }
+        if (schedule)
+            Schedule(slot);
+    }
+    /// \brief  retrieves the metrics of the handler for the given identifier
+    CANAPI_Return_t GetMetrics(uint32_t id, bool xtd, SMetrics &metrics) const {
+        int32_t index = -1;
+        if (!xtd) {
+            if (id <= CAN_MAX_STD_ID)
+                index = m_Standard[id];
+        } else {
+            auto it = m_Extended.find(id);
+            if (it != m_Extended.end())
+                index = it->second;
+        }
+        if (index < 0)
+            return CANERR_ILLPARA;
+        const SSlot *slot = m_Slots[(size_t)index].get();
+        metrics.u64Frames = slot->frames;
+        metrics.u64DelayTotal = slot->delayTotal;
+        metrics.u64DelayMax = slot->delayMax;
+        metrics.u64RuntimeTotal = slot->runtimeTotal;
+        metrics.u64RuntimeMax = slot->runtimeMax;
+        return CANERR_NOERROR;
+    }
+    /// \brief  number of messages received without handler
+    uint64_t GetUnhandled() const { return m_Unhandled; }
+    /// \brief  number of failed reads (the receive thread backs off and retries)
+    uint64_t GetReadErrors() const { return m_ReadErrors; }
+private:
+    void ReceiveLoop() {
+        CANAPI_Message_t message;
+        while (m_Running) {
+            CANAPI_Return_t rc = m_Channel.ReadMessage(message, CANREAD_INFINITE);
+            if (CANERR_NOERROR == rc)
+                Dispatch(message);
+            else if ((CANERR_RX_EMPTY != rc) && (CANERR_ERR_FRAME != rc) && m_Running) {
+                m_ReadErrors++;  // e.g. bus off or controller stopped: retry until stopped
+                std::this_thread::sleep_for(std::chrono::milliseconds(PEAKCAN_DISPATCH_IDLE));
+            }
+        }
+    }
+    void Schedule(SSlot *slot) {
+        SWorker *worker = m_Workers[m_Next++ % m_Workers.size()].get();
+        {
+            std::lock_guard<std::mutex> lock(worker->lock);
+            worker->ready.push_back(slot);
+        }
+        m_Ready++;
+        { std::lock_guard<std::mutex> lock(m_Mutex); }
+        m_Wakeup.notify_one();
+    }
+    SSlot *Take(size_t self) {
+        // own queue first (oldest), then steal from the others (newest)
+        for (size_t n = 0U; n < m_Workers.size(); n++) {
+            SWorker *worker = m_Workers[(self + n) % m_Workers.size()].get();
+            std::lock_guard<std::mutex> lock(worker->lock);
+            if (!worker->ready.empty()) {
+                SSlot *slot;
+                if (n == 0U) {
+                    slot = worker->ready.front();
+                    worker->ready.pop_front();
+                } else {
+                    slot = worker->ready.back();
+                    worker->ready.pop_back();
+                }
+                m_Ready--;
+                return slot;
+            }
+        }
+        return NULL;
+    }
+    void WorkerLoop(size_t self) {
+        for (;;) {
+            SSlot *slot = Take(self);
+            if (!slot) {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_Wakeup.wait(lock, [this] { return (m_Ready > 0U) || !m_Running; });
+                if (!m_Running && (m_Ready == 0U))
+                    return;
+                continue;
+            }
+            // handle up to PEAKCAN_DISPATCH_BATCH messages, then requeue the slot
+            bool requeue = false;
+            for (unsigned n = 0U; ; n++) {
+                SEntry entry;
+                {
+                    std::lock_guard<std::mutex> lock(slot->lock);
+                    if (slot->fifo.empty()) {
+                        slot->scheduled = false;
+                        break;
+                    }
+                    if (n == PEAKCAN_DISPATCH_BATCH) {
+                        requeue = true;  // note: stays scheduled
+                        break;
+                    }
+                    entry = slot->fifo.front();
+                    slot->fifo.pop_front();
+                }
+                Execute(slot, entry);
+            }
+            if (requeue)
+                Schedule(slot);
+        }
+    }
+    void Execute(SSlot *slot, const SEntry &entry) {
+        Clock::time_point start = Clock::now();
+        slot->handler(entry.message);
+        Clock::time_point stop = Clock::now();
+        uint64_t delay = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(start - entry.received).count();
+        uint64_t runtime = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+        slot->frames++;
+        slot->delayTotal += delay;
+        slot->runtimeTotal += runtime;
+        UpdateMax(slot->delayMax, delay);
+        UpdateMax(slot->runtimeMax, runtime);
+    }
+    static void UpdateMax(std::atomic<uint64_t> &max, uint64_t value) {
+        uint64_t prev = max;
+        while ((prev < value) && !max.compare_exchange_weak(prev, value)) {}
+    }
+};
+/// \}
+#endif // PEAKCAN_DISPATCHER_H_INCLUDED
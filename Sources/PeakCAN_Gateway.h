@@ -0,0 +1,384 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (for PEAK PCAN Interfaces)
+//
+//  Copyright (c) 2017-2021 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of PCANBasic-Wrapper.
+//
+//  PCANBasic-Wrapper is dual-licensed under the BSD 2-Clause "Simplified" License
+//  and under the GNU General Public License v3.0 (or any later version). You can
+//  choose between one of them if you use PCANBasic-Wrapper in whole or in part.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  PCANBasic-Wrapper IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF PCANBasic-Wrapper, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  PCANBasic-Wrapper is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  PCANBasic-Wrapper is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+#ifndef PEAKCAN_GATEWAY_H_INCLUDED
+#define PEAKCAN_GATEWAY_H_INCLUDED
+
+#include "PeakCAN.h"
+
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+/// \name   PeakCAN Gateway
+/// \brief  Forwarding of messages from one CAN channel to another.
+/// \note   Messages are forwarded by routes: an identifier range that is
+///         translated to a new identifier (keeping the offset), optionally
+///         converted between CAN 2.0 and CAN FD format and rate limited.
+///         The first matching route wins; messages without route are not
+///         forwarded. On Start the routes are compiled into a look-up
+///         table (an array for 11-bit identifiers and sorted, disjoint
+///         intervals for 29-bit identifiers).
+/// \note   The gateway thread drains the receive queue of the source in
+///         batches and writes each batch to the destination in one go.
+///         Per route the latency from reception to transmission is kept
+///         in a log-linear histogram (8 buckets per octave of microseconds).
+/// \{
+#define PEAKCAN_GATEWAY_BATCH  32U  ///< maximum number of messages per batch
+#define PEAKCAN_GATEWAY_RETRY  10U  ///< retries when the transmitter is busy
+#define PEAKCAN_GATEWAY_DELAY  100U  ///< back-off in [us] when the transmitter is busy
+#define PEAKCAN_GATEWAY_IDLE  10U  ///< back-off in [ms] when the source cannot be read (e.g. bus off)
+
+class CPeakCANGateway {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    /// \brief  format conversion of a route
+    enum EConvert {
+        ConvertNone = 0,  ///< keep the format
+        ConvertClassic,  ///< to CAN 2.0 (FD frames with more than 8 bytes are dropped)
+        ConvertFD,  ///< to CAN FD w/o bit-rate switching (remote frames are dropped)
+        ConvertFDBRS  ///< to CAN FD with bit-rate switching (remote frames are dropped)
+    };
+    /// \brief  route for an identifier range
+    struct SRoute {
+        uint32_t u32First;  ///< first identifier of the range
+        uint32_t u32Last;  ///< last identifier of the range
+        bool fXtd;  ///< range of 29-bit identifiers
+        int64_t s64Target;  ///< identifier for u32First on the destination (-1 = unchanged)
+        bool fTargetXtd;  ///< destination identifiers are 29-bit
+        EConvert eConvert;  ///< format conversion
+        uint32_t u32Rate;  ///< maximum messages per second (0 = unlimited)
+    };
+    /// \brief  statistics of a route (latencies in [us])
+    struct SStatistics {
+        uint64_t u64Forwarded;  ///< messages forwarded
+        uint64_t u64Dropped;  ///< messages dropped by conversion or rate limit
+        uint64_t u64Errors;  ///< write errors
+        uint64_t u64LatencyP50;  ///< median latency (lower bound of its bucket)
+        uint64_t u64LatencyP90;  ///< 90th percentile
+        uint64_t u64LatencyP99;  ///< 99th percentile
+        uint64_t u64LatencyMax;  ///< maximum latency
+    };
+private:
+    static const unsigned SUB_BITS = 3U;
+    static const unsigned BUCKETS = 64U << SUB_BITS;
+
+    struct SInterval {  // compiled 29-bit range
+        uint32_t first, last;  ///< identifier range
+        int32_t route;  ///< index of the route
+    };
+    struct SState {  // per route, owned by the gateway thread
+        double tokens;  ///< token bucket of the rate limit
+        Clock::time_point refill;  ///< time of the last refill
+        uint64_t forwarded, dropped, errors, latencyMax;
+        std::vector<uint64_t> histogram;
+        SState() : tokens(0.), forwarded(0U), dropped(0U), errors(0U), latencyMax(0U), histogram(BUCKETS, 0U) {}
+    };
+    struct SPending {  // message of the current batch
+        CANAPI_Message_t message;  ///< converted message
+        int32_t route;  ///< index of the route
+        Clock::time_point received;  ///< time of reception
+        Clock::time_point sent;  ///< time of transmission
+        CANAPI_Return_t result;  ///< result of the write
+    };
+    CPeakCAN &m_Source;  ///< receiving channel
+    CPeakCAN &m_Destination;  ///< transmitting channel
+    std::vector<SRoute> m_Routes;  ///< routes (in order of precedence)
+    std::vector<int32_t> m_Standard;  ///< 11-bit identifier to route (-1 = none)
+    std::vector<SInterval> m_Extended;  ///< 29-bit intervals, sorted by identifier
+    std::vector<SState> m_States;  ///< per route
+    std::thread m_Thread;  ///< gateway thread
+    std::atomic<bool> m_Running;  ///< flag: gateway running
+    std::mutex m_Mutex;  ///< protects the statistics
+public:
+    /// \brief  gateway from 'source' to 'destination' (both started by the application)
+    CPeakCANGateway(CPeakCAN &source, CPeakCAN &destination)
+        : m_Source(source), m_Destination(destination), m_Standard(CAN_MAX_STD_ID + 1, -1), m_Running(false) {}
+    ~CPeakCANGateway() { (void)Stop(); }
+
+    /// \brief  adds a route; returns its index (>= 0), or a negative error code
+    int AddRoute(const SRoute &route) {
+        if (m_Running)
+            return CANERR_ONLINE;
+        uint32_t max = route.fXtd ? CAN_MAX_XTD_ID : CAN_MAX_STD_ID;
+        if ((route.u32First > route.u32Last) || (route.u32Last > max))
+            return CANERR_ILLPARA;
+        if ((route.s64Target >= 0) &&
+            ((uint64_t)route.s64Target + (route.u32Last - route.u32First) > (route.fTargetXtd ? CAN_MAX_XTD_ID : CAN_MAX_STD_ID)))
+            return CANERR_ILLPARA;
+        m_Routes.push_back(route);
+        return (int)(m_Routes.size() - 1U);
+    }
+    /// \brief  adds a route that forwards an identifier range unchanged
+    int AddRoute(uint32_t first, uint32_t last, bool xtd) {
+        SRoute route = { first, last, xtd, -1, xtd, ConvertNone, 0U };
+        return AddRoute(route);
+    }
+    /// \brief  route for the opposite direction (the identifier translation inverted)
+    static SRoute Reverse(const SRoute &route) {
+        SRoute reverse = route;
+        if (route.s64Target >= 0) {
+            reverse.u32First = (uint32_t)route.s64Target;
+            reverse.u32Last = (uint32_t)route.s64Target + (route.u32Last - route.u32First);
+            reverse.fXtd = route.fTargetXtd;
+            reverse.s64Target = (int64_t)route.u32First;
+            reverse.fTargetXtd = route.fXtd;
+        }
+        return reverse;
+    }
+    /// \brief  compiles the routes and starts the gateway thread
+    CANAPI_Return_t Start() {
+        if (m_Running)
+            return CANERR_ONLINE;
+        Compile();
+        m_States.assign(m_Routes.size(), SState());
+        for (size_t i = 0U; i < m_Routes.size(); i++)
+            m_States[i].tokens = Burst(m_Routes[i]);
+        m_Running = true;
+        m_Thread = std::thread(&CPeakCANGateway::Run, this);
+        return CANERR_NOERROR;
+    }
+    /// \brief  stops the gateway thread
+    CANAPI_Return_t Stop() {
+        if (!m_Running)
+            return CANERR_OFFLINE;
+        m_Running = false;
+        (void)m_Source.SignalChannel();  // wake up the blocking read
+        if (m_Thread.joinable())
+            m_Thread.join();
+        return CANERR_NOERROR;
+    }
+    /// \brief  retrieves the statistics of a route
+    CANAPI_Return_t GetStatistics(int route, SStatistics &stats) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if ((route < 0) || ((size_t)route >= m_States.size()))
+            return CANERR_ILLPARA;
+        const SState &state = m_States[(size_t)route];
+        stats.u64Forwarded = state.forwarded;
+        stats.u64Dropped = state.dropped;
+        stats.u64Errors = state.errors;
+        stats.u64LatencyP50 = Percentile(state, 0.50);
+        stats.u64LatencyP90 = Percentile(state, 0.90);
+        stats.u64LatencyP99 = Percentile(state, 0.99);
+        stats.u64LatencyMax = state.latencyMax;
+        return CANERR_NOERROR;
+    }
+    /// \brief  number of routes
+    size_t GetRoutes() const { return m_Routes.size(); }
+private:
+    static double Burst(const SRoute &route) {
+        return (route.u32Rate > 10U) ? (double)route.u32Rate / 10. : 1.;  // 100ms worth of messages
+    }
+    void Compile() {
+        std::fill(m_Standard.begin(), m_Standard.end(), -1);
+        for (size_t i = m_Routes.size(); i > 0U; i--) {  // first route wins
+            const SRoute &route = m_Routes[i - 1U];
+            if (!route.fXtd)
+                std::fill(m_Standard.begin() + route.u32First, m_Standard.begin() + route.u32Last + 1U, (int32_t)(i - 1U));
+        }
+        // split the 29-bit ranges at every boundary into disjoint intervals
+        std::vector<uint64_t> bounds;
+        for (const SRoute &route : m_Routes) {
+            if (route.fXtd) {
+                bounds.push_back(route.u32First);
+                bounds.push_back((uint64_t)route.u32Last + 1U);
+            }
+        }
+        std::sort(bounds.begin(), bounds.end());
+        bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+        m_Extended.clear();
+        for (size_t b = 0U; (b + 1U) < bounds.size(); b++) {
+            int32_t match = -1;
+            for (size_t i = 0U; (i < m_Routes.size()) && (match < 0); i++) {
+                if (m_Routes[i].fXtd && (m_Routes[i].u32First <= bounds[b]) && (bounds[b] <= m_Routes[i].u32Last))
+                    match = (int32_t)i;
+            }
+            if (match < 0)
+                continue;
+            if (!m_Extended.empty() && (m_Extended.back().route == match) && ((uint64_t)m_Extended.back().last + 1U == bounds[b]))
+                m_Extended.back().last = (uint32_t)(bounds[b + 1U] - 1U);
+            else {
+                SInterval interval = { (uint32_t)bounds[b], (uint32_t)(bounds[b + 1U] - 1U), match };
+                m_Extended.push_back(interval);
+            }
+        }
+    }
+    int32_t Lookup(const CANAPI_Message_t &message) const {
+        if (!message.xtd)
+            return (message.id <= CAN_MAX_STD_ID) ? m_Standard[message.id] : -1;
+        std::vector<SInterval>::const_iterator it = std::upper_bound(m_Extended.begin(), m_Extended.end(), message.id,
+            [](uint32_t id, const SInterval &interval) { return id < interval.first; });
+        if ((it == m_Extended.begin()) || ((--it)->last < message.id))
+            return -1;
+        return it->route;
+    }
+    // translates the message; returns false when it cannot be forwarded
+    static bool Translate(const SRoute &route, CANAPI_Message_t &message) {
+        if (route.s64Target >= 0) {
+            message.id = (uint32_t)route.s64Target + (message.id - route.u32First);
+            message.xtd = route.fTargetXtd ? 1 : 0;
+        }
+        switch (route.eConvert) {
+        case ConvertClassic:
+            if (message.dlc > CAN_MAX_DLC)
+                return false;
+            message.fdf = message.brs = message.esi = 0;
+            break;
+        case ConvertFD:
+        case ConvertFDBRS:
+            if (message.rtr)
+                return false;
+            message.fdf = 1;
+            message.brs = (route.eConvert == ConvertFDBRS) ? 1 : 0;
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
+    bool Admit(size_t route, Clock::time_point now) {
+        const SRoute &config = m_Routes[route];
+        if (!config.u32Rate)
+            return true;
+        SState &state = m_States[route];
+        double elapsed = std::chrono::duration<double>(now - state.refill).count();
+        state.refill = now;
+        state.tokens = std::min(Burst(config), state.tokens + elapsed * (double)config.u32Rate);
+        if (state.tokens < 1.)
+            return false;
+        state.tokens -= 1.;
+        return true;
+    }
+    static unsigned Bucket(uint64_t value) {
+        if (value < (1U << SUB_BITS))
+            return (unsigned)value;
+        unsigned msb = 63U;
+        while (!(value >> msb))
+            msb--;
+        unsigned bucket = ((msb - SUB_BITS + 1U) << SUB_BITS) + (unsigned)((value >> (msb - SUB_BITS)) & ((1U << SUB_BITS) - 1U));
+        return std::min(bucket, BUCKETS - 1U);
+    }
+    static uint64_t BucketValue(unsigned bucket) {
+        if (bucket < (1U << SUB_BITS))
+            return bucket;
+        unsigned msb = (bucket >> SUB_BITS) + SUB_BITS - 1U;
+        return ((uint64_t)(bucket & ((1U << SUB_BITS) - 1U)) | (1U << SUB_BITS)) << (msb - SUB_BITS);
+    }
+    static uint64_t Percentile(const SState &state, double fraction) {
+        uint64_t total = 0U, count = 0U;
+        for (uint64_t n : state.histogram)
+            total += n;
+        if (!total)
+            return 0U;
+        uint64_t rank = (uint64_t)((double)total * fraction);
+        for (unsigned i = 0U; i < BUCKETS; i++) {
+            count += state.histogram[i];
+            if (count > rank)
+                return std::min(BucketValue(i), state.latencyMax);
+        }
+        return state.latencyMax;
+    }
+    void Run() {
+        std::vector<SPending> batch;
+        batch.reserve(PEAKCAN_GATEWAY_BATCH);
+        CANAPI_Message_t message;
+        CANAPI_Return_t rc = CANERR_NOERROR;
+        while (m_Running) {
+            // (1) wait for the first message, then drain the receive queue
+            uint16_t timeout = CANREAD_INFINITE;
+            batch.clear();
+            while ((batch.size() < PEAKCAN_GATEWAY_BATCH) && ((rc = m_Source.ReadMessage(message, timeout)) == CANERR_NOERROR)) {
+                Clock::time_point now = Clock::now();
+                timeout = 0U;
+                if (message.sts)  // status/error frames are not forwarded
+                    continue;
+                int32_t route = Lookup(message);
+                if (route < 0)
+                    continue;
+                if (!Translate(m_Routes[(size_t)route], message) || !Admit((size_t)route, now)) {
+                    std::lock_guard<std::mutex> lock(m_Mutex);
+                    m_States[(size_t)route].dropped++;
+                    continue;
+                }
+                SPending pending = { message, route, now, now, CANERR_NOERROR };
+                batch.push_back(pending);
+            }
+            // note: the blocking read failed (channel not running or bus off),
+            //       so wait a while before trying again instead of spinning
+            if ((CANREAD_INFINITE == timeout) && (CANERR_RX_EMPTY != rc) && (CANERR_ERR_FRAME != rc)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(PEAKCAN_GATEWAY_IDLE));
+                continue;
+            }
+            // (2) write the batch to the destination
+            for (SPending &pending : batch) {
+                CANAPI_Return_t rc = m_Destination.WriteMessage(pending.message);
+                for (unsigned retry = 0U; (rc == CANERR_TX_BUSY) && (retry < PEAKCAN_GATEWAY_RETRY) && m_Running; retry++) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(PEAKCAN_GATEWAY_DELAY));
+                    rc = m_Destination.WriteMessage(pending.message);
+                }
+                pending.sent = Clock::now();
+                pending.result = rc;
+            }
+            // (3) update the statistics of the batch
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            for (const SPending &pending : batch) {
+                SState &state = m_States[(size_t)pending.route];
+                if (pending.result != CANERR_NOERROR) {
+                    state.errors++;
+                    continue;
+                }
+                uint64_t latency = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(pending.sent - pending.received).count();
+                state.forwarded++;
+                state.histogram[Bucket(latency)]++;
+                if (latency > state.latencyMax)
+                    state.latencyMax = latency;
+            }
+        }
+    }
+};
+/// \}
+#endif // PEAKCAN_GATEWAY_H_INCLUDED
@@ -0,0 +1,366 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (for PEAK PCAN Interfaces)
+//
+//  Copyright (c) 2017-2021 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of PCANBasic-Wrapper.
+//
+//  PCANBasic-Wrapper is dual-licensed under the BSD 2-Clause "Simplified" License
+//  and under the GNU General Public License v3.0 (or any later version). You can
+//  choose between one of them if you use PCANBasic-Wrapper in whole or in part.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  PCANBasic-Wrapper IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF PCANBasic-Wrapper, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  PCANBasic-Wrapper is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  PCANBasic-Wrapper is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+#ifndef PEAKCAN_INDEX_H_INCLUDED
+#define PEAKCAN_INDEX_H_INCLUDED
+
+#include "PeakCAN.h"
+
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/// \name   PeakCAN Index
+/// \brief  Sparse side index of a capture file for seeking by time and
+///         by CAN identifier.
+/// \note   The records of a capture are grouped into blocks of a fixed
+///         number of consecutive sequence numbers. The index holds per
+///         block the first and the last time-stamp, and per identifier
+///         a posting list of the blocks that contain it. A range query
+///         by time and identifier thus touches the index and only those
+///         blocks of the capture that contain matching records.
+/// \note   The index file is memory-mapped by the reader. It is stamped
+///         with the capacity and the head of the capture, so an index of
+///         a capture that has been continued since is recognized as stale.
+/// \{
+#define PEAKCAN_INDEX_MAGIC  0x58494350U  ///< "PCIX"
+#define PEAKCAN_INDEX_VERSION  1U  ///< layout version of the index file
+#define PEAKCAN_INDEX_BLOCK  1024U  ///< default number of records per block
+#define PEAKCAN_INDEX_NOKEY  0xFFFFFFFFU  ///< record without identifier (e.g. an event)
+
+/// \brief  layout of an index file
+struct SPeakCANIndexFile {
+    /// \brief  header of the index file
+    struct SHeader {
+        uint32_t u32Magic;  ///< PEAKCAN_INDEX_MAGIC
+        uint16_t u16Version;  ///< PEAKCAN_INDEX_VERSION
+        uint16_t u16Reserved;
+        uint32_t u32BlockSize;  ///< number of records per block
+        uint32_t u32Blocks;  ///< number of blocks
+        uint64_t u64Capacity;  ///< capacity of the capture (stamp)
+        uint64_t u64Head;  ///< head of the capture (stamp)
+        uint64_t u64First;  ///< sequence number of the first record of block 0
+        uint32_t u32Keys;  ///< number of identifiers
+        uint32_t u32Reserved;
+        uint64_t u64Postings;  ///< total number of postings
+    };
+    /// \brief  time-stamps of a block in [ns]
+    struct SBlock {
+        uint64_t u64TimeFirst;  ///< smallest time-stamp
+        uint64_t u64TimeLast;  ///< largest time-stamp
+    };
+    /// \brief  posting list of an identifier
+    struct SKey {
+        uint32_t u32Key;  ///< identifier (see CPeakCANIndex::Key)
+        uint32_t u32Count;  ///< number of blocks
+        uint64_t u64Offset;  ///< index of the first posting
+    };
+    // followed by: SBlock[u32Blocks], SKey[u32Keys] (ascending), uint32_t[u64Postings] (ascending per key)
+};
+
+/// \brief  builds an index while the records are written (or scanned)
+class CPeakCANIndexWriter {
+private:
+    uint64_t m_First;  ///< sequence number of the first record
+    uint32_t m_BlockSize;  ///< number of records per block
+    uint64_t m_Records;  ///< number of records added
+    std::vector<SPeakCANIndexFile::SBlock> m_Blocks;  ///< time table
+    std::map<uint32_t, std::vector<uint32_t> > m_Postings;  ///< per identifier: blocks
+public:
+    /// \brief  index for records from sequence number 'first' on
+    CPeakCANIndexWriter(uint64_t first = 0U, uint32_t block = PEAKCAN_INDEX_BLOCK)
+        : m_First(first), m_BlockSize(block ? block : PEAKCAN_INDEX_BLOCK), m_Records(0U) {}
+
+    /// \brief  adds the next record (time-stamp in [ns], key or PEAKCAN_INDEX_NOKEY)
+    void Add(uint64_t time, uint32_t key) {
+        uint32_t block = (uint32_t)(m_Records++ / m_BlockSize);
+        if (block >= m_Blocks.size()) {
+            SPeakCANIndexFile::SBlock entry = { time, time };
+            m_Blocks.push_back(entry);
+        }
+        SPeakCANIndexFile::SBlock &entry = m_Blocks.back();
+        if (time < entry.u64TimeFirst)
+            entry.u64TimeFirst = time;
+        if (time > entry.u64TimeLast)
+            entry.u64TimeLast = time;
+        if (key != PEAKCAN_INDEX_NOKEY) {
+            std::vector<uint32_t> &blocks = m_Postings[key];
+            if (blocks.empty() || (blocks.back() != block))
+                blocks.push_back(block);
+        }
+    }
+    /// \brief  writes the index file, stamped with capacity and head of the capture
+    CANAPI_Return_t Write(const char *path, uint64_t capacity, uint64_t head) const {
+        if (!path)
+            return CANERR_NULLPTR;
+        SPeakCANIndexFile::SHeader header;
+        memset(&header, 0, sizeof(header));
+        header.u32Magic = PEAKCAN_INDEX_MAGIC;
+        header.u16Version = PEAKCAN_INDEX_VERSION;
+        header.u32BlockSize = m_BlockSize;
+        header.u32Blocks = (uint32_t)m_Blocks.size();
+        header.u64Capacity = capacity;
+        header.u64Head = head;
+        header.u64First = m_First;
+        header.u32Keys = (uint32_t)m_Postings.size();
+        std::vector<SPeakCANIndexFile::SKey> keys;
+        keys.reserve(m_Postings.size());
+        for (std::map<uint32_t, std::vector<uint32_t> >::const_iterator it = m_Postings.begin(); it != m_Postings.end(); ++it) {
+            SPeakCANIndexFile::SKey key = { it->first, (uint32_t)it->second.size(), header.u64Postings };
+            keys.push_back(key);
+            header.u64Postings += it->second.size();
+        }
+        FILE *file = fopen(path, "wb");
+        if (!file)
+            return CANERR_RESOURCE;
+        bool ok = (fwrite(&header, sizeof(header), 1U, file) == 1U);
+        if (ok && !m_Blocks.empty())
+            ok = (fwrite(&m_Blocks[0], sizeof(SPeakCANIndexFile::SBlock), m_Blocks.size(), file) == m_Blocks.size());
+        if (ok && !keys.empty())
+            ok = (fwrite(&keys[0], sizeof(SPeakCANIndexFile::SKey), keys.size(), file) == keys.size());
+        for (std::map<uint32_t, std::vector<uint32_t> >::const_iterator it = m_Postings.begin(); ok && (it != m_Postings.end()); ++it)
+            ok = (fwrite(&it->second[0], sizeof(uint32_t), it->second.size(), file) == it->second.size());
+        ok = (fclose(file) == 0) && ok;
+        return ok ? CANERR_NOERROR : CANERR_RESOURCE;
+    }
+};
+
+/// \brief  read-only memory mapping of a file
+class CPeakCANMappedFile {
+private:
+    const uint8_t *m_pData;  ///< mapped view
+    uint64_t m_Size;  ///< size of the file
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE m_hFile;  ///< the file
+    HANDLE m_hMapping;  ///< file mapping object
+#endif
+public:
+    CPeakCANMappedFile() : m_pData(NULL), m_Size(0U) {
+#if defined(_WIN32) || defined(_WIN64)
+        m_hFile = INVALID_HANDLE_VALUE;
+        m_hMapping = NULL;
+#endif
+    }
+    ~CPeakCANMappedFile() { Close(); }
+
+    /// \brief  maps the whole file (read-only)
+    CANAPI_Return_t Open(const char *path) {
+        if (m_pData)
+            return CANERR_YETINIT;
+        if (!path)
+            return CANERR_NULLPTR;
+#if defined(_WIN32) || defined(_WIN64)
+        m_hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        LARGE_INTEGER length;
+        if ((m_hFile == INVALID_HANDLE_VALUE) || !GetFileSizeEx(m_hFile, &length) || !length.QuadPart) {
+            Close();
+            return CANERR_RESOURCE;
+        }
+        m_Size = (uint64_t)length.QuadPart;
+        m_hMapping = CreateFileMappingA(m_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (m_hMapping)
+            m_pData = (const uint8_t*)MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+#else
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+            return CANERR_RESOURCE;
+        struct stat info;
+        void *view = MAP_FAILED;
+        if ((fstat(fd, &info) == 0) && (info.st_size > 0))
+            view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        (void)close(fd);
+        if (view != MAP_FAILED) {
+            m_pData = (const uint8_t*)view;
+            m_Size = (uint64_t)info.st_size;
+        }
+#endif
+        if (!m_pData) {
+            Close();
+            return CANERR_RESOURCE;
+        }
+        return CANERR_NOERROR;
+    }
+    /// \brief  unmaps the file
+    void Close() {
+#if defined(_WIN32) || defined(_WIN64)
+        if (m_pData)
+            (void)UnmapViewOfFile(m_pData);
+        if (m_hMapping)
+            (void)CloseHandle(m_hMapping);
+        if (m_hFile != INVALID_HANDLE_VALUE)
+            (void)CloseHandle(m_hFile);
+        m_hMapping = NULL;
+        m_hFile = INVALID_HANDLE_VALUE;
+#else
+        if (m_pData)
+            (void)munmap((void*)m_pData, (size_t)m_Size);
+#endif
+        m_pData = NULL;
+        m_Size = 0U;
+    }
+    const uint8_t *Data() const { return m_pData; }
+    uint64_t Size() const { return m_Size; }
+private:
+    CPeakCANMappedFile(const CPeakCANMappedFile&);  // not copyable
+    CPeakCANMappedFile &operator=(const CPeakCANMappedFile&);
+};
+
+/// \brief  reads an index file (memory-mapped)
+class CPeakCANIndex {
+private:
+    CPeakCANMappedFile m_File;  ///< mapped index file
+    const SPeakCANIndexFile::SHeader *m_pHeader;  ///< header
+    const SPeakCANIndexFile::SBlock *m_pBlocks;  ///< time table
+    const SPeakCANIndexFile::SKey *m_pKeys;  ///< identifiers (ascending)
+    const uint32_t *m_pPostings;  ///< posting lists
+public:
+    CPeakCANIndex() : m_pHeader(NULL), m_pBlocks(NULL), m_pKeys(NULL), m_pPostings(NULL) {}
+
+    /// \brief  key of an identifier in the index
+    static uint32_t Key(uint32_t id, bool xtd) { return (id & CAN_MAX_XTD_ID) | (xtd ? 0x80000000U : 0U); }
+
+    /// \brief  maps an index file
+    CANAPI_Return_t Open(const char *path) {
+        CANAPI_Return_t rc = m_File.Open(path);
+        if (rc != CANERR_NOERROR)
+            return rc;
+        const SPeakCANIndexFile::SHeader *header = (const SPeakCANIndexFile::SHeader*)m_File.Data();
+        if ((m_File.Size() < sizeof(SPeakCANIndexFile::SHeader)) ||
+            (header->u32Magic != PEAKCAN_INDEX_MAGIC) || (header->u16Version != PEAKCAN_INDEX_VERSION) ||
+            !header->u32BlockSize || (header->u64Postings > m_File.Size() / sizeof(uint32_t)) ||
+            (m_File.Size() != sizeof(SPeakCANIndexFile::SHeader) +
+                              (uint64_t)header->u32Blocks * sizeof(SPeakCANIndexFile::SBlock) +
+                              (uint64_t)header->u32Keys * sizeof(SPeakCANIndexFile::SKey) +
+                              header->u64Postings * sizeof(uint32_t))) {
+            m_File.Close();
+            return CANERR_ILLPARA;
+        }
+        // each posting list within the postings, keys ascending (binary search)
+        const SPeakCANIndexFile::SKey *keys = (const SPeakCANIndexFile::SKey*)((const SPeakCANIndexFile::SBlock*)(header + 1) + header->u32Blocks);
+        for (uint32_t i = 0U; i < header->u32Keys; i++) {
+            if ((keys[i].u64Offset > header->u64Postings) ||
+                ((uint64_t)keys[i].u32Count > (header->u64Postings - keys[i].u64Offset)) ||
+                (i && (keys[i].u32Key <= keys[i - 1U].u32Key))) {
+                m_File.Close();
+                return CANERR_ILLPARA;
+            }
+        }
+        m_pHeader = header;
+        m_pBlocks = (const SPeakCANIndexFile::SBlock*)(m_pHeader + 1);
+        m_pKeys = (const SPeakCANIndexFile::SKey*)(m_pBlocks + m_pHeader->u32Blocks);
+        m_pPostings = (const uint32_t*)(m_pKeys + m_pHeader->u32Keys);
+        return CANERR_NOERROR;
+    }
+    /// \brief  unmaps the index file
+    void Close() {
+        m_File.Close();
+        m_pHeader = NULL;
+        m_pBlocks = NULL;
+        m_pKeys = NULL;
+        m_pPostings = NULL;
+    }
+    bool IsOpen() const { return (m_pHeader != NULL); }
+    /// \brief  true when the index has been built for a capture with the given capacity and head
+    bool Matches(uint64_t capacity, uint64_t head) const {
+        return m_pHeader && (m_pHeader->u64Capacity == capacity) && (m_pHeader->u64Head == head);
+    }
+    /// \brief  head of the capture when the index was built
+    uint64_t GetHead() const { return m_pHeader ? m_pHeader->u64Head : 0U; }
+    uint32_t GetBlocks() const { return m_pHeader ? m_pHeader->u32Blocks : 0U; }
+    uint32_t GetBlockSize() const { return m_pHeader ? m_pHeader->u32BlockSize : 0U; }
+    /// \brief  sequence number of the first record of a block
+    uint64_t GetSequence(uint32_t block) const { return m_pHeader->u64First + (uint64_t)block * m_pHeader->u32BlockSize; }
+    /// \brief  time-stamps of a block
+    const SPeakCANIndexFile::SBlock &GetBlock(uint32_t block) const { return m_pBlocks[block]; }
+
+    /// \brief  first block that may contain a time-stamp >= 'time' (GetBlocks() if none)
+    /// \note   Requires ascending time-stamps (as delivered by the driver).
+    uint32_t Find(uint64_t time) const {
+        uint32_t lo = 0U, hi = GetBlocks();
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2U;
+            if (m_pBlocks[mid].u64TimeLast < time)
+                lo = mid + 1U;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+    /// \brief  posting list of an identifier (ascending block numbers); returns false if not in the capture
+    bool GetPostings(uint32_t key, const uint32_t *&blocks, uint32_t &count) const {
+        blocks = NULL;
+        count = 0U;
+        if (!m_pHeader)
+            return false;
+        const SPeakCANIndexFile::SKey *first = m_pKeys, *last = m_pKeys + m_pHeader->u32Keys;
+        while (first < last) {  // binary search
+            const SPeakCANIndexFile::SKey *mid = first + (last - first) / 2;
+            if (mid->u32Key < key)
+                first = mid + 1;
+            else
+                last = mid;
+        }
+        if ((first == m_pKeys + m_pHeader->u32Keys) || (first->u32Key != key))
+            return false;
+        blocks = m_pPostings + first->u64Offset;
+        count = first->u32Count;
+        return true;
+    }
+private:
+    CPeakCANIndex(const CPeakCANIndex&);  // not copyable
+    CPeakCANIndex &operator=(const CPeakCANIndex&);
+};
+/// \}
+
+#endif // PEAKCAN_INDEX_H_INCLUDED
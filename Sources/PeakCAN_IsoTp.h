@@ -0,0 +1,490 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (for PEAK PCAN Interfaces)
+//
+//  Copyright (c) 2017-2021 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of PCANBasic-Wrapper.
+//
+//  PCANBasic-Wrapper is dual-licensed under the BSD 2-Clause "Simplified" License
+//  and under the GNU General Public License v3.0 (or any later version). You can
+//  choose between one of them if you use PCANBasic-Wrapper in whole or in part.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  PCANBasic-Wrapper IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF PCANBasic-Wrapper, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  PCANBasic-Wrapper is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  PCANBasic-Wrapper is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+#ifndef PEAKCAN_ISOTP_H_INCLUDED
+#define PEAKCAN_ISOTP_H_INCLUDED
+
+#include "PeakCAN.h"
+
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+/// \name   PeakCAN ISO-TP
+/// \brief  ISO 15765-2 transport protocol (normal addressing) for CAN 2.0
+///         and CAN FD (up to 64 bytes per frame).
+/// \note   Sessions are keyed by a pair of identifiers (transmit/receive).
+///         A receive thread reassembles segmented messages and answers
+///         with flow control frames; Send segments a message in the calling
+///         thread and honours the block size and STmin of the receiver,
+///         including the 100..900us values (timed with a steady clock).
+///         With STmin = 0 the consecutive frames of a block are written
+///         back-to-back without waiting between them, in batches of up to
+///         PEAKCAN_ISOTP_BATCH frames under one lock (the driver accepts one
+///         frame per write).
+/// \note   Messages longer than 4095 bytes use the 32-bit length escape of
+///         the first frame (ISO 15765-2:2016).
+/// \{
+#define PEAKCAN_ISOTP_N_BS       1000U  ///< time-out for a flow control frame in [ms]
+#define PEAKCAN_ISOTP_N_CR       1000U  ///< time-out for a consecutive frame in [ms]
+#define PEAKCAN_ISOTP_N_WFT_MAX  10U  ///< maximum number of FC.WAIT in a row
+#define PEAKCAN_ISOTP_MAX_LENGTH (64UL * 1024UL * 1024UL)  ///< maximum message length (receiver)
+#define PEAKCAN_ISOTP_IDLE       10U  ///< back-off in [ms] when the channel cannot be read (e.g. bus off)
+#define PEAKCAN_ISOTP_BATCH      16U  ///< consecutive frames written in one batch (STmin = 0)
+
+class CPeakCANIsoTp {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    /// \brief  addressing and flow control parameters of a session
+    struct SAddress {
+        uint32_t u32TxId;  ///< identifier of transmitted frames
+        uint32_t u32RxId;  ///< identifier of received frames
+        bool fXtd;  ///< 29-bit identifiers
+        bool fFD;  ///< CAN FD frames (TX_DL = 64)
+        bool fBRS;  ///< CAN FD with bit-rate switching
+        uint8_t u8BlockSize;  ///< block size announced as receiver (0 = no limit)
+        uint8_t u8STmin;  ///< STmin announced as receiver (ISO 15765-2 encoding)
+        uint8_t u8Padding;  ///< padding byte
+    };
+    /// \brief  statistics of a session
+    struct SStatistics {
+        uint64_t u64MessagesSent;  ///< messages sent
+        uint64_t u64BytesSent;  ///< payload bytes sent
+        uint64_t u64SendTime;  ///< time spent in Send in [us] (for KB/s)
+        uint64_t u64MessagesReceived;  ///< messages received
+        uint64_t u64BytesReceived;  ///< payload bytes received
+        uint64_t u64Errors;  ///< protocol errors and time-outs
+    };
+private:
+    enum { PCI_SF = 0x0, PCI_FF = 0x1, PCI_CF = 0x2, PCI_FC = 0x3 };
+    enum { FC_CTS = 0x0, FC_WAIT = 0x1, FC_OVFLW = 0x2 };
+
+    struct SSession {
+        SAddress address;  ///< addressing and flow control parameters
+        std::mutex sending;  ///< one Send at a time
+        std::mutex lock;  ///< protects the state below
+        std::condition_variable signal;  ///< flow control or message received
+        // sender: last flow control frame
+        bool fcReceived;  ///< flag: flow control frame received
+        uint8_t fcStatus, fcBlockSize, fcSTmin;
+        // receiver: message in reassembly
+        bool receiving;  ///< flag: first frame received
+        std::vector<uint8_t> buffer;  ///< reassembly buffer
+        size_t offset;  ///< bytes received so far
+        uint8_t sequence;  ///< expected sequence number
+        uint8_t block;  ///< consecutive frames in the current block
+        Clock::time_point last;  ///< time of the last frame
+        std::deque<std::vector<uint8_t>> completed;  ///< received messages
+        SStatistics stats;  ///< statistics
+        explicit SSession(const SAddress &a) : address(a), fcReceived(false), fcStatus(0U), fcBlockSize(0U), fcSTmin(0U),
+            receiving(false), offset(0U), sequence(0U), block(0U), stats() {}
+    };
+    CPeakCAN &m_Channel;  ///< CAN channel (started by the application)
+    std::vector<std::unique_ptr<SSession>> m_Sessions;  ///< all sessions
+    std::unordered_map<uint64_t, size_t> m_Lookup;  ///< receive identifier to session
+    std::thread m_Receiver;  ///< receive thread
+    std::atomic<bool> m_Running;  ///< flag: engine running
+    std::mutex m_Mutex;  ///< protects sessions and look-up table
+    std::mutex m_Write;  ///< serializes writes (senders and flow control)
+public:
+    /// \brief  ISO-TP engine for 'channel'
+    CPeakCANIsoTp(CPeakCAN &channel) : m_Channel(channel), m_Running(false) {}
+    ~CPeakCANIsoTp() { (void)Stop(); }
+
+    /// \brief  opens a session; returns its index (>= 0), or a negative error code
+    int OpenSession(const SAddress &address) {
+        uint32_t max = address.fXtd ? CAN_MAX_XTD_ID : CAN_MAX_STD_ID;
+        if ((address.u32TxId > max) || (address.u32RxId > max) || (address.u32TxId == address.u32RxId))
+            return CANERR_ILLPARA;
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        uint64_t key = Key(address.u32RxId, address.fXtd);
+        if (m_Lookup.find(key) != m_Lookup.end())
+            return CANERR_ILLPARA;
+        m_Sessions.emplace_back(new SSession(address));
+        m_Lookup[key] = m_Sessions.size() - 1U;
+        return (int)(m_Sessions.size() - 1U);
+    }
+    /// \brief  starts the receive thread
+    CANAPI_Return_t Start() {
+        if (m_Running)
+            return CANERR_ONLINE;
+        m_Running = true;
+        m_Receiver = std::thread(&CPeakCANIsoTp::Run, this);
+        return CANERR_NOERROR;
+    }
+    /// \brief  stops the receive thread
+    CANAPI_Return_t Stop() {
+        if (!m_Running)
+            return CANERR_OFFLINE;
+        m_Running = false;
+        (void)m_Channel.SignalChannel();  // wake up the blocking read
+        if (m_Receiver.joinable())
+            m_Receiver.join();
+        return CANERR_NOERROR;
+    }
+    /// \brief  sends a message (blocks until the last frame is written)
+    CANAPI_Return_t Send(int session, const uint8_t *data, size_t length) {
+        SSession *s = GetSession(session);
+        if (!s || (!data && length) || !length || (length > UINT32_MAX))
+            return CANERR_ILLPARA;
+        std::lock_guard<std::mutex> sending(s->sending);
+        Clock::time_point start = Clock::now();
+        CANAPI_Return_t rc = Transmit(*s, data, length);
+        std::lock_guard<std::mutex> lock(s->lock);
+        if (CANERR_NOERROR == rc) {
+            s->stats.u64MessagesSent++;
+            s->stats.u64BytesSent += length;
+            s->stats.u64SendTime += (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+        } else
+            s->stats.u64Errors++;
+        return rc;
+    }
+    /// \brief  receives a message (waits up to 'timeout' milliseconds)
+    CANAPI_Return_t Receive(int session, std::vector<uint8_t> &data, uint16_t timeout = CANREAD_INFINITE) {
+        SSession *s = GetSession(session);
+        if (!s)
+            return CANERR_ILLPARA;
+        std::unique_lock<std::mutex> lock(s->lock);
+        if (timeout == CANREAD_INFINITE)
+            s->signal.wait(lock, [s, this] { return !s->completed.empty() || !m_Running; });
+        else
+            (void)s->signal.wait_for(lock, std::chrono::milliseconds(timeout), [s] { return !s->completed.empty(); });
+        if (s->completed.empty())
+            return (timeout == CANREAD_INFINITE) ? CANERR_OFFLINE : CANERR_RX_EMPTY;
+        data.swap(s->completed.front());
+        s->completed.pop_front();
+        return CANERR_NOERROR;
+    }
+    /// \brief  retrieves the statistics of a session
+    CANAPI_Return_t GetStatistics(int session, SStatistics &stats) {
+        SSession *s = GetSession(session);
+        if (!s)
+            return CANERR_ILLPARA;
+        std::lock_guard<std::mutex> lock(s->lock);
+        stats = s->stats;
+        return CANERR_NOERROR;
+    }
+private:
+    static uint64_t Key(uint32_t id, bool xtd) { return ((uint64_t)(xtd ? 1U : 0U) << 32) | id; }
+
+    SSession *GetSession(int session) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return ((session >= 0) && ((size_t)session < m_Sessions.size())) ? m_Sessions[(size_t)session].get() : NULL;
+    }
+    // STmin in microseconds (reserved values are treated as 127ms)
+    static uint32_t STmin(uint8_t value) {
+        if (value <= 0x7FU)
+            return (uint32_t)value * 1000U;
+        if ((value >= 0xF1U) && (value <= 0xF9U))
+            return (uint32_t)(value - 0xF0U) * 100U;
+        return 127000U;
+    }
+    static void WaitUntil(Clock::time_point deadline) {
+        // sleep for the milliseconds, spin for the rest (sub-millisecond STmin)
+        Clock::time_point now = Clock::now();
+        if ((deadline - now) > std::chrono::milliseconds(1))
+            std::this_thread::sleep_until(deadline - std::chrono::milliseconds(1));
+        while (Clock::now() < deadline)
+            std::this_thread::yield();
+    }
+    // completes a frame of 'length' bytes (padded to a valid frame length)
+    static void Frame(const SAddress &address, CANAPI_Message_t &message, size_t length) {
+        size_t frame = CAN_MAX_LEN;
+        if (address.fFD && (length > CAN_MAX_LEN))
+            frame = CCANAPI::Dlc2Len(CCANAPI::Len2Dlc((uint8_t)length));
+        if (length < frame)
+            memset(&message.data[length], address.u8Padding, frame - length);
+        message.id = address.u32TxId;
+        message.xtd = address.fXtd ? 1 : 0;
+        message.rtr = 0;
+        message.fdf = address.fFD ? 1 : 0;
+        message.brs = (address.fFD && address.fBRS) ? 1 : 0;
+        message.esi = 0;
+        message.sts = 0;
+        message.dlc = CCANAPI::Len2Dlc((uint8_t)frame);
+    }
+    // writes completed frames in a row (not interleaved with frames of other sessions)
+    CANAPI_Return_t WriteFrames(const CANAPI_Message_t *messages, size_t count) {
+        CANAPI_Return_t rc = CANERR_NOERROR;
+        std::lock_guard<std::mutex> lock(m_Write);
+        for (size_t i = 0U; (i < count) && (rc == CANERR_NOERROR); i++) {
+            while ((rc = m_Channel.WriteMessage(messages[i])) == CANERR_TX_BUSY)
+                std::this_thread::yield();
+        }
+        return rc;
+    }
+    // writes a frame of 'length' bytes (padded to a valid frame length)
+    CANAPI_Return_t WriteFrame(const SAddress &address, CANAPI_Message_t &message, size_t length) {
+        Frame(address, message, length);
+        return WriteFrames(&message, 1U);
+    }
+    // waits for a flow control frame (CTS), handling FC.WAIT
+    CANAPI_Return_t WaitForFlowControl(SSession &s, uint8_t &blockSize, uint32_t &separation) {
+        std::unique_lock<std::mutex> lock(s.lock);
+        for (unsigned wait = 0U; wait <= PEAKCAN_ISOTP_N_WFT_MAX; wait++) {
+            if (!s.signal.wait_for(lock, std::chrono::milliseconds(PEAKCAN_ISOTP_N_BS), [&s] { return s.fcReceived; }))
+                return CANERR_TIMEOUT;
+            s.fcReceived = false;
+            switch (s.fcStatus) {
+            case FC_CTS:
+                blockSize = s.fcBlockSize;
+                separation = STmin(s.fcSTmin);
+                return CANERR_NOERROR;
+            case FC_WAIT:
+                continue;
+            case FC_OVFLW:
+                return CANERR_RESOURCE;
+            default:
+                return CANERR_ILLPARA;
+            }
+        }
+        return CANERR_TIMEOUT;
+    }
+    CANAPI_Return_t Transmit(SSession &s, const uint8_t *data, size_t length) {
+        const SAddress &address = s.address;
+        size_t size = address.fFD ? CANFD_MAX_LEN : CAN_MAX_LEN;
+        CANAPI_Message_t message = {};
+        CANAPI_Return_t rc;
+        // (1) single frame
+        if ((length <= 7U) || (address.fFD && (length <= (size - 2U)))) {
+            if (length <= 7U) {
+                message.data[0] = (uint8_t)((PCI_SF << 4) | length);
+                memcpy(&message.data[1], data, length);
+                return WriteFrame(address, message, 1U + length);
+            }
+            message.data[0] = (uint8_t)(PCI_SF << 4);
+            message.data[1] = (uint8_t)length;
+            memcpy(&message.data[2], data, length);
+            return WriteFrame(address, message, 2U + length);
+        }
+        // (2) first frame
+        size_t offset, pci;
+        {
+            std::lock_guard<std::mutex> lock(s.lock);
+            s.fcReceived = false;  // discard a stale flow control frame
+        }
+        if (length <= 0xFFFU) {
+            message.data[0] = (uint8_t)((PCI_FF << 4) | (length >> 8));
+            message.data[1] = (uint8_t)length;
+            pci = 2U;
+        } else {
+            message.data[0] = (uint8_t)(PCI_FF << 4);
+            message.data[1] = 0x00U;
+            message.data[2] = (uint8_t)(length >> 24);
+            message.data[3] = (uint8_t)(length >> 16);
+            message.data[4] = (uint8_t)(length >> 8);
+            message.data[5] = (uint8_t)length;
+            pci = 6U;
+        }
+        offset = size - pci;
+        memcpy(&message.data[pci], data, offset);
+        if ((rc = WriteFrame(address, message, size)) != CANERR_NOERROR)
+            return rc;
+        // (3) consecutive frames, block by block
+        CANAPI_Message_t batch[PEAKCAN_ISOTP_BATCH] = {};
+        uint8_t sequence = 1U;
+        while (offset < length) {
+            uint8_t blockSize = 0U;
+            uint32_t separation = 0U;
+            if ((rc = WaitForFlowControl(s, blockSize, separation)) != CANERR_NOERROR)
+                return rc;
+            Clock::time_point next = Clock::now();
+            for (unsigned n = 0U; (offset < length) && (!blockSize || (n < blockSize)); ) {
+                if (separation && n) {
+                    next += std::chrono::microseconds(separation);
+                    WaitUntil(next);
+                    next = Clock::now();
+                }
+                // one frame with STmin, else up to PEAKCAN_ISOTP_BATCH frames of the block
+                size_t count = 0U;
+                do {
+                    size_t chunk = std::min(length - offset, size - 1U);
+                    CANAPI_Message_t &frame = batch[count++];
+                    frame.data[0] = (uint8_t)((PCI_CF << 4) | (sequence & 0x0FU));
+                    memcpy(&frame.data[1], &data[offset], chunk);
+                    Frame(address, frame, 1U + chunk);
+                    offset += chunk;
+                    sequence++;
+                    n++;
+                } while (!separation && (count < PEAKCAN_ISOTP_BATCH) && (offset < length) && (!blockSize || (n < blockSize)));
+                if ((rc = WriteFrames(batch, count)) != CANERR_NOERROR)
+                    return rc;
+            }
+        }
+        return CANERR_NOERROR;
+    }
+    void SendFlowControl(const SAddress &address, uint8_t status) {
+        CANAPI_Message_t message = {};
+        message.data[0] = (uint8_t)((PCI_FC << 4) | status);
+        message.data[1] = address.u8BlockSize;
+        message.data[2] = address.u8STmin;
+        (void)WriteFrame(address, message, 3U);
+    }
+    // processes a received frame of a session (with the session locked)
+    void Process(SSession &s, const uint8_t *data, size_t length) {
+        if (!length)
+            return;
+        switch (data[0] >> 4) {
+        case PCI_SF: {
+            size_t size = data[0] & 0x0FU, pci = 1U;
+            if (!size && (length > CAN_MAX_LEN) && (length >= 2U)) {  // CAN FD single frame
+                size = data[1];
+                pci = 2U;
+            }
+            if (!size || ((pci + size) > length))
+                break;
+            s.completed.push_back(std::vector<uint8_t>(&data[pci], &data[pci + size]));
+            s.stats.u64MessagesReceived++;
+            s.stats.u64BytesReceived += size;
+            s.receiving = false;  // note: a single frame aborts a reception in progress
+            s.signal.notify_all();
+            break;
+        }
+        case PCI_FF: {
+            size_t size = ((size_t)(data[0] & 0x0FU) << 8) | data[1], pci = 2U;
+            if (!size && (length >= 6U)) {
+                size = ((size_t)data[2] << 24) | ((size_t)data[3] << 16) | ((size_t)data[4] << 8) | data[5];
+                pci = 6U;
+            }
+            if ((size <= (length - pci)) || (length < CAN_MAX_LEN))
+                break;  // would fit into a single frame
+            if (size > PEAKCAN_ISOTP_MAX_LENGTH) {
+                SendFlowControl(s.address, FC_OVFLW);
+                s.stats.u64Errors++;
+                break;
+            }
+            if (s.receiving)
+                s.stats.u64Errors++;  // note: a first frame aborts a reception in progress
+            s.buffer.resize(size);
+            memcpy(s.buffer.data(), &data[pci], length - pci);
+            s.offset = length - pci;
+            s.sequence = 1U;
+            s.block = 0U;
+            s.receiving = true;
+            s.last = Clock::now();
+            SendFlowControl(s.address, FC_CTS);
+            break;
+        }
+        case PCI_CF: {
+            if (!s.receiving)
+                break;
+            Clock::time_point now = Clock::now();
+            if (((data[0] & 0x0FU) != (s.sequence & 0x0FU)) ||
+                ((now - s.last) > std::chrono::milliseconds(PEAKCAN_ISOTP_N_CR))) {
+                s.receiving = false;  // wrong sequence number or time-out
+                s.stats.u64Errors++;
+                break;
+            }
+            size_t chunk = std::min(length - 1U, s.buffer.size() - s.offset);
+            memcpy(&s.buffer[s.offset], &data[1], chunk);
+            s.offset += chunk;
+            s.sequence++;
+            s.last = now;
+            if (s.offset == s.buffer.size()) {
+                s.stats.u64MessagesReceived++;
+                s.stats.u64BytesReceived += s.buffer.size();
+                s.completed.push_back(std::vector<uint8_t>());
+                s.completed.back().swap(s.buffer);
+                s.receiving = false;
+                s.signal.notify_all();
+            } else if (s.address.u8BlockSize && (++s.block == s.address.u8BlockSize)) {
+                s.block = 0U;
+                SendFlowControl(s.address, FC_CTS);
+            }
+            break;
+        }
+        case PCI_FC:
+            if (length < 3U)
+                break;
+            s.fcStatus = data[0] & 0x0FU;
+            s.fcBlockSize = data[1];
+            s.fcSTmin = data[2];
+            s.fcReceived = true;
+            s.signal.notify_all();
+            break;
+        default:
+            break;
+        }
+    }
+    void Run() {
+        CANAPI_Message_t message;
+        while (m_Running) {
+            CANAPI_Return_t rc = m_Channel.ReadMessage(message);
+            if (CANERR_NOERROR != rc) {
+                // note: wait a while when the channel is not running, instead of spinning
+                if ((CANERR_RX_EMPTY != rc) && (CANERR_ERR_FRAME != rc))
+                    std::this_thread::sleep_for(std::chrono::milliseconds(PEAKCAN_ISOTP_IDLE));
+                continue;
+            }
+            if (message.sts || message.rtr)
+                continue;
+            SSession *s = NULL;
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                std::unordered_map<uint64_t, size_t>::const_iterator it = m_Lookup.find(Key(message.id, message.xtd != 0));
+                if (it != m_Lookup.end())
+                    s = m_Sessions[it->second].get();
+            }
+            if (s) {
+                std::lock_guard<std::mutex> lock(s->lock);
+                Process(*s, message.data, CCANAPI::Dlc2Len(message.dlc));
+            }
+        }
+        // wake up all blocking receivers
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (auto &s : m_Sessions) {
+            std::lock_guard<std::mutex> session(s->lock);
+            s->signal.notify_all();
+        }
+    }
+};
+/// \}
+#endif // PEAKCAN_ISOTP_H_INCLUDED
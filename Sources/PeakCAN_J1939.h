@@ -0,0 +1,533 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (for PEAK PCAN Interfaces)
+//
+//  Copyright (c) 2017-2021 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of PCANBasic-Wrapper.
+//
+//  PCANBasic-Wrapper is dual-licensed under the BSD 2-Clause "Simplified" License
+//  and under the GNU General Public License v3.0 (or any later version). You can
+//  choose between one of them if you use PCANBasic-Wrapper in whole or in part.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  PCANBasic-Wrapper IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF PCANBasic-Wrapper, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  PCANBasic-Wrapper is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  PCANBasic-Wrapper is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+#ifndef PEAKCAN_J1939_H_INCLUDED
+#define PEAKCAN_J1939_H_INCLUDED
+
+#include "PeakCAN.h"
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+/// \name   PeakCAN J1939
+/// \brief  SAE J1939-21 transport protocol (BAM and RTS/CTS) and J1939-81
+///         address claiming on 29-bit identifiers.
+/// \note   Received messages (single frames and reassembled multi-packet
+///         messages) are routed by PGN to the subscribed handlers through
+///         a hash table. Handlers are called in the thread that calls
+///         Process, i.e. the receive thread when the engine is started.
+/// \note   Without a NAME the engine is passive (monitor): it does not claim
+///         an address, does not answer RTS/CTS transfers and reassembles
+///         the transfers between all nodes.
+/// \{
+#define PEAKCAN_J1939_PGN_REQUEST  0x0EA00U  ///< Request
+#define PEAKCAN_J1939_PGN_TP_DT    0x0EB00U  ///< Transport Protocol - Data Transfer
+#define PEAKCAN_J1939_PGN_TP_CM    0x0EC00U  ///< Transport Protocol - Connection Management
+#define PEAKCAN_J1939_PGN_CLAIMED  0x0EE00U  ///< Address Claimed
+#define PEAKCAN_J1939_GLOBAL       0xFFU  ///< global destination address
+#define PEAKCAN_J1939_NULL         0xFEU  ///< null address (cannot claim)
+#define PEAKCAN_J1939_MAX_LENGTH   1785U  ///< maximum message length (255 packets)
+#define PEAKCAN_J1939_BAM_DELAY    50U  ///< delay between BAM packets in [ms] (50..200)
+#define PEAKCAN_J1939_T1           750U  ///< time-out for the next data packet in [ms]
+#define PEAKCAN_J1939_T2           1250U  ///< time-out after CTS in [ms]
+#define PEAKCAN_J1939_T3           1250U  ///< time-out for CTS or EoMA in [ms]
+#define PEAKCAN_J1939_T4           1050U  ///< time-out after CTS(hold) in [ms]
+#define PEAKCAN_J1939_POLL         100U  ///< read time-out of the receive loop in [ms] (resolution of the time-outs)
+#define PEAKCAN_J1939_IDLE         10U  ///< back-off in [ms] when the channel cannot be read (e.g. bus off)
+#define PEAKCAN_J1939_CTS_PACKETS  16U  ///< packets requested per CTS (as receiver)
+
+class CPeakCANJ1939 {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    /// \brief  decoded 29-bit identifier
+    struct SIdentifier {
+        uint8_t u8Priority;  ///< priority (0..7)
+        uint32_t u32PGN;  ///< parameter group number (PS = 0 for PDU1 format)
+        uint8_t u8Source;  ///< source address
+        uint8_t u8Destination;  ///< destination address (global for PDU2 format)
+    };
+    /// \brief  received message (single frame or reassembled)
+    struct SMessage {
+        SIdentifier identifier;  ///< PGN, priority and addresses
+        std::vector<uint8_t> data;  ///< payload (0..1785 bytes)
+        bool fTransport;  ///< reassembled by the transport protocol
+        CANAPI_Timestamp_t timestamp;  ///< time-stamp of the last frame
+    };
+    typedef std::function<void(const SMessage &message)> Handler;
+private:
+    enum { CM_RTS = 16, CM_CTS = 17, CM_EOMA = 19, CM_BAM = 32, CM_ABORT = 255 };
+    enum { ABORT_BUSY = 1, ABORT_RESOURCES = 2, ABORT_TIMEOUT = 3 };
+
+    struct SReception {  // multi-packet message in reassembly
+        SMessage message;  ///< message (data allocated on RTS/BAM)
+        uint8_t packets;  ///< total number of packets
+        uint8_t next;  ///< expected sequence number
+        uint8_t window;  ///< last sequence number of the current CTS
+        uint8_t maximum;  ///< packets per CTS allowed by the sender (RTS data[4], 0xFF = no limit)
+        bool answer;  ///< flag: we are the receiver (send CTS/EoMA)
+        Clock::time_point deadline;  ///< time-out of the next packet
+    };
+    struct STransmission {  // RTS/CTS transfer in progress (sender)
+        bool active;  ///< flag: waiting for CTS/EoMA
+        uint8_t peer;  ///< destination address
+        uint32_t pgn;  ///< PGN of the message
+        bool signaled;  ///< flag: control frame received
+        uint8_t control;  ///< received control byte
+        uint8_t count;  ///< CTS: number of packets
+        uint8_t next;  ///< CTS: next packet number
+    };
+    CPeakCAN &m_Channel;  ///< CAN channel (started by the application)
+    uint64_t m_Name;  ///< our NAME (0 = passive)
+    std::atomic<uint8_t> m_Address;  ///< our address (null = none)
+    bool m_Claimed[256];  ///< addresses claimed by other nodes
+    std::unordered_map<uint32_t, Handler> m_Handlers;  ///< PGN to handler
+    Handler m_Default;  ///< handler for all other PGNs
+    std::unordered_map<uint16_t, SReception> m_Receptions;  ///< by source and destination
+    STransmission m_Transmission;  ///< sender state
+    std::thread m_Receiver;  ///< receive thread
+    std::atomic<bool> m_Running;  ///< flag: engine running
+    std::mutex m_Mutex;  ///< protects receptions, transmission and claims
+    std::condition_variable m_Signal;  ///< control frame for the sender
+    std::mutex m_Sending;  ///< one multi-packet transfer at a time
+    std::mutex m_Write;  ///< serializes writes
+public:
+    /// \brief  J1939 node with 'name' and preferred 'address' (name 0 = passive)
+    CPeakCANJ1939(CPeakCAN &channel, uint64_t name = 0U, uint8_t address = PEAKCAN_J1939_NULL)
+        : m_Channel(channel), m_Name(name), m_Address(name ? address : (uint8_t)PEAKCAN_J1939_NULL), m_Running(false) {
+        memset(m_Claimed, 0, sizeof(m_Claimed));
+        memset(&m_Transmission, 0, sizeof(m_Transmission));
+    }
+    ~CPeakCANJ1939() { (void)Stop(); }
+
+    /// \brief  decodes a 29-bit identifier
+    static SIdentifier Decode(uint32_t id) {
+        SIdentifier result;
+        result.u8Priority = (uint8_t)((id >> 26) & 0x7U);
+        result.u32PGN = (id >> 8) & 0x3FFFFU;
+        result.u8Source = (uint8_t)id;
+        if (((result.u32PGN >> 8) & 0xFFU) < 240U) {  // PDU1: PS is the destination
+            result.u8Destination = (uint8_t)result.u32PGN;
+            result.u32PGN &= 0x3FF00U;
+        } else  // PDU2: PS is the group extension
+            result.u8Destination = PEAKCAN_J1939_GLOBAL;
+        return result;
+    }
+    /// \brief  encodes a 29-bit identifier
+    static uint32_t Encode(uint8_t priority, uint32_t pgn, uint8_t source, uint8_t destination) {
+        pgn &= 0x3FFFFU;
+        if (((pgn >> 8) & 0xFFU) < 240U)
+            pgn = (pgn & 0x3FF00U) | destination;
+        return ((uint32_t)(priority & 0x7U) << 26) | (pgn << 8) | source;
+    }
+    /// \brief  subscribes a handler for the given PGN
+    CANAPI_Return_t Subscribe(uint32_t pgn, const Handler &handler) {
+        if (m_Running)
+            return CANERR_ONLINE;
+        if (!handler || (pgn > 0x3FFFFU))
+            return CANERR_ILLPARA;
+        m_Handlers[pgn] = handler;
+        return CANERR_NOERROR;
+    }
+    /// \brief  subscribes a handler for all PGNs without own handler
+    CANAPI_Return_t SubscribeDefault(const Handler &handler) {
+        if (m_Running)
+            return CANERR_ONLINE;
+        m_Default = handler;
+        return CANERR_NOERROR;
+    }
+    /// \brief  starts the receive thread and claims the address (if any)
+    CANAPI_Return_t Start() {
+        if (m_Running)
+            return CANERR_ONLINE;
+        m_Running = true;
+        m_Receiver = std::thread(&CPeakCANJ1939::Run, this);
+        if (m_Name) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            SendClaim();
+        }
+        return CANERR_NOERROR;
+    }
+    /// \brief  stops the receive thread
+    CANAPI_Return_t Stop() {
+        if (!m_Running)
+            return CANERR_OFFLINE;
+        m_Running = false;
+        (void)m_Channel.SignalChannel();  // wake up the blocking read
+        if (m_Receiver.joinable())
+            m_Receiver.join();
+        return CANERR_NOERROR;
+    }
+    /// \brief  our current address (null when no address could be claimed)
+    uint8_t GetAddress() const { return m_Address; }
+
+    /// \brief  sends a message; messages longer than 8 bytes are sent by
+    ///         BAM (global destination) or by RTS/CTS (specific destination)
+    CANAPI_Return_t Send(uint32_t pgn, uint8_t priority, uint8_t destination, const uint8_t *data, size_t length) {
+        if ((pgn > 0x3FFFFU) || (!data && length) || (length > PEAKCAN_J1939_MAX_LENGTH))
+            return CANERR_ILLPARA;
+        uint8_t source = m_Address;
+        if (source == PEAKCAN_J1939_NULL)
+            return CANERR_NOTINIT;  // no address claimed
+        if (((pgn >> 8) & 0xFFU) >= 240U)
+            destination = PEAKCAN_J1939_GLOBAL;  // PDU2 is always broadcast
+        if (length <= CAN_MAX_LEN)
+            return WriteFrame(Encode(priority, pgn, source, destination), data, length, false);
+        std::lock_guard<std::mutex> sending(m_Sending);
+        uint8_t packets = (uint8_t)((length + 6U) / 7U);
+        uint8_t control[8] = { 0U, (uint8_t)length, (uint8_t)(length >> 8), packets, 0xFFU,
+                               (uint8_t)pgn, (uint8_t)(pgn >> 8), (uint8_t)(pgn >> 16) };
+        CANAPI_Return_t rc;
+        if (destination == PEAKCAN_J1939_GLOBAL) {
+            // (1) broadcast announce message, packets at a fixed rate
+            control[0] = CM_BAM;
+            if ((rc = WriteFrame(Encode(7U, PEAKCAN_J1939_PGN_TP_CM, source, destination), control, 8U)) != CANERR_NOERROR)
+                return rc;
+            for (unsigned sequence = 1U; sequence <= packets; sequence++) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(PEAKCAN_J1939_BAM_DELAY));
+                if ((rc = WritePacket(source, destination, (uint8_t)sequence, data, length)) != CANERR_NOERROR)
+                    return rc;
+            }
+            return CANERR_NOERROR;
+        }
+        // (2) request to send, then packets as requested by clear to send
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Transmission.active = true;
+            m_Transmission.peer = destination;
+            m_Transmission.pgn = pgn;
+            m_Transmission.signaled = false;
+        }
+        control[0] = CM_RTS;
+        if ((rc = WriteFrame(Encode(7U, PEAKCAN_J1939_PGN_TP_CM, source, destination), control, 8U)) != CANERR_NOERROR)
+            return EndTransmission(rc);
+        unsigned timeout = PEAKCAN_J1939_T3;
+        for (;;) {
+            uint8_t what, count, next;
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                if (!m_Signal.wait_for(lock, std::chrono::milliseconds(timeout), [this] { return m_Transmission.signaled; })) {
+                    lock.unlock();
+                    SendAbort(source, destination, pgn, ABORT_TIMEOUT);
+                    return EndTransmission(CANERR_TIMEOUT);
+                }
+                m_Transmission.signaled = false;
+                what = m_Transmission.control;
+                count = m_Transmission.count;
+                next = m_Transmission.next;
+            }
+            if (what == CM_EOMA)
+                return EndTransmission(CANERR_NOERROR);
+            if (what == CM_ABORT)
+                return EndTransmission(CANERR_RESOURCE);
+            if (!count) {  // hold the connection open
+                timeout = PEAKCAN_J1939_T4;
+                continue;
+            }
+            unsigned first = next ? next : 1U;  // note: 0 is not a valid packet number
+            for (unsigned sequence = first; (sequence < first + count) && (sequence <= packets); sequence++) {
+                if ((rc = WritePacket(source, destination, (uint8_t)sequence, data, length)) != CANERR_NOERROR)
+                    return EndTransmission(rc);
+            }
+            timeout = PEAKCAN_J1939_T3;
+        }
+    }
+    /// \brief  processes a received CAN message (called by the receive
+    ///         thread, or by the application when the engine is not started)
+    void Process(const CANAPI_Message_t &message) {
+        if (!message.xtd || message.sts || message.rtr)
+            return;
+        SIdentifier id = Decode(message.id);
+        size_t length = std::min((size_t)CCANAPI::Dlc2Len(message.dlc), (size_t)CAN_MAX_LEN);
+        std::vector<SMessage> deliver;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            switch (id.u32PGN) {
+            case PEAKCAN_J1939_PGN_TP_CM:
+                OnConnection(id, message.data, length, message.timestamp);
+                break;
+            case PEAKCAN_J1939_PGN_TP_DT:
+                OnData(id, message.data, length, message.timestamp, deliver);
+                break;
+            case PEAKCAN_J1939_PGN_CLAIMED:
+                OnClaim(id, message.data, length);
+                break;
+            case PEAKCAN_J1939_PGN_REQUEST:
+                if (m_Name && (length >= 3U) && (((uint32_t)message.data[2] << 16 | (uint32_t)message.data[1] << 8 | message.data[0]) == PEAKCAN_J1939_PGN_CLAIMED) &&
+                    ((id.u8Destination == PEAKCAN_J1939_GLOBAL) || (id.u8Destination == m_Address)))
+                    SendClaim();
+                break;
+            default:
+                break;
+            }
+        }
+        if ((id.u32PGN != PEAKCAN_J1939_PGN_TP_CM) && (id.u32PGN != PEAKCAN_J1939_PGN_TP_DT)) {
+            SMessage single;
+            single.identifier = id;
+            single.data.assign(message.data, message.data + length);
+            single.fTransport = false;
+            single.timestamp = message.timestamp;
+            deliver.push_back(single);
+        }
+        for (const SMessage &m : deliver)
+            Dispatch(m);
+    }
+    /// \brief  aborts reassemblies that timed out (called by the receive thread,
+    ///         or by the application when the engine is not started)
+    void Expire() {
+        Clock::time_point now = Clock::now();
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (std::unordered_map<uint16_t, SReception>::iterator it = m_Receptions.begin(); it != m_Receptions.end(); ) {
+            if (now > it->second.deadline) {
+                const SIdentifier &id = it->second.message.identifier;
+                if (it->second.answer)
+                    SendAbort(id.u8Destination, id.u8Source, id.u32PGN, ABORT_TIMEOUT);
+                it = m_Receptions.erase(it);
+            } else
+                ++it;
+        }
+    }
+private:
+    static uint16_t Key(uint8_t source, uint8_t destination) { return (uint16_t)((source << 8) | destination); }
+
+    void Dispatch(const SMessage &message) {
+        std::unordered_map<uint32_t, Handler>::const_iterator it = m_Handlers.find(message.identifier.u32PGN);
+        if (it != m_Handlers.end())
+            it->second(message);
+        else if (m_Default)
+            m_Default(message);
+    }
+    CANAPI_Return_t WriteFrame(uint32_t id, const uint8_t *data, size_t length, bool pad = true) {
+        CANAPI_Message_t message = {};
+        message.id = id;
+        message.xtd = 1;
+        message.dlc = (uint8_t)(pad ? CAN_MAX_LEN : length);
+        memset(message.data, 0xFF, CAN_MAX_LEN);
+        if (length)
+            memcpy(message.data, data, length);
+        CANAPI_Return_t rc;
+        std::lock_guard<std::mutex> lock(m_Write);
+        while ((rc = m_Channel.WriteMessage(message)) == CANERR_TX_BUSY)
+            std::this_thread::yield();
+        return rc;
+    }
+    CANAPI_Return_t WritePacket(uint8_t source, uint8_t destination, uint8_t sequence, const uint8_t *data, size_t length) {
+        uint8_t packet[8];
+        size_t offset = (size_t)(sequence - 1U) * 7U;
+        size_t chunk = std::min((size_t)7U, length - offset);
+        memset(packet, 0xFF, sizeof(packet));
+        packet[0] = sequence;
+        memcpy(&packet[1], &data[offset], chunk);
+        return WriteFrame(Encode(7U, PEAKCAN_J1939_PGN_TP_DT, source, destination), packet, 8U);
+    }
+    CANAPI_Return_t EndTransmission(CANAPI_Return_t rc) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Transmission.active = false;
+        return rc;
+    }
+    void SendControl(uint8_t source, uint8_t destination, uint8_t control, uint8_t b1, uint8_t b2, uint8_t b3, uint8_t b4, uint32_t pgn) {
+        uint8_t data[8] = { control, b1, b2, b3, b4, (uint8_t)pgn, (uint8_t)(pgn >> 8), (uint8_t)(pgn >> 16) };
+        (void)WriteFrame(Encode(7U, PEAKCAN_J1939_PGN_TP_CM, source, destination), data, 8U);
+    }
+    void SendAbort(uint8_t source, uint8_t destination, uint32_t pgn, uint8_t reason) {
+        SendControl(source, destination, CM_ABORT, reason, 0xFFU, 0xFFU, 0xFFU, pgn);
+    }
+    void SendClearToSend(SReception &r) {
+        const SIdentifier &id = r.message.identifier;
+        unsigned count = std::min((unsigned)PEAKCAN_J1939_CTS_PACKETS, (unsigned)r.maximum);
+        count = std::min(count, (unsigned)(r.packets - r.next + 1U));
+        r.window = (uint8_t)(r.next + count - 1U);
+        r.deadline = Clock::now() + std::chrono::milliseconds(PEAKCAN_J1939_T2);
+        SendControl(id.u8Destination, id.u8Source, CM_CTS, (uint8_t)count, r.next, 0xFFU, 0xFFU, id.u32PGN);
+    }
+    void SendClaim() {  // with the mutex locked
+        uint8_t name[8];
+        for (unsigned i = 0U; i < 8U; i++)
+            name[i] = (uint8_t)(m_Name >> (8U * i));
+        (void)WriteFrame(Encode(6U, PEAKCAN_J1939_PGN_CLAIMED, m_Address, PEAKCAN_J1939_GLOBAL), name, 8U);
+    }
+    // TP.CM: RTS, CTS, EoMA, BAM and abort (with the mutex locked)
+    void OnConnection(const SIdentifier &id, const uint8_t *data, size_t length, const CANAPI_Timestamp_t &timestamp) {
+        if (length < 8U)
+            return;
+        uint32_t pgn = (uint32_t)data[7] << 16 | (uint32_t)data[6] << 8 | data[5];
+        size_t size = (size_t)data[2] << 8 | data[1];
+        bool ours = m_Name && (id.u8Destination == m_Address) && (m_Address != PEAKCAN_J1939_NULL);
+        switch (data[0]) {
+        case CM_BAM:
+        case CM_RTS: {
+            bool bam = (data[0] == CM_BAM);
+            if (bam != (id.u8Destination == PEAKCAN_J1939_GLOBAL))
+                return;
+            if (!bam && !ours && m_Name)
+                return;  // a transfer between other nodes
+            if ((size <= CAN_MAX_LEN) || (size > PEAKCAN_J1939_MAX_LENGTH) || (data[3] != (size + 6U) / 7U)) {
+                if (ours)
+                    SendAbort(id.u8Destination, id.u8Source, pgn, ABORT_RESOURCES);
+                return;
+            }
+            SReception &r = m_Receptions[Key(id.u8Source, id.u8Destination)];  // note: replaces a reassembly in progress
+            r.message.identifier = id;
+            r.message.identifier.u32PGN = pgn;
+            r.message.data.assign(size, 0U);
+            r.message.fTransport = true;
+            r.message.timestamp = timestamp;
+            r.packets = data[3];
+            r.next = 1U;
+            r.window = r.packets;
+            r.maximum = (bam || !data[4]) ? 0xFFU : data[4];  // 0 is not valid: no limit
+            r.answer = ours;
+            r.deadline = Clock::now() + std::chrono::milliseconds(bam ? PEAKCAN_J1939_T1 : PEAKCAN_J1939_T2);
+            if (ours)
+                SendClearToSend(r);
+            break;
+        }
+        case CM_CTS:
+        case CM_EOMA:
+        case CM_ABORT:
+            if (m_Transmission.active && (id.u8Source == m_Transmission.peer) && (id.u8Destination == m_Address) && (pgn == m_Transmission.pgn)) {
+                m_Transmission.control = data[0];
+                m_Transmission.count = data[1];
+                m_Transmission.next = data[2];
+                m_Transmission.signaled = true;
+                m_Signal.notify_all();
+                return;
+            }
+            {   // receiver side (CTS/EoMA come from the receiver, abort from either)
+                std::unordered_map<uint16_t, SReception>::iterator it = m_Receptions.find(Key(id.u8Destination, id.u8Source));
+                if ((it == m_Receptions.end()) && (data[0] == CM_ABORT))
+                    it = m_Receptions.find(Key(id.u8Source, id.u8Destination));
+                if (it == m_Receptions.end())
+                    return;
+                if (data[0] == CM_CTS) {
+                    if (!it->second.answer && data[1]) {  // monitor: follow the sender
+                        it->second.next = data[2];
+                        it->second.deadline = Clock::now() + std::chrono::milliseconds(PEAKCAN_J1939_T2);
+                    }
+                } else if ((data[0] == CM_ABORT) || !it->second.answer)
+                    m_Receptions.erase(it);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    // TP.DT: data packets of BAM and RTS/CTS (with the mutex locked)
+    void OnData(const SIdentifier &id, const uint8_t *data, size_t length, const CANAPI_Timestamp_t &timestamp, std::vector<SMessage> &deliver) {
+        std::unordered_map<uint16_t, SReception>::iterator it = m_Receptions.find(Key(id.u8Source, id.u8Destination));
+        if ((it == m_Receptions.end()) || (length < 2U))
+            return;
+        SReception &r = it->second;
+        if (data[0] != r.next)
+            return;  // duplicate or out of sequence
+        size_t offset = (size_t)(r.next - 1U) * 7U;
+        size_t chunk = std::min(std::min((size_t)7U, length - 1U), r.message.data.size() - offset);
+        memcpy(&r.message.data[offset], &data[1], chunk);
+        r.message.timestamp = timestamp;
+        r.deadline = Clock::now() + std::chrono::milliseconds(PEAKCAN_J1939_T1);
+        if (r.next == r.packets) {  // complete
+            const SIdentifier &rid = r.message.identifier;
+            if (r.answer)
+                SendControl(rid.u8Destination, rid.u8Source, CM_EOMA, (uint8_t)r.message.data.size(),
+                            (uint8_t)(r.message.data.size() >> 8), r.packets, 0xFFU, rid.u32PGN);
+            deliver.push_back(r.message);
+            m_Receptions.erase(it);
+            return;
+        }
+        if (r.answer && (r.next == r.window)) {
+            r.next++;
+            SendClearToSend(r);
+            return;
+        }
+        r.next++;
+    }
+    // Address Claimed: defend or give up our address (with the mutex locked)
+    void OnClaim(const SIdentifier &id, const uint8_t *data, size_t length) {
+        if (length < 8U)
+            return;
+        uint64_t name = 0U;
+        for (unsigned i = 0U; i < 8U; i++)
+            name |= (uint64_t)data[i] << (8U * i);
+        if (name == m_Name)
+            return;
+        if (id.u8Source < PEAKCAN_J1939_NULL)
+            m_Claimed[id.u8Source] = true;
+        if (!m_Name || (id.u8Source != m_Address))
+            return;
+        if (m_Name < name) {  // we win (lower NAME has priority)
+            SendClaim();
+            return;
+        }
+        // we lose: self-configurable nodes pick another address (128..247)
+        m_Address = PEAKCAN_J1939_NULL;
+        if (m_Name >> 63) {
+            for (unsigned address = 128U; address <= 247U; address++) {
+                if (!m_Claimed[address]) {
+                    m_Address = (uint8_t)address;
+                    break;
+                }
+            }
+        }
+        SendClaim();  // or 'cannot claim' from the null address
+    }
+    void Run() {
+        CANAPI_Message_t message;
+        while (m_Running) {
+            CANAPI_Return_t rc = m_Channel.ReadMessage(message, PEAKCAN_J1939_POLL);
+            if (rc == CANERR_NOERROR)
+                Process(message);
+            else if ((rc != CANERR_RX_EMPTY) && (rc != CANERR_ERR_FRAME) && m_Running)
+                std::this_thread::sleep_for(std::chrono::milliseconds(PEAKCAN_J1939_IDLE));
+            Expire();
+        }
+    }
+};
+/// \}
+#endif // PEAKCAN_J1939_H_INCLUDED
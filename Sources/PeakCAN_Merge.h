@@ -0,0 +1,266 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (for PEAK PCAN Interfaces)
+//
+//  Copyright (c) 2017-2021 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of PCANBasic-Wrapper.
+//
+//  PCANBasic-Wrapper is dual-licensed under the BSD 2-Clause "Simplified" License
+//  and under the GNU General Public License v3.0 (or any later version). You can
+//  choose between one of them if you use PCANBasic-Wrapper in whole or in part.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  PCANBasic-Wrapper IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF PCANBasic-Wrapper, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  PCANBasic-Wrapper is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  PCANBasic-Wrapper is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+#ifndef PEAKCAN_MERGE_H_INCLUDED
+#define PEAKCAN_MERGE_H_INCLUDED
+
+#include "PeakCAN_Recorder.h"
+#include "PeakCAN_Compact.h"
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <string.h>
+
+/// \name   PeakCAN Merge
+/// \brief  K-way merge of capture files (one per channel) into a single
+///         stream in time-stamp order, each message tagged with the channel
+///         number of its capture.
+/// \note   The inputs are memory-mapped capture files (black-box recorder
+///         or snapshot, see PeakCAN_Recorder.h) or compact capture files
+///         (see PeakCAN_Compact.h); the format is recognized by its magic.
+///         They are read as streams: a compact file block by block, a
+///         capture file record by record (torn records and events are
+///         skipped).
+/// \note   Inputs need only be ordered locally: a message may come up to
+///         the reorder window after a message with a later time-stamp of
+///         the same input. All messages read ahead wait in one binary heap
+///         (time-stamp, channel, arrival); the smallest one is released
+///         when every input that is not exhausted has read past its time-
+///         stamp plus the window. So the memory is bounded by the traffic
+///         of the window, not by the size of the files. Messages that are
+///         later than the window are released as soon as possible (out of
+///         order) and counted.
+/// \{
+#define PEAKCAN_MERGE_WINDOW  10U  ///< default reorder window in [ms]
+
+class CPeakCANMerge {
+public:
+    /// \brief  statistics of a merge
+    struct SStatistics {
+        uint64_t u64Messages;  ///< messages released
+        uint64_t u64Late;  ///< messages later than the reorder window (released out of order)
+        uint64_t u64Skipped;  ///< records skipped (torn records, events)
+        uint64_t u64Pending;  ///< maximum number of messages waiting in the heap
+    };
+private:
+    struct SInput {  // a capture file
+        CPeakCANMappedFile file;  ///< mapped capture file
+        int32_t channel;  ///< channel number of the capture
+        bool compact;  ///< compact capture format
+        bool exhausted;  ///< flag: all messages read
+        uint64_t watermark;  ///< latest time-stamp read in [ns]
+        const CPeakCANRecorder::SRecord *records;  ///< capture file: records
+        uint64_t capacity;  ///< capture file: number of records
+        uint64_t sequence, head;  ///< capture file: next record and sequence number after the newest record
+        uint32_t blockSize;  ///< compact file: maximum block size
+        uint64_t offset;  ///< compact file: next block
+        CPeakCANCompactBlock block;  ///< compact file: current block
+    };
+    struct SPending {  // message read ahead
+        uint64_t time;  ///< time-stamp in [ns]
+        int32_t channel;  ///< channel number
+        uint64_t arrival;  ///< read order (stable output for equal time-stamps)
+        CANAPI_Message_t message;  ///< the message
+    };
+    struct SLater {  // heap order: the smallest element on top
+        bool operator()(const SPending &a, const SPending &b) const {
+            if (a.time != b.time)
+                return a.time > b.time;
+            if (a.channel != b.channel)
+                return a.channel > b.channel;
+            return a.arrival > b.arrival;
+        }
+    };
+    std::vector<std::unique_ptr<SInput>> m_Inputs;  ///< capture files
+    std::vector<SPending> m_Heap;  ///< messages read ahead (binary heap)
+    uint64_t m_Window;  ///< reorder window in [ns]
+    uint64_t m_Arrival;  ///< read counter
+    uint64_t m_Released;  ///< time-stamp of the last message released in [ns]
+    SStatistics m_Statistics;  ///< statistics
+public:
+    CPeakCANMerge(uint32_t window = PEAKCAN_MERGE_WINDOW) : m_Window((uint64_t)window * 1000000U), m_Arrival(0U), m_Released(0U) {
+        memset(&m_Statistics, 0, sizeof(m_Statistics));
+    }
+    /// \brief  adds a capture file (before the first message is read)
+    /// \param[in]  path - name of the capture or compact capture file
+    /// \param[in]  channel - channel number of the messages of the file
+    /// \return CANERR_ILLPARA if the file is not a capture
+    CANAPI_Return_t AddInput(const char *path, int32_t channel) {
+        if (m_Arrival)
+            return CANERR_YETINIT;
+        std::unique_ptr<SInput> input(new SInput());
+        CANAPI_Return_t rc = input->file.Open(path);
+        if (rc != CANERR_NOERROR)
+            return rc;
+        input->channel = channel;
+        input->compact = input->exhausted = false;
+        input->watermark = 0U;
+        input->records = NULL;
+        input->capacity = input->sequence = input->head = 0U;
+        input->blockSize = 0U;
+        input->offset = 0U;
+        const uint8_t *data = input->file.Data();
+        uint64_t size = input->file.Size();
+        if ((size >= sizeof(CPeakCANRecorder::SHeader)) &&
+            (((const CPeakCANRecorder::SHeader*)data)->u32Magic == PEAKCAN_RECORDER_MAGIC)) {
+            const CPeakCANRecorder::SHeader *header = (const CPeakCANRecorder::SHeader*)data;
+            if ((header->u16Version != PEAKCAN_RECORDER_VERSION) ||
+                (header->u16RecordSize != (uint16_t)sizeof(CPeakCANRecorder::SRecord)) || !header->u64Capacity ||
+                (size < sizeof(CPeakCANRecorder::SHeader) + header->u64Capacity * sizeof(CPeakCANRecorder::SRecord)))
+                return CANERR_ILLPARA;
+            input->records = (const CPeakCANRecorder::SRecord*)(header + 1);
+            input->capacity = header->u64Capacity;
+            input->head = header->u64Head;
+            input->sequence = (input->head > input->capacity) ? (input->head - input->capacity) : 0U;
+        }
+        else if ((size >= sizeof(CPeakCANCompact::SFileHeader)) &&
+                 (((const CPeakCANCompact::SFileHeader*)data)->u32Magic == PEAKCAN_COMPACT_MAGIC)) {
+            const CPeakCANCompact::SFileHeader *header = (const CPeakCANCompact::SFileHeader*)data;
+            if ((header->u16Version != PEAKCAN_COMPACT_VERSION) || !header->u32BlockSize)
+                return CANERR_ILLPARA;
+            input->compact = true;
+            input->blockSize = header->u32BlockSize;
+            input->offset = sizeof(CPeakCANCompact::SFileHeader);
+        }
+        else
+            return CANERR_ILLPARA;
+        m_Inputs.push_back(std::move(input));
+        return CANERR_NOERROR;
+    }
+    /// \brief  number of capture files
+    size_t GetInputs() const { return m_Inputs.size(); }
+
+    /// \brief  releases the next message in time-stamp order
+    /// \param[out] message - the message
+    /// \param[out] channel - channel number of its capture file
+    /// \return CANERR_RX_EMPTY when all inputs are exhausted, CANERR_ILLPARA if a compact file is corrupt
+    CANAPI_Return_t Next(CANAPI_Message_t &message, int32_t &channel) {
+        for (;;) {
+            // the input that has read the least (the one that holds the heap back)
+            SInput *lagging = NULL;
+            for (size_t i = 0U; i < m_Inputs.size(); i++)
+                if (!m_Inputs[i]->exhausted && (!lagging || (m_Inputs[i]->watermark < lagging->watermark)))
+                    lagging = m_Inputs[i].get();
+            if (!m_Heap.empty() && (!lagging || (lagging->watermark >= m_Heap.front().time + m_Window))) {
+                std::pop_heap(m_Heap.begin(), m_Heap.end(), SLater());
+                const SPending &pending = m_Heap.back();
+                if (pending.time < m_Released)
+                    m_Statistics.u64Late++;
+                else
+                    m_Released = pending.time;
+                message = pending.message;
+                channel = pending.channel;
+                m_Heap.pop_back();
+                m_Statistics.u64Messages++;
+                return CANERR_NOERROR;
+            }
+            if (!lagging)
+                return CANERR_RX_EMPTY;
+            // read ahead until the lagging input has passed the release time
+            uint64_t until = m_Heap.empty() ? 0U : (m_Heap.front().time + m_Window);
+            do {
+                SPending pending;
+                CANAPI_Return_t rc = Read(*lagging, pending.message);
+                if (rc != CANERR_NOERROR) {
+                    lagging->exhausted = true;
+                    if (rc != CANERR_RX_EMPTY)
+                        return rc;
+                    break;
+                }
+                pending.time = (uint64_t)pending.message.timestamp.tv_sec * 1000000000U + (uint64_t)pending.message.timestamp.tv_nsec;
+                pending.channel = lagging->channel;
+                pending.arrival = m_Arrival++;
+                if (pending.time > lagging->watermark)
+                    lagging->watermark = pending.time;
+                m_Heap.push_back(pending);
+                std::push_heap(m_Heap.begin(), m_Heap.end(), SLater());
+                if ((uint64_t)m_Heap.size() > m_Statistics.u64Pending)
+                    m_Statistics.u64Pending = (uint64_t)m_Heap.size();
+                if (pending.time + m_Window < until)
+                    break;  // a new release time (don't read ahead to the old one)
+            } while (lagging->watermark < until);
+        }
+    }
+    /// \brief  statistics of the merge
+    void GetStatistics(SStatistics &statistics) const { statistics = m_Statistics; }
+private:
+    /// \brief  reads the next message of a capture file
+    CANAPI_Return_t Read(SInput &input, CANAPI_Message_t &message) {
+        if (!input.compact) {
+            for (; input.sequence < input.head; input.sequence++) {
+                const CPeakCANRecorder::SRecord &record = input.records[input.sequence % input.capacity];
+                if ((record.u64Sequence != (input.sequence + 1U)) || (record.u8Type != CPeakCANRecorder::RecordMessage)) {
+                    m_Statistics.u64Skipped++;
+                    continue;
+                }
+                message = record.message;
+                if (record.u64Sequence != (input.sequence + 1U)) {  // overwritten while copying
+                    m_Statistics.u64Skipped++;
+                    continue;
+                }
+                input.sequence++;
+                return CANERR_NOERROR;
+            }
+            return CANERR_RX_EMPTY;
+        }
+        CANAPI_Return_t rc;
+        while ((rc = input.block.Next(message)) == CANERR_RX_EMPTY) {
+            CPeakCANCompact::SBlockHeader header;
+            if ((input.offset + sizeof(header)) > input.file.Size())
+                return CANERR_RX_EMPTY;
+            memcpy(&header, input.file.Data() + input.offset, sizeof(header));
+            if ((input.offset + sizeof(header) + header.u32StoredSize) > input.file.Size())
+                return CANERR_RX_EMPTY;  // cut off by a crash
+            if (!input.block.Load(header, input.file.Data() + input.offset + sizeof(header), input.blockSize))
+                return CANERR_ILLPARA;
+            input.offset += sizeof(header) + header.u32StoredSize;
+        }
+        return rc;
+    }
+    CPeakCANMerge(const CPeakCANMerge&);  // not copyable
+    CPeakCANMerge &operator=(const CPeakCANMerge&);
+};
+/// \}
+
+#endif // PEAKCAN_MERGE_H_INCLUDED
@@ -0,0 +1,216 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (for PEAK PCAN Interfaces)
+//
+//  Copyright (c) 2017-2021 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of PCANBasic-Wrapper.
+//
+//  PCANBasic-Wrapper is dual-licensed under the BSD 2-Clause "Simplified" License
+//  and under the GNU General Public License v3.0 (or any later version). You can
+//  choose between one of them if you use PCANBasic-Wrapper in whole or in part.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  PCANBasic-Wrapper IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF PCANBasic-Wrapper, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  PCANBasic-Wrapper is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  PCANBasic-Wrapper is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with PCANBasic-Wrapper.  If not, see <https://www.gnu.org/licenses/>.
+//
+#ifndef PEAKCAN_PRESETS_H_INCLUDED
+#define PEAKCAN_PRESETS_H_INCLUDED
+
+#include "CANAPI.h"
+
+/// \name   PeakCAN Bit-timing Presets
+/// \brief  Compile-time validated bit-timing settings for the PCAN clocks.
+/// \note   All presets are checked by static_assert against the register
+///         limits and their bit-rates, so a typo does not compile.
+/// \{
+struct SPeakCANPreset {
+    struct STiming {
+        uint16_t brp;  ///< bit-rate prescaler
+        uint16_t tseg1;  ///< time segment 1 (before SP)
+        uint16_t tseg2;  ///< time segment 2 (after SP)
+        uint16_t sjw;  ///< synchronization jump width
+    };
+    int32_t frequency;  ///< clock domain (frequency in [Hz])
+    STiming nominal;  ///< nominal bit-timing
+    STiming data;  ///< data bit-timing (all zero for long frames only)
+
+    /// \brief  CAN 2.0 preset (SJA1000 registers @ 8MHz)?
+    constexpr bool IsSja1000() const {
+        return (frequency == CANBTR_FREQ_SJA1000);
+    }
+    /// \brief  preset with data bit-rate (bit-rate switching)?
+    constexpr bool HasData() const {
+        return (data.brp != 0U) || (data.tseg1 != 0U) || (data.tseg2 != 0U) || (data.sjw != 0U);
+    }
+    /// \brief  all register settings within their limits?
+    constexpr bool IsValid() const {
+        return IsSja1000()
+            ? (InRange(nominal, CANBTR_SJA1000_BRP_MIN, CANBTR_SJA1000_BRP_MAX,
+                                CANBTR_SJA1000_TSEG1_MIN, CANBTR_SJA1000_TSEG1_MAX,
+                                CANBTR_SJA1000_TSEG2_MIN, CANBTR_SJA1000_TSEG2_MAX,
+                                CANBTR_SJA1000_SJW_MIN, CANBTR_SJA1000_SJW_MAX) && !HasData())
+            : (InRange(nominal, CANBTR_NOMINAL_BRP_MIN, CANBTR_NOMINAL_BRP_MAX,
+                                CANBTR_NOMINAL_TSEG1_MIN, CANBTR_NOMINAL_TSEG1_MAX,
+                                CANBTR_NOMINAL_TSEG2_MIN, CANBTR_NOMINAL_TSEG2_MAX,
+                                CANBTR_NOMINAL_SJW_MIN, CANBTR_NOMINAL_SJW_MAX) &&
+               (!HasData() ||
+                InRange(data, CANBTR_DATA_BRP_MIN, CANBTR_DATA_BRP_MAX,
+                              CANBTR_DATA_TSEG1_MIN, CANBTR_DATA_TSEG1_MAX,
+                              CANBTR_DATA_TSEG2_MIN, CANBTR_DATA_TSEG2_MAX,
+                              CANBTR_DATA_SJW_MIN, CANBTR_DATA_SJW_MAX)));
+    }
+    /// \brief  nominal bit-rate in [bit/s] (or 0 if not an integral value)
+    constexpr uint32_t NominalSpeed() const {
+        return Speed(frequency, nominal);
+    }
+    /// \brief  data bit-rate in [bit/s] (or 0 if not an integral value)
+    constexpr uint32_t DataSpeed() const {
+        return HasData() ? Speed(frequency, data) : 0U;
+    }
+    /// \brief  nominal sample-point in [permille]
+    constexpr uint16_t NominalSamplePoint() const {
+        return SamplePoint(nominal);
+    }
+    /// \brief  data sample-point in [permille]
+    constexpr uint16_t DataSamplePoint() const {
+        return HasData() ? SamplePoint(data) : 0U;
+    }
+    /// \brief  the preset as CAN API V3 bit-rate settings
+    CANAPI_Bitrate_t Bitrate() const {
+        CANAPI_Bitrate_t bitrate;
+        bitrate.btr.frequency = frequency;
+        bitrate.btr.nominal.brp = nominal.brp;
+        bitrate.btr.nominal.tseg1 = nominal.tseg1;
+        bitrate.btr.nominal.tseg2 = nominal.tseg2;
+        bitrate.btr.nominal.sjw = nominal.sjw;
+        bitrate.btr.nominal.sam = 0U;
+        bitrate.btr.data.brp = data.brp;
+        bitrate.btr.data.tseg1 = data.tseg1;
+        bitrate.btr.data.tseg2 = data.tseg2;
+        bitrate.btr.data.sjw = data.sjw;
+        return bitrate;
+    }
+    //  (1) speed = freq / (brp * (1 + tseg1 + tseg2))
+    static constexpr uint32_t Speed(int32_t freq, STiming t) {
+        return (t.brp && (((uint32_t)freq % ((uint32_t)t.brp * (1U + t.tseg1 + t.tseg2))) == 0U))
+            ? ((uint32_t)freq / ((uint32_t)t.brp * (1U + t.tseg1 + t.tseg2))) : 0U;
+    }
+    //  (2) sp = (1 + tseg1) / (1 + tseg1 + tseg2)
+    static constexpr uint16_t SamplePoint(STiming t) {
+        return (uint16_t)((1000U * (1U + t.tseg1)) / (1U + t.tseg1 + t.tseg2));
+    }
+    static constexpr bool InRange(STiming t, uint32_t brpMin, uint32_t brpMax,
+                                             uint32_t tseg1Min, uint32_t tseg1Max,
+                                             uint32_t tseg2Min, uint32_t tseg2Max,
+                                             uint32_t sjwMin, uint32_t sjwMax) {
+        return (brpMin <= t.brp) && (t.brp <= brpMax) &&
+               (tseg1Min <= t.tseg1) && (t.tseg1 <= tseg1Max) &&
+               (tseg2Min <= t.tseg2) && (t.tseg2 <= tseg2Max) &&
+               (sjwMin <= t.sjw) && (t.sjw <= sjwMax) && (t.sjw <= t.tseg2);
+    }
+};
+
+#define PEAKCAN_PRESET(name,freq,nbrp,ntseg1,ntseg2,nsjw,dbrp,dtseg1,dtseg2,dsjw,nspeed,dspeed) \
+    constexpr SPeakCANPreset name = { freq, { nbrp, ntseg1, ntseg2, nsjw }, { dbrp, dtseg1, dtseg2, dsjw } }; \
+    static_assert(name.IsValid(), #name ": bit-timing settings out of range"); \
+    static_assert(name.NominalSpeed() == (nspeed), #name ": wrong nominal bit-rate"); \
+    static_assert(name.DataSpeed() == (dspeed), #name ": wrong data bit-rate")
+
+//  CAN 2.0 (SJA1000 @ 8MHz, same as the CiA bit-timing indexes)
+PEAKCAN_PRESET(PEAKCAN_PRESET_8MHz_1M,   CANBTR_FREQ_SJA1000,  1, 5, 2, 1,  0, 0, 0, 0, 1000000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_8MHz_800K, CANBTR_FREQ_SJA1000,  1, 7, 2, 1,  0, 0, 0, 0,  800000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_8MHz_500K, CANBTR_FREQ_SJA1000,  1, 13, 2, 1, 0, 0, 0, 0,  500000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_8MHz_250K, CANBTR_FREQ_SJA1000,  2, 13, 2, 1, 0, 0, 0, 0,  250000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_8MHz_125K, CANBTR_FREQ_SJA1000,  4, 13, 2, 1, 0, 0, 0, 0,  125000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_8MHz_100K, CANBTR_FREQ_SJA1000,  5, 13, 2, 2, 0, 0, 0, 0,  100000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_8MHz_50K,  CANBTR_FREQ_SJA1000, 10, 13, 2, 2, 0, 0, 0, 0,   50000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_8MHz_20K,  CANBTR_FREQ_SJA1000, 25, 13, 2, 2, 0, 0, 0, 0,   20000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_8MHz_10K,  CANBTR_FREQ_SJA1000, 50, 13, 2, 2, 0, 0, 0, 0,   10000U, 0U);
+
+//  CAN FD @ 20MHz (sample-point at 80%)
+PEAKCAN_PRESET(PEAKCAN_PRESET_20MHz_1M,      CANBTR_FREQ_20MHz, 1, 15, 4, 4,   0, 0, 0, 0, 1000000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_20MHz_500K,    CANBTR_FREQ_20MHz, 1, 31, 8, 8,   0, 0, 0, 0,  500000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_20MHz_250K,    CANBTR_FREQ_20MHz, 1, 63, 16, 16, 0, 0, 0, 0,  250000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_20MHz_125K,    CANBTR_FREQ_20MHz, 1, 127, 32, 32, 0, 0, 0, 0, 125000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_20MHz_1M_2M,   CANBTR_FREQ_20MHz, 1, 15, 4, 4,   1, 7, 2, 2, 1000000U, 2000000U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_20MHz_1M_4M,   CANBTR_FREQ_20MHz, 1, 15, 4, 4,   1, 3, 1, 1, 1000000U, 4000000U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_20MHz_500K_2M, CANBTR_FREQ_20MHz, 1, 31, 8, 8,   1, 7, 2, 2,  500000U, 2000000U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_20MHz_500K_4M, CANBTR_FREQ_20MHz, 1, 31, 8, 8,   1, 3, 1, 1,  500000U, 4000000U);
+
+//  CAN FD @ 24MHz (sample-point at 79.2%)
+PEAKCAN_PRESET(PEAKCAN_PRESET_24MHz_1M,      CANBTR_FREQ_24MHz, 1, 18, 5, 5,    0, 0, 0, 0, 1000000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_24MHz_500K,    CANBTR_FREQ_24MHz, 1, 37, 10, 10,  0, 0, 0, 0,  500000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_24MHz_250K,    CANBTR_FREQ_24MHz, 1, 76, 19, 19,  0, 0, 0, 0,  250000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_24MHz_125K,    CANBTR_FREQ_24MHz, 1, 153, 38, 38, 0, 0, 0, 0,  125000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_24MHz_1M_2M,   CANBTR_FREQ_24MHz, 1, 18, 5, 5,    1, 9, 2, 2, 1000000U, 2000000U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_24MHz_1M_4M,   CANBTR_FREQ_24MHz, 1, 18, 5, 5,    1, 4, 1, 1, 1000000U, 4000000U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_24MHz_500K_2M, CANBTR_FREQ_24MHz, 1, 37, 10, 10,  1, 9, 2, 2,  500000U, 2000000U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_24MHz_500K_4M, CANBTR_FREQ_24MHz, 1, 37, 10, 10,  1, 4, 1, 1,  500000U, 4000000U);
+
+//  CAN FD @ 40MHz (sample-point at 80%)
+PEAKCAN_PRESET(PEAKCAN_PRESET_40MHz_1M,      CANBTR_FREQ_40MHz, 1, 31, 8, 8,    0, 0, 0, 0, 1000000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_40MHz_500K,    CANBTR_FREQ_40MHz, 1, 63, 16, 16,  0, 0, 0, 0,  500000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_40MHz_250K,    CANBTR_FREQ_40MHz, 1, 127, 32, 32, 0, 0, 0, 0,  250000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_40MHz_125K,    CANBTR_FREQ_40MHz, 1, 255, 64, 64, 0, 0, 0, 0,  125000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_40MHz_1M_2M,   CANBTR_FREQ_40MHz, 1, 31, 8, 8,    1, 15, 4, 4, 1000000U, 2000000U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_40MHz_1M_4M,   CANBTR_FREQ_40MHz, 1, 31, 8, 8,    1, 7, 2, 2,  1000000U, 4000000U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_40MHz_1M_8M,   CANBTR_FREQ_40MHz, 1, 31, 8, 8,    1, 3, 1, 1,  1000000U, 8000000U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_40MHz_500K_2M, CANBTR_FREQ_40MHz, 1, 63, 16, 16,  1, 15, 4, 4,  500000U, 2000000U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_40MHz_500K_4M, CANBTR_FREQ_40MHz, 1, 63, 16, 16,  1, 7, 2, 2,   500000U, 4000000U);
+
+//  CAN FD @ 60MHz (sample-point at 80%)
+PEAKCAN_PRESET(PEAKCAN_PRESET_60MHz_1M,      CANBTR_FREQ_60MHz, 1, 47, 12, 12,  0, 0, 0, 0, 1000000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_60MHz_500K,    CANBTR_FREQ_60MHz, 1, 95, 24, 24,  0, 0, 0, 0,  500000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_60MHz_250K,    CANBTR_FREQ_60MHz, 1, 191, 48, 48, 0, 0, 0, 0,  250000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_60MHz_125K,    CANBTR_FREQ_60MHz, 2, 191, 48, 48, 0, 0, 0, 0,  125000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_60MHz_1M_2M,   CANBTR_FREQ_60MHz, 1, 47, 12, 12,  1, 23, 6, 6, 1000000U, 2000000U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_60MHz_1M_4M,   CANBTR_FREQ_60MHz, 1, 47, 12, 12,  1, 11, 3, 3, 1000000U, 4000000U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_60MHz_500K_2M, CANBTR_FREQ_60MHz, 1, 95, 24, 24,  1, 23, 6, 6,  500000U, 2000000U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_60MHz_500K_4M, CANBTR_FREQ_60MHz, 1, 95, 24, 24,  1, 11, 3, 3,  500000U, 4000000U);
+
+//  CAN FD @ 80MHz (sample-point at 80%)
+PEAKCAN_PRESET(PEAKCAN_PRESET_80MHz_1M,      CANBTR_FREQ_80MHz, 1, 63, 16, 16,  0, 0, 0, 0, 1000000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_80MHz_500K,    CANBTR_FREQ_80MHz, 1, 127, 32, 32, 0, 0, 0, 0,  500000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_80MHz_250K,    CANBTR_FREQ_80MHz, 1, 255, 64, 64, 0, 0, 0, 0,  250000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_80MHz_125K,    CANBTR_FREQ_80MHz, 2, 255, 64, 64, 0, 0, 0, 0,  125000U, 0U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_80MHz_1M_2M,   CANBTR_FREQ_80MHz, 1, 63, 16, 16,  1, 31, 8, 8, 1000000U, 2000000U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_80MHz_1M_4M,   CANBTR_FREQ_80MHz, 1, 63, 16, 16,  1, 15, 4, 4, 1000000U, 4000000U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_80MHz_1M_8M,   CANBTR_FREQ_80MHz, 1, 63, 16, 16,  1, 7, 2, 2,  1000000U, 8000000U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_80MHz_500K_2M, CANBTR_FREQ_80MHz, 1, 127, 32, 32, 1, 31, 8, 8,  500000U, 2000000U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_80MHz_500K_4M, CANBTR_FREQ_80MHz, 1, 127, 32, 32, 1, 15, 4, 4,  500000U, 4000000U);
+PEAKCAN_PRESET(PEAKCAN_PRESET_80MHz_500K_8M, CANBTR_FREQ_80MHz, 1, 127, 32, 32, 1, 7, 2, 2,   500000U, 8000000U);
+/// \}
+
+#endif // PEAKCAN_PRESETS_H_INCLUDED
@@ -0,0 +1,259 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (for PEAK PCAN Interfaces)
+//
+//  Copyright (c) 2017-2021 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of PCANBasic-Wrapper.
+//
+//  PCANBasic-Wrapper is dual-licensed under the BSD 2-Clause "Simplified" License
+//  and under the GNU General Public License v3.0 (or any later version). You can
+//  choose between one of them if you use PCANBasic-Wrapper in whole or in part.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  PCANBasic-Wrapper IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF PCANBasic-Wrapper, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  PCANBasic-Wrapper is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  PCANBasic-Wrapper is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+#ifndef PEAKCAN_PRIORITY_H_INCLUDED
+#define PEAKCAN_PRIORITY_H_INCLUDED
+
+#include "PeakCAN.h"
+#include "PeakCAN_BusLoad.h"
+
+#include <vector>
+#include <map>
+#include <deque>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+
+/// \name   PeakCAN Priority Queue
+/// \brief  Software transmit queue ordered by CAN arbitration priority.
+/// \note   Messages are not handed to the driver in call order but by the
+///         arbitration field, as on the bus: the lower identifier wins, a
+///         data frame wins over a remote frame, and a standard frame wins
+///         over an extended frame with the same base identifier (SRR/IDE).
+///         Messages with the same arbitration field are sent in order.
+/// \note   Once written, a message cannot be overtaken in the driver's
+///         transmit queue. Therefore the transmit thread hands at most
+///         'inflight' messages to the driver that are not yet on the bus:
+///         the end of transmission of each message is estimated from its
+///         length and the bit-rate (see CPeakCANBusLoad), and the next
+///         message is written when the oldest one is done. So a message of
+///         higher priority waits for at most 'inflight' messages, plus the
+///         time they lose in arbitration against other nodes (not known
+///         to the estimate). With 'inflight' = 0 the driver's queue is
+///         filled until it reports 'transmitter busy' (no such bound).
+/// \{
+#define PEAKCAN_PRIORITY_QUEUE  4096U  ///< default capacity of the queue
+#define PEAKCAN_PRIORITY_INFLIGHT  2U  ///< default number of messages written and not yet on the bus
+#define PEAKCAN_PRIORITY_RETRY  100U  ///< back-off in [us] when the transmitter is busy
+
+class CPeakCANPriorityQueue {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    /// \brief  queueing latency of one arbitration field (times in [us])
+    struct SLatency {
+        uint64_t u64Frames;  ///< number of messages written
+        uint64_t u64DelayTotal;  ///< sum of queueing delays (enqueue to write)
+        uint64_t u64DelayMax;  ///< maximum queueing delay
+    };
+private:
+    struct SEntry {
+        uint32_t key;  ///< arbitration field (lower value = higher priority)
+        uint64_t sequence;  ///< enqueue order (for equal keys)
+        CANAPI_Message_t message;  ///< message to be sent
+        Clock::time_point queued;  ///< time of enqueue
+    };
+    struct SLower {  // heap order: lowest key first, then oldest first
+        bool operator()(const SEntry &a, const SEntry &b) const {
+            return (a.key != b.key) ? (a.key > b.key) : (a.sequence > b.sequence);
+        }
+    };
+    CPeakCAN &m_Channel;  ///< CAN channel (started by the application)
+    size_t m_Capacity;  ///< maximum number of queued messages
+    size_t m_InFlight;  ///< maximum number of messages in the driver (0 = no limit)
+    std::deque<Clock::time_point> m_Finish;  ///< estimated end of transmission of the messages in the driver
+    CANAPI_BusSpeed_t m_Speed;  ///< bus speed (for the estimate)
+    std::vector<SEntry> m_Heap;  ///< pending messages (binary heap)
+    uint64_t m_Sequence;  ///< next sequence number
+    std::map<uint32_t, SLatency> m_Latency;  ///< latency per arbitration field
+    std::thread m_Thread;  ///< transmit thread
+    std::atomic<bool> m_Running;  ///< flag: queue running
+    std::mutex m_Mutex;  ///< protects heap and latency
+    std::condition_variable m_Wakeup;  ///< wakes up the transmit thread
+public:
+    /// \brief  priority queue for 'channel' with room for 'capacity' messages,
+    ///         of which at most 'inflight' are handed to the driver at a time
+    CPeakCANPriorityQueue(CPeakCAN &channel, size_t capacity = PEAKCAN_PRIORITY_QUEUE,
+                          size_t inflight = PEAKCAN_PRIORITY_INFLIGHT)
+        : m_Channel(channel), m_Capacity(capacity), m_InFlight(inflight), m_Speed(), m_Sequence(0U), m_Running(false) {
+        m_Heap.reserve(capacity);
+    }
+    ~CPeakCANPriorityQueue() { (void)Stop(); }
+
+    /// \brief  arbitration field of a message (lower value = higher priority)
+    /// \note   standard: ID[10:0] RTR IDE=0; extended: ID[28:18] SRR=1 IDE=1 ID[17:0] RTR
+    static uint32_t ArbitrationKey(const CANAPI_Message_t &message) {
+        uint32_t rtr = message.rtr ? 1U : 0U;
+        if (!message.xtd)
+            return ((message.id & CAN_MAX_STD_ID) << 21) | (rtr << 20);
+        return (((message.id >> 18) & CAN_MAX_STD_ID) << 21) | (1U << 20) | (1U << 19)
+             | ((message.id & 0x3FFFFU) << 1) | rtr;
+    }
+    /// \brief  queues a message for transmission
+    /// \returns CANERR_TX_BUSY when the queue is full
+    CANAPI_Return_t WriteMessage(const CANAPI_Message_t &message) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Heap.size() >= m_Capacity)
+            return CANERR_TX_BUSY;
+        SEntry entry;
+        entry.key = ArbitrationKey(message);
+        entry.sequence = m_Sequence++;
+        entry.message = message;
+        entry.queued = Clock::now();
+        m_Heap.push_back(entry);
+        std::push_heap(m_Heap.begin(), m_Heap.end(), SLower());
+        m_Wakeup.notify_one();
+        return CANERR_NOERROR;
+    }
+    /// \brief  number of messages waiting in the queue
+    size_t GetPending() {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Heap.size();
+    }
+    /// \brief  retrieves the queueing latency of the given identifier
+    CANAPI_Return_t GetLatency(uint32_t id, bool xtd, bool rtr, SLatency &latency) {
+        CANAPI_Message_t message = {};
+        message.id = id; message.xtd = xtd ? 1 : 0; message.rtr = rtr ? 1 : 0;
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        std::map<uint32_t, SLatency>::const_iterator it = m_Latency.find(ArbitrationKey(message));
+        if (it == m_Latency.end())
+            return CANERR_ILLPARA;
+        latency = it->second;
+        return CANERR_NOERROR;
+    }
+    /// \brief  retrieves the queueing latency of all arbitration fields (by priority)
+    std::map<uint32_t, SLatency> GetLatency() {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Latency;
+    }
+    /// \brief  starts the transmit thread (the channel must be started)
+    CANAPI_Return_t Start() {
+        if (m_Running)
+            return CANERR_ONLINE;
+        CANAPI_Return_t rc = m_Channel.GetBusSpeed(m_Speed);
+        if (CANERR_NOERROR != rc)
+            return rc;
+        m_Finish.clear();
+        m_Running = true;
+        m_Thread = std::thread(&CPeakCANPriorityQueue::Run, this);
+        return CANERR_NOERROR;
+    }
+    /// \brief  stops the transmit thread (pending messages remain queued)
+    CANAPI_Return_t Stop() {
+        if (!m_Running)
+            return CANERR_OFFLINE;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Running = false;
+        }
+        m_Wakeup.notify_all();
+        if (m_Thread.joinable())
+            m_Thread.join();
+        return CANERR_NOERROR;
+    }
+    /// \brief  discards all pending messages
+    void Clear() {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Heap.clear();
+    }
+private:
+    void Run() {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        while (m_Running) {
+            if (m_Heap.empty()) {
+                m_Wakeup.wait(lock);
+                continue;
+            }
+            // wait until there is room in the driver (by the estimate)
+            Clock::time_point now = Clock::now();
+            while (!m_Finish.empty() && (m_Finish.front() <= now))
+                m_Finish.pop_front();
+            if (m_InFlight && (m_Finish.size() >= m_InFlight)) {
+                m_Wakeup.wait_until(lock, m_Finish.front());
+                continue;
+            }
+            // note: the message stays in the queue until the driver took it,
+            //       so a message of higher priority queued meanwhile overtakes
+            SEntry entry = m_Heap.front();
+            lock.unlock();
+            CANAPI_Return_t rc = m_Channel.WriteMessage(entry.message, 0U);
+            Clock::time_point written = Clock::now();
+            lock.lock();
+            if (CANERR_TX_BUSY == rc) {
+                m_Wakeup.wait_for(lock, std::chrono::microseconds(PEAKCAN_PRIORITY_RETRY));
+                continue;
+            }
+            if ((CANERR_NOERROR == rc) && m_InFlight) {
+                // sent after the messages ahead of it in the driver
+                Clock::time_point start = m_Finish.empty() ? written : std::max(written, m_Finish.back());
+                m_Finish.push_back(start + std::chrono::nanoseconds(CPeakCANBusLoad::Nanoseconds(entry.message, m_Speed)));
+            }
+            // remove the entry just written (a message queued meanwhile may be on top)
+            if (!m_Heap.empty() && (m_Heap.front().sequence == entry.sequence)) {
+                std::pop_heap(m_Heap.begin(), m_Heap.end(), SLower());
+                m_Heap.pop_back();
+            } else {
+                std::vector<SEntry>::iterator it = std::find_if(m_Heap.begin(), m_Heap.end(),
+                    [&entry](const SEntry &e) { return e.sequence == entry.sequence; });
+                if (it != m_Heap.end()) {
+                    m_Heap.erase(it);
+                    std::make_heap(m_Heap.begin(), m_Heap.end(), SLower());
+                }
+            }
+            if (CANERR_NOERROR == rc) {
+                uint64_t delay = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(written - entry.queued).count();
+                SLatency &latency = m_Latency[entry.key];
+                latency.u64Frames++;
+                latency.u64DelayTotal += delay;
+                if (delay > latency.u64DelayMax)
+                    latency.u64DelayMax = delay;
+            }
+            // note: on any other error the message is dropped (e.g. bus off)
+        }
+    }
+};
+/// \}
+#endif // PEAKCAN_PRIORITY_H_INCLUDED
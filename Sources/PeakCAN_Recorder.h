@@ -0,0 +1,774 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (for PEAK PCAN Interfaces)
+//
+//  Copyright (c) 2017-2021 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of PCANBasic-Wrapper.
+//
+//  PCANBasic-Wrapper is dual-licensed under the BSD 2-Clause "Simplified" License
+//  and under the GNU General Public License v3.0 (or any later version). You can
+//  choose between one of them if you use PCANBasic-Wrapper in whole or in part.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  PCANBasic-Wrapper IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF PCANBasic-Wrapper, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  PCANBasic-Wrapper is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  PCANBasic-Wrapper is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+#ifndef PEAKCAN_RECORDER_H_INCLUDED
+#define PEAKCAN_RECORDER_H_INCLUDED
+
+#include "PeakCAN.h"
+#include "PeakCAN_Index.h"
+
+#include <functional>
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/// \name   PeakCAN Recorder
+/// \brief  Black-box recorder: a circular capture file of fixed size that
+///         keeps the most recent traffic of a CAN channel.
+/// \note   The capture file is memory-mapped; a record is written by one
+///         copy into the mapping (no system call per frame). The operating
+///         system keeps the file contents when the process crashes. Every
+///         record carries its sequence number, which is written last, so
+///         a torn record is recognized when the file is re-opened.
+/// \note   Triggers (identifier and data pattern, bus off, error frame, or
+///         Trigger() e.g. from a signal handler) cut a snapshot out of the
+///         ring: the records from 'pre' milliseconds before the trigger to
+///         'post' milliseconds after it. Snapshots are written by a
+///         background thread to standalone capture files in the same
+///         format ("<file>.<number>"). Triggers during the post-trigger
+///         window of a snapshot are merged into that snapshot.
+/// \note   Every snapshot comes with a side index ("<file>.<number>.idx",
+///         see PeakCAN_Index.h); CPeakCANCapture uses it to seek by time
+///         and identifier. The index of a circular capture file is built
+///         on demand (BuildIndex).
+/// \{
+#define PEAKCAN_RECORDER_MAGIC  0x43524350U  ///< "PCRC"
+#define PEAKCAN_RECORDER_VERSION  1U  ///< layout version of the capture file
+#define PEAKCAN_RECORDER_RECORDS  262144U  ///< default number of records
+#if (SIZE_MAX > 0xFFFFFFFFU)
+#define PEAKCAN_RECORDER_MAX_RECORDS  1073741824U  ///< maximum number of records (2^30)
+#else
+#define PEAKCAN_RECORDER_MAX_RECORDS  8388608U  ///< maximum number of records (2^23, 32-bit address space)
+#endif
+#define PEAKCAN_RECORDER_PRE  60000U  ///< default pre-trigger window in [ms]
+#define PEAKCAN_RECORDER_POST  10000U  ///< default post-trigger window in [ms]
+#define PEAKCAN_RECORDER_TIMEOUT  10U  ///< read time-out in [ms] (trigger latency)
+
+class CPeakCANRecorder {
+public:
+    /// \brief  record type
+    enum ERecord {
+        RecordMessage = 0,  ///< CAN message
+        RecordEvent  ///< CAN event (bus state, error frame, overrun)
+    };
+    /// \brief  trigger type
+    enum ETrigger {
+        TriggerMessage = 0,  ///< identifier and data pattern
+        TriggerBusOff,  ///< bus off
+        TriggerErrorFrame,  ///< error frame
+        TriggerSignal  ///< Trigger() has been called
+    };
+    /// \brief  header of a capture file (64 bytes)
+    struct SHeader {
+        uint32_t u32Magic;  ///< PEAKCAN_RECORDER_MAGIC
+        uint16_t u16Version;  ///< PEAKCAN_RECORDER_VERSION
+        uint16_t u16RecordSize;  ///< size of a record in bytes
+        uint64_t u64Capacity;  ///< number of records in the file
+        uint64_t u64Head;  ///< sequence number of the next record
+        uint32_t u32Snapshots;  ///< number of snapshots taken from the file
+        uint32_t u32Reserved;
+        uint64_t u64Reserved[4];
+    };
+    /// \brief  record of a capture file
+    struct SRecord {
+        uint64_t u64Sequence;  ///< sequence number + 1 (0 = empty or torn)
+        uint8_t u8Type;  ///< record type (ERecord)
+        uint8_t u8Reserved[7];
+        union {
+            CANAPI_Message_t message;  ///< CAN message (RecordMessage)
+            CANAPI_Event_t event;  ///< CAN event (RecordEvent)
+        };
+    };
+    /// \brief  trigger condition
+    struct STrigger {
+        ETrigger eType;  ///< trigger type
+        uint32_t u32Id;  ///< CAN identifier (TriggerMessage)
+        bool fXtd;  ///< 29-bit identifier (TriggerMessage)
+        uint8_t u8Length;  ///< number of data bytes to compare (0..8)
+        uint8_t u8Data[8];  ///< data pattern
+        uint8_t u8Mask[8];  ///< relevant bits of the data pattern
+    };
+    /// \brief  written snapshot
+    struct SSnapshot {
+        uint32_t u32Number;  ///< number of the snapshot
+        ETrigger eReason;  ///< first trigger of the snapshot
+        std::string strFile;  ///< name of the snapshot file
+        uint64_t u64Records;  ///< number of records written
+        uint64_t u64Lost;  ///< records overwritten before they were extracted
+        bool fSaved;  ///< flag: file written successfully
+    };
+    /// \brief  statistics of the recorder
+    struct SStatistics {
+        uint64_t u64Records;  ///< records written into the ring
+        uint64_t u64Triggers;  ///< triggers fired (including merged ones)
+        uint64_t u64Snapshots;  ///< snapshots written
+        uint64_t u64Lost;  ///< records overwritten before they were extracted
+    };
+    typedef std::function<void(const SSnapshot &snapshot)> Handler;
+private:
+    typedef std::chrono::steady_clock Clock;
+    static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "atomic view on the mapped file");
+
+    /// \brief  atomic view on a field of the mapped file (written by the recorder thread)
+    static std::atomic<uint64_t> &Atomic(uint64_t &field) { return *reinterpret_cast<std::atomic<uint64_t>*>(&field); }
+    static const std::atomic<uint64_t> &Atomic(const uint64_t &field) { return *reinterpret_cast<const std::atomic<uint64_t>*>(&field); }
+
+    struct SJob {  // snapshot to be extracted
+        uint32_t number;
+        ETrigger reason;
+        uint64_t first, last;  ///< sequence numbers [first, last)
+    };
+    CPeakCAN &m_Channel;  ///< CAN channel (started by the application)
+    std::string m_strPath;  ///< name of the capture file
+    SHeader *m_pHeader;  ///< mapped capture file
+    SRecord *m_pRecords;  ///< records of the capture file
+    uint64_t m_Capacity;  ///< number of records
+    size_t m_Size;  ///< size of the mapping
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE m_hFile;  ///< capture file
+    HANDLE m_hMapping;  ///< file mapping object
+#endif
+    std::vector<STrigger> m_Triggers;  ///< trigger conditions
+    uint32_t m_Pre;  ///< pre-trigger window in [ms]
+    uint32_t m_Post;  ///< post-trigger window in [ms]
+    Handler m_Handler;  ///< called after a snapshot has been written
+    bool m_Active;  ///< snapshot in its post-trigger window (recorder thread)
+    SJob m_Current;  ///< snapshot in its post-trigger window (recorder thread)
+    Clock::time_point m_Deadline;  ///< end of the post-trigger window
+    bool m_BusOff;  ///< last bus-off state (recorder thread)
+    std::atomic<bool> m_Signaled;  ///< flag: Trigger() has been called
+    std::deque<SJob> m_Jobs;  ///< snapshots to be extracted
+    std::thread m_Recorder;  ///< recorder thread
+    std::thread m_Extractor;  ///< extraction thread
+    std::atomic<bool> m_Running;  ///< flag: recorder running
+    bool m_Done;  ///< flag: recorder thread finished (no more jobs)
+    std::mutex m_Mutex;  ///< protects the jobs and the statistics
+    std::condition_variable m_Cond;  ///< signals new jobs
+    SStatistics m_Statistics;  ///< statistics
+public:
+    CPeakCANRecorder(CPeakCAN &channel)
+        : m_Channel(channel), m_pHeader(NULL), m_pRecords(NULL), m_Capacity(0U), m_Size(0U),
+          m_Pre(PEAKCAN_RECORDER_PRE), m_Post(PEAKCAN_RECORDER_POST), m_Active(false), m_BusOff(false),
+          m_Signaled(false), m_Running(false), m_Done(false) {
+#if defined(_WIN32) || defined(_WIN64)
+        m_hFile = INVALID_HANDLE_VALUE;
+        m_hMapping = NULL;
+#endif
+        memset(&m_Current, 0, sizeof(m_Current));
+        memset(&m_Statistics, 0, sizeof(m_Statistics));
+    }
+    ~CPeakCANRecorder() {
+        (void)Stop();
+        (void)Close();
+    }
+    /// \brief  creates the capture file with 'records' records, or resumes an existing one of the same size
+    CANAPI_Return_t Open(const char *path, uint64_t records = PEAKCAN_RECORDER_RECORDS) {
+        if (m_pHeader)
+            return CANERR_YETINIT;
+        if (!path)
+            return CANERR_NULLPTR;
+        if (!records || (records > PEAKCAN_RECORDER_MAX_RECORDS))
+            return CANERR_ILLPARA;
+        size_t size = sizeof(SHeader) + (size_t)records * sizeof(SRecord);
+#if defined(_WIN32) || defined(_WIN64)
+        m_hFile = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                              OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (m_hFile == INVALID_HANDLE_VALUE)
+            return CANERR_RESOURCE;
+        LARGE_INTEGER length;
+        bool fresh = !GetFileSizeEx(m_hFile, &length) || ((uint64_t)length.QuadPart != (uint64_t)size);
+        length.QuadPart = 0;  // as on POSIX: truncated, then extended by the mapping (zero-filled)
+        if (!fresh || (SetFilePointerEx(m_hFile, length, NULL, FILE_BEGIN) && SetEndOfFile(m_hFile)))
+            m_hMapping = CreateFileMappingA(m_hFile, NULL, PAGE_READWRITE,
+                                            (DWORD)((uint64_t)size >> 32), (DWORD)size, NULL);
+        if (m_hMapping)
+            m_pHeader = (SHeader*)MapViewOfFile(m_hMapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+#else
+        int fd = open(path, O_RDWR | O_CREAT, 0644);
+        if (fd < 0)
+            return CANERR_RESOURCE;
+        struct stat info;
+        bool fresh = (fstat(fd, &info) != 0) || ((uint64_t)info.st_size != (uint64_t)size);
+        void *view = MAP_FAILED;
+        if (!fresh || (ftruncate(fd, 0) == 0 && ftruncate(fd, (off_t)size) == 0))
+            view = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        (void)close(fd);
+        m_pHeader = (view != MAP_FAILED) ? (SHeader*)view : NULL;
+#endif
+        m_Size = size;
+        if (!m_pHeader) {
+            (void)Close();
+            return CANERR_RESOURCE;
+        }
+        m_pRecords = (SRecord*)(m_pHeader + 1);
+        m_Capacity = records;
+        if (fresh || !Valid(m_pHeader, records))
+            Format(m_pHeader, records);
+        else
+            Recover();
+        m_strPath = path;
+        return CANERR_NOERROR;
+    }
+    /// \brief  unmaps the capture file
+    CANAPI_Return_t Close() {
+        if (m_Running)
+            return CANERR_ONLINE;
+        if (!m_pHeader
+#if defined(_WIN32) || defined(_WIN64)
+            && (m_hFile == INVALID_HANDLE_VALUE)
+#endif
+           )
+            return CANERR_NOTINIT;
+#if defined(_WIN32) || defined(_WIN64)
+        if (m_pHeader) {
+            (void)FlushViewOfFile(m_pHeader, 0);
+            (void)UnmapViewOfFile(m_pHeader);
+        }
+        if (m_hMapping)
+            (void)CloseHandle(m_hMapping);
+        if (m_hFile != INVALID_HANDLE_VALUE)
+            (void)CloseHandle(m_hFile);
+        m_hMapping = NULL;
+        m_hFile = INVALID_HANDLE_VALUE;
+#else
+        if (m_pHeader) {
+            (void)msync(m_pHeader, m_Size, MS_ASYNC);
+            (void)munmap(m_pHeader, m_Size);
+        }
+#endif
+        m_pHeader = NULL;
+        m_pRecords = NULL;
+        m_Capacity = 0U;
+        return CANERR_NOERROR;
+    }
+    /// \brief  adds a trigger condition; returns its index (>= 0), or a negative error code
+    int AddTrigger(const STrigger &trigger) {
+        if (m_Running)
+            return CANERR_ONLINE;
+        if ((trigger.eType == TriggerMessage) &&
+            ((trigger.u8Length > 8U) || (trigger.u32Id > (trigger.fXtd ? CAN_MAX_XTD_ID : CAN_MAX_STD_ID))))
+            return CANERR_ILLPARA;
+        m_Triggers.push_back(trigger);
+        return (int)(m_Triggers.size() - 1U);
+    }
+    /// \brief  sets the pre- and post-trigger windows in [ms]
+    CANAPI_Return_t SetWindow(uint32_t pre, uint32_t post) {
+        if (m_Running)
+            return CANERR_ONLINE;
+        m_Pre = pre;
+        m_Post = post;
+        return CANERR_NOERROR;
+    }
+    /// \brief  sets a function that is called (in the extraction thread) for every snapshot
+    CANAPI_Return_t SetHandler(Handler handler) {
+        if (m_Running)
+            return CANERR_ONLINE;
+        m_Handler = handler;
+        return CANERR_NOERROR;
+    }
+    /// \brief  starts the recorder thread and the extraction thread
+    CANAPI_Return_t Start() {
+        if (!m_pHeader)
+            return CANERR_NOTINIT;
+        if (m_Running)
+            return CANERR_ONLINE;
+        m_Active = m_BusOff = false;
+        m_Signaled = false;
+        m_Done = false;
+        m_Running = true;
+        m_Extractor = std::thread(&CPeakCANRecorder::Extract, this);
+        m_Recorder = std::thread(&CPeakCANRecorder::Record, this);
+        return CANERR_NOERROR;
+    }
+    /// \brief  stops recording; an open post-trigger window is closed and all snapshots are written
+    CANAPI_Return_t Stop() {
+        if (!m_Running)
+            return CANERR_OFFLINE;
+        m_Running = false;
+        (void)m_Channel.SignalChannel();  // wake up the blocking read
+        if (m_Recorder.joinable())
+            m_Recorder.join();
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Done = true;
+            m_Cond.notify_all();
+        }
+        if (m_Extractor.joinable())
+            m_Extractor.join();
+        return CANERR_NOERROR;
+    }
+    /// \brief  fires the trigger 'TriggerSignal' (async-signal-safe)
+    void Trigger() { m_Signaled.store(true); }
+
+    /// \brief  retrieves the statistics of the recorder (records: since the capture file was created)
+    void GetStatistics(SStatistics &statistics) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        statistics = m_Statistics;
+        statistics.u64Records = m_pHeader ? Atomic(m_pHeader->u64Head).load(std::memory_order_relaxed) : 0U;
+    }
+    /// \brief  time-stamp of a record in [ns]
+    static uint64_t Nanoseconds(const SRecord &record) {
+        const can_timestamp_t &ts = (record.u8Type == RecordEvent) ? record.event.timestamp : record.message.timestamp;
+        return (uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec;
+    }
+    /// \brief  index key of a record (PEAKCAN_INDEX_NOKEY for events and status messages)
+    static uint32_t Key(const SRecord &record) {
+        if ((record.u8Type != RecordMessage) || record.message.sts)
+            return PEAKCAN_INDEX_NOKEY;
+        return CPeakCANIndex::Key(record.message.id, record.message.xtd ? true : false);
+    }
+    /// \brief  builds the side index "<path>.idx" of a capture file (circular or snapshot)
+    static CANAPI_Return_t BuildIndex(const char *path, uint32_t block = PEAKCAN_INDEX_BLOCK) {
+        CPeakCANMappedFile file;
+        CANAPI_Return_t rc = file.Open(path);
+        if (rc != CANERR_NOERROR)
+            return rc;
+        const SHeader *header = (const SHeader*)file.Data();
+        if ((file.Size() < sizeof(SHeader)) || !Valid(header, header->u64Capacity) ||
+            (file.Size() < sizeof(SHeader) + header->u64Capacity * sizeof(SRecord)))
+            return CANERR_ILLPARA;
+        const SRecord *ring = (const SRecord*)(header + 1);
+        uint64_t head = header->u64Head;
+        uint64_t first = (head > header->u64Capacity) ? head - header->u64Capacity : 0U;
+        CPeakCANIndexWriter index(first, block);
+        uint64_t time = 0U;
+        for (uint64_t sequence = first; sequence < head; sequence++) {
+            const SRecord &record = ring[sequence % header->u64Capacity];
+            if (record.u64Sequence == (sequence + 1U)) {
+                time = Nanoseconds(record);
+                index.Add(time, Key(record));
+            }
+            else
+                index.Add(time, PEAKCAN_INDEX_NOKEY);  // torn record
+        }
+        return index.Write((std::string(path) + ".idx").c_str(), header->u64Capacity, head);
+    }
+    /// \brief  reads a capture file (circular or snapshot) in order of the records
+    /// \note   Torn or overwritten records are skipped.
+    static CANAPI_Return_t Load(const char *path, std::vector<SRecord> &records) {
+        if (!path)
+            return CANERR_NULLPTR;
+        FILE *file = fopen(path, "rb");
+        if (!file)
+            return CANERR_RESOURCE;
+        SHeader header;
+        CANAPI_Return_t rc = CANERR_NOERROR;
+        if ((fread(&header, sizeof(SHeader), 1U, file) != 1U) || !Valid(&header, header.u64Capacity))
+            rc = CANERR_ILLPARA;
+        std::vector<SRecord> ring;
+        if (rc == CANERR_NOERROR) {
+            ring.resize((size_t)header.u64Capacity);
+            if (fread(&ring[0], sizeof(SRecord), ring.size(), file) != ring.size())
+                rc = CANERR_ILLPARA;
+        }
+        fclose(file);
+        if (rc != CANERR_NOERROR)
+            return rc;
+        uint64_t head = header.u64Head;
+        uint64_t first = (head > header.u64Capacity) ? head - header.u64Capacity : 0U;
+        records.clear();
+        records.reserve((size_t)(head - first));
+        for (uint64_t sequence = first; sequence < head; sequence++) {
+            const SRecord &record = ring[(size_t)(sequence % header.u64Capacity)];
+            if (record.u64Sequence == (sequence + 1U))
+                records.push_back(record);
+        }
+        return CANERR_NOERROR;
+    }
+private:
+    static bool Valid(const SHeader *header, uint64_t records) {
+        return (header->u32Magic == PEAKCAN_RECORDER_MAGIC) &&
+               (header->u16Version == PEAKCAN_RECORDER_VERSION) &&
+               (header->u16RecordSize == (uint16_t)sizeof(SRecord)) &&
+               (header->u64Capacity == records) && records;
+    }
+    static void Format(SHeader *header, uint64_t records) {
+        memset(header, 0, sizeof(SHeader) + (size_t)records * sizeof(SRecord));
+        header->u16Version = PEAKCAN_RECORDER_VERSION;
+        header->u16RecordSize = (uint16_t)sizeof(SRecord);
+        header->u64Capacity = records;
+        std::atomic_thread_fence(std::memory_order_release);
+        header->u32Magic = PEAKCAN_RECORDER_MAGIC;
+    }
+    /// \brief  the head is rebuilt from the records (the last record may be torn)
+    void Recover() {
+        uint64_t head = 0U;
+        for (uint64_t i = 0U; i < m_Capacity; i++) {
+            uint64_t sequence = m_pRecords[i].u64Sequence;
+            if ((sequence > head) && (((sequence - 1U) % m_Capacity) == i))
+                head = sequence;
+        }
+        m_pHeader->u64Head = head;
+    }
+    void Append(ERecord type, const void *data, size_t size) {
+        uint64_t sequence = Atomic(m_pHeader->u64Head).load(std::memory_order_relaxed);
+        SRecord &record = m_pRecords[sequence % m_Capacity];
+        Atomic(record.u64Sequence).store(0U, std::memory_order_relaxed);  // torn until completed
+        std::atomic_thread_fence(std::memory_order_release);
+        record.u8Type = (uint8_t)type;
+        memcpy(&record.message, data, size);
+        Atomic(record.u64Sequence).store(sequence + 1U, std::memory_order_release);
+        Atomic(m_pHeader->u64Head).store(sequence + 1U, std::memory_order_release);
+    }
+    bool Matches(const STrigger &trigger, const CANAPI_Message_t &message) const {
+        if ((trigger.eType != TriggerMessage) || (message.id != trigger.u32Id) || (!!message.xtd != trigger.fXtd))
+            return false;
+        if (CCANAPI::Dlc2Len(message.dlc) < trigger.u8Length)
+            return false;
+        for (uint8_t i = 0U; i < trigger.u8Length; i++)
+            if ((message.data[i] & trigger.u8Mask[i]) != (trigger.u8Data[i] & trigger.u8Mask[i]))
+                return false;
+        return true;
+    }
+    bool Fires(ETrigger type) const {
+        for (size_t i = 0U; i < m_Triggers.size(); i++)
+            if (m_Triggers[i].eType == type)
+                return true;
+        return false;
+    }
+    /// \brief  first sequence number of the pre-trigger window of the trigger at 'head' - 1
+    uint64_t Begin(uint64_t head) const {
+        uint64_t first = (head > m_Capacity) ? head - m_Capacity : 0U;
+        if (head == first)
+            return head;
+        uint64_t now = Nanoseconds(m_pRecords[(head - 1U) % m_Capacity]);
+        uint64_t limit = (now > (uint64_t)m_Pre * 1000000U) ? now - (uint64_t)m_Pre * 1000000U : 0U;
+        uint64_t lo = first, hi = head - 1U;  // binary search (time-stamps are ascending)
+        while (lo < hi) {
+            uint64_t mid = lo + (hi - lo) / 2U;
+            if (Nanoseconds(m_pRecords[mid % m_Capacity]) < limit)
+                lo = mid + 1U;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+    void Fire(ETrigger reason) {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Statistics.u64Triggers++;
+        }
+        if (m_Active)
+            return;  // merged into the current snapshot
+        uint64_t head = Atomic(m_pHeader->u64Head).load(std::memory_order_relaxed);
+        m_Current.number = ++m_pHeader->u32Snapshots;
+        m_Current.reason = reason;
+        m_Current.first = Begin(head);
+        m_Current.last = head;
+        m_Deadline = Clock::now() + std::chrono::milliseconds(m_Post);
+        m_Active = true;
+    }
+    void Finish(uint64_t head) {
+        m_Current.last = head;
+        m_Active = false;
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Jobs.push_back(m_Current);
+        m_Cond.notify_one();
+    }
+    void Record() {
+        CANAPI_Message_t message;
+        CANAPI_Event_t events[16];
+        while (m_Running) {
+            CANAPI_Return_t rc = m_Channel.ReadMessage(message, PEAKCAN_RECORDER_TIMEOUT);
+            // status changes and error frames are reported as events; they are queued
+            // by the read, so they are appended before the message (in time order)
+            int n;
+            while ((n = m_Channel.ReadEvents(events, 16U)) > 0) {
+                for (int i = 0; i < n; i++) {
+                    Append(RecordEvent, &events[i], sizeof(CANAPI_Event_t));
+                    CANAPI_Status_t status;
+                    status.byte = events[i].status;
+                    if ((events[i].type == CANEVT_ERR_FRAME) && Fires(TriggerErrorFrame))
+                        Fire(TriggerErrorFrame);
+                    if (status.bus_off && !m_BusOff && Fires(TriggerBusOff))
+                        Fire(TriggerBusOff);
+                    m_BusOff = status.bus_off;
+                }
+            }
+            if (rc == CANERR_NOERROR) {
+                Append(RecordMessage, &message, sizeof(CANAPI_Message_t));
+                for (size_t i = 0U; i < m_Triggers.size(); i++) {
+                    if (Matches(m_Triggers[i], message)) {
+                        Fire(TriggerMessage);
+                        break;
+                    }
+                }
+            }
+            if (m_Signaled.exchange(false))
+                Fire(TriggerSignal);
+            if (m_Active && (Clock::now() >= m_Deadline))
+                Finish(Atomic(m_pHeader->u64Head).load(std::memory_order_relaxed));
+        }
+        if (m_Active)
+            Finish(Atomic(m_pHeader->u64Head).load(std::memory_order_relaxed));
+    }
+    void Extract() {
+        for (;;) {
+            SJob job;
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_Cond.wait(lock, [this] { return !m_Jobs.empty() || m_Done; });
+                if (m_Jobs.empty())
+                    return;
+                job = m_Jobs.front();
+                m_Jobs.pop_front();
+            }
+            SSnapshot snapshot;
+            snapshot.u32Number = job.number;
+            snapshot.eReason = job.reason;
+            snapshot.u64Records = snapshot.u64Lost = 0U;
+            char suffix[16];
+            (void)snprintf(suffix, sizeof(suffix), ".%03u", (unsigned)job.number);
+            snapshot.strFile = m_strPath + suffix;
+            snapshot.fSaved = Save(job, snapshot);
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Statistics.u64Snapshots += snapshot.fSaved ? 1U : 0U;
+                m_Statistics.u64Lost += snapshot.u64Lost;
+            }
+            if (m_Handler)
+                m_Handler(snapshot);
+        }
+    }
+    bool Save(const SJob &job, SSnapshot &snapshot) {
+        std::vector<SRecord> records;
+        records.reserve((size_t)(job.last - job.first));
+        for (uint64_t sequence = job.first; sequence < job.last; sequence++) {
+            const SRecord &record = m_pRecords[sequence % m_Capacity];
+            bool intact = (Atomic(record.u64Sequence).load(std::memory_order_acquire) == (sequence + 1U));
+            records.push_back(record);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (!intact || (Atomic(record.u64Sequence).load(std::memory_order_relaxed) != (sequence + 1U))) {
+                records.pop_back();  // overwritten by the recorder
+                snapshot.u64Lost++;
+            }
+        }
+        SHeader header;
+        memset(&header, 0, sizeof(SHeader));
+        header.u32Magic = PEAKCAN_RECORDER_MAGIC;
+        header.u16Version = PEAKCAN_RECORDER_VERSION;
+        header.u16RecordSize = (uint16_t)sizeof(SRecord);
+        header.u64Capacity = records.size() ? (uint64_t)records.size() : 1U;
+        header.u64Head = (uint64_t)records.size();
+        for (size_t i = 0U; i < records.size(); i++)
+            records[i].u64Sequence = (uint64_t)i + 1U;  // renumbered from 0
+        if (records.empty()) {  // one empty record
+            SRecord empty;
+            memset(&empty, 0, sizeof(SRecord));
+            records.push_back(empty);
+        }
+        FILE *file = fopen(snapshot.strFile.c_str(), "wb");
+        if (!file)
+            return false;
+        bool ok = (fwrite(&header, sizeof(SHeader), 1U, file) == 1U) &&
+                  (fwrite(&records[0], sizeof(SRecord), records.size(), file) == records.size());
+        ok = (fclose(file) == 0) && ok;
+        snapshot.u64Records = header.u64Head;
+        CPeakCANIndexWriter index(0U);
+        for (uint64_t i = 0U; i < header.u64Head; i++)
+            index.Add(Nanoseconds(records[(size_t)i]), Key(records[(size_t)i]));
+        return ok && (index.Write((snapshot.strFile + ".idx").c_str(), header.u64Capacity, header.u64Head) == CANERR_NOERROR);
+    }
+    CPeakCANRecorder(const CPeakCANRecorder&);  // not copyable
+    CPeakCANRecorder &operator=(const CPeakCANRecorder&);
+};
+
+/// \brief  reader of a capture file with seeking by time and identifier
+/// \note   Capture and index are memory-mapped; a query touches the index
+///         and only the blocks of the capture that can contain matches.
+///         Sequence numbers returned by the queries are resolved with At.
+class CPeakCANCapture {
+public:
+    typedef CPeakCANRecorder::SHeader SHeader;
+    typedef CPeakCANRecorder::SRecord SRecord;
+private:
+    CPeakCANMappedFile m_File;  ///< mapped capture file
+    const SHeader *m_pHeader;  ///< header of the capture
+    const SRecord *m_pRecords;  ///< records of the capture
+    uint64_t m_First;  ///< sequence number of the oldest record
+    uint64_t m_Head;  ///< sequence number after the newest record
+    CPeakCANIndex m_Index;  ///< side index
+    uint64_t m_Touched;  ///< blocks touched by the last query
+public:
+    CPeakCANCapture() : m_pHeader(NULL), m_pRecords(NULL), m_First(0U), m_Head(0U), m_Touched(0U) {}
+
+    /// \brief  maps a capture file and its index ("<path>.idx"), which is (re-)built if missing or stale
+    CANAPI_Return_t Open(const char *path, bool build = true) {
+        if (m_pHeader)
+            return CANERR_YETINIT;
+        CANAPI_Return_t rc = m_File.Open(path);
+        if (rc != CANERR_NOERROR)
+            return rc;
+        const SHeader *header = (const SHeader*)m_File.Data();
+        if ((m_File.Size() < sizeof(SHeader)) || (header->u32Magic != PEAKCAN_RECORDER_MAGIC) ||
+            (header->u16Version != PEAKCAN_RECORDER_VERSION) || (header->u16RecordSize != (uint16_t)sizeof(SRecord)) ||
+            !header->u64Capacity || (m_File.Size() < sizeof(SHeader) + header->u64Capacity * sizeof(SRecord))) {
+            m_File.Close();
+            return CANERR_ILLPARA;
+        }
+        std::string index = std::string(path) + ".idx";
+        if ((m_Index.Open(index.c_str()) != CANERR_NOERROR) || !m_Index.Matches(header->u64Capacity, header->u64Head)) {
+            m_Index.Close();
+            if (!build || ((rc = CPeakCANRecorder::BuildIndex(path)) != CANERR_NOERROR) ||
+                ((rc = m_Index.Open(index.c_str())) != CANERR_NOERROR)) {
+                m_File.Close();
+                return (rc != CANERR_NOERROR) ? rc : CANERR_RESOURCE;
+            }
+        }
+        m_pHeader = header;
+        m_pRecords = (const SRecord*)(header + 1);
+        m_First = m_Index.GetSequence(0U);  // the records covered by the index
+        m_Head = m_Index.GetHead();
+        return CANERR_NOERROR;
+    }
+    /// \brief  unmaps capture and index
+    void Close() {
+        m_Index.Close();
+        m_File.Close();
+        m_pHeader = NULL;
+        m_pRecords = NULL;
+        m_First = m_Head = 0U;
+    }
+    /// \brief  sequence number of the oldest record
+    uint64_t GetFirst() const { return m_First; }
+    /// \brief  sequence number after the newest record
+    uint64_t GetHead() const { return m_Head; }
+    /// \brief  number of blocks of the capture touched by the last query
+    uint64_t GetTouched() const { return m_Touched; }
+
+    /// \brief  record with the given sequence number (NULL if out of range, torn or overwritten)
+    const SRecord *At(uint64_t sequence) const {
+        if (!m_pHeader || (sequence < m_First) || (sequence >= m_Head))
+            return NULL;
+        const SRecord *record = &m_pRecords[sequence % m_pHeader->u64Capacity];
+        return (record->u64Sequence == (sequence + 1U)) ? record : NULL;
+    }
+    /// \brief  sequence number of the first record with a time-stamp >= 'time' in [ns] (GetHead() if none)
+    uint64_t Seek(uint64_t time) {
+        m_Touched = 0U;
+        uint32_t block = m_Index.Find(time);
+        if (block >= m_Index.GetBlocks())
+            return m_Head;
+        m_Touched++;
+        uint64_t sequence = m_Index.GetSequence(block);
+        uint64_t end = sequence + m_Index.GetBlockSize();
+        for (; (sequence < end) && (sequence < m_Head); sequence++) {
+            const SRecord *record = At(sequence);
+            if (record && (CPeakCANRecorder::Nanoseconds(*record) >= time))
+                return sequence;
+        }
+        return (sequence < m_Head) ? sequence : m_Head;
+    }
+    /// \brief  sequence numbers of all records with a time-stamp in ['from', 'to'] in [ns]
+    size_t Query(uint64_t from, uint64_t to, std::vector<uint64_t> &sequences) {
+        sequences.clear();
+        uint64_t sequence = Seek(from);
+        uint64_t block = (uint64_t)-1;
+        m_Touched = 0U;
+        for (; sequence < m_Head; sequence++) {
+            uint64_t current = (sequence - m_First) / m_Index.GetBlockSize();
+            if (current != block) {
+                block = current;
+                if (m_Index.GetBlock((uint32_t)block).u64TimeFirst > to)
+                    break;
+                m_Touched++;
+            }
+            const SRecord *record = At(sequence);
+            if (!record)
+                continue;
+            uint64_t time = CPeakCANRecorder::Nanoseconds(*record);
+            if (time > to)
+                break;
+            sequences.push_back(sequence);
+        }
+        return sequences.size();
+    }
+    /// \brief  sequence numbers of the messages with identifier 'id' and a time-stamp in ['from', 'to'] in [ns]
+    size_t Query(uint64_t from, uint64_t to, uint32_t id, bool xtd, std::vector<uint64_t> &sequences) {
+        sequences.clear();
+        m_Touched = 0U;
+        uint32_t key = CPeakCANIndex::Key(id, xtd);
+        const uint32_t *blocks;
+        uint32_t count;
+        if (!m_Index.GetPostings(key, blocks, count))
+            return 0U;
+        const uint32_t *block = std::lower_bound(blocks, blocks + count, m_Index.Find(from));
+        for (; block < (blocks + count); ++block) {
+            if (m_Index.GetBlock(*block).u64TimeFirst > to)
+                break;
+            m_Touched++;
+            uint64_t sequence = m_Index.GetSequence(*block);
+            uint64_t end = sequence + m_Index.GetBlockSize();
+            for (; (sequence < end) && (sequence < m_Head); sequence++) {
+                const SRecord *record = At(sequence);
+                if (!record || (CPeakCANRecorder::Key(*record) != key))
+                    continue;
+                uint64_t time = CPeakCANRecorder::Nanoseconds(*record);
+                if ((time >= from) && (time <= to))
+                    sequences.push_back(sequence);
+            }
+        }
+        return sequences.size();
+    }
+private:
+    CPeakCANCapture(const CPeakCANCapture&);  // not copyable
+    CPeakCANCapture &operator=(const CPeakCANCapture&);
+};
+/// \}
+
+#endif // PEAKCAN_RECORDER_H_INCLUDED
@@ -0,0 +1,317 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (for PEAK PCAN Interfaces)
+//
+//  Copyright (c) 2017-2021 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of PCANBasic-Wrapper.
+//
+//  PCANBasic-Wrapper is dual-licensed under the BSD 2-Clause "Simplified" License
+//  and under the GNU General Public License v3.0 (or any later version). You can
+//  choose between one of them if you use PCANBasic-Wrapper in whole or in part.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  PCANBasic-Wrapper IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF PCANBasic-Wrapper, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  PCANBasic-Wrapper is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  PCANBasic-Wrapper is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+#ifndef PEAKCAN_SCHEDULER_H_INCLUDED
+#define PEAKCAN_SCHEDULER_H_INCLUDED
+
+#include "PeakCAN.h"
+
+#include <functional>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+/// \name   PeakCAN Scheduler
+/// \brief  Cyclic transmission of periodic messages (rest-bus simulation).
+/// \note   One thread drives a hierarchical timer wheel (3 levels with
+///         256 x 64 x 64 slots of one tick each, i.e. 4.6 hours at 1ms).
+///         Deadlines are absolute (start + phase + n * period), so there
+///         is no drift. All messages due in the same tick are written
+///         back-to-back as one burst. Per message the number of late
+///         sends and the jitter of the send interval are recorded.
+/// \note   A message can be shaped (see SetShape): each period is delayed
+///         by a random jitter (without drift of the deadlines), and it can
+///         be sent as a burst of several messages, back-to-back or with a
+///         gap between them. The interval jitter is measured from the first
+///         message of a burst, so it includes the random jitter.
+/// \note   The payload update is called from the scheduler thread right
+///         before the message is sent; it must not call Add or Remove.
+/// \{
+#define PEAKCAN_SCHEDULER_TICK  1000U  ///< default tick in [us]
+
+class CPeakCANScheduler {
+public:
+    typedef std::function<void(CANAPI_Message_t &message)> Update;
+    typedef std::chrono::steady_clock Clock;
+
+    /// \brief  statistics of one cyclic message (times in [us])
+    struct SStatistics {
+        uint64_t u64Sent;  ///< number of messages sent
+        uint64_t u64Late;  ///< sent more than one tick after the deadline
+        uint64_t u64Skipped;  ///< periods skipped (more than one period late)
+        uint64_t u64Errors;  ///< write errors (e.g. transmitter busy)
+        uint64_t u64LatenessMax;  ///< maximum delay after the deadline
+        uint64_t u64JitterMax;  ///< maximum deviation of the interval from the period
+        uint64_t u64JitterTotal;  ///< sum of deviations (for the mean)
+    };
+private:
+    static const unsigned L0_BITS = 8U;
+    static const unsigned LN_BITS = 6U;
+    static const uint64_t L0_SIZE = (uint64_t)1U << L0_BITS;
+    static const uint64_t LN_SIZE = (uint64_t)1U << LN_BITS;
+
+    struct SEntry {
+        CANAPI_Message_t message;  ///< message to be sent
+        uint64_t period;  ///< period in ticks
+        uint64_t deadline;  ///< next deadline in ticks (absolute)
+        Update update;  ///< payload update (optional)
+        uint64_t fire;  ///< tick of the next send (deadline + jitter, or within a burst)
+        uint64_t jitter;  ///< maximum random delay in ticks
+        uint64_t gap;  ///< ticks between the messages of a burst
+        uint32_t burst;  ///< messages per period
+        uint32_t index;  ///< next message of the burst
+        bool active;  ///< false when removed
+        bool first;  ///< no interval so far
+        Clock::time_point last;  ///< time of the last send
+        SStatistics stats;  ///< statistics
+    };
+    CPeakCAN &m_Channel;  ///< CAN channel (started by the application)
+    Clock::duration m_Tick;  ///< duration of one tick
+    Clock::time_point m_Epoch;  ///< time of tick 0
+    uint64_t m_Now;  ///< current tick (processed up to)
+    std::vector<std::unique_ptr<SEntry>> m_Entries;  ///< all messages (index = id)
+    std::vector<SEntry*> m_Wheel[3][L0_SIZE];  ///< timer wheel (levels 1 and 2 use LN_SIZE slots)
+    std::thread m_Thread;  ///< scheduler thread
+    std::atomic<bool> m_Running;  ///< flag: scheduler running
+    std::mutex m_Mutex;  ///< protects entries and wheel
+    uint64_t m_Random;  ///< state of the jitter generator (xorshift64)
+public:
+    /// \brief  scheduler for 'channel' with a tick of 'tick' microseconds
+    CPeakCANScheduler(CPeakCAN &channel, uint32_t tick = PEAKCAN_SCHEDULER_TICK)
+        : m_Channel(channel), m_Tick(std::chrono::microseconds(tick ? tick : 1U)), m_Epoch(Clock::now()),
+          m_Now(0U), m_Running(false), m_Random(0x9E3779B97F4A7C15ULL) {}
+    ~CPeakCANScheduler() { (void)Stop(); }
+
+    /// \brief  adds a cyclic message with 'period' and 'phase' offset (in [us]);
+    ///         returns the id of the message (>= 0), or a negative error code
+    int Add(const CANAPI_Message_t &message, uint32_t period, uint32_t phase = 0U, const Update &update = Update()) {
+        uint64_t ticks = ToTicks(period);
+        if (!ticks)
+            return CANERR_ILLPARA;
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        std::unique_ptr<SEntry> entry(new SEntry());
+        entry->message = message;
+        entry->period = ticks;
+        entry->deadline = m_Now + 1U + ToTicks(phase);
+        entry->fire = entry->deadline;
+        entry->burst = 1U;
+        entry->update = update;
+        entry->active = true;
+        entry->first = true;
+        Insert(entry.get());
+        m_Entries.push_back(std::move(entry));
+        return (int)(m_Entries.size() - 1U);
+    }
+    /// \brief  shapes a cyclic message: random delay up to 'jitter' per period,
+    ///         and 'burst' messages per period with 'gap' between them (in [us]);
+    ///         jitter and burst must fit into the period
+    CANAPI_Return_t SetShape(int id, uint32_t jitter, uint32_t burst = 1U, uint32_t gap = 0U) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if ((id < 0) || ((size_t)id >= m_Entries.size()) || !m_Entries[(size_t)id]->active || !burst)
+            return CANERR_ILLPARA;
+        SEntry *entry = m_Entries[(size_t)id].get();
+        if ((ToTicks(jitter) + ToTicks(gap) * (burst - 1U)) >= entry->period)
+            return CANERR_ILLPARA;
+        entry->jitter = ToTicks(jitter);
+        entry->gap = ToTicks(gap);
+        entry->burst = burst;
+        return CANERR_NOERROR;
+    }
+    /// \brief  removes a cyclic message
+    CANAPI_Return_t Remove(int id) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if ((id < 0) || ((size_t)id >= m_Entries.size()) || !m_Entries[(size_t)id]->active)
+            return CANERR_ILLPARA;
+        m_Entries[(size_t)id]->active = false;  // note: dropped from the wheel when due
+        return CANERR_NOERROR;
+    }
+    /// \brief  retrieves the statistics of a cyclic message
+    CANAPI_Return_t GetStatistics(int id, SStatistics &stats) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if ((id < 0) || ((size_t)id >= m_Entries.size()))
+            return CANERR_ILLPARA;
+        stats = m_Entries[(size_t)id]->stats;
+        return CANERR_NOERROR;
+    }
+    /// \brief  starts the scheduler thread (deadlines count from now)
+    CANAPI_Return_t Start() {
+        if (m_Running)
+            return CANERR_ONLINE;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Epoch = Clock::now() - m_Tick * m_Now;
+        }
+        m_Running = true;
+        m_Thread = std::thread(&CPeakCANScheduler::Run, this);
+        return CANERR_NOERROR;
+    }
+    /// \brief  stops the scheduler thread
+    CANAPI_Return_t Stop() {
+        if (!m_Running)
+            return CANERR_OFFLINE;
+        m_Running = false;
+        if (m_Thread.joinable())
+            m_Thread.join();
+        return CANERR_NOERROR;
+    }
+private:
+    uint64_t ToTicks(uint32_t usec) const {
+        return (uint64_t)(std::chrono::microseconds(usec) / m_Tick);
+    }
+    uint64_t Random() {
+        m_Random ^= m_Random << 13;
+        m_Random ^= m_Random >> 7;
+        m_Random ^= m_Random << 17;
+        return m_Random;
+    }
+    void Insert(SEntry *entry) {
+        uint64_t delta = (entry->fire > m_Now) ? (entry->fire - m_Now) : 0U;
+        if (delta < L0_SIZE)
+            m_Wheel[0][entry->fire & (L0_SIZE - 1U)].push_back(entry);
+        else if (delta < (L0_SIZE << LN_BITS))
+            m_Wheel[1][(entry->fire >> L0_BITS) & (LN_SIZE - 1U)].push_back(entry);
+        else  // note: deadlines beyond the wheel wait in the last slot of level 2
+            m_Wheel[2][(std::min(delta, (L0_SIZE << (2U * LN_BITS)) - 1U) + m_Now) >> (L0_BITS + LN_BITS) & (LN_SIZE - 1U)].push_back(entry);
+    }
+    void Cascade(unsigned level, uint64_t slot) {
+        std::vector<SEntry*> entries;
+        entries.swap(m_Wheel[level][slot]);
+        for (SEntry *entry : entries)
+            Insert(entry);
+    }
+    // collects the messages due in tick 'm_Now' (with the mutex locked)
+    void Expire(std::vector<SEntry*> &due) {
+        uint64_t index = m_Now & (L0_SIZE - 1U);
+        if (index == 0U) {
+            uint64_t index1 = (m_Now >> L0_BITS) & (LN_SIZE - 1U);
+            if (index1 == 0U)
+                Cascade(2U, (m_Now >> (L0_BITS + LN_BITS)) & (LN_SIZE - 1U));
+            Cascade(1U, index1);
+        }
+        std::vector<SEntry*> entries;
+        entries.swap(m_Wheel[0][index]);
+        for (SEntry *entry : entries) {
+            if (!entry->active)
+                continue;
+            if (entry->fire > m_Now)  // not yet (parked beyond the wheel)
+                Insert(entry);
+            else
+                due.push_back(entry);
+        }
+    }
+    void Run() {
+        std::vector<SEntry*> due;
+        while (m_Running) {
+            Clock::time_point next;
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                next = m_Epoch + m_Tick * (m_Now + 1U);
+            }
+            std::this_thread::sleep_until(next);
+            // process every tick up to now (catch up when the thread was late)
+            uint64_t now = (uint64_t)((Clock::now() - m_Epoch) / m_Tick);
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            while (m_Now < now) {
+                m_Now++;
+                due.clear();
+                Expire(due);
+                Burst(due);
+            }
+        }
+    }
+    // sends the messages due in one tick back-to-back and schedules them again
+    void Burst(const std::vector<SEntry*> &due) {
+        for (SEntry *entry : due) {
+            SStatistics &stats = entry->stats;
+            do {
+                if (entry->update)
+                    entry->update(entry->message);
+                CANAPI_Return_t rc = m_Channel.WriteMessage(entry->message, 0U);
+                Clock::time_point sent = Clock::now();
+                Clock::time_point ideal = m_Epoch + m_Tick * entry->fire;
+                if (CANERR_NOERROR == rc) {
+                    uint64_t lateness = (sent > ideal) ? (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(sent - ideal).count() : 0U;
+                    stats.u64Sent++;
+                    if (sent > (ideal + m_Tick))
+                        stats.u64Late++;
+                    if (lateness > stats.u64LatenessMax)
+                        stats.u64LatenessMax = lateness;
+                    if (!entry->first && !entry->index) {
+                        int64_t interval = (int64_t)std::chrono::duration_cast<std::chrono::microseconds>(sent - entry->last).count();
+                        int64_t period = (int64_t)std::chrono::duration_cast<std::chrono::microseconds>(m_Tick * entry->period).count();
+                        uint64_t jitter = (uint64_t)((interval > period) ? (interval - period) : (period - interval));
+                        stats.u64JitterTotal += jitter;
+                        if (jitter > stats.u64JitterMax)
+                            stats.u64JitterMax = jitter;
+                    }
+                    if (!entry->index) {
+                        entry->first = false;
+                        entry->last = sent;
+                    }
+                } else
+                    stats.u64Errors++;
+            } while ((++entry->index < entry->burst) && !entry->gap);
+            // rest of the burst after the gap
+            if (entry->index < entry->burst) {
+                entry->fire = m_Now + entry->gap;
+                Insert(entry);
+                continue;
+            }
+            entry->index = 0U;
+            // next deadline (absolute); skip periods that are already over
+            entry->deadline += entry->period;
+            if (entry->deadline <= m_Now) {
+                uint64_t missed = (m_Now - entry->deadline) / entry->period + 1U;
+                stats.u64Skipped += missed;
+                entry->deadline += missed * entry->period;
+            }
+            entry->fire = entry->deadline + (entry->jitter ? (Random() % (entry->jitter + 1U)) : 0U);
+            Insert(entry);
+        }
+    }
+};
+/// \}
+#endif // PEAKCAN_SCHEDULER_H_INCLUDED
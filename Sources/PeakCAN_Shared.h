@@ -0,0 +1,747 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (for PEAK PCAN Interfaces)
+//
+//  Copyright (c) 2017-2021 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of PCANBasic-Wrapper.
+//
+//  PCANBasic-Wrapper is dual-licensed under the BSD 2-Clause "Simplified" License
+//  and under the GNU General Public License v3.0 (or any later version). You can
+//  choose between one of them if you use PCANBasic-Wrapper in whole or in part.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  PCANBasic-Wrapper IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF PCANBasic-Wrapper, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  PCANBasic-Wrapper is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  PCANBasic-Wrapper is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+#ifndef PEAKCAN_SHARED_H_INCLUDED
+#define PEAKCAN_SHARED_H_INCLUDED
+
+#include "PeakCAN.h"
+
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <stdio.h>
+#include <string.h>
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/// \name   PeakCAN Shared Memory
+/// \brief  Distribution of the messages of one CAN channel to many local
+///         consumers (other processes) through a shared-memory ring.
+/// \note   A CAN channel can only be opened once per process. The publisher
+///         (CPeakCANPublisher) drains the channel into a named shared-memory
+///         ring; clients (CPeakCANShared) attach to the ring by the channel
+///         number and read the messages through the CCANAPI interface.
+/// \note   The ring is lock-free with one producer and any number of
+///         consumers. Every consumer has its own cursor; the publisher never
+///         waits for a consumer. A slot carries the sequence number of its
+///         message (seqlock): a consumer that has been lapped by the
+///         publisher detects this, counts the lost messages and resumes half
+///         a ring behind the publisher (status bit 'queue_overrun').
+/// \note   Waiting consumers are woken up by a named semaphore (Windows);
+///         elsewhere they poll the ring every PEAKCAN_SHARED_POLL [us].
+/// \{
+#define PEAKCAN_SHARED_SLOTS  65536U  ///< default number of slots (power of two)
+#define PEAKCAN_SHARED_BATCH  64U  ///< maximum number of messages per wake-up
+#define PEAKCAN_SHARED_REFRESH  100U  ///< refresh of status and bus load in [ms]
+#define PEAKCAN_SHARED_POLL  100U  ///< polling interval in [us] (w/o semaphore)
+#define PEAKCAN_SHARED_MAGIC  0x4E414350U  ///< "PCAN"
+#define PEAKCAN_SHARED_VERSION  1U  ///< layout version of the ring
+
+/// \brief  shared-memory ring (used by the publisher and its clients)
+class CPeakCANSharedRing {
+public:
+    /// \brief  a message and its sequence number (0 = being written)
+    struct SSlot {
+        std::atomic<uint64_t> u64Sequence;  ///< sequence number + 1 of the message
+        CANAPI_Message_t message;  ///< the message
+    };
+    /// \brief  header of the ring (followed by the slots)
+    struct SHeader {
+        uint32_t u32Magic;  ///< PEAKCAN_SHARED_MAGIC
+        uint32_t u32Version;  ///< PEAKCAN_SHARED_VERSION
+        uint32_t u32Slots;  ///< number of slots (power of two)
+        uint32_t u32SlotSize;  ///< size of a slot in bytes
+        std::atomic<uint32_t> u32Online;  ///< flag: publisher running
+        std::atomic<uint32_t> u32Waiters;  ///< number of waiting consumers
+        std::atomic<uint64_t> u64Head;  ///< sequence number of the next message
+        std::atomic<uint8_t> u8Status;  ///< status register of the channel
+        std::atomic<uint8_t> u8BusLoad;  ///< bus load of the channel
+        CANAPI_OpMode_t opMode;  ///< operation mode of the channel
+        CANAPI_Bitrate_t bitrate;  ///< bit-rate settings of the channel
+        CANAPI_BusSpeed_t speed;  ///< bus speed of the channel
+        char szHardware[CANPROP_MAX_BUFFER_SIZE];  ///< hardware version of the channel
+        char szFirmware[CANPROP_MAX_BUFFER_SIZE];  ///< firmware version of the channel
+    };
+    static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "64-bit atomics must be lock-free to be shared between processes");
+private:
+    SHeader *m_pHeader;  ///< mapped view
+    size_t m_Size;  ///< size of the view
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE m_hMapping;  ///< file mapping object
+    HANDLE m_hWake;  ///< semaphore to wake up waiting consumers
+#else
+    char m_szName[64];  ///< name of the shared-memory object (owner only)
+#endif
+public:
+    CPeakCANSharedRing() : m_pHeader(NULL), m_Size(0U) {
+#if defined(_WIN32) || defined(_WIN64)
+        m_hMapping = m_hWake = NULL;
+#else
+        m_szName[0] = '\0';
+#endif
+    }
+    ~CPeakCANSharedRing() { Close(); }
+
+    /// \brief  name of the ring of a CAN channel
+    static void MakeName(int32_t channel, char *name, size_t length) {
+#if defined(_WIN32) || defined(_WIN64)
+        (void)snprintf(name, length, "Local\\PeakCAN.Shared.%i", (int)channel);
+#else
+        (void)snprintf(name, length, "/PeakCAN.Shared.%i", (int)channel);
+#endif
+    }
+    /// \brief  size of the ring with 'slots' slots in bytes
+    static size_t Size(uint32_t slots) { return sizeof(SHeader) + (size_t)slots * sizeof(SSlot); }
+
+    /// \brief  creates (or re-opens) the ring as owner; 'fresh' is set when it is initialized
+    CANAPI_Return_t Create(const char *name, uint32_t slots, bool &fresh) {
+        if (m_pHeader)
+            return CANERR_YETINIT;
+        if (!name || (slots < 2U) || (slots & (slots - 1U)))
+            return CANERR_ILLPARA;
+        size_t size = Size(slots);
+#if defined(_WIN32) || defined(_WIN64)
+        m_hMapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                        (DWORD)((uint64_t)size >> 32), (DWORD)size, name);
+        if (!m_hMapping)
+            return CANERR_RESOURCE;
+        fresh = (GetLastError() != ERROR_ALREADY_EXISTS);  // a client may still hold a view
+        m_pHeader = (SHeader*)MapViewOfFile(m_hMapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+#else
+        (void)snprintf(m_szName, sizeof(m_szName), "%s", name);
+        (void)shm_unlink(m_szName);  // a previous owner has gone
+        int fd = shm_open(m_szName, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if ((fd < 0) || (ftruncate(fd, (off_t)size) != 0)) {
+            if (fd >= 0) { (void)close(fd); (void)shm_unlink(m_szName); }
+            m_szName[0] = '\0';
+            return CANERR_RESOURCE;
+        }
+        fresh = true;
+        void *view = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        (void)close(fd);
+        m_pHeader = (view != MAP_FAILED) ? (SHeader*)view : NULL;
+#endif
+        m_Size = size;
+        if (!m_pHeader || (!fresh && !Valid(slots))) {
+            Close();
+            return CANERR_RESOURCE;
+        }
+        if (fresh) {
+            (void)new (m_pHeader) SHeader();
+            m_pHeader->u32Slots = slots;
+            m_pHeader->u32SlotSize = (uint32_t)sizeof(SSlot);
+            m_pHeader->u32Version = PEAKCAN_SHARED_VERSION;
+            SSlot *slot = Slots();
+            for (uint32_t i = 0U; i < slots; i++)
+                slot[i].u64Sequence.store(0U, std::memory_order_relaxed);
+            m_pHeader->u64Head.store(0U, std::memory_order_relaxed);
+            m_pHeader->u32Waiters.store(0U, std::memory_order_relaxed);
+            m_pHeader->u32Online.store(0U, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            m_pHeader->u32Magic = PEAKCAN_SHARED_MAGIC;
+        }
+        return OpenWake(name, true);
+    }
+    /// \brief  opens an existing ring as client
+    CANAPI_Return_t Open(const char *name) {
+        if (m_pHeader)
+            return CANERR_YETINIT;
+        if (!name)
+            return CANERR_NULLPTR;
+#if defined(_WIN32) || defined(_WIN64)
+        m_hMapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name);
+        if (!m_hMapping)
+            return CANERR_NOTINIT;  // no publisher
+        m_pHeader = (SHeader*)MapViewOfFile(m_hMapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+        MEMORY_BASIC_INFORMATION info;
+        m_Size = (m_pHeader && VirtualQuery(m_pHeader, &info, sizeof(info))) ? (size_t)info.RegionSize : 0U;
+#else
+        int fd = shm_open(name, O_RDWR, 0);
+        if (fd < 0)
+            return CANERR_NOTINIT;  // no publisher
+        struct stat info;
+        void *view = MAP_FAILED;
+        if ((fstat(fd, &info) == 0) && ((size_t)info.st_size >= sizeof(SHeader)))
+            view = mmap(NULL, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        (void)close(fd);
+        m_pHeader = (view != MAP_FAILED) ? (SHeader*)view : NULL;
+        m_Size = m_pHeader ? (size_t)info.st_size : 0U;
+#endif
+        if (!m_pHeader || (m_Size < sizeof(SHeader)) || !Valid(m_pHeader->u32Slots)) {
+            Close();
+            return CANERR_RESOURCE;
+        }
+        return OpenWake(name, false);
+    }
+    /// \brief  unmaps the ring (the owner also removes its name)
+    void Close() {
+#if defined(_WIN32) || defined(_WIN64)
+        if (m_pHeader)
+            (void)UnmapViewOfFile(m_pHeader);
+        if (m_hMapping)
+            (void)CloseHandle(m_hMapping);
+        if (m_hWake)
+            (void)CloseHandle(m_hWake);
+        m_hMapping = m_hWake = NULL;
+#else
+        if (m_pHeader)
+            (void)munmap(m_pHeader, m_Size);
+        if (m_szName[0])
+            (void)shm_unlink(m_szName);  // clients keep their mapping
+        m_szName[0] = '\0';
+#endif
+        m_pHeader = NULL;
+        m_Size = 0U;
+    }
+    /// \brief  wakes up all waiting consumers (publisher)
+    void Wake() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);  // head before waiters (see Wait)
+        uint32_t waiters = m_pHeader->u32Waiters.exchange(0U);
+#if defined(_WIN32) || defined(_WIN64)
+        if (waiters && m_hWake)
+            (void)ReleaseSemaphore(m_hWake, (LONG)waiters, NULL);
+#else
+        (void)waiters;
+#endif
+    }
+    /// \brief  waits for a wake-up or for 'signal' (consumer); returns false when signaled
+    /// \note   The consumer must announce itself in u32Waiters and re-check the
+    ///         head before it calls this function. A spurious wake-up is harmless;
+    ///         on a time-out or a signal the announcement is withdrawn.
+    bool Wait(uint32_t milliseconds, void *signal) {
+#if defined(_WIN32) || defined(_WIN64)
+        HANDLE handles[2] = { m_hWake, (HANDLE)signal };
+        DWORD result = WaitForMultipleObjects(signal ? 2U : 1U, handles, FALSE,
+                                              (milliseconds != CANREAD_INFINITE) ? (DWORD)milliseconds : INFINITE);
+        if (result != WAIT_OBJECT_0)
+            Withdraw();  // no permit consumed
+        return (result == WAIT_OBJECT_0) || (result == WAIT_TIMEOUT);
+#else
+        std::atomic<bool> *flag = (std::atomic<bool>*)signal;
+        if (flag && flag->exchange(false))
+            return false;
+        std::this_thread::sleep_for(std::chrono::microseconds(
+            (milliseconds * 1000U < PEAKCAN_SHARED_POLL) ? milliseconds * 1000U : PEAKCAN_SHARED_POLL));
+        return !(flag && flag->exchange(false));
+#endif
+    }
+    /// \brief  withdraws the announcement of a consumer that does not wait (consumer)
+    /// \note   If the publisher has taken the announcement already, the permit
+    ///         released for it is consumed, so that no permit is left over.
+    void Withdraw() {
+        uint32_t waiters = m_pHeader->u32Waiters.load();
+        while (waiters && !m_pHeader->u32Waiters.compare_exchange_weak(waiters, waiters - 1U)) {}
+#if defined(_WIN32) || defined(_WIN64)
+        if (!waiters && m_hWake)  // released right after the exchange (see Wake)
+            (void)WaitForSingleObject(m_hWake, 1U);
+#endif
+    }
+    SHeader *Header() const { return m_pHeader; }
+    SSlot *Slots() const { return (SSlot*)(m_pHeader + 1); }
+private:
+    bool Valid(uint32_t slots) const {
+        return (m_pHeader->u32Magic == PEAKCAN_SHARED_MAGIC) &&
+               (m_pHeader->u32Version == PEAKCAN_SHARED_VERSION) &&
+               (m_pHeader->u32SlotSize == (uint32_t)sizeof(SSlot)) &&
+               (m_pHeader->u32Slots == slots) && slots && !(slots & (slots - 1U)) &&
+               (Size(slots) <= m_Size);
+    }
+    CANAPI_Return_t OpenWake(const char *name, bool owner) {
+#if defined(_WIN32) || defined(_WIN64)
+        char wake[MAX_PATH];
+        (void)snprintf(wake, sizeof(wake), "%s.Wake", name);
+        m_hWake = owner ? CreateSemaphoreA(NULL, 0, 0x7FFFFFFF, wake)
+                        : OpenSemaphoreA(SEMAPHORE_MODIFY_STATE | SYNCHRONIZE, FALSE, wake);
+        if (!m_hWake) {
+            Close();
+            return CANERR_RESOURCE;
+        }
+#else
+        (void)name;
+        (void)owner;
+#endif
+        return CANERR_NOERROR;
+    }
+    CPeakCANSharedRing(const CPeakCANSharedRing&);  // not copyable
+    CPeakCANSharedRing &operator=(const CPeakCANSharedRing&);
+};
+
+/// \brief  publisher: drains a CAN channel into the shared-memory ring
+class CPeakCANPublisher {
+private:
+    CPeakCAN &m_Channel;  ///< CAN channel (started by the application)
+    uint32_t m_Slots;  ///< number of slots
+    CPeakCANSharedRing m_Ring;  ///< shared-memory ring
+    uint64_t m_Sequence;  ///< sequence number of the next message
+    std::atomic<uint64_t> m_Published;  ///< number of published messages
+    std::thread m_Thread;  ///< publisher thread
+    std::atomic<bool> m_Running;  ///< flag: publisher running
+public:
+    /// \brief  publisher of 'channel' with a ring of 'slots' messages (power of two)
+    CPeakCANPublisher(CPeakCAN &channel, uint32_t slots = PEAKCAN_SHARED_SLOTS)
+        : m_Channel(channel), m_Slots(slots), m_Sequence(0U), m_Published(0U), m_Running(false) {}
+    ~CPeakCANPublisher() { (void)Stop(); }
+
+    /// \brief  creates the ring for channel number 'channel' and starts the publisher thread
+    CANAPI_Return_t Start(int32_t channel) {
+        char name[64];
+        CPeakCANSharedRing::MakeName(channel, name, sizeof(name));
+        return Start(name);
+    }
+    /// \brief  creates the ring with the given name and starts the publisher thread
+    CANAPI_Return_t Start(const char *name) {
+        if (m_Running)
+            return CANERR_ONLINE;
+        bool fresh = false;
+        CANAPI_Return_t rc = m_Ring.Create(name, m_Slots, fresh);
+        if (rc != CANERR_NOERROR)
+            return rc;
+        CPeakCANSharedRing::SHeader *header = m_Ring.Header();
+        m_Sequence = header->u64Head.load(std::memory_order_relaxed);  // continue a re-opened ring
+        uint8_t mode = 0U;
+        (void)m_Channel.GetProperty(CANPROP_GET_OP_MODE, (void*)&mode, sizeof(uint8_t));
+        header->opMode.byte = mode;
+        if (m_Channel.GetBitrate(header->bitrate) != CANERR_NOERROR)
+            memset(&header->bitrate, 0, sizeof(header->bitrate));
+        if (m_Channel.GetBusSpeed(header->speed) != CANERR_NOERROR)
+            memset(&header->speed, 0, sizeof(header->speed));
+        const char *version = m_Channel.GetHardwareVersion();
+        (void)snprintf(header->szHardware, CANPROP_MAX_BUFFER_SIZE, "%s", version ? version : "");
+        version = m_Channel.GetFirmwareVersion();
+        (void)snprintf(header->szFirmware, CANPROP_MAX_BUFFER_SIZE, "%s", version ? version : "");
+        Refresh();
+        header->u32Online.store(1U, std::memory_order_release);
+        m_Running = true;
+        m_Thread = std::thread(&CPeakCANPublisher::Run, this);
+        return CANERR_NOERROR;
+    }
+    /// \brief  stops the publisher thread and removes the ring (clients go offline)
+    CANAPI_Return_t Stop() {
+        if (!m_Running)
+            return CANERR_OFFLINE;
+        m_Running = false;
+        (void)m_Channel.SignalChannel();  // wake up the blocking read
+        if (m_Thread.joinable())
+            m_Thread.join();
+        m_Ring.Header()->u32Online.store(0U, std::memory_order_release);
+        m_Ring.Wake();
+        m_Ring.Close();
+        return CANERR_NOERROR;
+    }
+    /// \brief  number of published messages
+    uint64_t GetPublished() const { return m_Published.load(std::memory_order_relaxed); }
+private:
+    void Run() {
+        typedef std::chrono::steady_clock Clock;
+        Clock::time_point refresh = Clock::now() + std::chrono::milliseconds(PEAKCAN_SHARED_REFRESH);
+        CANAPI_Message_t message;
+        while (m_Running) {
+            // the first read blocks, the rest of the batch is drained from the queue
+            CANAPI_Return_t rc = m_Channel.ReadMessage(message, PEAKCAN_SHARED_REFRESH);
+            uint32_t n = 0U, i = 0U;
+            while ((rc == CANERR_NOERROR) || (rc == CANERR_ERR_FRAME)) {
+                if (rc == CANERR_NOERROR) {  // an error frame leaves the message untouched
+                    Publish(message);
+                    n++;
+                }
+                if (++i >= PEAKCAN_SHARED_BATCH)
+                    break;
+                rc = m_Channel.ReadMessage(message, 0U);
+            }
+            if (n) {
+                m_Published.fetch_add(n, std::memory_order_relaxed);
+                m_Ring.Wake();
+            }
+            if (Clock::now() >= refresh) {
+                Refresh();
+                refresh = Clock::now() + std::chrono::milliseconds(PEAKCAN_SHARED_REFRESH);
+            }
+            if (!i && (rc != CANERR_RX_EMPTY) && m_Running)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));  // e.g. controller stopped
+        }
+    }
+    void Publish(const CANAPI_Message_t &message) {
+        CPeakCANSharedRing::SSlot &slot = m_Ring.Slots()[m_Sequence & (m_Slots - 1U)];
+        slot.u64Sequence.store(0U, std::memory_order_relaxed);  // being written
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&slot.message, &message, sizeof(CANAPI_Message_t));
+        slot.u64Sequence.store(m_Sequence + 1U, std::memory_order_release);
+        m_Ring.Header()->u64Head.store(++m_Sequence, std::memory_order_release);
+    }
+    void Refresh() {
+        CANAPI_Status_t status;
+        uint8_t load = 0U;
+        status.byte = 0U;
+        (void)m_Channel.GetStatus(status);
+        (void)m_Channel.GetBusLoad(load);
+        m_Ring.Header()->u8Status.store(status.byte, std::memory_order_relaxed);
+        m_Ring.Header()->u8BusLoad.store(load, std::memory_order_relaxed);
+    }
+};
+
+/// \brief  client: CAN API V3 compatible reader of a shared-memory ring
+/// \note   The client is read-only: WriteMessage returns CANERR_NOTSUPP.
+///         The bit-rate is owned by the publisher; StartController only
+///         places the cursor at the newest message, and the settings of
+///         the channel are reported by GetBitrate and GetBusSpeed.
+/// \note   The operation mode of the client filters the messages: status
+///         messages are only returned with 'err', extended and remote
+///         frames are suppressed with 'nxtd' and 'nrtr'.
+class CPeakCANShared : public CCANAPI {
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    CPeakCANSharedRing m_Ring;  ///< shared-memory ring
+    CPeakCANSharedRing::SSlot *m_pSlots;  ///< slots of the ring
+    uint64_t m_Mask;  ///< number of slots - 1
+    uint64_t m_Cursor;  ///< sequence number of the next message
+    const CPeakCANSharedRing::SSlot *m_pHeld;  ///< message held by AcquireMessage
+    CANAPI_OpMode_t m_OpMode;  ///< operation mode of the client
+    bool m_Started;  ///< flag: reading started
+    bool m_Overrun;  ///< flag: messages lost since the last status request
+    uint64_t m_Received;  ///< number of messages read
+    uint64_t m_Lost;  ///< number of messages lost by overruns
+    char m_szHardware[CANPROP_MAX_BUFFER_SIZE];  ///< hardware version (copy)
+    char m_szFirmware[CANPROP_MAX_BUFFER_SIZE];  ///< firmware version (copy)
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE m_hSignal;  ///< event for SignalChannel
+#else
+    std::atomic<bool> m_Signal;  ///< flag for SignalChannel
+#endif
+public:
+    CPeakCANShared() : m_pSlots(NULL), m_Mask(0U), m_Cursor(0U), m_pHeld(NULL),
+                       m_Started(false), m_Overrun(false), m_Received(0U), m_Lost(0U) {
+        m_OpMode.byte = 0U;
+        m_szHardware[0] = m_szFirmware[0] = '\0';
+#if defined(_WIN32) || defined(_WIN64)
+        m_hSignal = CreateEventA(NULL, FALSE, FALSE, NULL);
+#else
+        m_Signal = false;
+#endif
+    }
+    ~CPeakCANShared() {
+        (void)TeardownChannel();
+#if defined(_WIN32) || defined(_WIN64)
+        if (m_hSignal)
+            (void)CloseHandle(m_hSignal);
+#endif
+    }
+    /// \brief  attaches to the ring of channel number 'channel' ('param' = name of the ring, or NULL)
+    CANAPI_Return_t InitializeChannel(int32_t channel, CANAPI_OpMode_t opMode, const void *param = NULL) {
+        char name[64];
+        if (!param)
+            CPeakCANSharedRing::MakeName(channel, name, sizeof(name));
+        CANAPI_Return_t rc = m_Ring.Open(param ? (const char*)param : name);
+        if (rc != CANERR_NOERROR)
+            return rc;
+        CPeakCANSharedRing::SHeader *header = m_Ring.Header();
+        m_pSlots = m_Ring.Slots();
+        m_Mask = (uint64_t)header->u32Slots - 1U;
+        m_OpMode = opMode;
+        m_Started = m_Overrun = false;
+        m_Received = m_Lost = 0U;
+        (void)snprintf(m_szHardware, CANPROP_MAX_BUFFER_SIZE, "%s", header->szHardware);
+        (void)snprintf(m_szFirmware, CANPROP_MAX_BUFFER_SIZE, "%s", header->szFirmware);
+        return CANERR_NOERROR;
+    }
+    /// \brief  detaches from the ring
+    CANAPI_Return_t TeardownChannel() {
+        if (!m_Ring.Header())
+            return CANERR_NOTINIT;
+        m_Started = false;
+        m_pHeld = NULL;
+        m_pSlots = NULL;
+        m_Ring.Close();
+        return CANERR_NOERROR;
+    }
+    /// \brief  wakes up a blocking read (returns CANERR_RX_EMPTY)
+    CANAPI_Return_t SignalChannel() {
+#if defined(_WIN32) || defined(_WIN64)
+        if (m_hSignal)
+            (void)SetEvent(m_hSignal);
+#else
+        m_Signal = true;
+#endif
+        return CANERR_NOERROR;
+    }
+    /// \brief  starts reading with the newest message ('bitrate' is ignored)
+    CANAPI_Return_t StartController(CANAPI_Bitrate_t bitrate) {
+        (void)bitrate;
+        if (!m_Ring.Header())
+            return CANERR_NOTINIT;
+        if (m_Started)
+            return CANERR_ONLINE;
+        m_Cursor = m_Ring.Header()->u64Head.load();
+        m_pHeld = NULL;
+        m_Started = true;
+        return CANERR_NOERROR;
+    }
+    /// \brief  stops reading
+    CANAPI_Return_t ResetController() {
+        if (!m_Ring.Header())
+            return CANERR_NOTINIT;
+        if (!m_Started)
+            return CANERR_OFFLINE;
+        m_Started = false;
+        m_pHeld = NULL;
+        return CANERR_NOERROR;
+    }
+    /// \brief  not supported (the client is read-only)
+    CANAPI_Return_t WriteMessage(CANAPI_Message_t message, uint16_t timeout = 0U) {
+        (void)message;
+        (void)timeout;
+        return m_Ring.Header() ? CANERR_NOTSUPP : CANERR_NOTINIT;
+    }
+    /// \brief  reads the next message (copied once from the ring)
+    CANAPI_Return_t ReadMessage(CANAPI_Message_t &message, uint16_t timeout = CANREAD_INFINITE) {
+        CANAPI_Return_t rc = Check();
+        Clock::time_point start = Clock::now();
+        while (rc == CANERR_NOERROR) {
+            const CPeakCANSharedRing::SSlot *slot = Locate();
+            if (slot) {
+                memcpy(&message, &slot->message, sizeof(CANAPI_Message_t));
+                if (!Intact(slot))
+                    continue;  // overwritten while copying
+                m_Cursor++;
+                if (Filtered(message))
+                    continue;
+                m_Received++;
+                return message.sts ? CANERR_ERR_FRAME : CANERR_NOERROR;
+            }
+            rc = Await(timeout, start);
+        }
+        return rc;
+    }
+    /// \brief  returns the next message in place (zero copy)
+    /// \note   The message stays in the ring until ReleaseMessage is called;
+    ///         meanwhile it can be overwritten by the publisher, which is then
+    ///         reported by ReleaseMessage (CANERR_MSG_LST: discard what has been
+    ///         read). While a message is held the same message is returned.
+    CANAPI_Return_t AcquireMessage(const CANAPI_Message_t *&message, uint16_t timeout = CANREAD_INFINITE) {
+        CANAPI_Return_t rc = Check();
+        Clock::time_point start = Clock::now();
+        while (rc == CANERR_NOERROR) {
+            const CPeakCANSharedRing::SSlot *slot = m_pHeld ? m_pHeld : Locate();
+            if (slot) {
+                bool filtered = Filtered(slot->message);
+                if (!Intact(slot)) {
+                    m_pHeld = NULL;
+                    continue;  // overwritten meanwhile
+                }
+                if (filtered) {
+                    m_Cursor++;
+                    continue;
+                }
+                m_pHeld = slot;
+                message = &slot->message;
+                return slot->message.sts ? CANERR_ERR_FRAME : CANERR_NOERROR;
+            }
+            rc = Await(timeout, start);
+        }
+        return rc;
+    }
+    /// \brief  releases the message returned by AcquireMessage
+    CANAPI_Return_t ReleaseMessage() {
+        if (!m_pHeld)
+            return CANERR_ILLPARA;
+        bool intact = Intact(m_pHeld);
+        m_pHeld = NULL;
+        if (!intact)
+            return CANERR_MSG_LST;  // the next read resynchronizes
+        m_Cursor++;
+        m_Received++;
+        return CANERR_NOERROR;
+    }
+    /// \brief  status of the channel (queue_overrun: messages lost by this client)
+    CANAPI_Return_t GetStatus(CANAPI_Status_t &status) {
+        if (!m_Ring.Header())
+            return CANERR_NOTINIT;
+        status.byte = m_Ring.Header()->u8Status.load(std::memory_order_relaxed);
+        if (!m_Started || !m_Ring.Header()->u32Online.load(std::memory_order_acquire))
+            status.can_stopped = 1;
+        if (m_Overrun)
+            status.queue_overrun = 1;
+        m_Overrun = false;
+        return CANERR_NOERROR;
+    }
+    CANAPI_Return_t GetBusLoad(uint8_t &load) {
+        if (!m_Ring.Header())
+            return CANERR_NOTINIT;
+        load = m_Ring.Header()->u8BusLoad.load(std::memory_order_relaxed);
+        return CANERR_NOERROR;
+    }
+    CANAPI_Return_t GetBitrate(CANAPI_Bitrate_t &bitrate) {
+        if (!m_Ring.Header())
+            return CANERR_NOTINIT;
+        bitrate = m_Ring.Header()->bitrate;
+        return CANERR_NOERROR;
+    }
+    CANAPI_Return_t GetBusSpeed(CANAPI_BusSpeed_t &speed) {
+        if (!m_Ring.Header())
+            return CANERR_NOTINIT;
+        speed = m_Ring.Header()->speed;
+        return CANERR_NOERROR;
+    }
+    /// \brief  supported: operation mode, bit-rate, bus speed, status, bus load,
+    ///         receive counter, size of the ring and number of lost messages
+    CANAPI_Return_t GetProperty(uint16_t param, void *value, uint32_t nbyte) {
+        CPeakCANSharedRing::SHeader *header = m_Ring.Header();
+        if (!header)
+            return CANERR_NOTINIT;
+        if (!value)
+            return CANERR_NULLPTR;
+        switch (param) {
+        case CANPROP_GET_OP_MODE:
+            return Copy(value, nbyte, &header->opMode.byte, sizeof(uint8_t));
+        case CANPROP_GET_BITRATE:
+            return Copy(value, nbyte, &header->bitrate, sizeof(CANAPI_Bitrate_t));
+        case CANPROP_GET_SPEED:
+            return Copy(value, nbyte, &header->speed, sizeof(CANAPI_BusSpeed_t));
+        case CANPROP_GET_STATUS: {
+            uint8_t status = header->u8Status.load(std::memory_order_relaxed);
+            return Copy(value, nbyte, &status, sizeof(uint8_t)); }
+        case CANPROP_GET_BUSLOAD: {
+            uint8_t load = header->u8BusLoad.load(std::memory_order_relaxed);
+            return Copy(value, nbyte, &load, sizeof(uint8_t)); }
+        case CANPROP_GET_RX_COUNTER:
+            return Copy(value, nbyte, &m_Received, sizeof(uint64_t));
+        case CANPROP_GET_RCV_QUEUE_MAX:
+            return Copy(value, nbyte, &header->u32Slots, sizeof(uint32_t));
+        case CANPROP_GET_RCV_QUEUE_OVFL:
+            return Copy(value, nbyte, &m_Lost, sizeof(uint64_t));
+        default:
+            return CANERR_NOTSUPP;
+        }
+    }
+    CANAPI_Return_t SetProperty(uint16_t param, const void *value, uint32_t nbyte) {
+        (void)param;
+        (void)value;
+        (void)nbyte;
+        return m_Ring.Header() ? CANERR_NOTSUPP : CANERR_NOTINIT;
+    }
+    char *GetHardwareVersion() { return m_Ring.Header() ? m_szHardware : NULL; }
+    char *GetFirmwareVersion() { return m_Ring.Header() ? m_szFirmware : NULL; }
+
+    /// \brief  number of messages lost by overruns
+    uint64_t GetLost() const { return m_Lost; }
+private:
+    CANAPI_Return_t Check() const {
+        if (!m_Ring.Header())
+            return CANERR_NOTINIT;
+        if (!m_Started)
+            return CANERR_OFFLINE;
+        return CANERR_NOERROR;
+    }
+    /// \brief  slot of the message at the cursor, or NULL when there is none
+    const CPeakCANSharedRing::SSlot *Locate() {
+        for (;;) {
+            uint64_t head = m_Ring.Header()->u64Head.load();
+            if (m_Cursor >= head)
+                return NULL;
+            if ((head - m_Cursor) <= (m_Mask + 1U)) {
+                const CPeakCANSharedRing::SSlot *slot = &m_pSlots[m_Cursor & m_Mask];
+                if (slot->u64Sequence.load(std::memory_order_acquire) == (m_Cursor + 1U))
+                    return slot;
+            }
+            // lapped by the publisher: resume half a ring behind it
+            uint64_t next = head - ((m_Mask + 1U) >> 1);
+            if (next <= m_Cursor)
+                next = m_Cursor + 1U;
+            m_Lost += next - m_Cursor;
+            m_Cursor = next;
+            m_Overrun = true;
+        }
+    }
+    /// \brief  true when the slot still holds the message at the cursor
+    bool Intact(const CPeakCANSharedRing::SSlot *slot) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return (slot->u64Sequence.load(std::memory_order_relaxed) == (m_Cursor + 1U));
+    }
+    bool Filtered(const CANAPI_Message_t &message) const {
+        if (message.sts)
+            return !m_OpMode.err;
+        return (message.xtd && m_OpMode.nxtd) || (message.rtr && m_OpMode.nrtr);
+    }
+    /// \brief  waits for new messages; returns CANERR_NOERROR to read again
+    CANAPI_Return_t Await(uint16_t timeout, Clock::time_point start) {
+        CPeakCANSharedRing::SHeader *header = m_Ring.Header();
+        if (!header->u32Online.load(std::memory_order_acquire) && (m_Cursor >= header->u64Head.load()))
+            return CANERR_OFFLINE;  // publisher gone
+        if (!timeout)
+            return CANERR_RX_EMPTY;
+        uint32_t remaining = CANREAD_INFINITE;
+        if (timeout != CANREAD_INFINITE) {
+            int64_t elapsed = (int64_t)std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+            if (elapsed >= (int64_t)timeout)
+                return CANERR_RX_EMPTY;
+            remaining = (uint32_t)((int64_t)timeout - elapsed);
+        }
+        header->u32Waiters.fetch_add(1U);  // announce, then re-check (see Wake)
+        if (m_Cursor < header->u64Head.load()) {
+            m_Ring.Withdraw();
+            return CANERR_NOERROR;
+        }
+#if defined(_WIN32) || defined(_WIN64)
+        void *signal = (void*)m_hSignal;
+#else
+        void *signal = (void*)&m_Signal;
+#endif
+        return m_Ring.Wait(remaining, signal) ? CANERR_NOERROR : CANERR_RX_EMPTY;
+    }
+    static CANAPI_Return_t Copy(void *value, uint32_t nbyte, const void *source, size_t size) {
+        if (nbyte < size)
+            return CANERR_ILLPARA;
+        memcpy(value, source, size);
+        return CANERR_NOERROR;
+    }
+};
+/// \}
+
+#endif // PEAKCAN_SHARED_H_INCLUDED
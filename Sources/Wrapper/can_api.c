@@ -86,6 +86,7 @@ static const char version[] = "CAN API V3 for PEAK PCAN Interfaces, Version " VE
 #endif
 #include "can_defs.h"
 #include "can_api.h"
+#include "can_btr.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -104,7 +105,14 @@ static const char version[] = "CAN API V3 for PEAK PCAN Interfaces, Version " VE
 #ifndef PCAN_MAX_HANDLES
 #define PCAN_MAX_HANDLES        (16)    // maximum number of open handles
 #endif
+#ifndef PCAN_MAX_EVENTS
+#define PCAN_MAX_EVENTS         (64)    // size of the event queue (power of 2)
+#endif
+#define PCAN_MAX_SELECT         (32)    // maximum number of handles for can_select
 #define INVALID_HANDLE          (-1)
+#define PCAN_STATUS_MASK        (PCAN_ERROR_ANYBUSERR | \
+                                 PCAN_ERROR_OVERRUN | PCAN_ERROR_QOVERRUN | \
+                                 PCAN_ERROR_XMTFULL | PCAN_ERROR_QXMTFULL)
 #define IS_HANDLE_VALID(hnd)    ((0 <= (hnd)) && ((hnd) < PCAN_MAX_HANDLES))
 #ifndef DLC2LEN
 #define DLC2LEN(x)              dlc_table[(x) & 0xF]
@@ -135,6 +143,21 @@ typedef struct {                        // frame conters:
     uint64_t err;                       //   number of receiced error frames
 }   can_counter_t;
 
+typedef struct {                        // event queue:
+    can_event_t fifo[PCAN_MAX_EVENTS];  //   ring-buffer of events
+    volatile uint32_t head;             //   write index (by can_read)
+    volatile uint32_t tail;             //   read index (by can_event)
+    TPCANStatus overrun;                //   overrun reported by CAN_Read[FD]
+}   can_queue_t;
+
+typedef struct {                        // status cache:
+    volatile LONG errors;               //   PCAN status (CAN_GetStatus or status frame)
+    volatile DWORD time;                //   time of the last update (tick count in [ms])
+    volatile LONG valid;                //   flag: cache valid (since can_start)
+    volatile LONG generation;           //   incremented by can_start and can_exit
+    DWORD max_age;                      //   max. age of the cached status in [ms]
+}   can_cache_t;
+
 typedef struct {                        // PCAN interface:
     TPCANHandle board;                  //   board hardware channel handle
     BYTE  brd_type;                     //   board type (none PnP hardware)
@@ -146,6 +169,8 @@ typedef struct {                        // PCAN interface:
     can_mode_t mode;                    //   operation mode of the CAN channel
     can_status_t status;                //   8-bit status register
     can_counter_t counters;             //   statistical counters
+    can_queue_t events;                 //   bus state changes, error frames
+    can_cache_t cache;                  //   last known bus status
 }   can_interface_t;
 
 
@@ -154,6 +179,13 @@ typedef struct {                        // PCAN interface:
 
 static int pcan_error(TPCANStatus);     // PCAN specific errors
 static TPCANStatus pcan_capability(TPCANHandle board, can_mode_t *capability);
+static void pcan_status(int handle, BYTE errors, const can_timestamp_t *timestamp);
+static void pcan_errframe(int handle, DWORD id, const BYTE *data, const can_timestamp_t *timestamp);
+static void pcan_event(int handle, uint8_t type, uint32_t flags, uint8_t rx_err, uint8_t tx_err, const can_timestamp_t *timestamp);
+
+static void cache_status(int handle, TPCANStatus errors);
+static int refresh_status(DWORD interval);
+static DWORD WINAPI refresh_thread(LPVOID arg);
 
 static int bitrate2register(const can_bitrate_t *bitrate, TPCANBaudrate *btr0btr1);
 static int register2bitrate(const TPCANBaudrate btr0btr1, can_bitrate_t *bitrate);
@@ -194,6 +226,11 @@ static const uint8_t dlc_table[16] = {  // DLC to length
 };
 static can_interface_t can[PCAN_MAX_HANDLES]; // interface handles
 static int init = 0;                    // initialization flag
+static struct {                         // status refresh thread:
+    HANDLE thread;                      //   thread handle
+    HANDLE stop;                        //   event to stop the thread
+    volatile DWORD interval;            //   refresh interval in [ms]
+}   refresher = { NULL, NULL, 0U };
 
 
 /*  -----------  functions  ----------------------------------------------
@@ -224,6 +261,13 @@ int can_test(int32_t board, uint8_t mode, const void *param, int *result)
             can[i].counters.tx = 0ull;
             can[i].counters.rx = 0ull;
             can[i].counters.err = 0ull;
+            can[i].events.head = 0U;
+            can[i].events.tail = 0U;
+            can[i].events.overrun = PCAN_ERROR_OK;
+            can[i].cache.errors = PCAN_ERROR_OK;
+            can[i].cache.time = 0U;
+            can[i].cache.valid = 0;
+            can[i].cache.max_age = PCAN_STATUS_MAX_AGE;
         }
         init = 1;                       //   set initialization flag
     }
@@ -289,6 +333,13 @@ int can_init(int32_t board, uint8_t mode, const void *param)
             can[i].counters.tx = 0ull;
             can[i].counters.rx = 0ull;
             can[i].counters.err = 0ull;
+            can[i].events.head = 0U;
+            can[i].events.tail = 0U;
+            can[i].events.overrun = PCAN_ERROR_OK;
+            can[i].cache.errors = PCAN_ERROR_OK;
+            can[i].cache.time = 0U;
+            can[i].cache.valid = 0;
+            can[i].cache.max_age = PCAN_STATUS_MAX_AGE;
         }
         init = 1;                       //   set initialization flag
     }
@@ -316,7 +367,7 @@ int can_init(int32_t board, uint8_t mode, const void *param)
         NULL,                           //   default security attributes
         FALSE,                          //   auto-reset event
         FALSE,                          //   initial state is nonsignaled
-        TEXT("PCANBasic")               //   object name
+        NULL                            //   no name (one object per channel)
       )) == NULL) {
         return SYSERR_OFFSET - (int)GetLastError();
     }
@@ -376,6 +427,8 @@ int can_exit(int handle)
         if((rc = CAN_Uninitialize(can[handle].board)) != PCAN_ERROR_OK)
             return pcan_error(rc);
 
+        (void)InterlockedIncrement(&can[handle].cache.generation); // discard a refresh in progress
+        can[handle].cache.valid = 0;
         can[handle].status.byte |= CANSTAT_RESET;  // CAN controller in INIT state
         can[handle].board = PCAN_NONEBUS; // handle can be used again
 
@@ -387,6 +440,7 @@ int can_exit(int handle)
 #endif
     }
     else {
+        (void)refresh_status(0U);       // stop the status refresh thread (before the teardown)
         for(i = 0; i < PCAN_MAX_HANDLES; i++) {
             if(can[i].board != PCAN_NONEBUS) // must be an opened handle
             {
@@ -529,6 +583,11 @@ int can_start(int handle, const can_bitrate_t *bitrate)
     can[handle].counters.tx = 0ull;
     can[handle].counters.rx = 0ull;
     can[handle].counters.err = 0ull;
+    can[handle].events.head = 0U;       // discard old events
+    can[handle].events.tail = 0U;
+    can[handle].events.overrun = PCAN_ERROR_OK;
+    (void)InterlockedIncrement(&can[handle].cache.generation); // discard a refresh in progress
+    can[handle].cache.valid = 0;        // status not read so far
     can[handle].status.can_stopped = 0; // CAN controller started!
 
     return CANERR_NOERROR;
@@ -651,6 +710,7 @@ int can_read(int handle, can_msg_t *msg, uint16_t timeout)
     TPCANTimestamp timestamp;           // time stamp (CAN 2.0)
     TPCANMsgFD can_msg_fd;              // the message (CAN FD)
     TPCANTimestampFD timestamp_fd;      // time stamp (CAN FD)
+    can_timestamp_t ts;                 // time stamp (CAN API)
     uint64_t msec;                      // milliseconds
     TPCANStatus rc;                     // return value
 
@@ -711,15 +771,16 @@ int can_read(int handle, can_msg_t *msg, uint16_t timeout)
         return pcan_error(rc);          //   something's wrong
     }
     if(!can[handle].mode.fdoe) {        // CAN 2.0 message:
+        msec = ((uint64_t)timestamp.millis_overflow << 32) + (uint64_t)timestamp.millis;
+        ts.tv_sec = (time_t)(msec / 1000ull);
+        ts.tv_nsec = ((((long)(msec % 1000ull)) * 1000L) + (long)timestamp.micros) * (long)1000;
         if((can_msg.MSGTYPE & PCAN_MESSAGE_STATUS)) {
-            can[handle].status.bus_off = (can_msg.DATA[3] & PCAN_ERROR_BUSOFF) != PCAN_ERROR_OK;
-            can[handle].status.bus_error = (can_msg.DATA[3] & PCAN_ERROR_BUSPASSIVE) != PCAN_ERROR_OK;
-            can[handle].status.warning_level = (can_msg.DATA[3] & PCAN_ERROR_BUSWARNING) != PCAN_ERROR_OK;
-            can[handle].status.message_lost |= (can_msg.DATA[3] & PCAN_ERROR_OVERRUN) != PCAN_ERROR_OK;
+            pcan_status(handle, can_msg.DATA[3], &ts);
             can[handle].status.receiver_empty = 1;
             return CANERR_RX_EMPTY;     //   receiver empty
         }
         if((can_msg.MSGTYPE & PCAN_MESSAGE_ERRFRAME))  {
+            pcan_errframe(handle, can_msg.ID, can_msg.DATA, &ts);
             can[handle].status.receiver_empty = 1;
             can[handle].counters.err++;
             return CANERR_ERR_FRAME;    //   error frame received
@@ -732,20 +793,18 @@ int can_read(int handle, can_msg_t *msg, uint16_t timeout)
         msg->esi = 0;
         msg->dlc = (uint8_t)can_msg.LEN;
         memcpy(msg->data, can_msg.DATA, CAN_MAX_LEN);
-        msec = ((uint64_t)timestamp.millis_overflow << 32) + (uint64_t)timestamp.millis;
-        msg->timestamp.tv_sec = (time_t)(msec / 1000ull);
-        msg->timestamp.tv_nsec = ((((long)(msec % 1000ull)) * 1000L) + (long)timestamp.micros) * (long)1000;
+        msg->timestamp = ts;
     }
     else {                              // CAN FD message:
+        ts.tv_sec = (time_t)(timestamp_fd / 1000000ull);
+        ts.tv_nsec = (long)(timestamp_fd % 1000000ull) * (long)1000;
         if((can_msg_fd.MSGTYPE & PCAN_MESSAGE_STATUS)) {
-            can[handle].status.bus_off = (can_msg_fd.DATA[3] & PCAN_ERROR_BUSOFF) != PCAN_ERROR_OK;
-            can[handle].status.bus_error = (can_msg_fd.DATA[3] & PCAN_ERROR_BUSPASSIVE) != PCAN_ERROR_OK;
-            can[handle].status.warning_level = (can_msg_fd.DATA[3] & PCAN_ERROR_BUSWARNING) != PCAN_ERROR_OK;
-            can[handle].status.message_lost |= (can_msg_fd.DATA[3] & PCAN_ERROR_OVERRUN) != PCAN_ERROR_OK;
+            pcan_status(handle, can_msg_fd.DATA[3], &ts);
             can[handle].status.receiver_empty = 1;
             return CANERR_RX_EMPTY;     //   receiver empty
         }
         if((can_msg_fd.MSGTYPE & PCAN_MESSAGE_ERRFRAME)) {
+            pcan_errframe(handle, can_msg_fd.ID, can_msg_fd.DATA, &ts);
             can[handle].status.receiver_empty = 1;
             can[handle].counters.err++;
             return CANERR_ERR_FRAME;    //   error frame received
@@ -758,8 +817,13 @@ int can_read(int handle, can_msg_t *msg, uint16_t timeout)
         msg->esi = (can_msg_fd.MSGTYPE & PCAN_MESSAGE_ESI) ? 1 : 0;
         msg->dlc = (uint8_t)can_msg_fd.DLC;
         memcpy(msg->data, can_msg_fd.DATA, CANFD_MAX_LEN);
-        msg->timestamp.tv_sec = (time_t)(timestamp_fd / 1000000ull);
-        msg->timestamp.tv_nsec = (long)(timestamp_fd % 1000000ull) * (long)1000;
+        msg->timestamp = ts;
+    }
+    if((rc & (PCAN_ERROR_OVERRUN | PCAN_ERROR_QOVERRUN)) != can[handle].events.overrun) {
+        if((can[handle].events.overrun = rc & (PCAN_ERROR_OVERRUN | PCAN_ERROR_QOVERRUN)) != 0U) {
+            can[handle].status.message_lost = 1;
+            pcan_event(handle, CANEVT_OVERRUN, (uint32_t)rc, 0U, 0U, &ts);
+        }
     }
     can[handle].status.receiver_empty = 0; // message read
     can[handle].counters.rx++;
@@ -767,6 +831,98 @@ int can_read(int handle, can_msg_t *msg, uint16_t timeout)
     return CANERR_NOERROR;
 }
 
+int can_event(int handle, can_event_t *events, uint16_t count)
+{
+    can_queue_t *queue;                 // event queue
+    uint32_t head;                      // write index
+    int n = 0;                          // number of events
+
+    if(!init)                           // must be initialized
+        return CANERR_NOTINIT;
+    if(!IS_HANDLE_VALID(handle))        // must be a valid handle
+        return CANERR_HANDLE;
+    if(can[handle].board == PCAN_NONEBUS) // must be an opened handle
+        return CANERR_HANDLE;
+    if(events == NULL)                  // check for null-pointer
+        return CANERR_NULLPTR;
+
+    /* note: the queue is filled by can_read (one writer) and emptied
+     *       here (one reader), so only the indexes have to be ordered */
+    queue = &can[handle].events;
+    head = queue->head;
+    MemoryBarrier();                    // read events after the index
+    while((queue->tail != head) && (n < (int)count)) {
+        memcpy(&events[n++], &queue->fifo[queue->tail % PCAN_MAX_EVENTS], sizeof(can_event_t));
+        MemoryBarrier();                // release the entry after copying
+        queue->tail++;
+    }
+    if(queue->tail == head)             // queue empty: reset overrun flag
+        can[handle].status.queue_overrun = 0;
+
+    return n;                           // number of events read
+}
+
+int can_select(const int *handles, size_t n, uint16_t timeout, uint32_t *ready_mask)
+{
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE events[PCAN_MAX_SELECT];     // event objects of the handles
+    DWORD result;                       // result of the wait function
+    uint32_t mask = 0U;                 // ready handles
+    int ready = 0;                      // number of ready handles
+    size_t i, j;
+
+    if(!init)                           // must be initialized
+        return CANERR_NOTINIT;
+    if((handles == NULL) || (ready_mask == NULL))
+        return CANERR_NULLPTR;          // check for null-pointer
+    if((n == 0U) || (n > PCAN_MAX_SELECT))
+        return CANERR_ILLPARA;          // 1 .. 32 handles
+    for(i = 0U; i < n; i++) {
+        if(!IS_HANDLE_VALID(handles[i]))  // must be a valid handle
+            return CANERR_HANDLE;
+        if(can[handles[i]].board == PCAN_NONEBUS) // must be an opened handle
+            return CANERR_HANDLE;
+        if(can[handles[i]].status.can_stopped)  // must be running
+            return CANERR_OFFLINE;
+        events[i] = can[handles[i]].event;
+        for(j = 0U; j < i; j++) {       // no handle twice (the wait
+            if(handles[j] == handles[i])  //   function rejects duplicates)
+                return CANERR_ILLPARA;
+        }
+    }
+    *ready_mask = 0U;
+
+    result = WaitForMultipleObjects((DWORD)n, events, FALSE,
+                                    (timeout != CANREAD_INFINITE) ? (DWORD)timeout : INFINITE);
+    if(result == WAIT_TIMEOUT)
+        return 0;                       //   time-out: no handle ready
+    if(/*(WAIT_OBJECT_0 > result) ||*/ (result >= (WAIT_OBJECT_0 + (DWORD)n)))
+        return CANERR_FATAL;            //   function failed!
+    /* note: the wait function reports the first signaled event only, so we
+     *       poll the following ones (this resets them, they are auto-reset) */
+    mask |= (uint32_t)1U << (result - WAIT_OBJECT_0);
+    ready++;
+    for(i = (size_t)(result - WAIT_OBJECT_0) + 1U; i < n; i++) {
+        if(WaitForSingleObject(events[i], 0U) == WAIT_OBJECT_0) {
+            mask |= (uint32_t)1U << i;
+            ready++;
+        }
+    }
+    for(i = 0U; i < n; i++) {           // receiver not empty anymore
+        if((mask & ((uint32_t)1U << i)))
+            can[handles[i]].status.receiver_empty = 0;
+    }
+    *ready_mask = mask;
+    return ready;                       // number of ready handles
+#else
+    (void)handles;
+    (void)n;
+    (void)timeout;
+    (void)ready_mask;
+    return CANERR_NOTSUPP;
+#endif
+}
+
 int can_status(int handle, uint8_t *status)
 {
     TPCANStatus rc;                     // represents a status
@@ -779,11 +935,15 @@ int can_status(int handle, uint8_t *status)
         return CANERR_HANDLE;
 
     if(!can[handle].status.can_stopped) { // when running get bus status
-        rc = CAN_GetStatus(can[handle].board);
-        if((rc & ~(PCAN_ERROR_ANYBUSERR |
-                   PCAN_ERROR_OVERRUN | PCAN_ERROR_QOVERRUN |
-                   PCAN_ERROR_XMTFULL | PCAN_ERROR_QXMTFULL)))
-            return pcan_error(rc);
+        if(!can[handle].cache.valid ||  //   from the driver, when too old
+           ((GetTickCount() - can[handle].cache.time) >= can[handle].cache.max_age)) {
+            rc = CAN_GetStatus(can[handle].board);
+            if((rc & ~PCAN_STATUS_MASK))
+                return pcan_error(rc);
+            cache_status(handle, rc);
+        }
+        else                            //   or the last known status
+            rc = (TPCANStatus)can[handle].cache.errors;
         can[handle].status.bus_off = (rc & PCAN_ERROR_BUSOFF) != PCAN_ERROR_OK;
         can[handle].status.bus_error = (rc & PCAN_ERROR_BUSPASSIVE) != PCAN_ERROR_OK;
         can[handle].status.warning_level = (rc & PCAN_ERROR_BUSWARNING) != PCAN_ERROR_OK;
@@ -986,6 +1146,130 @@ static TPCANStatus pcan_capability(TPCANHandle board, can_mode_t *capability)
     return PCAN_ERROR_OK;
 }
 
+/*  - - - - - -  Status cache  - - - - - - - - - - - - - - - - - - - - -
+ */
+static void cache_status(int handle, TPCANStatus errors)
+{
+    assert(IS_HANDLE_VALID(handle));    // just to make sure
+
+    can[handle].cache.errors = (LONG)(errors & PCAN_STATUS_MASK);
+    MemoryBarrier();                    // status before time-stamp
+    can[handle].cache.time = GetTickCount();
+    can[handle].cache.valid = 1;
+}
+
+static int refresh_status(DWORD interval)
+{
+    refresher.interval = interval;      // note: takes effect with next cycle
+
+    if((interval != 0U) && (refresher.thread == NULL)) {
+        if((refresher.stop = CreateEvent(NULL, TRUE, FALSE, NULL)) == NULL)
+            return SYSERR_OFFSET - (int)GetLastError();
+        if((refresher.thread = CreateThread(NULL, 0, refresh_thread, NULL, 0, NULL)) == NULL) {
+            (void)CloseHandle(refresher.stop);
+            refresher.stop = NULL;
+            return SYSERR_OFFSET - (int)GetLastError();
+        }
+    }
+    else if((interval == 0U) && (refresher.thread != NULL)) {
+        (void)SetEvent(refresher.stop); //   signal the thread to terminate
+        (void)WaitForSingleObject(refresher.thread, INFINITE);
+        (void)CloseHandle(refresher.thread);
+        (void)CloseHandle(refresher.stop);
+        refresher.thread = NULL;
+        refresher.stop = NULL;
+    }
+    return CANERR_NOERROR;
+}
+
+static DWORD WINAPI refresh_thread(LPVOID arg)
+{
+    TPCANHandle board;                  // board hardware channel handle
+    TPCANStatus rc;                     // return value
+    LONG generation;                    // of the cache when the status was requested
+    int i;
+
+    (void)arg;
+    /* note: the thread only stores the driver status in the cache, the status
+     *       register itself is updated by can_status() of the application */
+    while(WaitForSingleObject(refresher.stop, refresher.interval) == WAIT_TIMEOUT) {
+        for(i = 0; i < PCAN_MAX_HANDLES; i++) {
+            generation = can[i].cache.generation;
+            MemoryBarrier();            // generation before the board
+            board = can[i].board;
+            if((board != PCAN_NONEBUS) && !can[i].status.can_stopped) {
+                rc = CAN_GetStatus(board);
+                if(!(rc & ~PCAN_STATUS_MASK)) {
+                    cache_status(i, rc);
+                    MemoryBarrier();    // valid before the generation
+                    if(can[i].cache.generation != generation)
+                        can[i].cache.valid = 0; // restarted or closed meanwhile
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+/*  - - - - - -  Event queue  - - - - - - - - - - - - - - - - - - - - - -
+ */
+static void pcan_status(int handle, BYTE errors, const can_timestamp_t *timestamp)
+{
+    can_status_t status;                // previous status
+    uint8_t type = 0U;                  // event type
+
+    assert(IS_HANDLE_VALID(handle));    // just to make sure
+
+    cache_status(handle, (TPCANStatus)errors);
+    status.byte = can[handle].status.byte;
+    can[handle].status.bus_off = (errors & PCAN_ERROR_BUSOFF) != PCAN_ERROR_OK;
+    can[handle].status.bus_error = (errors & PCAN_ERROR_BUSPASSIVE) != PCAN_ERROR_OK;
+    can[handle].status.warning_level = (errors & PCAN_ERROR_BUSWARNING) != PCAN_ERROR_OK;
+    can[handle].status.message_lost |= (errors & PCAN_ERROR_OVERRUN) != PCAN_ERROR_OK;
+
+    if((status.byte ^ can[handle].status.byte) & (CANSTAT_BOFF | CANSTAT_EWRN | CANSTAT_BERR))
+        type |= CANEVT_BUS_STATE;       // bus state changed
+    if((errors & PCAN_ERROR_OVERRUN))
+        type |= CANEVT_OVERRUN;         // message lost
+    if(type)
+        pcan_event(handle, type, (uint32_t)errors, 0U, 0U, timestamp);
+}
+
+static void pcan_errframe(int handle, DWORD id, const BYTE *data, const can_timestamp_t *timestamp)
+{
+    assert(IS_HANDLE_VALID(handle));    // just to make sure
+    assert(data);
+
+    /* PCAN error frame: ID = error type, DATA[0] = direction (Rx/Tx),
+     * DATA[1] = error code capture, DATA[2..3] = Rx/Tx error counter */
+    pcan_event(handle, CANEVT_ERR_FRAME, ((uint32_t)id << 16) | ((uint32_t)data[0] << 8) | (uint32_t)data[1],
+               data[2], data[3], timestamp);
+}
+
+static void pcan_event(int handle, uint8_t type, uint32_t flags, uint8_t rx_err, uint8_t tx_err, const can_timestamp_t *timestamp)
+{
+    can_queue_t *queue;                 // event queue
+    can_event_t *event;                 // next free entry
+
+    assert(IS_HANDLE_VALID(handle));    // just to make sure
+    assert(timestamp);
+
+    queue = &can[handle].events;
+    if((uint32_t)(queue->head - queue->tail) >= (uint32_t)PCAN_MAX_EVENTS) {
+        can[handle].status.queue_overrun = 1;
+        return;                         // queue full: event discarded
+    }
+    event = &queue->fifo[queue->head % PCAN_MAX_EVENTS];
+    event->type = type;
+    event->status = can[handle].status.byte;
+    event->rx_err = rx_err;
+    event->tx_err = tx_err;
+    event->flags = flags;
+    event->timestamp = *timestamp;
+    MemoryBarrier();                    // publish the entry before the index
+    queue->head++;
+}
+
 static int index2bitrate(int index, can_bitrate_t *bitrate)
 {
     TPCANBaudrate btr0btr1 = 0x0000u;
@@ -1047,79 +1331,36 @@ static int register2bitrate(const TPCANBaudrate btr0btr1, can_bitrate_t *bitrate
 
 static int bitrate2string(const can_bitrate_t *bitrate, TPCANBitrateFD string, int brse)
 {
-    if((bitrate->btr.nominal.brp < CANBTR_NOMINAL_BRP_MIN) || (CANBTR_NOMINAL_BRP_MAX < bitrate->btr.nominal.brp))
-        return CANERR_BAUDRATE;
-    if((bitrate->btr.nominal.tseg1 < CANBTR_NOMINAL_TSEG1_MIN) || (CANBTR_NOMINAL_TSEG1_MAX < bitrate->btr.nominal.tseg1))
-        return CANERR_BAUDRATE;
-    if((bitrate->btr.nominal.tseg2 < CANBTR_NOMINAL_TSEG2_MIN) || (CANBTR_NOMINAL_TSEG2_MAX < bitrate->btr.nominal.tseg2))
-        return CANERR_BAUDRATE;
-    if((bitrate->btr.nominal.sjw < CANBTR_NOMINAL_SJW_MIN) || (CANBTR_NOMINAL_SJW_MAX < bitrate->btr.nominal.sjw))
-        return CANERR_BAUDRATE;
+    can_bitrate_t temporary;            // bit-rate settings
+
+    memcpy(&temporary, bitrate, sizeof(can_bitrate_t));
     if(!brse) {     // long frames only
-        if(sprintf(string, "f_clock=%i,nom_brp=%u,nom_tseg1=%u,nom_tseg2=%u,nom_sjw=%u,nom_sam=%u",
-                            bitrate->btr.frequency,
-                            bitrate->btr.nominal.brp,
-                            bitrate->btr.nominal.tseg1,
-                            bitrate->btr.nominal.tseg2,
-                            bitrate->btr.nominal.sjw,
-                            bitrate->btr.nominal.sam) < 0)
-            return CANERR_BAUDRATE;
-    }
-    else {          // long and fast frames
-        if((bitrate->btr.data.brp < CANBTR_DATA_BRP_MIN) || (CANBTR_DATA_BRP_MAX < bitrate->btr.data.brp))
-            return CANERR_BAUDRATE;
-        if((bitrate->btr.data.tseg1 < CANBTR_DATA_TSEG1_MIN) || (CANBTR_DATA_TSEG1_MAX < bitrate->btr.data.tseg1))
-            return CANERR_BAUDRATE;
-        if((bitrate->btr.data.tseg2 < CANBTR_DATA_TSEG2_MIN) || (CANBTR_DATA_TSEG2_MAX < bitrate->btr.data.tseg2))
-            return CANERR_BAUDRATE;
-        if((bitrate->btr.data.sjw < CANBTR_DATA_SJW_MIN) || (CANBTR_DATA_SJW_MAX < bitrate->btr.data.sjw))
-            return CANERR_BAUDRATE;
-        if(sprintf(string, "f_clock=%i,nom_brp=%u,nom_tseg1=%u,nom_tseg2=%u,nom_sjw=%u,nom_sam=%u,"
-                                     "data_brp=%u,data_tseg1=%u,data_tseg2=%u,data_sjw=%u",
-                            bitrate->btr.frequency,
-                            bitrate->btr.nominal.brp,
-                            bitrate->btr.nominal.tseg1,
-                            bitrate->btr.nominal.tseg2,
-                            bitrate->btr.nominal.sjw,
-                            bitrate->btr.nominal.sam,
-                            bitrate->btr.data.brp,
-                            bitrate->btr.data.tseg1,
-                            bitrate->btr.data.tseg2,
-                            bitrate->btr.data.sjw) < 0)
-            return CANERR_BAUDRATE;
+        temporary.btr.data.brp = 0;
+        temporary.btr.data.tseg1 = 0;
+        temporary.btr.data.tseg2 = 0;
+        temporary.btr.data.sjw = 0;
     }
+    /* note: the conversion is cached, so restarting with the same settings is cheap */
+    if(btr_bitrate2string(&temporary, brse ? true : false, (btr_string_t)string) != BTRERR_NOERROR)
+        return CANERR_BAUDRATE;
     return CANERR_NOERROR;
 }
 
 static int string2bitrate(const TPCANBitrateFD string, can_bitrate_t *bitrate, int brse)
 {
-    long unsigned freq = 0;
-    int unsigned nom_brp = 0, nom_tseg1 = 0, nom_tseg2 = 0, nom_sjw = 0/*, nom_sam = 0*/;
-    int unsigned data_brp = 0, data_tseg1 = 0, data_tseg2 = 0, data_sjw = 0/*, data_ssp_offset = 0*/;
-
-    // TODO: rework this!
-    if(sscanf(string, "f_clock=%lu,nom_brp=%u,nom_tseg1=%u,nom_tseg2=%u,nom_sjw=%u,"
-                                 "data_brp=%u,data_tseg1=%u,data_tseg2=%u,data_sjw=%u",
-                           &freq, &nom_brp, &nom_tseg1, &nom_tseg2, &nom_sjw,
-                                 &data_brp, &data_tseg1, &data_tseg2, &data_sjw) != 9)
+    can_bitrate_t temporary;            // bit-rate settings
+    bool data = false;                  // data bit-rate settings
+
+    /* note: the conversion is cached, so reading back the same settings is cheap */
+    if(btr_string2bitrate((btr_string_t)string, &temporary, &data) != BTRERR_NOERROR)
         return CANERR_BAUDRATE;
-    bitrate->btr.frequency = (int32_t)freq;
-    bitrate->btr.nominal.brp = (uint16_t)nom_brp;
-    bitrate->btr.nominal.tseg1 = (uint16_t)nom_tseg1;
-    bitrate->btr.nominal.tseg2 = (uint16_t)nom_tseg2;
-    bitrate->btr.nominal.sjw = (uint16_t)nom_sjw;
-    if(brse) {
-        bitrate->btr.data.brp = (uint16_t)data_brp;
-        bitrate->btr.data.tseg1 = (uint16_t)data_tseg1;
-        bitrate->btr.data.tseg2 = (uint16_t)data_tseg2;
-        bitrate->btr.data.sjw = (uint16_t)data_sjw;
-    }
-    else {
-        bitrate->btr.data.brp = (uint16_t)0;
-        bitrate->btr.data.tseg1 = (uint16_t)0;
-        bitrate->btr.data.tseg2 = (uint16_t)0;
-        bitrate->btr.data.sjw = (uint16_t)0;
+    if(!brse || !data) {
+        temporary.btr.data.brp = (uint16_t)0;
+        temporary.btr.data.tseg1 = (uint16_t)0;
+        temporary.btr.data.tseg2 = (uint16_t)0;
+        temporary.btr.data.sjw = (uint16_t)0;
     }
+    memcpy(bitrate, &temporary, sizeof(can_bitrate_t));
     return CANERR_NOERROR;
 }
 
@@ -1194,6 +1435,17 @@ static int lib_parameter(uint16_t param, void *value, size_t nbyte)
             rc = CANERR_NOERROR;
         }
         break;
+    case CANPROP_GET_VENDOR_PROP + PCAN_PROP_STATUS_REFRESH:  // refresh interval of the status thread in [ms] (uint32_t)
+        if(nbyte >= sizeof(uint32_t)) {
+            *(uint32_t*)value = (uint32_t)refresher.interval;
+            rc = CANERR_NOERROR;
+        }
+        break;
+    case CANPROP_SET_VENDOR_PROP + PCAN_PROP_STATUS_REFRESH:  // set refresh interval of the status thread in [ms] (uint32_t)
+        if(nbyte >= sizeof(uint32_t)) {
+            rc = refresh_status((DWORD)*(uint32_t*)value);
+        }
+        break;
     case CANPROP_SET_FIRST_CHANNEL:     // set index to the first entry in the interface list (NULL)
         idx_board = 0;
         rc = (can_boards[idx_board].type != EOF) ? CANERR_NOERROR : CANERR_RESOURCE;
@@ -1379,6 +1631,43 @@ static int drv_parameter(int handle, uint16_t param, void *value, size_t nbyte)
             rc = CANERR_NOERROR;
         }
         break;
+    case CANPROP_GET_VENDOR_PROP + PCAN_PROP_STATUS_AGE:  // age of the cached status register in [ms] (uint32_t)
+        if(nbyte >= sizeof(uint32_t)) {
+            if(can[handle].cache.valid && !can[handle].status.can_stopped)
+                *(uint32_t*)value = (uint32_t)(GetTickCount() - can[handle].cache.time);
+            else
+                *(uint32_t*)value = (uint32_t)PCAN_STATUS_AGE_UNKNOWN;
+            rc = CANERR_NOERROR;
+        }
+        break;
+    case CANPROP_GET_VENDOR_PROP + PCAN_PROP_STATUS_MAX_AGE:  // max. age of the cached status register in [ms] (uint32_t)
+        if(nbyte >= sizeof(uint32_t)) {
+            *(uint32_t*)value = (uint32_t)can[handle].cache.max_age;
+            rc = CANERR_NOERROR;
+        }
+        break;
+    case CANPROP_SET_VENDOR_PROP + PCAN_PROP_STATUS_MAX_AGE:  // set max. age of the cached status register in [ms] (uint32_t)
+        if(nbyte >= sizeof(uint32_t)) {
+            can[handle].cache.max_age = (DWORD)*(uint32_t*)value;
+            rc = CANERR_NOERROR;
+        }
+        break;
+    case CANPROP_GET_VENDOR_PROP + PCAN_PROP_STATUS_REFRESH:  // refresh interval of the status thread in [ms] (uint32_t)
+    case CANPROP_SET_VENDOR_PROP + PCAN_PROP_STATUS_REFRESH:  // set refresh interval of the status thread in [ms] (uint32_t)
+        rc = lib_parameter(param, value, nbyte);
+        break;
+    case CANPROP_GET_VENDOR_PROP + PCAN_PROP_RX_EVENT:  // event object signaled on message reception (void*)
+        /* note: it is an auto-reset event, so after it was signaled the receive
+         *       queue has to be read with can_read(handle, msg, 0) until empty */
+        if(nbyte >= sizeof(void*)) {
+#if defined(_WIN32) || defined(_WIN64)
+            *(void**)value = (void*)can[handle].event;
+            rc = CANERR_NOERROR;
+#else
+            rc = CANERR_NOTSUPP;
+#endif
+        }
+        break;
     default:
         if((CANPROP_GET_VENDOR_PROP <= param) &&  // get a vendor-specific property value (void*)
            (param < (CANPROP_GET_VENDOR_PROP + CANPROP_VENDOR_PROP_RANGE))) {
@@ -0,0 +1,169 @@
+/*  -- $HeadURL$ --
+ *
+ *  project   :  CAN - Controller Area Network
+ *
+ *  purpose   :  CAN API V3 Bit-rate Conversion (Microbenchmark)
+ *
+ *  copyright :  (C) 2021, UV Software, Berlin
+ *
+ *  compiler  :  Microsoft Visual C/C++ Compiler (Version 19.16)
+ *
+ *  syntax    :  <program> [<loops>]
+ *
+ *  libraries :  (none)
+ *
+ *  includes  :  can_btr.h
+ *
+ *  author    :  Uwe Vogt, UV Software
+ *
+ *  e-mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *  -----------  description  --------------------------------------------
+ *
+ *  Measures the string <-> bit-rate conversion of module can_btr with a
+ *  repeated configuration (hits in the conversion cache) and with more
+ *  configurations than cache entries (always a miss), and compares it
+ *  with the sscanf/sprintf conversion formerly used by the wrapper.
+ */
+
+/*  -----------  includes  -----------------------------------------------
+ */
+
+#include "can_btr.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <time.h>
+#else
+#include <windows.h>
+#endif
+#include <inttypes.h>
+
+
+/*  -----------  defines  ------------------------------------------------
+ */
+
+#define DEFAULT_LOOPS       1000000
+#define CONFIGURATIONS      64          // more than the cache entries
+
+
+/*  -----------  prototypes  ---------------------------------------------
+ */
+
+static uint64_t nanoseconds(void);
+static void report(const char *title, uint64_t elapsed, long loops, int errors);
+
+
+/*  -----------  variables  ----------------------------------------------
+ */
+
+static char strings[CONFIGURATIONS][BTR_STRING_LENGTH];
+static btr_bitrate_t bitrates[CONFIGURATIONS];
+
+
+/*  -----------  functions  ----------------------------------------------
+ */
+
+int main(int argc, char *argv[])
+{
+    char string[BTR_STRING_LENGTH];
+    btr_bitrate_t bitrate;
+    bool brse;
+    unsigned int freq, brp, tseg1, tseg2, sjw, dbrp, dtseg1, dtseg2, dsjw;
+    long loops = DEFAULT_LOOPS, n;
+    uint64_t start;
+    int errors, i;
+
+    if((argc > 1) && ((loops = strtol(argv[1], NULL, 10)) <= 0)) {
+        fprintf(stderr, "Usage: %s [<loops>]\n", argv[0]);
+        return 1;
+    }
+    /* CAN FD configurations @ 80MHz with different nominal prescaler */
+    for(i = 0; i < CONFIGURATIONS; i++) {
+        memset(&bitrates[i], 0, sizeof(btr_bitrate_t));
+        bitrates[i].btr.frequency = BTR_FREQ_80MHz;
+        bitrates[i].btr.nominal.brp = (uint16_t)(i + 1);
+        bitrates[i].btr.nominal.tseg1 = 63;
+        bitrates[i].btr.nominal.tseg2 = 16;
+        bitrates[i].btr.nominal.sjw = 16;
+        bitrates[i].btr.data.brp = 2;
+        bitrates[i].btr.data.tseg1 = 7;
+        bitrates[i].btr.data.tseg2 = 2;
+        bitrates[i].btr.data.sjw = 2;
+        if(btr_bitrate2string(&bitrates[i], true, strings[i]) != BTRERR_NOERROR) {
+            fprintf(stderr, "+++ error: configuration %i could not be converted\n", i);
+            return 1;
+        }
+    }
+    fprintf(stdout, "String <-> bit-rate conversion (%li loops, %i configurations):\n", loops, CONFIGURATIONS);
+
+    /* string -> bit-rate */
+    for(n = 0, errors = 0, start = nanoseconds(); n < loops; n++)
+        errors += (btr_string2bitrate(strings[0], &bitrate, &brse) != BTRERR_NOERROR) ? 1 : 0;
+    report("btr_string2bitrate (same)", nanoseconds() - start, loops, errors);
+    for(n = 0, errors = 0, start = nanoseconds(); n < loops; n++)
+        errors += (btr_string2bitrate(strings[n % CONFIGURATIONS], &bitrate, &brse) != BTRERR_NOERROR) ? 1 : 0;
+    report("btr_string2bitrate (various)", nanoseconds() - start, loops, errors);
+    for(n = 0, errors = 0, start = nanoseconds(); n < loops; n++)
+        errors += (sscanf(strings[n % CONFIGURATIONS], "f_clock=%u,nom_brp=%u,nom_tseg1=%u,nom_tseg2=%u,nom_sjw=%u,"
+                                                       "data_brp=%u,data_tseg1=%u,data_tseg2=%u,data_sjw=%u",
+                          &freq, &brp, &tseg1, &tseg2, &sjw, &dbrp, &dtseg1, &dtseg2, &dsjw) != 9) ? 1 : 0;
+    report("sscanf (reference)", nanoseconds() - start, loops, errors);
+
+    /* bit-rate -> string */
+    for(n = 0, errors = 0, start = nanoseconds(); n < loops; n++)
+        errors += (btr_bitrate2string(&bitrates[0], true, string) != BTRERR_NOERROR) ? 1 : 0;
+    report("btr_bitrate2string (same)", nanoseconds() - start, loops, errors);
+    for(n = 0, errors = 0, start = nanoseconds(); n < loops; n++)
+        errors += (btr_bitrate2string(&bitrates[n % CONFIGURATIONS], true, string) != BTRERR_NOERROR) ? 1 : 0;
+    report("btr_bitrate2string (various)", nanoseconds() - start, loops, errors);
+    for(n = 0, errors = 0, start = nanoseconds(); n < loops; n++) {
+        i = (int)(n % CONFIGURATIONS);
+        errors += (sprintf(string, "f_clock=%i,nom_brp=%u,nom_tseg1=%u,nom_tseg2=%u,nom_sjw=%u,"
+                                   "data_brp=%u,data_tseg1=%u,data_tseg2=%u,data_sjw=%u",
+                           bitrates[i].btr.frequency,
+                           bitrates[i].btr.nominal.brp, bitrates[i].btr.nominal.tseg1,
+                           bitrates[i].btr.nominal.tseg2, bitrates[i].btr.nominal.sjw,
+                           bitrates[i].btr.data.brp, bitrates[i].btr.data.tseg1,
+                           bitrates[i].btr.data.tseg2, bitrates[i].btr.data.sjw) < 0) ? 1 : 0;
+    }
+    report("sprintf (reference)", nanoseconds() - start, loops, errors);
+
+    return 0;
+}
+
+/*  -----------  local functions  ----------------------------------------
+ */
+
+static uint64_t nanoseconds(void)
+{
+#if !defined(_WIN32) && !defined(_WIN64)
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * (uint64_t)1000000000) + (uint64_t)ts.tv_nsec;
+#else
+    LARGE_INTEGER frequency, counter;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1000000000.0 / (double)frequency.QuadPart);
+#endif
+}
+
+static void report(const char *title, uint64_t elapsed, long loops, int errors)
+{
+    fprintf(stdout, "  %-30s %8.1f ns/call", title, (double)elapsed / (double)loops);
+    if(errors)
+        fprintf(stdout, " (%i errors)", errors);
+    fprintf(stdout, "\n");
+}
+
+/*  ----------------------------------------------------------------------
+ *  Uwe Vogt,  UV Software,  Chausseestrasse 33 A,  10115 Berlin,  Germany
+ *  Tel.: +49-30-46799872,  Fax: +49-30-46799873,  Mobile: +49-170-3801903
+ *  E-Mail: uwe.vogt@uv-software.de,  Homepage: http://www.uv-software.de/
+ */
@@ -0,0 +1,228 @@
+/*  -- $HeadURL$ --
+ *
+ *  project   :  CAN - Controller Area Network
+ *
+ *  purpose   :  PeakCAN Compact Capture (Benchmark)
+ *
+ *  copyright :  (C) 2021, UV Software, Berlin
+ *
+ *  compiler  :  Microsoft Visual C/C++ Compiler (Version 19.16)
+ *
+ *  syntax    :  <program> [<frames> [<file>]]
+ *
+ *  libraries :  (none)
+ *
+ *  includes  :  PeakCAN_Compact.h
+ *
+ *  author    :  Uwe Vogt, UV Software
+ *
+ *  e-mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *  -----------  description  --------------------------------------------
+ *
+ *  Writes the traffic of a saturated 1 Mbit/s bus (periodic 11-bit and
+ *  29-bit messages with counters, slowly changing signals and a few noisy
+ *  bytes) into a compact capture file, reads it back and compares it with
+ *  the original.  Reported are the encoding cost in the caller's thread,
+ *  the cost including compression and file output, the decoding cost, and
+ *  the file size compared to a binary dump of CANAPI_Message_t.
+ */
+
+/*  -----------  includes  -----------------------------------------------
+ */
+
+#include "PeakCAN_Compact.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <time.h>
+#else
+#include <windows.h>
+#endif
+#include <inttypes.h>
+#include <vector>
+
+
+/*  -----------  defines  ------------------------------------------------
+ */
+
+#define DEFAULT_FRAMES      2000000
+#define DEFAULT_FILE        "cap_bench.pcc"
+#define IDENTIFIERS         48
+#define FRAME_TIME          111         // 8-byte frame @ 1 Mbit/s in [us]
+
+
+/*  -----------  types  --------------------------------------------------
+ */
+
+struct SPeriodic {
+    uint32_t id;
+    bool xtd;
+    uint8_t dlc;
+    uint32_t period;                    // in [us]
+    uint64_t due;                       // in [us]
+    uint8_t data[8];
+};
+
+
+/*  -----------  prototypes  ---------------------------------------------
+ */
+
+static uint64_t nanoseconds(void);
+static uint32_t random32(void);
+static void report(const char *title, uint64_t elapsed, long frames, int errors);
+
+
+/*  -----------  variables  ----------------------------------------------
+ */
+
+static uint32_t seed = 0x2545F491U;
+
+
+/*  -----------  functions  ----------------------------------------------
+ */
+
+int main(int argc, char *argv[])
+{
+    const char *file = DEFAULT_FILE;
+    long frames = DEFAULT_FRAMES, n;
+    std::vector<CANAPI_Message_t> messages;
+    SPeriodic periodic[IDENTIFIERS];
+    CPeakCANCompactWriter writer;
+    CPeakCANCompactWriter::SStatistics statistics;
+    CPeakCANCompactReader reader;
+    CANAPI_Message_t message;
+    uint64_t start, now = 0U;
+    int errors, failed = 0, i, j;
+
+    if((argc > 1) && ((frames = strtol(argv[1], NULL, 10)) <= 0)) {
+        fprintf(stderr, "Usage: %s [<frames> [<file>]]\n", argv[0]);
+        return 1;
+    }
+    if(argc > 2)
+        file = argv[2];
+    /* periodic messages: 10ms to 1s, one in four with a 29-bit identifier */
+    for(i = 0; i < IDENTIFIERS; i++) {
+        periodic[i].xtd = (i % 4) == 3;
+        periodic[i].id = periodic[i].xtd ? (0x18FF0000U | (uint32_t)(i << 8) | 0x21U) : (0x100U + (uint32_t)i * 0x10U);
+        periodic[i].dlc = (i % 8) ? 8U : (uint8_t)(2 + i % 6);
+        periodic[i].period = (i < 16) ? 10000U : (i < 32) ? 20000U : (i < 44) ? 100000U : 1000000U;
+        periodic[i].due = (uint64_t)i * 137U;
+        for(j = 0; j < 8; j++)
+            periodic[i].data[j] = (uint8_t)random32();
+    }
+    /* saturated bus: always the most overdue message, back to back */
+    messages.resize((size_t)frames);
+    for(n = 0; n < frames; n++) {
+        SPeriodic *next = &periodic[0];
+        for(i = 1; i < IDENTIFIERS; i++)
+            if(periodic[i].due < next->due)
+                next = &periodic[i];
+        next->due += next->period;
+        next->data[0]++;                                    // counter
+        if(!(random32() % 16U))
+            next->data[2] += (uint8_t)(random32() % 3U);    // slowly changing signal
+        next->data[7] = (uint8_t)random32();                // checksum (noise)
+        now += FRAME_TIME + (random32() % 8U);              // bit stuffing
+        memset(&message, 0, sizeof(message));
+        message.id = next->id;
+        message.xtd = next->xtd ? 1 : 0;
+        message.dlc = next->dlc;
+        memcpy(message.data, next->data, next->dlc);
+        message.timestamp.tv_sec = (time_t)(now / 1000000U);
+        message.timestamp.tv_nsec = (long)(now % 1000000U) * 1000L;
+        messages[(size_t)n] = message;
+    }
+    fprintf(stdout, "Compact capture of a saturated 1 Mbit/s bus (%li frames, %i identifiers):\n", frames, IDENTIFIERS);
+
+    /* encoding */
+    if(writer.Open(file) != CANERR_NOERROR) {
+        fprintf(stderr, "+++ error: file '%s' could not be created\n", file);
+        return 1;
+    }
+    for(n = 0, errors = 0, start = nanoseconds(); n < frames; n++)
+        errors += (writer.Write(messages[(size_t)n]) != CANERR_NOERROR) ? 1 : 0;
+    report("Write (caller)", nanoseconds() - start, frames, errors);
+    failed += errors;
+    errors = (writer.Close() != CANERR_NOERROR) ? 1 : 0;
+    report("Write + Close (total)", nanoseconds() - start, frames, errors);
+    failed += errors;
+    writer.GetStatistics(statistics);
+
+    /* decoding */
+    if(reader.Open(file) != CANERR_NOERROR) {
+        fprintf(stderr, "+++ error: file '%s' could not be opened\n", file);
+        return 1;
+    }
+    for(n = 0, errors = 0, start = nanoseconds(); n < frames; n++) {
+        if(reader.Read(message) != CANERR_NOERROR) {
+            errors += (int)(frames - n);
+            break;
+        }
+        errors += memcmp(&message, &messages[(size_t)n], sizeof(message)) ? 1 : 0;
+    }
+    report("Read (decode + compare)", nanoseconds() - start, frames, errors);
+    failed += errors;
+    errors = (reader.Read(message) != CANERR_RX_EMPTY) ? 1 : 0;
+    (void)reader.Close();
+    if(errors)
+        fprintf(stdout, "  +++ error: more frames than written\n");
+    failed += errors;
+
+    /* sizes */
+    double dump = (double)frames * (double)sizeof(CANAPI_Message_t);
+    fprintf(stdout, "Sizes:\n");
+    fprintf(stdout, "  %-30s %12.0f bytes (%5.1f bytes/frame)\n", "CANAPI_Message_t dump", dump, dump / (double)frames);
+    fprintf(stdout, "  %-30s %12" PRIu64 " bytes (%5.1f bytes/frame, %5.1fx)\n", "encoded", statistics.u64RawBytes,
+            (double)statistics.u64RawBytes / (double)frames, dump / (double)statistics.u64RawBytes);
+    fprintf(stdout, "  %-30s %12" PRIu64 " bytes (%5.1f bytes/frame, %5.1fx)\n", "compressed (file)", statistics.u64StoredBytes,
+            (double)statistics.u64StoredBytes / (double)frames, dump / (double)statistics.u64StoredBytes);
+    fprintf(stdout, "  %-30s %12" PRIu64 " blocks, %" PRIu64 " stalls\n", "writer thread", statistics.u64Blocks, statistics.u64Stalls);
+    (void)remove(file);
+
+    return failed ? 1 : 0;
+}
+
+/*  -----------  local functions  ----------------------------------------
+ */
+
+static uint64_t nanoseconds(void)
+{
+#if !defined(_WIN32) && !defined(_WIN64)
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * (uint64_t)1000000000) + (uint64_t)ts.tv_nsec;
+#else
+    LARGE_INTEGER frequency, counter;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1000000000.0 / (double)frequency.QuadPart);
+#endif
+}
+
+static uint32_t random32(void)
+{
+    seed ^= seed << 13;                 // xorshift32 (reproducible traffic)
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static void report(const char *title, uint64_t elapsed, long frames, int errors)
+{
+    fprintf(stdout, "  %-30s %8.1f ns/frame", title, (double)elapsed / (double)frames);
+    if(errors)
+        fprintf(stdout, " (%i errors)", errors);
+    fprintf(stdout, "\n");
+}
+
+/*  ----------------------------------------------------------------------
+ *  Uwe Vogt,  UV Software,  Chausseestrasse 33 A,  10115 Berlin,  Germany
+ *  Tel.: +49-30-46799872,  Fax: +49-30-46799873,  Mobile: +49-170-3801903
+ *  E-Mail: uwe.vogt@uv-software.de,  Homepage: http://www.uv-software.de/
+ */
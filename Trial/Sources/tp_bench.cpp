@@ -0,0 +1,220 @@
+/*  -- $HeadURL$ --
+ *
+ *  project   :  CAN - Controller Area Network
+ *
+ *  purpose   :  PeakCAN ISO-TP Throughput (Benchmark)
+ *
+ *  copyright :  (C) 2021, UV Software, Berlin
+ *
+ *  compiler  :  Microsoft Visual C/C++ Compiler (Version 19.16)
+ *
+ *  syntax    :  <program> [<length> [<messages> [FD]]]
+ *
+ *  libraries :  PCANBasic.lib
+ *
+ *  includes  :  PeakCAN_IsoTp.h, PeakCAN_BusLoad.h, PeakCAN_Presets.h
+ *
+ *  author    :  Uwe Vogt, UV Software
+ *
+ *  e-mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *  -----------  description  --------------------------------------------
+ *
+ *  Sends ISO-TP messages from PCAN-USB1 to PCAN-USB2 (both channels on the
+ *  same bus, e.g. two PCAN-USB adapters cabled together) and checks them
+ *  on the receiving side.  The receiver announces block size 0 and STmin
+ *  0, so the consecutive frames are sent back-to-back.  Reported are the
+ *  payload throughput in KB/s (first Send to last message received), the
+ *  throughput seen by the sender (time spent in Send), and the limit set
+ *  by the bus: the payload divided by the time on the bus of all frames,
+ *  including first, consecutive and flow control frames.
+ */
+
+/*  -----------  includes  -----------------------------------------------
+ */
+
+#include "PeakCAN_Defines.h"
+#include "PeakCAN_IsoTp.h"
+#include "PeakCAN_BusLoad.h"
+#include "PeakCAN_Presets.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <thread>
+#include <chrono>
+
+
+/*  -----------  defines  ------------------------------------------------
+ */
+
+#define DEFAULT_LENGTH      4095
+#define DEFAULT_MESSAGES    100
+#define TESTER_ID           0x7E0U      // PCAN-USB1 transmits
+#define ECU_ID              0x7E8U      // PCAN-USB2 transmits (flow control)
+#define RECEIVE_TIMEOUT     5000U       // in [ms]
+
+
+/*  -----------  types  --------------------------------------------------
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+
+/*  -----------  prototypes  ---------------------------------------------
+ */
+
+static uint64_t frame_time(size_t bytes, bool fd, const CANAPI_BusSpeed_t &speed);
+static uint64_t bus_time(size_t length, long messages, bool fd, const CANAPI_BusSpeed_t &speed);
+
+
+/*  -----------  variables  ----------------------------------------------
+ */
+
+
+/*  -----------  functions  ----------------------------------------------
+ */
+
+int main(int argc, char *argv[])
+{
+    long length = DEFAULT_LENGTH, messages = DEFAULT_MESSAGES, n;
+    bool fd = false;
+    CPeakCAN tester, ecu;
+    CANAPI_OpMode_t mode = {};
+    CANAPI_Bitrate_t bitrate = {};
+    CANAPI_BusSpeed_t speed = {};
+    CPeakCANIsoTp::SAddress address = {};
+    CPeakCANIsoTp::SStatistics statistics = {};
+    std::vector<uint8_t> data;
+    int errors = 0, i;
+
+    if(((argc > 1) && (((length = strtol(argv[1], NULL, 10)) <= 0) || (length > (long)PEAKCAN_ISOTP_MAX_LENGTH))) ||
+       ((argc > 2) && ((messages = strtol(argv[2], NULL, 10)) <= 0)) ||
+       ((argc > 3) && !(fd = !strcmp(argv[3], "FD")))) {
+        fprintf(stderr, "Usage: %s [<length> [<messages> [FD]]]\n", argv[0]);
+        return 1;
+    }
+    /* both channels on the same bus: 1 Mbit/s, or 1 Mbit/s : 8 Mbit/s */
+    if(fd) {
+        mode.byte = CANMODE_FDOE | CANMODE_BRSE;
+        bitrate = PEAKCAN_PRESET_80MHz_1M_8M.Bitrate();
+    }
+    else {
+        mode.byte = CANMODE_DEFAULT;
+        bitrate.index = CANBTR_INDEX_1M;
+    }
+    CPeakCAN *channel[2] = { &tester, &ecu };
+    int32_t board[2] = { PCAN_USB1, PCAN_USB2 };
+    for(i = 0; i < 2; i++) {
+        if((channel[i]->InitializeChannel(board[i], mode) != CANERR_NOERROR) ||
+           (channel[i]->StartController(bitrate) != CANERR_NOERROR)) {
+            fprintf(stderr, "+++ error: PCAN-USB%i could not be initialized or started\n", i + 1);
+            return 1;
+        }
+    }
+    (void)tester.GetBusSpeed(speed);
+    fprintf(stdout, "ISO-TP from PCAN-USB1 to PCAN-USB2 (%li messages of %li bytes, %s):\n",
+            messages, length, fd ? "CAN FD 1M:8M" : "CAN 2.0 1M");
+
+    /* one session on each side */
+    CPeakCANIsoTp sender(tester), receiver(ecu);
+    address.fFD = address.fBRS = fd;
+    address.u8Padding = 0xCCU;
+    address.u32TxId = TESTER_ID;
+    address.u32RxId = ECU_ID;
+    int out = sender.OpenSession(address);
+    address.u32TxId = ECU_ID;
+    address.u32RxId = TESTER_ID;
+    int in = receiver.OpenSession(address);
+    (void)sender.Start();
+    (void)receiver.Start();
+
+    /* receive and check in a thread of its own */
+    Clock::time_point last = Clock::now();
+    std::thread check([&]() {
+        std::vector<uint8_t> message;
+        for(long k = 0; k < messages; k++) {
+            if(receiver.Receive(in, message, RECEIVE_TIMEOUT) != CANERR_NOERROR) {
+                errors += (int)(messages - k);
+                break;
+            }
+            last = Clock::now();
+            if((message.size() != (size_t)length) || (message[0] != (uint8_t)k) ||
+               ((length > 1) && (message[message.size() - 1U] != (uint8_t)(length + k))))
+                errors++;
+        }
+    });
+    /* send: the first and the last byte identify the message (one byte: the first) */
+    data.resize((size_t)length);
+    for(n = 0; n < length; n++)
+        data[(size_t)n] = (uint8_t)(n * 7);
+    Clock::time_point start = Clock::now();
+    for(n = 0; n < messages; n++) {
+        data[0] = (uint8_t)n;
+        if(length > 1)
+            data[(size_t)length - 1U] = (uint8_t)(length + n);
+        if(sender.Send(out, data.data(), data.size()) != CANERR_NOERROR) {
+            fprintf(stderr, "+++ error: message %li could not be sent\n", n + 1);
+            break;
+        }
+    }
+    check.join();
+    (void)sender.Stop();
+    (void)receiver.Stop();
+    (void)sender.GetStatistics(out, statistics);
+
+    /* throughput */
+    double bytes = (double)length * (double)messages;
+    double elapsed = std::chrono::duration<double>(last - start).count();
+    double bus = (double)bus_time((size_t)length, messages, fd, speed) / 1.0E9;
+    fprintf(stdout, "  %-30s %10.1f KB/s (%.3f s)\n", "end to end", bytes / 1024. / elapsed, elapsed);
+    if(statistics.u64SendTime)
+        fprintf(stdout, "  %-30s %10.1f KB/s\n", "sender (time in Send)", (double)statistics.u64BytesSent / 1024. / ((double)statistics.u64SendTime / 1.0E6));
+    fprintf(stdout, "  %-30s %10.1f KB/s (%.0f%% reached)\n", "bus limit (frames on the bus)", bytes / 1024. / bus, bus / elapsed * 100.);
+    if(errors)
+        fprintf(stdout, "  +++ error: %i messages lost or corrupted\n", errors);
+
+    (void)tester.TeardownChannel();
+    (void)ecu.TeardownChannel();
+    return errors ? 1 : 0;
+}
+
+/*  -----------  local functions  ----------------------------------------
+ */
+
+static uint64_t frame_time(size_t bytes, bool fd, const CANAPI_BusSpeed_t &speed)
+{
+    CANAPI_Message_t frame = {};
+
+    /* padded as by the ISO-TP engine: 8 bytes, or the next CAN FD length */
+    frame.fdf = frame.brs = fd ? 1 : 0;
+    frame.dlc = (fd && (bytes > CAN_MAX_LEN)) ? CCANAPI::Len2Dlc((uint8_t)bytes) : CAN_MAX_DLC;
+    return CPeakCANBusLoad::Nanoseconds(frame, speed);
+}
+
+static uint64_t bus_time(size_t length, long messages, bool fd, const CANAPI_BusSpeed_t &speed)
+{
+    size_t size = fd ? CANFD_MAX_LEN : CAN_MAX_LEN;
+    uint64_t total;
+
+    if(length <= 7U)                    // single frame
+        total = frame_time(1U + length, fd, speed);
+    else if(fd && (length <= (size - 2U)))
+        total = frame_time(2U + length, fd, speed);
+    else {                              // first frame, flow control, consecutive frames
+        size_t rest = length - (size - ((length <= 0xFFFU) ? 2U : 6U));
+        total = frame_time(size, fd, speed) + frame_time(3U, fd, speed);
+        total += frame_time(size, fd, speed) * (uint64_t)(rest / (size - 1U));
+        if((rest % (size - 1U)))
+            total += frame_time(1U + rest % (size - 1U), fd, speed);
+    }
+    return total * (uint64_t)messages;
+}
+
+/*  ----------------------------------------------------------------------
+ *  Uwe Vogt,  UV Software,  Chausseestrasse 33 A,  10115 Berlin,  Germany
+ *  Tel.: +49-30-46799872,  Fax: +49-30-46799873,  Mobile: +49-170-3801903
+ *  E-Mail: uwe.vogt@uv-software.de,  Homepage: http://www.uv-software.com/
+ */
@@ -0,0 +1,663 @@
+//  SPDX-License-Identifier: GPL-3.0-or-later
+//
+//  CAN Gateway for PEAK PCAN Interfaces
+//
+//  Copyright (c) 2021 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "build_no.h"
+#define VERSION_MAJOR    0
+#define VERSION_MINOR    1
+#define VERSION_PATCH    0
+#define VERSION_BUILD    BUILD_NO
+#define VERSION_STRING   TOSTRING(VERSION_MAJOR) "." TOSTRING(VERSION_MINOR) "." TOSTRING(VERSION_PATCH) " (" TOSTRING(BUILD_NO) ")"
+#if defined(_WIN64)
+#define PLATFORM        "x64"
+#elif defined(_WIN32)
+#define PLATFORM        "x86"
+#elif defined(__linux__)
+#define PLATFORM        "Linux"
+#elif defined(__APPLE__)
+#define PLATFORM        "macOS"
+#else
+#error Unsupported architecture
+#endif
+static const char APPLICATION[] = "CAN Gateway for PEAK PCAN Interfaces, Version " VERSION_STRING;
+static const char COPYRIGHT[]   = "Copyright (c) 2021 by Uwe Vogt, UV Software, Berlin";
+static const char WARRANTY[]    = "This program comes with ABSOLUTELY NO WARRANTY!\n\n" \
+                                  "This is free software, and you are welcome to redistribute it\n" \
+                                  "under certain conditions; type `/ABOUT' for details.";
+static const char LICENSE[]     = "This program is free software: you can redistribute it and/or modify\n" \
+                                  "it under the terms of the GNU General Public License as published by\n" \
+                                  "the Free Software Foundation, either version 3 of the License, or\n" \
+                                  "(at your option) any later version.\n\n" \
+                                  "This program is distributed in the hope that it will be useful,\n" \
+                                  "but WITHOUT ANY WARRANTY; without even the implied warranty of\n" \
+                                  "MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the\n" \
+                                  "GNU General Public License for more details.\n\n" \
+                                  "You should have received a copy of the GNU General Public License\n" \
+                                  "along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+#define basename(x)  "can_gate" // FIXME: Where is my `basename' function?
+
+#include "PeakCAN_Defines.h"
+#include "PeakCAN.h"
+#include "PeakCAN_Gateway.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <signal.h>
+#include <errno.h>
+
+#include <inttypes.h>
+
+#include <vector>
+#include <thread>
+#include <chrono>
+
+#ifdef _MSC_VER
+//not #if defined(_WIN32) || defined(_WIN64) because we have strncasecmp in mingw
+#define strncasecmp _strnicmp
+#define strcasecmp _stricmp
+#endif
+
+extern "C" {
+#include "dosopt.h"
+}
+#define BAUDRATE_STR    0
+#define BAUDRATE_CHR    1
+#define BITRATE_STR     2
+#define BITRATE_CHR     3
+#define VERBOSE_STR     4
+#define VERBOSE_CHR     5
+#define OP_MODE_STR     6
+#define OP_MODE_CHR     7
+#define SHARED_STR      8
+#define SHARED_CHR      9
+#define ROUTE_STR       10
+#define ROUTE_CHR       11
+#define XROUTE_STR      12
+#define XROUTE_CHR      13
+#define CONVERT_STR     14
+#define CONVERT_CHR     15
+#define BOTH_STR        16
+#define BOTH_CHR        17
+#define LISTBOARDS_STR  18
+#define LISTBOARDS_CHR  19
+#define HELP            20
+#define QUESTION_MARK   21
+#define ABOUT           22
+#define CHARACTER_MJU   23
+#define MAX_OPTIONS     24
+
+static char* option[MAX_OPTIONS] = {
+    (char*)"BAUDRATE", (char*)"bd",
+    (char*)"BITRATE", (char*)"br",
+    (char*)"VERBOSE", (char*)"v",
+    (char*)"MODE", (char*)"m",
+    (char*)"SHARED", (char*)"shrd",
+    (char*)"ROUTE", (char*)"r",
+    (char*)"XROUTE", (char*)"x",
+    (char*)"CONVERT", (char*)"c",
+    (char*)"BIDIRECTIONAL", (char*)"both",
+    (char*)"LIST-BOARDS", (char*)"list",
+    (char*)"HELP", (char*)"?",
+    (char*)"ABOUT", (char*)"�"
+};
+
+static const struct TCanDevice {
+    int32_t adapter;
+    char *name;
+} can_devices[] = {
+    {PCAN_USB1, (char *)"PCAN-USB1" },
+    {PCAN_USB2, (char *)"PCAN-USB2" },
+    {PCAN_USB3, (char *)"PCAN-USB3" },
+    {PCAN_USB4, (char *)"PCAN-USB4" },
+    {PCAN_USB5, (char *)"PCAN-USB5" },
+    {PCAN_USB6, (char *)"PCAN-USB6" },
+    {PCAN_USB7, (char *)"PCAN-USB7" },
+    {PCAN_USB8, (char *)"PCAN-USB8" },
+    {PCAN_USB9, (char *)"PCAN-USB9" },
+    {PCAN_USB10, (char *)"PCAN-USB10" },
+    {PCAN_USB11, (char *)"PCAN-USB11" },
+    {PCAN_USB12, (char *)"PCAN-USB12" },
+    {PCAN_USB13, (char *)"PCAN-USB13" },
+    {PCAN_USB14, (char *)"PCAN-USB14" },
+    {PCAN_USB15, (char *)"PCAN-USB15" },
+    {PCAN_USB16, (char *)"PCAN-USB16" },
+    {EOF, NULL}
+};
+
+static int get_routes(const char *arg, bool xtd, std::vector<CPeakCANGateway::SRoute> &routes);
+static void print_statistics(CPeakCANGateway &gateway, const std::vector<CPeakCANGateway::SRoute> &routes,
+                             const char *from, const char *to);
+
+static void sigterm(int signo);
+static void usage(FILE *stream, const char *program);
+static void version(FILE *stream, const char *program);
+
+static volatile int running = 1;
+
+static CPeakCAN canSource = CPeakCAN();
+static CPeakCAN canDestination = CPeakCAN();
+
+int main(int argc, const char * argv[]) {
+    int i;
+    int optind;
+    char *optarg;
+
+    int channel[2] = { 0, 0 }, hw = 0, on = 0;
+    int op = 0, sh = 0, cv = 0, bi = 0;
+    int baudrate = CANBDR_250; int bd = 0;
+    CPeakCANGateway::EConvert convert = CPeakCANGateway::ConvertNone;
+    std::vector<CPeakCANGateway::SRoute> routes;
+    int verbose = 0;
+    int num_boards = 0;
+
+    CANAPI_Bitrate_t bitrate = {};
+    bitrate.index = CANBTR_INDEX_250K;
+    CANAPI_OpMode_t opMode = {};
+    opMode.byte = CANMODE_DEFAULT;
+    CANAPI_Return_t retVal = 0;
+
+    /* default bit-timing */
+    CANAPI_BusSpeed_t speed = {};
+    (void)CPeakCAN::MapIndex2Bitrate(bitrate.index, bitrate);
+    (void)CPeakCAN::MapBitrate2Speed(bitrate, speed);
+
+    /* signal handler */
+    if ((signal(SIGINT, sigterm) == SIG_ERR) ||
+#if !defined(_WIN32) && !defined(_WIN64)
+       (signal(SIGHUP, sigterm) == SIG_ERR) ||
+#endif
+       (signal(SIGTERM, sigterm) == SIG_ERR)) {
+        perror("+++ error");
+        return errno;
+    }
+    /* scan command-line */
+    while ((optind = getOption(argc, (char**)argv, MAX_OPTIONS, option)) != EOF) {
+        switch (optind) {
+        case BAUDRATE_STR:
+        case BAUDRATE_CHR:
+            if ((bd++)) {
+                fprintf(stderr, "%s: duplicated option /BAUDRATE\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) == NULL) {
+                fprintf(stderr, "%s: missing argument for option /BAUDRATE\n", basename(argv[0]));
+                return 1;
+            }
+            if (sscanf_s(optarg, "%i", &baudrate) != 1) {
+                fprintf(stderr, "%s: illegal argument for option /BAUDRATE\n", basename(argv[0]));
+                return 1;
+            }
+            switch (baudrate) {
+            case 1000: case 1000000: bitrate.index = CANBTR_INDEX_1M; break;
+            case 800:  case 800000:  bitrate.index = CANBTR_INDEX_800K; break;
+            case 500:  case 500000:  bitrate.index = CANBTR_INDEX_500K; break;
+            case 250:  case 250000:  bitrate.index = CANBTR_INDEX_250K; break;
+            case 125:  case 125000:  bitrate.index = CANBTR_INDEX_125K; break;
+            case 100:  case 100000:  bitrate.index = CANBTR_INDEX_100K; break;
+            case 50:   case 50000:   bitrate.index = CANBTR_INDEX_50K; break;
+            case 20:   case 20000:   bitrate.index = CANBTR_INDEX_20K; break;
+            case 10:   case 10000:   bitrate.index = CANBTR_INDEX_10K; break;
+            default:                 bitrate.index = -baudrate; break;
+            }
+            if (CPeakCAN::MapIndex2Bitrate(bitrate.index, bitrate) != CCANAPI::NoError) {
+                fprintf(stderr, "%s: illegal argument for option /BAUDRATE\n", basename(argv[0]));
+                return 1;
+            }
+            if (CPeakCAN::MapBitrate2Speed(bitrate, speed) != CCANAPI::NoError) {
+                fprintf(stderr, "%s: illegal argument for option /BAUDRATE\n", basename(argv[0]));
+                return 1;
+            }
+            break;
+        case BITRATE_STR:
+        case BITRATE_CHR:
+            if ((bd++)) {
+                fprintf(stderr, "%s: duplicated option /BITRATE\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) == NULL) {
+                fprintf(stderr, "%s: missing argument for option /BITRATE\n", basename(argv[0]));
+                return 1;
+            }
+            if (CPeakCAN::MapString2Bitrate(optarg, bitrate) != CCANAPI::NoError) {
+                fprintf(stderr, "%s: illegal argument for option /BITRATE\n", basename(argv[0]));
+                return 1;
+            }
+            if (CPeakCAN::MapBitrate2Speed(bitrate, speed) != CCANAPI::NoError) {
+                fprintf(stderr, "%s: illegal argument for option /BITRATE\n", basename(argv[0]));
+                return 1;
+            }
+            break;
+        case VERBOSE_STR:
+        case VERBOSE_CHR:
+            if (verbose) {
+                fprintf(stderr, "%s: duplicated option /VERBOSE\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) != NULL) {
+                fprintf(stderr, "%s: illegal argument for option /VERBOSE\n", basename(argv[0]));
+                return 1;
+            }
+            verbose = 1;
+            break;
+        case OP_MODE_STR:
+        case OP_MODE_CHR:
+            if ((op++)) {
+                fprintf(stderr, "%s: duplicated option /MODE\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) == NULL) {
+                fprintf(stderr, "%s: missing argument for option /MODE\n", basename(argv[0]));
+                return 1;
+            }
+            if (!_strcmpi(optarg, "DEFAULT") || !_strcmpi(optarg, "CLASSIC") ||
+                !_strcmpi(optarg, "CAN20") || !_strcmpi(optarg, "CAN2.0") || !_strcmpi(optarg, "2.0"))
+                opMode.byte |= CANMODE_DEFAULT;
+            else if (!_strcmpi(optarg, "CANFD") || !_strcmpi(optarg, "FD") || !_strcmpi(optarg, "FDF"))
+                opMode.byte |= CANMODE_FDOE;
+            else if (!_strcmpi(optarg, "CANFD+BRS") || !_strcmpi(optarg, "FDF+BRS") || !_strcmpi(optarg, "FD+BRS"))
+                opMode.byte |= CANMODE_FDOE | CANMODE_BRSE;
+            else {
+                fprintf(stderr, "%s: illegal argument for option /MODE\n", basename(argv[0]));
+                return 1;
+            }
+            break;
+        case SHARED_STR:
+        case SHARED_CHR:
+            if ((sh++)) {
+                fprintf(stderr, "%s: duplicated option /SHARED\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) != NULL) {
+                fprintf(stderr, "%s: illegal argument for option /SHARED\n", basename(argv[0]));
+                return 1;
+            }
+            opMode.byte |= CANMODE_SHRD;
+            break;
+        case ROUTE_STR:
+        case ROUTE_CHR:
+        case XROUTE_STR:
+        case XROUTE_CHR:
+            /* note: the option can be given several times */
+            if ((optarg = getOptionParameter()) == NULL) {
+                fprintf(stderr, "%s: missing argument for option /%sROUTE\n", basename(argv[0]), (optind >= XROUTE_STR) ? "X" : "");
+                return 1;
+            }
+            if (!get_routes(optarg, (optind >= XROUTE_STR), routes)) {
+                fprintf(stderr, "%s: illegal argument for option /%sROUTE\n", basename(argv[0]), (optind >= XROUTE_STR) ? "X" : "");
+                return 1;
+            }
+            break;
+        case CONVERT_STR:
+        case CONVERT_CHR:
+            if ((cv++)) {
+                fprintf(stderr, "%s: duplicated option /CONVERT\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) == NULL) {
+                fprintf(stderr, "%s: missing argument for option /CONVERT\n", basename(argv[0]));
+                return 1;
+            }
+            if (!_strcmpi(optarg, "NO") || !_strcmpi(optarg, "N") || !_strcmpi(optarg, "OFF") || !_strcmpi(optarg, "0"))
+                convert = CPeakCANGateway::ConvertNone;
+            else if (!_strcmpi(optarg, "CLASSIC") || !_strcmpi(optarg, "CAN2.0") || !_strcmpi(optarg, "2.0"))
+                convert = CPeakCANGateway::ConvertClassic;
+            else if (!_strcmpi(optarg, "CANFD") || !_strcmpi(optarg, "FD") || !_strcmpi(optarg, "FDF"))
+                convert = CPeakCANGateway::ConvertFD;
+            else if (!_strcmpi(optarg, "CANFD+BRS") || !_strcmpi(optarg, "FDF+BRS") || !_strcmpi(optarg, "FD+BRS"))
+                convert = CPeakCANGateway::ConvertFDBRS;
+            else {
+                fprintf(stderr, "%s: illegal argument for option /CONVERT\n", basename(argv[0]));
+                return 1;
+            }
+            break;
+        case BOTH_STR:
+        case BOTH_CHR:
+            if ((bi++)) {
+                fprintf(stderr, "%s: duplicated option /BIDIRECTIONAL\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) != NULL) {
+                fprintf(stderr, "%s: illegal argument for option /BIDIRECTIONAL\n", basename(argv[0]));
+                return 1;
+            }
+            break;
+        case LISTBOARDS_STR:
+        case LISTBOARDS_CHR:
+            fprintf(stdout, "%s\n%s\n\n%s\n\n", APPLICATION, COPYRIGHT, WARRANTY);
+            /* list all supported interfaces */
+            fprintf(stdout, "Suppored hardware:\n");
+            for (num_boards = 0; can_devices[num_boards].adapter != EOF; num_boards++)
+                fprintf(stdout, "\"%s\" (AdapterId=%" PRIi32 ")\n", can_devices[num_boards].name, can_devices[num_boards].adapter);
+            fprintf(stdout, "Number of supported CAN interfaces=%i\n", num_boards);
+            return 0;
+        case HELP:
+        case QUESTION_MARK:
+            usage(stdout, basename(argv[0]));
+            return 0;
+        case ABOUT:
+        case CHARACTER_MJU:
+            version(stdout, basename(argv[0]));
+            return 0;
+        default:
+            usage(stderr, basename(argv[0]));
+            return 1;
+        }
+    }
+    /* - check if two and only two <interface>s are given */
+    for (i = 1; i < argc; i++) {
+        if (!isOption(argc, (char**)argv, MAX_OPTIONS, option, i)) {
+            if (hw >= 2) {
+                fprintf(stderr, "%s: too many arguments\n", basename(argv[0]));
+                return 1;
+            }
+            for (channel[hw] = 0; can_devices[channel[hw]].adapter != EOF; channel[hw]++) {
+                if (!_stricmp(argv[i], can_devices[channel[hw]].name))
+                    break;
+            }
+            if (can_devices[channel[hw]].adapter == EOF) {
+                fprintf(stderr, "%s: illegal argument\n", basename(argv[0]));
+                return 1;
+            }
+            hw++;
+        }
+    }
+    if (hw < 2) {
+        fprintf(stderr, "%s: not enough arguments\n", basename(argv[0]));
+        return 1;
+    }
+    if (channel[0] == channel[1]) {
+        fprintf(stderr, "%s: source and destination must be different interfaces\n", basename(argv[0]));
+        return 1;
+    }
+    /* - check bit-timing index (n/a for CAN FD) */
+    if (opMode.fdoe && (bitrate.btr.frequency <= 0)) {
+        fprintf(stderr, "%s: illegal combination of options /MODE and /BAUDRATE\n", basename(argv[0]));
+        return 1;
+    }
+    /* - check format conversion (CAN FD frames need CAN FD mode) */
+    if (!opMode.fdoe && (convert >= CPeakCANGateway::ConvertFD)) {
+        fprintf(stderr, "%s: illegal combination of options /MODE and /CONVERT\n", basename(argv[0]));
+        return 1;
+    }
+    /* - forward everything unchanged when no route is given */
+    if (routes.empty()) {
+        CPeakCANGateway::SRoute all_std = { 0U, CAN_MAX_STD_ID, false, -1, false, CPeakCANGateway::ConvertNone, 0U };
+        CPeakCANGateway::SRoute all_xtd = { 0U, CAN_MAX_XTD_ID, true, -1, true, CPeakCANGateway::ConvertNone, 0U };
+        routes.push_back(all_std);
+        routes.push_back(all_xtd);
+    }
+    for (size_t r = 0U; r < routes.size(); r++)
+        routes[r].eConvert = convert;
+    /* CAN Gateway for PEAK PCAN interfaces */
+    fprintf(stdout, "%s\n%s\n\n%s\n\n", APPLICATION, COPYRIGHT, WARRANTY);
+
+    /* - show operation mode, bit-rate settings and routes */
+    if (verbose) {
+        fprintf(stdout, "Op.-mode=%s", (opMode.byte & CANMODE_FDOE) ? "CANFD" : "CAN2.0");
+        if ((opMode.byte & CANMODE_BRSE)) fprintf(stdout, "+BRS");
+        if ((opMode.byte & CANMODE_SHRD)) fprintf(stdout, "+SHRD");
+        fprintf(stdout, " (op_mode=%02Xh)\n", opMode.byte);
+        if (bitrate.btr.frequency > 0) {
+            fprintf(stdout, "Bit-rate=%.0fkbps@%.1f%%",
+                speed.nominal.speed / 1000.,
+                speed.nominal.samplepoint * 100.);
+            if (speed.data.brse)
+                fprintf(stdout, ":%.0fkbps@%.1f%%",
+                    speed.data.speed / 1000.,
+                    speed.data.samplepoint * 100.);
+            fprintf(stdout, "\n");
+        }
+        else {
+            fprintf(stdout, "Baudrate=%.0fkbps@%.1f%% (index %i)\n",
+                             speed.nominal.speed / 1000.,
+                             speed.nominal.samplepoint * 100., -bitrate.index);
+        }
+        for (size_t r = 0U; r < routes.size(); r++) {
+            fprintf(stdout, "Route #%u: %" PRIX32 "h-%" PRIX32 "h (%s)", (unsigned)r,
+                routes[r].u32First, routes[r].u32Last, routes[r].fXtd ? "29-bit" : "11-bit");
+            if (routes[r].s64Target >= 0)
+                fprintf(stdout, " -> %" PRIX32 "h (%s)", (uint32_t)routes[r].s64Target, routes[r].fTargetXtd ? "29-bit" : "11-bit");
+            if (routes[r].u32Rate)
+                fprintf(stdout, " @ %" PRIu32 " msg/s", routes[r].u32Rate);
+            fprintf(stdout, "\n");
+        }
+        fprintf(stdout, "\n");
+    }
+    /* - initialize and start both interfaces */
+    CPeakCAN *canDriver[2] = { &canSource, &canDestination };
+    for (i = 0; i < 2; i++) {
+        fprintf(stdout, "Hardware=%s...", can_devices[channel[i]].name);
+        fflush(stdout);
+        retVal = canDriver[i]->InitializeChannel(can_devices[channel[i]].adapter, opMode);
+        if (retVal != CCANAPI::NoError) {
+            fprintf(stdout, "FAILED!\n");
+            fprintf(stderr, "+++ error: CAN Controller could not be initialized (%i)\n", retVal);
+            if (retVal == CCANAPI::NotSupported)
+                fprintf(stderr, " - possibly CAN operating mode %02Xh not supported", opMode.byte);
+            fputc('\n', stderr);
+            goto teardown;
+        }
+        fprintf(stdout, "OK!\n");
+        on++;
+        retVal = canDriver[i]->StartController(bitrate);
+        if (retVal != CCANAPI::NoError) {
+            fprintf(stderr, "+++ error: CAN Controller could not be started (%i)\n", retVal);
+            goto teardown;
+        }
+    }
+    /* - do your job well: */
+    {
+        CPeakCANGateway forward(canSource, canDestination);
+        CPeakCANGateway backward(canDestination, canSource);
+        std::vector<CPeakCANGateway::SRoute> reverse;
+        for (size_t r = 0U; r < routes.size(); r++)
+            reverse.push_back(CPeakCANGateway::Reverse(routes[r]));
+        for (size_t r = 0U; r < routes.size(); r++) {
+            if ((forward.AddRoute(routes[r]) < 0) || (bi && (backward.AddRoute(reverse[r]) < 0))) {
+                fprintf(stderr, "+++ error: illegal route #%u\n", (unsigned)r);
+                retVal = CCANAPI::IllegalParameter;
+                goto teardown;
+            }
+        }
+        (void)forward.Start();
+        if (bi)
+            (void)backward.Start();
+        fprintf(stderr, "\nPress ^C to abort.\n\n");
+        while (running)
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        (void)forward.Stop();
+        (void)backward.Stop();
+        /* - show statistics per route */
+        print_statistics(forward, routes, can_devices[channel[0]].name, can_devices[channel[1]].name);
+        if (bi)
+            print_statistics(backward, reverse, can_devices[channel[1]].name, can_devices[channel[0]].name);
+    }
+teardown:
+    /* - teardown the interfaces */
+    for (i = 0; i < on; i++) {
+        if (canDriver[i]->TeardownChannel() != CCANAPI::NoError)
+            fprintf(stderr, "+++ error: CAN Controller could not be reset\n");
+    }
+    /* So long and farewell! */
+    fprintf(stdout, "%s\n", COPYRIGHT);
+    return retVal;
+}
+
+/** @brief       parses a comma-separated list of routes:
+ *               <id>[-<id>][:<id>][@<rate>]{,<id>[-<id>][:<id>][@<rate>]}
+ *
+ *  @param[in]   arg    - argument of option /ROUTE or /XROUTE
+ *  @param[in]   xtd    - 29-bit identifiers (/XROUTE)
+ *  @param[out]  routes - list of routes (routes are appended)
+ *
+ *  @returns     non-zero if the list is valid, zero otherwise
+ */
+static int get_routes(const char *arg, bool xtd, std::vector<CPeakCANGateway::SRoute> &routes)
+{
+    char *val, *end;
+    unsigned long first, last, value;
+    unsigned long max = xtd ? CAN_MAX_XTD_ID : CAN_MAX_STD_ID;
+
+    if (!arg)
+        return 0;
+
+    val = (char *)arg;
+    for (;;) {
+        CPeakCANGateway::SRoute route = { 0U, 0U, xtd, -1, xtd, CPeakCANGateway::ConvertNone, 0U };
+
+        errno = 0;
+        first = strtoul(val, &end, 0);
+        if ((errno != 0) || (val == end) || (first > max))
+            return 0;
+        last = first;
+        if (*end == '-') {
+            val = ++end;
+            last = strtoul(val, &end, 0);
+            if ((errno != 0) || (val == end) || (last > max) || (last < first))
+                return 0;
+        }
+        route.u32First = (uint32_t)first;
+        route.u32Last = (uint32_t)last;
+        if (*end == ':') {
+            val = ++end;
+            value = strtoul(val, &end, 0);
+            if ((errno != 0) || (val == end) || (value + (last - first) > CAN_MAX_XTD_ID))
+                return 0;
+            route.s64Target = (int64_t)value;
+            /* note: 11-bit identifiers mapped above 7FFh become 29-bit identifiers */
+            route.fTargetXtd = xtd || ((value + (last - first)) > CAN_MAX_STD_ID);
+        }
+        if (*end == '@') {
+            val = ++end;
+            value = strtoul(val, &end, 0);
+            if ((errno != 0) || (val == end) || (value == 0U) || (value > UINT32_MAX))
+                return 0;
+            route.u32Rate = (uint32_t)value;
+        }
+        routes.push_back(route);
+
+        if (*end == '\0')
+            break;
+        if (*end != ',')
+            return 0;
+        val = ++end;
+    }
+    return 1;
+}
+
+/** @brief       shows the statistics of all routes of a gateway.
+ *
+ *  @param[in]   gateway - the gateway
+ *  @param[in]   routes  - list of routes
+ *  @param[in]   from    - name of the source interface
+ *  @param[in]   to      - name of the destination interface
+ */
+static void print_statistics(CPeakCANGateway &gateway, const std::vector<CPeakCANGateway::SRoute> &routes,
+                             const char *from, const char *to)
+{
+    CPeakCANGateway::SStatistics stats;
+
+    fprintf(stdout, "%s -> %s:\n", from, to);
+    for (size_t r = 0U; r < routes.size(); r++) {
+        if (gateway.GetStatistics((int)r, stats) != CCANAPI::NoError)
+            continue;
+        fprintf(stdout, "  #%u %" PRIX32 "h-%" PRIX32 "h: forwarded=%" PRIu64 " dropped=%" PRIu64 " errors=%" PRIu64,
+            (unsigned)r, routes[r].u32First, routes[r].u32Last, stats.u64Forwarded, stats.u64Dropped, stats.u64Errors);
+        fprintf(stdout, " latency[us]: p50=%" PRIu64 " p90=%" PRIu64 " p99=%" PRIu64 " max=%" PRIu64 "\n",
+            stats.u64LatencyP50, stats.u64LatencyP90, stats.u64LatencyP99, stats.u64LatencyMax);
+    }
+}
+
+/** @brief       signal handler to catch Ctrl+C.
+ *
+ *  @param[in]   signo - signal number (SIGINT, SIGHUP, SIGTERM)
+ */
+static void sigterm(int signo)
+{
+    //fprintf(stderr, "%s: got signal %d\n", __FILE__, signo);
+    running = 0;
+    (void)signo;
+}
+
+/** @brief       shows a help screen with all command-line options.
+ *
+ *  @param[in]   stream  - output stream (e.g. stdout)
+ *  @param[in]   program - base name of the program
+ */
+static void usage(FILE *stream, const char *program)
+{
+    fprintf(stream, "Usage:\n");
+    fprintf(stream, "  %-8s <from> <to>  [/Route=<route>{,<route>}]\n", program);
+    fprintf(stream, "  %-8s              [/Xroute=<route>{,<route>}]\n", "");
+    fprintf(stream, "  %-8s              [/Convert=(No|2.0|FDf[+BRS])] [/BIDIRECTIONAL]\n", "");
+    fprintf(stream, "  %-8s              [/Mode=(2.0|FDf[+BRS])] [/SHARED] [/Verbose]\n", "");
+    fprintf(stream, "  %-8s              [/BauDrate=<baudrate> | /BitRate=<bitrate>]\n", "");
+    fprintf(stream, "  %-8s (/LIST-BOARDS | /LIST)\n", program);
+    fprintf(stream, "  %-8s (/HELP  | /?)\n", program);
+    fprintf(stream, "  %-8s (/ABOUT | /�)\n", program);
+    fprintf(stream, "Options:\n");
+    fprintf(stream, "  <from>      CAN interface board to receive from (list all with /LIST)\n");
+    fprintf(stream, "  <to>        CAN interface board to transmit to\n");
+    fprintf(stream, "  <route>     <id>[-<id>][:<id>][@<rate>] (first matching route wins):\n");
+    fprintf(stream, "              <id>[-<id>]  CAN identifier range (11-bit or 29-bit with /Xroute)\n");
+    fprintf(stream, "              :<id>        new identifier of the first one (offset is kept)\n");
+    fprintf(stream, "              @<rate>      maximum number of messages per second\n");
+    fprintf(stream, "              (all messages are forwarded unchanged if no route is given)\n");
+    fprintf(stream, "  /BIDIRECTIONAL also forward from <to> to <from> (new identifiers back to the\n");
+    fprintf(stream, "              original ones)\n");
+    fprintf(stream, "  <baudrate>  CAN baud rate index (default=3):\n");
+    fprintf(stream, "              0 = 1000 kbps\n");
+    fprintf(stream, "              1 = 800 kbps\n");
+    fprintf(stream, "              2 = 500 kbps\n");
+    fprintf(stream, "              3 = 250 kbps\n");
+    fprintf(stream, "              4 = 125 kbps\n");
+    fprintf(stream, "              5 = 100 kbps\n");
+    fprintf(stream, "              6 = 50 kbps\n");
+    fprintf(stream, "              7 = 20 kbps\n");
+    fprintf(stream, "              8 = 10 kbps\n");
+    fprintf(stream, "  <bitrate>   Comma-separated <key>=<value>-list:\n");
+    fprintf(stream, "              f_clock=<value>      Frequency in Hz or\n");
+    fprintf(stream, "              f_clock_mhz=<value>  Frequency in MHz\n");
+    fprintf(stream, "              nom_brp=<value>      Bit-rate prescaler (nominal)\n");
+    fprintf(stream, "              nom_tseg1=<value>    Time segment 1 (nominal)\n");
+    fprintf(stream, "              nom_tseg2=<value>    Time segment 2 (nominal)\n");
+    fprintf(stream, "              nom_sjw=<value>      Sync. jump width (nominal)\n");
+    fprintf(stream, "              nom_sam=<value>      Sampling (only SJA1000)\n");
+    fprintf(stream, "              data_brp=<value>     Bit-rate prescaler (FD data)\n");
+    fprintf(stream, "              data_tseg1=<value>   Time segment 1 (FD data)\n");
+    fprintf(stream, "              data_tseg2=<value>   Time segment 2 (FD data)\n");
+    fprintf(stream, "              data_sjw=<value>     Sync. jump width (FD data).\n");
+    fprintf(stream, "Hazard note:\n");
+    fprintf(stream, "  If you connect your CAN device to a real CAN network when using this program,\n");
+    fprintf(stream, "  you might damage your application.\n");
+}
+
+/** @brief       shows version information of the program.
+ *
+ *  @param[in]   stream  - output stream (e.g. stdout)
+ *  @param[in]   program - base name of the program
+ */
+static void version(FILE *stream, const char *program)
+{
+    fprintf(stdout, "%s\n%s\n\n%s\n\n", APPLICATION, COPYRIGHT, LICENSE);
+    (void)program;
+    fprintf(stream, "Written by Uwe Vogt, UV Software, Berlin <http://www.uv-software.com/>\n");
+}
@@ -0,0 +1,199 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  Software for Industrial Communication, Motion Control and Automation
+//
+//  Copyright (c) 2021 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This class is dual-licensed under the BSD 2-Clause "Simplified" License and
+//  under the GNU General Public License v3.0 (or any later version).
+//  You can choose between one of them if you use this class.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS CLASS IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF THIS CLASS, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  This class is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This class is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this class.  If not, see <http://www.gnu.org/licenses/>.
+#include "Filter.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <map>
+
+#define WORDS  ((size_t)1U << (CCanFilter::PAGE_BITS - 6U))  // 64-bit words per page
+#define FULL   (~(uint64_t)0U)
+
+const unsigned CCanFilter::PAGE_BITS;
+const uint32_t CCanFilter::PAGE_NONE;
+const uint32_t CCanFilter::PAGE_ALL;
+
+struct SPageWork {  // page under construction
+    bool all;
+    std::vector<uint64_t> bits;  // empty = none set
+};
+
+static bool parse_id(const char *string, char **end, uint32_t max, uint32_t &id) {
+    unsigned long value;
+
+    errno = 0;
+    value = strtoul(string, end, 0);
+    if ((*end == string) || (errno != 0) || (value > (unsigned long)max))
+        return false;
+    id = (uint32_t)value;
+    return true;
+}
+
+static void set_range(std::vector<SPageWork> &pages, uint32_t first, uint32_t last) {
+    for (uint32_t page = first >> CCanFilter::PAGE_BITS; page <= (last >> CCanFilter::PAGE_BITS); page++) {
+        uint32_t lo = page << CCanFilter::PAGE_BITS;
+        uint32_t hi = lo + ((1U << CCanFilter::PAGE_BITS) - 1U);
+        if (pages[page].all)
+            continue;
+        if ((first <= lo) && (hi <= last)) {
+            pages[page].all = true;  // whole page
+            pages[page].bits.clear();
+            continue;
+        }
+        if (pages[page].bits.empty())
+            pages[page].bits.assign(WORDS, 0U);
+        for (uint32_t id = (first > lo) ? first : lo; id <= ((last < hi) ? last : hi); id++)
+            pages[page].bits[(id - lo) >> 6] |= (uint64_t)1U << (id & 63U);
+    }
+}
+
+static void set_mask(std::vector<SPageWork> &pages, uint32_t code, uint32_t mask) {
+    const uint32_t low = (1U << CCanFilter::PAGE_BITS) - 1U;
+    std::vector<uint64_t> pattern(WORDS, 0U);
+    bool full = !(mask & low);
+
+    // identifiers within a page that match the lower part of the mask (same for all pages)
+    if (!full) {
+        for (uint32_t id = 0U; id <= low; id++)
+            if (!((id ^ code) & mask & low))
+                pattern[id >> 6] |= (uint64_t)1U << (id & 63U);
+    }
+    // pages that match the upper part
+    for (uint32_t page = 0U; page < (uint32_t)pages.size(); page++) {
+        if (((page << CCanFilter::PAGE_BITS) ^ code) & mask & ~low)
+            continue;
+        if (pages[page].all)
+            continue;
+        if (full) {
+            pages[page].all = true;
+            pages[page].bits.clear();
+            continue;
+        }
+        if (pages[page].bits.empty())
+            pages[page].bits = pattern;
+        else
+            for (size_t i = 0U; i < WORDS; i++)
+                pages[page].bits[i] |= pattern[i];
+    }
+}
+
+CCanFilter::CCanFilter(bool fExtended)
+    : m_u32MaxId(fExtended ? 0x1FFFFFFFU : 0x7FFU), m_fInverse(false), m_fEmpty(true) {
+    Clear();
+}
+
+void CCanFilter::Clear() {
+    m_fInverse = false;
+    m_fEmpty = true;
+    m_Pages.assign((size_t)(m_u32MaxId >> PAGE_BITS) + 1U, PAGE_NONE);
+    m_Bitmaps.clear();
+}
+
+bool CCanFilter::Compile(const char *pszList) {
+    std::vector<SPageWork> pages((size_t)(m_u32MaxId >> PAGE_BITS) + 1U);
+    const char *item = pszList;
+    char *end;
+    bool inverse = false;
+    uint32_t first, last;
+
+    if (!pszList)
+        return false;
+    if (*item == '~') {
+        inverse = true;
+        item++;
+    }
+    for (size_t i = 0U; i < pages.size(); i++)
+        pages[i].all = false;
+    // <id> | <id>-<id> | <code>/<mask>, separated by ','
+    for (;;) {
+        if (!parse_id(item, &end, m_u32MaxId, first))
+            return false;
+        if (*end == '-') {
+            if (!parse_id(end + 1, &end, m_u32MaxId, last))
+                return false;
+            if (last < first) {
+                uint32_t swap = first; first = last; last = swap;
+            }
+            set_range(pages, first, last);
+        }
+        else if (*end == '/') {
+            if (!parse_id(end + 1, &end, m_u32MaxId, last))
+                return false;
+            set_mask(pages, first, last);
+        }
+        else
+            set_range(pages, first, first);
+        if (*end == '\0')
+            break;
+        if (*end != ',')
+            return false;
+        item = end + 1;
+    }
+    // the page table: full bitmaps become 'all', equal bitmaps are shared
+    std::map<std::vector<uint64_t>, uint32_t> distinct;
+    Clear();
+    for (size_t i = 0U; i < pages.size(); i++) {
+        if (pages[i].all)
+            m_Pages[i] = PAGE_ALL;
+        else if (!pages[i].bits.empty()) {
+            size_t w;
+            for (w = 0U; (w < WORDS) && (pages[i].bits[w] == FULL); w++);
+            if (w == WORDS) {
+                m_Pages[i] = PAGE_ALL;
+                continue;
+            }
+            std::map<std::vector<uint64_t>, uint32_t>::iterator it = distinct.find(pages[i].bits);
+            if (it == distinct.end()) {
+                it = distinct.insert(std::make_pair(pages[i].bits, (uint32_t)m_Bitmaps.size() + 2U)).first;
+                m_Bitmaps.push_back(pages[i].bits);
+            }
+            m_Pages[i] = it->second;
+        }
+    }
+    m_fInverse = inverse;
+    m_fEmpty = false;
+    return true;
+}
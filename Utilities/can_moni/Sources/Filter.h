@@ -0,0 +1,98 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  Software for Industrial Communication, Motion Control and Automation
+//
+//  Copyright (c) 2021 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This class is dual-licensed under the BSD 2-Clause "Simplified" License and
+//  under the GNU General Public License v3.0 (or any later version).
+//  You can choose between one of them if you use this class.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS CLASS IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF THIS CLASS, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  This class is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This class is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this class.  If not, see <http://www.gnu.org/licenses/>.
+#ifndef FILTER_H_INCLUDED
+#define FILTER_H_INCLUDED
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// Identifier filter for 11-bit or 29-bit identifiers: a comma-separated
+// list of identifiers, ranges <id>-<id> and masks <code>/<mask> (mask bits
+// set = compared), optionally inverted by a leading '~'.  The list is
+// compiled into a table of pages of 2^16 identifiers, each of them empty,
+// full or pointing to a bitmap; equal bitmaps are shared (e.g. all pages
+// of a mask on the source address), so a lookup takes constant time and
+// memory stays small for any expression.
+class CCanFilter {
+public:
+    static const unsigned PAGE_BITS = 16U;
+private:
+    static const uint32_t PAGE_NONE = 0U;
+    static const uint32_t PAGE_ALL = 1U;  // other values: index of the bitmap + 2
+
+    uint32_t m_u32MaxId;  // highest identifier (7FFh or 1FFFFFFFh)
+    bool m_fInverse;  // list of the identifiers not matched (leading '~')
+    bool m_fEmpty;  // no expression
+    std::vector<uint32_t> m_Pages;  // per page: none, all or bitmap
+    std::vector<std::vector<uint64_t> > m_Bitmaps;  // distinct bitmaps of the pages
+public:
+    CCanFilter(bool fExtended = false);
+    virtual ~CCanFilter() {};
+
+    bool Compile(const char *pszList);  // false on syntax error (filter unchanged)
+    void Clear();
+    void MatchAll() { Clear(); m_fInverse = true; m_fEmpty = false; }  // as '~' with no identifier
+
+    bool IsEmpty() const { return m_fEmpty; }
+    bool IsInverse() const { return m_fInverse; }
+    size_t Bitmaps() const { return m_Bitmaps.size(); }
+
+    bool Contains(uint32_t u32Id) const {  // in the list (ignoring '~')
+        if (u32Id > m_u32MaxId)
+            return false;
+        uint32_t u32Page = m_Pages[u32Id >> PAGE_BITS];
+        if (u32Page < 2U)
+            return u32Page == PAGE_ALL;
+        return ((m_Bitmaps[u32Page - 2U][(u32Id >> 6) & ((1U << (PAGE_BITS - 6U)) - 1U)] >> (u32Id & 63U)) & 1U) ? true : false;
+    }
+    bool Matches(uint32_t u32Id) const { return Contains(u32Id) != m_fInverse; }  // in the list (with '~': not in the list)
+};
+
+#endif // FILTER_H_INCLUDED
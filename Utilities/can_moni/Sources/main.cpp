@@ -53,8 +53,11 @@ static const char LICENSE[]     = "This program is free software: you can redist
 
 #include "PeakCAN_Defines.h"
 #include "PeakCAN.h"
+#include "PeakCAN_J1939.h"
+#include "PeakCAN_Recorder.h"
 #include "Timer.h"
 #include "Message.h"
+#include "Filter.h"
 
 #include <stdio.h>
 #include <stdint.h>
@@ -64,8 +67,10 @@ static const char LICENSE[]     = "This program is free software: you can redist
 #include <signal.h>
 #include <errno.h>
 #include <time.h>
+#include <ctype.h>
 
 #include <inttypes.h>
+#include <vector>
 
 #ifdef _MSC_VER
 //not #if defined(_WIN32) || defined(_WIN64) because we have strncasecmp in mingw
@@ -73,8 +78,6 @@ static const char LICENSE[]     = "This program is free software: you can redist
 #define strcasecmp _stricmp
 #endif
 
-#define MAX_ID  (CAN_MAX_STD_ID + 1)
-
 extern "C" {
 #include "dosopt.h"
 }
@@ -117,7 +120,15 @@ extern "C" {
 #define QUESTION_MARK   36
 #define ABOUT           37
 #define CHARACTER_MJU   38
-#define MAX_OPTIONS     39
+#define J1939_STR       39
+#define RECORD_STR      40
+#define RECORDSIZE_STR  41
+#define TRIGGER_STR     42
+#define XTRIGGER_STR    43
+#define PRETRIGGER_STR  44
+#define POSTTRIGGER_STR 45
+#define XEXCLUDE_STR    46
+#define MAX_OPTIONS     47
 
 static char* option[MAX_OPTIONS] = {
     (char*)"BAUDRATE", (char*)"bd",
@@ -139,14 +150,23 @@ static char* option[MAX_OPTIONS] = {
     (char*)"LIST-BOARDS", (char*)"list",
     (char*)"TEST-BOARDS", (char*)"test",
     (char*)"HELP", (char*)"?",
-    (char*)"ABOUT", (char*)"�"
+    (char*)"ABOUT", (char*)"�",
+    (char*)"J1939",
+    (char*)"RECORD",
+    (char*)"RECORD-SIZE",
+    (char*)"TRIGGER",
+    (char*)"XTRIGGER",
+    (char*)"PRE-TRIGGER",
+    (char*)"POST-TRIGGER",
+    (char*)"XEXCLUDE"
 };
 
-static int get_exclusion(const char *arg);  // TODO: make it a member function
+static int get_trigger(const char *arg, int xtd);
 
 class CCanDriver : public CPeakCAN {
 public:
     uint64_t ReceptionLoop();
+    uint64_t RecorderLoop();
 public:
     static int ListCanDevices(const char *vendor = NULL);
     static int TestCanDevices(CANAPI_OpMode_t opMode, const char *vendor = NULL);
@@ -187,13 +207,22 @@ const CCanDriver::TCanDevice CCanDriver::m_CanDevices[] = {
 };
 
 static void sigterm(int signo);
+static void sigtrigger(int signo);
 static void usage(FILE *stream, const char *program);
 static void version(FILE *stream, const char *program);
 
-static int can_id[MAX_ID];
-static int can_id_xtd = 1;
+static CCanFilter std_filter(false);  // excluded 11-bit identifiers
+static CCanFilter xtd_filter(true);  // excluded 29-bit identifiers
+static int j1939 = 0;
 static volatile int running = 1;
 
+static const char *record_file = NULL;
+static uint64_t record_size = PEAKCAN_RECORDER_RECORDS;
+static uint32_t pre_trigger = PEAKCAN_RECORDER_PRE;
+static uint32_t post_trigger = PEAKCAN_RECORDER_POST;
+static std::vector<CPeakCANRecorder::STrigger> triggers;
+static CPeakCANRecorder *volatile black_box = NULL;
+
 static CCanDriver canDriver = CCanDriver();
 
 // TODO: this code could be made more C++ alike
@@ -211,6 +240,9 @@ int main(int argc, const char * argv[]) {
     CCanMessage::EFormatOption modeAscii = CCanMessage::OptionOn; int ma = 0;
     CCanMessage::EFormatWraparound wraparound = CCanMessage::OptionWraparoundNo; int mw = 0;
     int exclude = 0;
+    int xexclude = 0;
+    int rs = 0, pre = 0, post = 0;
+    unsigned long long ull;
 //    char *script_file = NULL;
     int verbose = 0;
     int num_boards = 0;
@@ -236,10 +268,6 @@ int main(int argc, const char * argv[]) {
     (void)CCanMessage::SetAsciiFormat(modeAscii);
     (void)CCanMessage::SetWraparound(wraparound);
 
-    /* exclude list (11-bit IDs only) */
-    for (int i = 0; i < MAX_ID; i++) {
-        can_id[i] = 1;
-    }
     /* signal handler */
     if ((signal(SIGINT, sigterm) == SIG_ERR) ||
 #if !defined(_WIN32) && !defined(_WIN64)
@@ -586,11 +614,91 @@ int main(int argc, const char * argv[]) {
                 fprintf(stderr, "%s: missing argument for option /EXCLUDE\n", basename(argv[0]));
                 return 1;
             }
-            if (!get_exclusion(optarg)) {
+            if (!std_filter.Compile(optarg)) {
                 fprintf(stderr, "%s: illegal argument for option /EXCLUDE\n", basename(argv[0]));
                 return 1;
             }
             break;
+        case XEXCLUDE_STR:
+            if ((xexclude++)) {
+                fprintf(stderr, "%s: duplicated option /XEXCLUDE\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) == NULL) {
+                fprintf(stderr, "%s: missing argument for option /XEXCLUDE\n", basename(argv[0]));
+                return 1;
+            }
+            if (!xtd_filter.Compile(optarg)) {
+                fprintf(stderr, "%s: illegal argument for option /XEXCLUDE\n", basename(argv[0]));
+                return 1;
+            }
+            break;
+        case J1939_STR:
+            if ((j1939++)) {
+                fprintf(stderr, "%s: duplicated option /J1939\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) != NULL) {
+                fprintf(stderr, "%s: illegal argument for option /J1939\n", basename(argv[0]));
+                return 1;
+            }
+            break;
+        case RECORD_STR:
+            if (record_file) {
+                fprintf(stderr, "%s: duplicated option /RECORD\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) == NULL) {
+                fprintf(stderr, "%s: missing argument for option /RECORD\n", basename(argv[0]));
+                return 1;
+            }
+            record_file = optarg;
+            break;
+        case RECORDSIZE_STR:
+            if ((rs++)) {
+                fprintf(stderr, "%s: duplicated option /RECORD-SIZE\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) == NULL) {
+                fprintf(stderr, "%s: missing argument for option /RECORD-SIZE\n", basename(argv[0]));
+                return 1;
+            }
+            if ((sscanf_s(optarg, "%llu", &ull) != 1) || (ull < 1ULL) || (ull > (unsigned long long)PEAKCAN_RECORDER_MAX_RECORDS)) {
+                fprintf(stderr, "%s: illegal argument for option /RECORD-SIZE\n", basename(argv[0]));
+                return 1;
+            }
+            record_size = (uint64_t)ull;
+            break;
+        case TRIGGER_STR:
+        case XTRIGGER_STR:
+            if ((optarg = getOptionParameter()) == NULL) {
+                fprintf(stderr, "%s: missing argument for option /%s\n", basename(argv[0]), option[optind]);
+                return 1;
+            }
+            if (!get_trigger(optarg, optind == XTRIGGER_STR)) {
+                fprintf(stderr, "%s: illegal argument for option /%s\n", basename(argv[0]), option[optind]);
+                return 1;
+            }
+            break;
+        case PRETRIGGER_STR:
+        case POSTTRIGGER_STR:
+            if ((optind == PRETRIGGER_STR) ? (pre++) : (post++)) {
+                fprintf(stderr, "%s: duplicated option /%s\n", basename(argv[0]), option[optind]);
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) == NULL) {
+                fprintf(stderr, "%s: missing argument for option /%s\n", basename(argv[0]), option[optind]);
+                return 1;
+            }
+            if ((sscanf_s(optarg, "%llu", &ull) != 1) || (ull > (unsigned long long)UINT32_MAX)) {
+                fprintf(stderr, "%s: illegal argument for option /%s\n", basename(argv[0]), option[optind]);
+                return 1;
+            }
+            if (optind == PRETRIGGER_STR)
+                pre_trigger = (uint32_t)ull;
+            else
+                post_trigger = (uint32_t)ull;
+            break;
         case LISTBOARDS_STR:
         case LISTBOARDS_CHR:
             fprintf(stdout, "%s\n%s\n\n%s\n\n", APPLICATION, COPYRIGHT, WARRANTY);
@@ -618,6 +726,11 @@ int main(int argc, const char * argv[]) {
             return 1;
         }
     }
+    /* - with '~' the other identifier format is excluded too, unless given by its own option */
+    if (std_filter.IsInverse() && !xexclude)
+        xtd_filter.MatchAll();
+    if (xtd_filter.IsInverse() && !exclude)
+        std_filter.MatchAll();
     /* - check if one and only one <interface> is given */
     for (i = 1; i < argc; i++) {
         if (!isOption(argc, (char**)argv, MAX_OPTIONS, option, i)) {
@@ -644,6 +757,19 @@ int main(int argc, const char * argv[]) {
         fprintf(stderr, "%s: illegal combination of options /MODE and /BAUDRATE\n", basename(argv[0]));
         return 1;
     }
+    /* - check recorder options */
+    if (!record_file && (rs || pre || post || !triggers.empty())) {
+        fprintf(stderr, "%s: option /RECORD missing\n", basename(argv[0]));
+        return 1;
+    }
+    if (record_file && j1939) {
+        fprintf(stderr, "%s: illegal combination of options /RECORD and /J1939\n", basename(argv[0]));
+        return 1;
+    }
+    if (record_file && (exclude || xexclude)) {
+        fprintf(stderr, "%s: illegal combination of options /RECORD and /%s\n", basename(argv[0]), exclude ? "EXCLUDE" : "XEXCLUDE");
+        return 1;
+    }
     /* CAN Monitor for PEAK PCAN interfaces */
     fprintf(stdout, "%s\n%s\n\n%s\n\n", APPLICATION, COPYRIGHT, WARRANTY);
 
@@ -731,7 +857,10 @@ int main(int argc, const char * argv[]) {
     }
     fprintf(stdout, "OK!\n");
     /* - do your job well: */
-    canDriver.ReceptionLoop();
+    if (record_file)
+        canDriver.RecorderLoop();
+    else
+        canDriver.ReceptionLoop();
     /* - show interface information */
     if ((device = canDriver.GetHardwareVersion()) != NULL)
         fprintf(stdout, "Hardware: %s\n", device);
@@ -832,85 +961,136 @@ uint64_t CCanDriver::ReceptionLoop() {
     char string[CANPROP_MAX_STRING_LENGTH+1];
     memset(string, 0, CANPROP_MAX_STRING_LENGTH+1);
 
+    /* J1939: passive engine to reassemble BAM and RTS/CTS transfers */
+    CPeakCANJ1939 monitor(*this);
+    (void)monitor.SubscribeDefault([](const CPeakCANJ1939::SMessage &j1939_msg) {
+        if (j1939_msg.fTransport) {
+            fprintf(stdout, "  J1939 TP PGN=%05" PRIX32 "h P=%u SA=%02Xh DA=%02Xh length=%u",
+                j1939_msg.identifier.u32PGN, j1939_msg.identifier.u8Priority,
+                j1939_msg.identifier.u8Source, j1939_msg.identifier.u8Destination, (unsigned)j1939_msg.data.size());
+            for (size_t i = 0U; i < j1939_msg.data.size(); i++)
+                fprintf(stdout, "%s%02X", (i % 16U) ? " " : "\n    ", j1939_msg.data[i]);
+            fprintf(stdout, "\n");
+        }
+    });
     fprintf(stderr, "\nPress ^C to abort.\n\n");
     while(running) {
-        if ((retVal = ReadMessage(message)) == CCANAPI::NoError) {
-            if ((((message.id < MAX_ID) && can_id[message.id]) || ((message.id >= MAX_ID) && can_id_xtd)) &&
+        /* - J1939: finite time-out, so that aborted transfers time out (T1..T4) */
+        if ((retVal = ReadMessage(message, j1939 ? PEAKCAN_J1939_POLL : CANREAD_INFINITE)) == CCANAPI::NoError) {
+            if (!(message.xtd ? xtd_filter.Matches(message.id) : std_filter.Matches(message.id)) &&
                 !message.sts) {
                 (void)CCanMessage::Format(message, ++frames, string, CANPROP_MAX_STRING_LENGTH);
-                fprintf(stdout, "%s\n", string);
-            }
+                if (j1939 && message.xtd) {
+                    CPeakCANJ1939::SIdentifier id = CPeakCANJ1939::Decode(message.id);
+                    fprintf(stdout, "%s  PGN=%05" PRIX32 "h P=%u SA=%02Xh DA=%02Xh\n", string,
+                        id.u32PGN, id.u8Priority, id.u8Source, id.u8Destination);
+                } else
+                    fprintf(stdout, "%s\n", string);
+            }
+            if (j1939)
+                monitor.Process(message);
         }
+        if (j1939)
+            monitor.Expire();
     }
     fprintf(stdout, "\n");
     return frames;
 }
 
-static int get_exclusion(const char *arg)
+uint64_t CCanDriver::RecorderLoop() {
+    CPeakCANRecorder recorder(*this);
+    CPeakCANRecorder::SStatistics statistics;
+    CANAPI_Return_t retVal;
+
+    /* black-box: circular capture file, snapshots around each trigger */
+    fprintf(stdout, "Capture=%s...", record_file);
+    fflush(stdout);
+    if ((retVal = recorder.Open(record_file, record_size)) != CCANAPI::NoError) {
+        fprintf(stdout, "FAILED!\n");
+        fprintf(stderr, "+++ error: capture file could not be opened (%i)\n", retVal);
+        return 0U;
+    }
+    fprintf(stdout, "OK!\n");
+    for (size_t i = 0U; i < triggers.size(); i++)
+        (void)recorder.AddTrigger(triggers[i]);
+    (void)recorder.SetWindow(pre_trigger, post_trigger);
+    (void)recorder.SetHandler([](const CPeakCANRecorder::SSnapshot &snapshot) {
+        static const char *reason[] = { "message", "bus off", "error frame", "signal" };
+        if (snapshot.fSaved)
+            fprintf(stdout, "Snapshot #%u (%s): %s (%" PRIu64 " records, %" PRIu64 " lost)\n",
+                snapshot.u32Number, reason[snapshot.eReason], snapshot.strFile.c_str(),
+                snapshot.u64Records, snapshot.u64Lost);
+        else
+            fprintf(stderr, "+++ error: snapshot #%u could not be written to %s\n",
+                snapshot.u32Number, snapshot.strFile.c_str());
+        fflush(stdout);
+    });
+    if ((retVal = recorder.Start()) != CCANAPI::NoError) {
+        fprintf(stderr, "+++ error: recorder could not be started (%i)\n", retVal);
+        (void)recorder.Close();
+        return 0U;
+    }
+    black_box = &recorder;
+#if defined(_WIN32) || defined(_WIN64)
+    (void)signal(SIGBREAK, sigtrigger);
+    fprintf(stderr, "\nPress ^C to abort, ^Break to take a snapshot.\n\n");
+#else
+    (void)signal(SIGUSR1, sigtrigger);
+    fprintf(stderr, "\nPress ^C to abort, send SIGUSR1 to take a snapshot.\n\n");
+#endif
+    while(running) {
+        CTimer::Delay(100U * CTimer::MSEC);
+    }
+    (void)recorder.Stop();
+    black_box = NULL;
+    recorder.GetStatistics(statistics);
+    fprintf(stdout, "\nRecords=%" PRIu64 ", triggers=%" PRIu64 ", snapshots=%" PRIu64 "\n",
+        statistics.u64Records, statistics.u64Triggers, statistics.u64Snapshots);
+    (void)recorder.Close();
+    return statistics.u64Records;
+}
+
+static int get_trigger(const char *arg, int xtd)
 {
-    char *val, *end;
-    int i, inv = 0;
-    long id, last = -1;
+    CPeakCANRecorder::STrigger trigger = {};
+    char *end;
+    unsigned long id;
 
     if (!arg)
         return 0;
 
-    val = (char *)arg;
-    if (*val == '~') {
-        inv = 1;
-        val++;
-    }
-    for (;;) {
+    if (!xtd && (!strcasecmp(arg, "BUSOFF") || !strcasecmp(arg, "BUS-OFF")))
+        trigger.eType = CPeakCANRecorder::TriggerBusOff;
+    else if (!xtd && (!strcasecmp(arg, "ERROR") || !strcasecmp(arg, "ERR")))
+        trigger.eType = CPeakCANRecorder::TriggerErrorFrame;
+    else {
+        /* <id>[:<data>] with <data> = byte pairs in hex, '--' = any */
         errno = 0;
-        id = strtol(val, &end, 0);
-
-        if (errno == ERANGE && (id == LONG_MAX || id == LONG_MIN))
-            return 0;
-        if (errno != 0 && id == 0)
-            return 0;
-        if (val == end)
+        id = strtoul(arg, &end, 0);
+        if ((errno != 0) || (end == arg) || (id > (xtd ? CAN_MAX_XTD_ID : CAN_MAX_STD_ID)))
             return 0;
-
-        if (id < MAX_ID)
-            can_id[id] = 0;
-
-        if (*end == '\0') {
-            if (last != -1) {
-                while (last != id) {
-                    if (last < id)
-                        last++;
-                    else
-                        last--;
-                    can_id[last] = 0;
-                }
-                /*last = -1; <<< dead store */
-            }
-            break;
-        }
-        if (*end == ',') {
-            if (last != -1) {
-                while (last != id) {
-                    if (last < id)
-                        last++;
-                    else
-                        last--;
-                    can_id[last] = 0;
+        trigger.eType = CPeakCANRecorder::TriggerMessage;
+        trigger.u32Id = (uint32_t)id;
+        trigger.fXtd = xtd ? true : false;
+        if (*end == ':') {
+            for (end++; *end != '\0'; end += 2) {
+                if ((trigger.u8Length >= 8U) || (end[1] == '\0'))
+                    return 0;
+                if ((end[0] == '-') && (end[1] == '-')) {
+                    trigger.u8Length++;
+                    continue;
                 }
-                last = -1;
+                if (!isxdigit((unsigned char)end[0]) || !isxdigit((unsigned char)end[1]))
+                    return 0;
+                char byte[3] = { end[0], end[1], '\0' };
+                trigger.u8Data[trigger.u8Length] = (uint8_t)strtoul(byte, NULL, 16);
+                trigger.u8Mask[trigger.u8Length++] = 0xFFU;
             }
         }
-        else if (*end == '-')
-            last = id;
-        else
+        else if (*end != '\0')
             return 0;
-
-        val = ++end;
-    }
-    if (inv) {
-        for (i = 0; i < MAX_ID; i++)
-            can_id[i] = !can_id[i];
     }
-    can_id_xtd = !inv;
+    triggers.push_back(trigger);
     return 1;
 }
 
@@ -926,6 +1106,18 @@ static void sigterm(int signo)
     (void)signo;
 }
 
+/** @brief       signal handler to take a snapshot (SIGUSR1 or Ctrl+Break).
+ *
+ *  @param[in]   signo - signal number (SIGUSR1, SIGBREAK)
+ */
+static void sigtrigger(int signo)
+{
+    CPeakCANRecorder *recorder = black_box;
+    if (recorder)
+        recorder->Trigger();
+    (void)signal(signo, sigtrigger);
+}
+
 /** @brief       shows a help screen with all command-line options.
  *
  *  @param[in]   stream  - output stream (e.g. stdout)
@@ -939,7 +1131,11 @@ static void usage(FILE *stream, const char *program)
     fprintf(stream, "  %-8s              [/Data=(HEX|DEC|OCT)]\n", "");
     fprintf(stream, "  %-8s              [/Ascii=(ON|OFF)]\n", "");
     fprintf(stream, "  %-8s              [/Wraparound=(No|8|10|16|32|64)]\n", "");
-    fprintf(stream, "  %-8s              [/eXclude=[~]<id>[-<id>]{,<id>[-<id>]}]\n", "");
+    fprintf(stream, "  %-8s              [/eXclude=[~]<id-list>] [/XEXCLUDE=[~]<id-list>]\n", "");
+    fprintf(stream, "  %-8s              [/J1939]\n", "");
+    fprintf(stream, "  %-8s              [/RECORD=<file> [/RECORD-SIZE=<records>]\n", "");
+    fprintf(stream, "  %-8s               {/TRIGGER=<trigger> | /XTRIGGER=<pattern>}\n", "");
+    fprintf(stream, "  %-8s               [/PRE-TRIGGER=<ms>] [/POST-TRIGGER=<ms>]]\n", "");
     //fprintf(stream, "  %-8s              [/Script=<filename>]\n", "");
     fprintf(stream, "  %-8s              [/RTR=(Yes|No)] [/XTD=(Yes|No)]\n", "");
     fprintf(stream, "  %-8s              [/ERR=(No|Yes) | /ERROR-FRAMES]\n", "");
@@ -956,8 +1152,20 @@ static void usage(FILE *stream, const char *program)
     fprintf(stream, "  %-8s (/HELP  | /?)\n", program);
     fprintf(stream, "  %-8s (/ABOUT | /�)\n", program);
     fprintf(stream, "Options:\n");
-    fprintf(stream, "  <id>        CAN identifier (11-bit)\n");
+    fprintf(stream, "  <id-list>   <id>, <id>-<id> or <id>/<mask> (mask bits set = compared),\n");
+    fprintf(stream, "              comma-separated; with '~' all other identifiers are excluded\n");
+    fprintf(stream, "  <id>        CAN identifier (11-bit; /XEXCLUDE: 29-bit)\n");
     fprintf(stream, "  <interface> CAN interface board (list all with /LIST)\n");
+    fprintf(stream, "  /J1939      show PGN, priority, source and destination of 29-bit\n");
+    fprintf(stream, "              identifiers and reassembled BAM and RTS/CTS transfers\n");
+    fprintf(stream, "  <file>      circular capture file of the black-box recorder (memory-mapped);\n");
+    fprintf(stream, "              snapshots are written to <file>.<number>\n");
+    fprintf(stream, "  <records>   size of the capture file in records (default=%u, max=%u)\n", PEAKCAN_RECORDER_RECORDS, PEAKCAN_RECORDER_MAX_RECORDS);
+    fprintf(stream, "  <trigger>   BUSOFF, ERROR (requires /ERR=Yes), or a <pattern>\n");
+    fprintf(stream, "  <pattern>   <id>[:<data>] with <data> as hex byte pairs, '--' = any byte\n");
+    fprintf(stream, "              (/XTRIGGER: 29-bit identifier), e.g. 0x7E8:--22F1\n");
+    fprintf(stream, "  <ms>        pre-/post-trigger window in milliseconds (default=%u/%u);\n", PEAKCAN_RECORDER_PRE, PEAKCAN_RECORDER_POST);
+    fprintf(stream, "              SIGUSR1 (^Break on Windows) also triggers a snapshot\n");
     fprintf(stream, "  <baudrate>  CAN baud rate index (default=3):\n");
     fprintf(stream, "              0 = 1000 kbps\n");
     fprintf(stream, "              1 = 800 kbps\n");
@@ -0,0 +1,868 @@
+//  SPDX-License-Identifier: GPL-3.0-or-later
+//
+//  CAN Statistics for PEAK PCAN Captures
+//
+//  Copyright (c) 2021 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#include "build_no.h"
+#define VERSION_MAJOR    0
+#define VERSION_MINOR    1
+#define VERSION_PATCH    0
+#define VERSION_BUILD    BUILD_NO
+#define VERSION_STRING   TOSTRING(VERSION_MAJOR) "." TOSTRING(VERSION_MINOR) "." TOSTRING(VERSION_PATCH) " (" TOSTRING(BUILD_NO) ")"
+#if defined(_WIN64)
+#define PLATFORM        "x64"
+#elif defined(_WIN32)
+#define PLATFORM        "x86"
+#elif defined(__linux__)
+#define PLATFORM        "Linux"
+#elif defined(__APPLE__)
+#define PLATFORM        "macOS"
+#else
+#error Unsupported architecture
+#endif
+static const char APPLICATION[] = "CAN Statistics for PEAK PCAN Captures, Version " VERSION_STRING;
+static const char COPYRIGHT[]   = "Copyright (c) 2021 by Uwe Vogt, UV Software, Berlin";
+static const char WARRANTY[]    = "This program comes with ABSOLUTELY NO WARRANTY!\n\n" \
+                                  "This is free software, and you are welcome to redistribute it\n" \
+                                  "under certain conditions; type `/ABOUT' for details.";
+static const char LICENSE[]     = "This program is free software: you can redistribute it and/or modify\n" \
+                                  "it under the terms of the GNU General Public License as published by\n" \
+                                  "the Free Software Foundation, either version 3 of the License, or\n" \
+                                  "(at your option) any later version.\n\n" \
+                                  "This program is distributed in the hope that it will be useful,\n" \
+                                  "but WITHOUT ANY WARRANTY; without even the implied warranty of\n" \
+                                  "MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the\n" \
+                                  "GNU General Public License for more details.\n\n" \
+                                  "You should have received a copy of the GNU General Public License\n" \
+                                  "along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+#define basename(x)  "can_stat" // FIXME: Where is my `basename' function?
+
+#include "PeakCAN_Defines.h"
+#include "PeakCAN.h"
+#include "PeakCAN_Recorder.h"
+#include "PeakCAN_Compact.h"
+#include "PeakCAN_BusLoad.h"
+#include "PeakCAN_Merge.h"
+#include "can_msg.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <errno.h>
+#include <math.h>
+
+#include <inttypes.h>
+
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#ifdef _MSC_VER
+//not #if defined(_WIN32) || defined(_WIN64) because we have strncasecmp in mingw
+#define strncasecmp _strnicmp
+#define strcasecmp _stricmp
+#endif
+
+#define DEFAULT_INTERVAL  1000U  // bus-load interval in [ms]
+#define CHUNKS_PER_THREAD  8U  // for load balancing
+#define MAX_THREADS  256U
+
+extern "C" {
+#include "dosopt.h"
+}
+#define BAUDRATE_STR    0
+#define BAUDRATE_CHR    1
+#define BITRATE_STR     2
+#define BITRATE_CHR     3
+#define VERBOSE_STR     4
+#define VERBOSE_CHR     5
+#define INTERVAL_STR    6
+#define INTERVAL_CHR    7
+#define THREADS_STR     8
+#define THREADS_CHR     9
+#define SERIES_STR      10
+#define SERIES_CHR      11
+#define MERGE_STR       12
+#define MERGE_CHR       13
+#define WINDOW_STR      14
+#define WINDOW_CHR      15
+#define MODE_TIME_STR   16
+#define MODE_TIME_CHR   17
+#define HELP            18
+#define QUESTION_MARK   19
+#define ABOUT           20
+#define CHARACTER_MJU   21
+#define MAX_OPTIONS     22
+
+static char* option[MAX_OPTIONS] = {
+    (char*)"BAUDRATE", (char*)"bd",
+    (char*)"BITRATE", (char*)"br",
+    (char*)"VERBOSE", (char*)"v",
+    (char*)"INTERVAL", (char*)"i",
+    (char*)"THREADS", (char*)"t",
+    (char*)"SERIES", (char*)"s",
+    (char*)"MERGE", (char*)"m",
+    (char*)"WINDOW", (char*)"w",
+    (char*)"TIME", (char*)"tm",
+    (char*)"HELP", (char*)"?",
+    (char*)"ABOUT", (char*)"�"
+};
+
+/* statistics of one identifier (key = identifier | 29-bit flag << 31) */
+struct SIdentifier {
+    uint64_t count;                     // number of messages
+    uint64_t first, last;               // time-stamps of the first and the last message in [ns]
+    uint64_t cycles;                    // number of cycle times
+    uint64_t minimum, maximum;          // shortest and longest cycle time in [ns]
+    double sum, squares;                // sum of the cycle times (and of their squares) in [ms]
+    uint64_t busy;                      // time on the bus in [ns]
+    uint64_t dlc[CANFD_MAX_DLC + 1];    // DLC distribution
+};
+typedef std::unordered_map<uint32_t, SIdentifier> Identifiers;
+
+/* result of a chunk (and of the whole capture after merging) */
+struct SResult {
+    Identifiers identifiers;            // per-identifier statistics
+    std::vector<uint64_t> busy;         // time on the bus per interval in [ns]
+    size_t offset;                      // interval of busy[0] (from the start of the capture)
+    uint64_t messages, xtd, rtr, fdf, brs, status;
+    uint64_t errorFrames, busStates, overruns;
+    uint64_t torn;                      // records torn or overwritten while reading
+    uint64_t first, last;               // time-stamps of the first and the last record in [ns]
+};
+
+/* a capture file: circular/snapshot capture (records) or compact capture (blocks) */
+struct SCapture {
+    CPeakCANMappedFile file;            // mapped capture file
+    bool compact;                       // compact capture format
+    const CPeakCANRecorder::SHeader *header;  // capture file: header
+    const CPeakCANRecorder::SRecord *records; // capture file: records
+    uint64_t first, head;               // capture file: sequence numbers [first, head)
+    uint32_t blockSize;                 // compact file: maximum block size
+    std::vector<uint64_t> blocks;       // compact file: offsets of the blocks
+    uint64_t units;                     // number of records or blocks
+    uint64_t origin;                    // time-stamp of the first record in [ns]
+    uint64_t interval;                  // bus-load interval in [ns]
+    CANAPI_BusSpeed_t speed;            // bus speed for the frame durations
+};
+
+static int open_capture(const char *path, SCapture &capture);
+static void analyze(const SCapture &capture, uint64_t begin, uint64_t end, SResult &result);
+static void merge(SResult &total, const SResult &chunk);
+static void print_statistics(const SCapture &capture, const SResult &result, FILE *series);
+static int merge_captures(const std::vector<const char*> &paths, unsigned window, int verbose);
+
+static void usage(FILE *stream, const char *program);
+static void version(FILE *stream, const char *program);
+
+int main(int argc, const char * argv[]) {
+    int i;
+    int optind;
+    char *optarg;
+
+    const char *path = NULL;
+    std::vector<const char*> paths;
+    const char *series_file = NULL;
+    int baudrate = CANBDR_250; int bd = 0;
+    unsigned long ul;
+    unsigned interval = DEFAULT_INTERVAL; int iv = 0;
+    unsigned threads = std::thread::hardware_concurrency(); int th = 0;
+    int verbose = 0;
+    int merging = 0;
+    unsigned window = PEAKCAN_MERGE_WINDOW; int wd = 0;
+    msg_fmt_timestamp_t modeTime = MSG_FMT_TIMESTAMP_ZERO; int mt = 0;
+
+    CANAPI_Bitrate_t bitrate = {};
+    bitrate.index = CANBTR_INDEX_250K;
+
+    /* default bit-timing */
+    CANAPI_BusSpeed_t speed = {};
+    (void)CPeakCAN::MapIndex2Bitrate(bitrate.index, bitrate);
+    (void)CPeakCAN::MapBitrate2Speed(bitrate, speed);
+
+    /* scan command-line */
+    while ((optind = getOption(argc, (char**)argv, MAX_OPTIONS, option)) != EOF) {
+        switch (optind) {
+        case BAUDRATE_STR:
+        case BAUDRATE_CHR:
+            if ((bd++)) {
+                fprintf(stderr, "%s: duplicated option /BAUDRATE\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) == NULL) {
+                fprintf(stderr, "%s: missing argument for option /BAUDRATE\n", basename(argv[0]));
+                return 1;
+            }
+            if (sscanf_s(optarg, "%i", &baudrate) != 1) {
+                fprintf(stderr, "%s: illegal argument for option /BAUDRATE\n", basename(argv[0]));
+                return 1;
+            }
+            switch (baudrate) {
+            case 1000: case 1000000: bitrate.index = CANBTR_INDEX_1M; break;
+            case 800:  case 800000:  bitrate.index = CANBTR_INDEX_800K; break;
+            case 500:  case 500000:  bitrate.index = CANBTR_INDEX_500K; break;
+            case 250:  case 250000:  bitrate.index = CANBTR_INDEX_250K; break;
+            case 125:  case 125000:  bitrate.index = CANBTR_INDEX_125K; break;
+            case 100:  case 100000:  bitrate.index = CANBTR_INDEX_100K; break;
+            case 50:   case 50000:   bitrate.index = CANBTR_INDEX_50K; break;
+            case 20:   case 20000:   bitrate.index = CANBTR_INDEX_20K; break;
+            case 10:   case 10000:   bitrate.index = CANBTR_INDEX_10K; break;
+            default:                 bitrate.index = -baudrate; break;
+            }
+            if (CPeakCAN::MapIndex2Bitrate(bitrate.index, bitrate) != CCANAPI::NoError) {
+                fprintf(stderr, "%s: illegal argument for option /BAUDRATE\n", basename(argv[0]));
+                return 1;
+            }
+            if (CPeakCAN::MapBitrate2Speed(bitrate, speed) != CCANAPI::NoError) {
+                fprintf(stderr, "%s: illegal argument for option /BAUDRATE\n", basename(argv[0]));
+                return 1;
+            }
+            break;
+        case BITRATE_STR:
+        case BITRATE_CHR:
+            if ((bd++)) {
+                fprintf(stderr, "%s: duplicated option /BITRATE\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) == NULL) {
+                fprintf(stderr, "%s: missing argument for option /BITRATE\n", basename(argv[0]));
+                return 1;
+            }
+            if (CPeakCAN::MapString2Bitrate(optarg, bitrate) != CCANAPI::NoError) {
+                fprintf(stderr, "%s: illegal argument for option /BITRATE\n", basename(argv[0]));
+                return 1;
+            }
+            if (CPeakCAN::MapBitrate2Speed(bitrate, speed) != CCANAPI::NoError) {
+                fprintf(stderr, "%s: illegal argument for option /BITRATE\n", basename(argv[0]));
+                return 1;
+            }
+            break;
+        case VERBOSE_STR:
+        case VERBOSE_CHR:
+            if (verbose) {
+                fprintf(stderr, "%s: duplicated option /VERBOSE\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) != NULL) {
+                fprintf(stderr, "%s: illegal argument for option /VERBOSE\n", basename(argv[0]));
+                return 1;
+            }
+            verbose = 1;
+            break;
+        case INTERVAL_STR:
+        case INTERVAL_CHR:
+            if ((iv++)) {
+                fprintf(stderr, "%s: duplicated option /INTERVAL\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) == NULL) {
+                fprintf(stderr, "%s: missing argument for option /INTERVAL\n", basename(argv[0]));
+                return 1;
+            }
+            if ((sscanf_s(optarg, "%lu", &ul) != 1) || (ul == 0UL) || (ul > 86400000UL)) {
+                fprintf(stderr, "%s: illegal argument for option /INTERVAL\n", basename(argv[0]));
+                return 1;
+            }
+            interval = (unsigned)ul;
+            break;
+        case THREADS_STR:
+        case THREADS_CHR:
+            if ((th++)) {
+                fprintf(stderr, "%s: duplicated option /THREADS\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) == NULL) {
+                fprintf(stderr, "%s: missing argument for option /THREADS\n", basename(argv[0]));
+                return 1;
+            }
+            if ((sscanf_s(optarg, "%lu", &ul) != 1) || (ul == 0UL) || (ul > MAX_THREADS)) {
+                fprintf(stderr, "%s: illegal argument for option /THREADS\n", basename(argv[0]));
+                return 1;
+            }
+            threads = (unsigned)ul;
+            break;
+        case SERIES_STR:
+        case SERIES_CHR:
+            if (series_file) {
+                fprintf(stderr, "%s: duplicated option /SERIES\n", basename(argv[0]));
+                return 1;
+            }
+            if ((series_file = getOptionParameter()) == NULL) {
+                fprintf(stderr, "%s: missing argument for option /SERIES\n", basename(argv[0]));
+                return 1;
+            }
+            break;
+        case MERGE_STR:
+        case MERGE_CHR:
+            if (merging) {
+                fprintf(stderr, "%s: duplicated option /MERGE\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) != NULL) {
+                fprintf(stderr, "%s: illegal argument for option /MERGE\n", basename(argv[0]));
+                return 1;
+            }
+            merging = 1;
+            break;
+        case WINDOW_STR:
+        case WINDOW_CHR:
+            if ((wd++)) {
+                fprintf(stderr, "%s: duplicated option /WINDOW\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) == NULL) {
+                fprintf(stderr, "%s: missing argument for option /WINDOW\n", basename(argv[0]));
+                return 1;
+            }
+            if ((sscanf_s(optarg, "%lu", &ul) != 1) || (ul > 3600000UL)) {
+                fprintf(stderr, "%s: illegal argument for option /WINDOW\n", basename(argv[0]));
+                return 1;
+            }
+            window = (unsigned)ul;
+            break;
+        case MODE_TIME_STR:
+        case MODE_TIME_CHR:
+            if ((mt++)) {
+                fprintf(stderr, "%s: duplicated option /TIME\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) == NULL) {
+                fprintf(stderr, "%s: missing argument for option /TIME\n", basename(argv[0]));
+                return 1;
+            }
+            if (!strcasecmp(optarg, "ABSOLUTE") || !strcasecmp(optarg, "ABS") || !strcasecmp(optarg, "a"))
+                modeTime = MSG_FMT_TIMESTAMP_ABSOLUTE;
+            else if (!strcasecmp(optarg, "RELATIVE") || !strcasecmp(optarg, "REL") || !strcasecmp(optarg, "r"))
+                modeTime = MSG_FMT_TIMESTAMP_RELATIVE;
+            else if (!strcasecmp(optarg, "ZERO") || !strcasecmp(optarg, "0") || !strcasecmp(optarg, "z"))
+                modeTime = MSG_FMT_TIMESTAMP_ZERO;
+            else {
+                fprintf(stderr, "%s: illegal argument for option /TIME\n", basename(argv[0]));
+                return 1;
+            }
+            break;
+        case HELP:
+        case QUESTION_MARK:
+            usage(stdout, basename(argv[0]));
+            return 0;
+        case ABOUT:
+        case CHARACTER_MJU:
+            version(stdout, basename(argv[0]));
+            return 0;
+        default:
+            usage(stderr, basename(argv[0]));
+            return 1;
+        }
+    }
+    /* - check if one and only one <file> is given (or at least one with /MERGE) */
+    for (i = 1; i < argc; i++) {
+        if (!isOption(argc, (char**)argv, MAX_OPTIONS, option, i)) {
+            if (path && !merging) {
+                fprintf(stderr, "%s: too many arguments\n", basename(argv[0]));
+                return 1;
+            }
+            path = argv[i];
+            paths.push_back(argv[i]);
+        }
+    }
+    if (!path) {
+        fprintf(stderr, "%s: not enough arguments\n", basename(argv[0]));
+        return 1;
+    }
+    if (!merging && (wd || mt)) {
+        fprintf(stderr, "%s: option /%s requires option /MERGE\n", basename(argv[0]), wd ? "WINDOW" : "TIME");
+        return 1;
+    }
+    if (!threads)
+        threads = 1U;
+    /* CAN Statistics for PEAK PCAN captures */
+    fprintf(stdout, "%s\n%s\n\n%s\n\n", APPLICATION, COPYRIGHT, WARRANTY);
+
+    /* - merge the captures of several channels into one trace */
+    if (merging) {
+        (void)msg_set_fmt_time_stamp(modeTime);
+        (void)msg_set_fmt_channel(MSG_FMT_OPTION_ON);
+        return merge_captures(paths, window, verbose);
+    }
+
+    /* - map the capture file and split it into chunks */
+    SCapture capture;
+    if (!open_capture(path, capture)) {
+        fprintf(stderr, "+++ error: capture file '%s' could not be opened (no capture or compact capture)\n", path);
+        return 1;
+    }
+    capture.interval = (uint64_t)interval * 1000000U;
+    capture.speed = speed;
+    if (verbose) {
+        if (bitrate.btr.frequency > 0) {
+            fprintf(stdout, "Bit-rate=%.0fkbps@%.1f%%",
+                speed.nominal.speed / 1000.,
+                speed.nominal.samplepoint * 100.);
+            if (speed.data.brse)
+                fprintf(stdout, ":%.0fkbps@%.1f%%",
+                    speed.data.speed / 1000.,
+                    speed.data.samplepoint * 100.);
+            fprintf(stdout, "\n");
+        }
+        else {
+            fprintf(stdout, "Baudrate=%.0fkbps@%.1f%% (index %i)\n",
+                             speed.nominal.speed / 1000.,
+                             speed.nominal.samplepoint * 100., -bitrate.index);
+        }
+        fprintf(stdout, "Capture=%s (%s, %" PRIu64 " %s, %" PRIu64 " bytes)\n", path,
+            capture.compact ? "compact" : "records", capture.units, capture.compact ? "blocks" : "records",
+            capture.file.Size());
+        fprintf(stdout, "Threads=%u\n\n", threads);
+    }
+    uint64_t chunks = (uint64_t)threads * CHUNKS_PER_THREAD;
+    if (chunks > capture.units)
+        chunks = capture.units ? capture.units : 1U;
+    std::vector<SResult> results((size_t)chunks);
+
+    /* - do your job well: analyze the chunks on all cores */
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::atomic<uint64_t> next(0U);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0U; t < threads; t++) {
+        workers.push_back(std::thread([&capture, &results, &next, chunks]() {
+            uint64_t chunk;
+            while ((chunk = next.fetch_add(1U)) < chunks)
+                analyze(capture, capture.units * chunk / chunks, capture.units * (chunk + 1U) / chunks, results[(size_t)chunk]);
+        }));
+    }
+    for (size_t t = 0U; t < workers.size(); t++)
+        workers[t].join();
+    SResult total = SResult();
+    for (size_t c = 0U; c < results.size(); c++)
+        merge(total, results[c]);   // in chunk order (cycle times across the chunk borders)
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    /* - print the statistics (and the bus-load time series) */
+    FILE *series = NULL;
+    if (series_file) {
+        if (!strcmp(series_file, "-"))
+            series = stdout;
+        else if (!(series = fopen(series_file, "w"))) {
+            fprintf(stderr, "+++ error: file '%s' could not be created\n", series_file);
+            return 1;
+        }
+    }
+    print_statistics(capture, total, series);
+    if (series && (series != stdout))
+        fclose(series);
+    if (verbose)
+        fprintf(stdout, "\nAnalyzed %" PRIu64 " bytes in %.3f s (%.1f MB/s)\n", capture.file.Size(),
+            elapsed.count(), (double)capture.file.Size() / 1.0E6 / ((elapsed.count() > 0.) ? elapsed.count() : 1.));
+    return 0;
+}
+
+/** @brief       maps a capture file (black-box recorder or snapshot) or
+ *               a compact capture file.
+ *
+ *  @param[in]   path    - name of the capture file
+ *  @param[out]  capture - the mapped capture
+ *
+ *  @returns     non-zero on success, or 0 if the file is not a capture.
+ */
+static int open_capture(const char *path, SCapture &capture)
+{
+    capture.compact = false;
+    capture.header = NULL;
+    capture.records = NULL;
+    capture.first = capture.head = capture.units = capture.origin = 0U;
+    capture.blockSize = 0U;
+    if (capture.file.Open(path) != CANERR_NOERROR)
+        return 0;
+    const uint8_t *data = capture.file.Data();
+    uint64_t size = capture.file.Size();
+    if ((size >= sizeof(CPeakCANRecorder::SHeader)) &&
+        (((const CPeakCANRecorder::SHeader*)data)->u32Magic == PEAKCAN_RECORDER_MAGIC)) {
+        const CPeakCANRecorder::SHeader *header = (const CPeakCANRecorder::SHeader*)data;
+        if ((header->u16Version != PEAKCAN_RECORDER_VERSION) ||
+            (header->u16RecordSize != (uint16_t)sizeof(CPeakCANRecorder::SRecord)) || !header->u64Capacity ||
+            (size < sizeof(CPeakCANRecorder::SHeader) + header->u64Capacity * sizeof(CPeakCANRecorder::SRecord)))
+            return 0;
+        capture.header = header;
+        capture.records = (const CPeakCANRecorder::SRecord*)(header + 1);
+        capture.head = header->u64Head;
+        capture.first = (capture.head > header->u64Capacity) ? (capture.head - header->u64Capacity) : 0U;
+        capture.units = capture.head - capture.first;
+        for (uint64_t sequence = capture.first; sequence < capture.head; sequence++) {
+            const CPeakCANRecorder::SRecord &record = capture.records[sequence % header->u64Capacity];
+            if (record.u64Sequence == (sequence + 1U)) {
+                capture.origin = CPeakCANRecorder::Nanoseconds(record);
+                break;
+            }
+        }
+        return 1;
+    }
+    if ((size >= sizeof(CPeakCANCompact::SFileHeader)) &&
+        (((const CPeakCANCompact::SFileHeader*)data)->u32Magic == PEAKCAN_COMPACT_MAGIC)) {
+        const CPeakCANCompact::SFileHeader *header = (const CPeakCANCompact::SFileHeader*)data;
+        if ((header->u16Version != PEAKCAN_COMPACT_VERSION) || !header->u32BlockSize)
+            return 0;
+        capture.compact = true;
+        capture.blockSize = header->u32BlockSize;
+        /* note: walking the block headers touches one page per block */
+        uint64_t offset = sizeof(CPeakCANCompact::SFileHeader);
+        while ((offset + sizeof(CPeakCANCompact::SBlockHeader)) <= size) {
+            CPeakCANCompact::SBlockHeader block;
+            memcpy(&block, data + offset, sizeof(block));
+            if ((offset + sizeof(block) + block.u32StoredSize) > size)
+                break;  // cut off by a crash
+            if (capture.blocks.empty())
+                capture.origin = block.u64Time;
+            capture.blocks.push_back(offset);
+            offset += sizeof(block) + block.u32StoredSize;
+        }
+        capture.units = (uint64_t)capture.blocks.size();
+        return 1;
+    }
+    return 0;
+}
+
+/** @brief       accounts a CAN message.
+ */
+static inline void account(const SCapture &capture, const CANAPI_Message_t &message, SResult &result)
+{
+    uint64_t time = (uint64_t)message.timestamp.tv_sec * 1000000000U + (uint64_t)message.timestamp.tv_nsec;
+    if (!result.first || (time < result.first))
+        result.first = time;
+    if (time > result.last)
+        result.last = time;
+    if (message.sts) {
+        result.status++;
+        return;
+    }
+    result.messages++;
+    result.xtd += message.xtd ? 1U : 0U;
+    result.rtr += message.rtr ? 1U : 0U;
+    result.fdf += message.fdf ? 1U : 0U;
+    result.brs += message.brs ? 1U : 0U;
+
+    uint64_t busy = CPeakCANBusLoad::Nanoseconds(message, capture.speed);
+    size_t bin = (time > capture.origin) ? (size_t)((time - capture.origin) / capture.interval) : 0U;
+    if (result.busy.empty())
+        result.offset = bin;
+    else if (bin < result.offset) {  // a time-stamp out of order: extend to the front
+        result.busy.insert(result.busy.begin(), result.offset - bin, 0U);
+        result.offset = bin;
+    }
+    if ((bin - result.offset) >= result.busy.size())
+        result.busy.resize(bin - result.offset + 1U, 0U);
+    result.busy[bin - result.offset] += busy;
+
+    uint32_t key = (message.id & CAN_MAX_XTD_ID) | (message.xtd ? 0x80000000U : 0U);
+    SIdentifier &identifier = result.identifiers[key];   // zero-initialized when new
+    if (identifier.count) {
+        if (time >= identifier.last) {
+            uint64_t cycle = time - identifier.last;
+            double ms = (double)cycle / 1.0E6;
+            if (!identifier.cycles || (cycle < identifier.minimum))
+                identifier.minimum = cycle;
+            if (cycle > identifier.maximum)
+                identifier.maximum = cycle;
+            identifier.cycles++;
+            identifier.sum += ms;
+            identifier.squares += ms * ms;
+        }
+    }
+    else
+        identifier.first = time;
+    identifier.last = time;
+    identifier.count++;
+    identifier.busy += busy;
+    identifier.dlc[message.dlc & CANFD_MAX_DLC]++;
+}
+
+/** @brief       analyzes the records or blocks [begin, end) of a capture.
+ */
+static void analyze(const SCapture &capture, uint64_t begin, uint64_t end, SResult &result)
+{
+    CANAPI_Message_t message;
+
+    if (!capture.compact) {
+        uint64_t capacity = capture.header->u64Capacity;
+        for (uint64_t sequence = capture.first + begin; sequence < capture.first + end; sequence++) {
+            const CPeakCANRecorder::SRecord &record = capture.records[sequence % capacity];
+            if (record.u64Sequence != (sequence + 1U)) {
+                result.torn++;
+                continue;
+            }
+            if (record.u8Type == CPeakCANRecorder::RecordEvent) {
+                result.errorFrames += (record.event.type & CANEVT_ERR_FRAME) ? 1U : 0U;
+                result.busStates += (record.event.type & CANEVT_BUS_STATE) ? 1U : 0U;
+                result.overruns += (record.event.type & CANEVT_OVERRUN) ? 1U : 0U;
+                continue;
+            }
+            message = record.message;  // a copy (the recorder may overwrite it)
+            if (record.u64Sequence != (sequence + 1U)) {
+                result.torn++;
+                continue;
+            }
+            account(capture, message, result);
+        }
+    }
+    else {
+        CPeakCANCompactBlock block;
+        const uint8_t *data = capture.file.Data();
+        for (uint64_t b = begin; b < end; b++) {
+            CPeakCANCompact::SBlockHeader header;
+            memcpy(&header, data + capture.blocks[(size_t)b], sizeof(header));
+            if (!block.Load(header, data + capture.blocks[(size_t)b] + sizeof(header), capture.blockSize)) {
+                result.torn++;
+                continue;
+            }
+            CANAPI_Return_t rc;
+            while ((rc = block.Next(message)) == CANERR_NOERROR)
+                account(capture, message, result);
+            if (rc != CANERR_RX_EMPTY)
+                result.torn++;
+        }
+    }
+}
+
+/** @brief       merges the result of a chunk into the total (in chunk order).
+ */
+static void merge(SResult &total, const SResult &chunk)
+{
+    for (Identifiers::const_iterator it = chunk.identifiers.begin(); it != chunk.identifiers.end(); ++it) {
+        const SIdentifier &b = it->second;
+        Identifiers::iterator found = total.identifiers.find(it->first);
+        if (found == total.identifiers.end()) {
+            total.identifiers[it->first] = b;
+            continue;
+        }
+        SIdentifier &a = found->second;
+        if (b.first >= a.last) {  // the cycle across the chunk border
+            uint64_t cycle = b.first - a.last;
+            double ms = (double)cycle / 1.0E6;
+            if (!a.cycles || (cycle < a.minimum))
+                a.minimum = cycle;
+            if (cycle > a.maximum)
+                a.maximum = cycle;
+            a.cycles++;
+            a.sum += ms;
+            a.squares += ms * ms;
+        }
+        if (b.cycles) {
+            if (!a.cycles || (b.minimum < a.minimum))
+                a.minimum = b.minimum;
+            if (b.maximum > a.maximum)
+                a.maximum = b.maximum;
+        }
+        a.cycles += b.cycles;
+        a.sum += b.sum;
+        a.squares += b.squares;
+        a.count += b.count;
+        a.busy += b.busy;
+        if (b.first < a.first)
+            a.first = b.first;
+        if (b.last > a.last)
+            a.last = b.last;
+        for (int i = 0; i <= CANFD_MAX_DLC; i++)
+            a.dlc[i] += b.dlc[i];
+    }
+    if ((chunk.offset + chunk.busy.size()) > total.busy.size())  // total: offset 0
+        total.busy.resize(chunk.offset + chunk.busy.size(), 0U);
+    for (size_t i = 0U; i < chunk.busy.size(); i++)
+        total.busy[chunk.offset + i] += chunk.busy[i];
+    total.messages += chunk.messages;
+    total.xtd += chunk.xtd;
+    total.rtr += chunk.rtr;
+    total.fdf += chunk.fdf;
+    total.brs += chunk.brs;
+    total.status += chunk.status;
+    total.errorFrames += chunk.errorFrames;
+    total.busStates += chunk.busStates;
+    total.overruns += chunk.overruns;
+    total.torn += chunk.torn;
+    if (chunk.first && (!total.first || (chunk.first < total.first)))
+        total.first = chunk.first;
+    if (chunk.last > total.last)
+        total.last = chunk.last;
+}
+
+/** @brief       prints the per-identifier statistics and the bus load.
+ */
+static void print_statistics(const SCapture &capture, const SResult &result, FILE *series)
+{
+    double duration = (result.last > result.first) ? (double)(result.last - result.first) / 1.0E9 : 0.;
+    double interval = (double)capture.interval;
+    double average = 0., peak = 0.;
+    size_t bins = result.busy.size();
+
+    for (size_t i = 0U; i < bins; i++) {
+        double load = (double)result.busy[i] * 100. / interval;
+        if (load > peak)
+            peak = load;
+    }
+    if (duration > 0.) {
+        uint64_t busy = 0U;
+        for (size_t i = 0U; i < bins; i++)
+            busy += result.busy[i];
+        average = (double)busy * 100. / (duration * 1.0E9);
+    }
+    fprintf(stdout, "Duration=%.3fs Messages=%" PRIu64 " (29-bit=%" PRIu64 " RTR=%" PRIu64 " FDF=%" PRIu64 " BRS=%" PRIu64 ")\n",
+        duration, result.messages, result.xtd, result.rtr, result.fdf, result.brs);
+    fprintf(stdout, "Status=%" PRIu64 " ErrorFrames=%" PRIu64 " BusStates=%" PRIu64 " Overruns=%" PRIu64 " Torn=%" PRIu64 "\n",
+        result.status, result.errorFrames, result.busStates, result.overruns, result.torn);
+    fprintf(stdout, "BusLoad=%.1f%% (peak %.1f%% per %.0fms)\n\n", average, peak, interval / 1.0E6);
+
+    /* per-identifier statistics (11-bit before 29-bit identifiers) */
+    std::map<uint32_t, const SIdentifier*> sorted;
+    for (Identifiers::const_iterator it = result.identifiers.begin(); it != result.identifiers.end(); ++it)
+        sorted[it->first] = &it->second;
+    fprintf(stdout, "%-10s %12s %10s %10s %10s %10s %9s %7s  %s\n",
+        "Identifier", "Count", "Rate[1/s]", "Min[ms]", "Avg[ms]", "Max[ms]", "Dev[ms]", "Load[%]", "DLC:Count");
+    for (std::map<uint32_t, const SIdentifier*>::const_iterator it = sorted.begin(); it != sorted.end(); ++it) {
+        const SIdentifier &s = *it->second;
+        double mean = s.cycles ? s.sum / (double)s.cycles : 0.;
+        double deviation = s.cycles ? sqrt(fabs(s.squares / (double)s.cycles - mean * mean)) : 0.;
+        if (it->first & 0x80000000U)
+            fprintf(stdout, "%08" PRIX32 "h ", it->first & CAN_MAX_XTD_ID);
+        else
+            fprintf(stdout, "%03" PRIX32 "h      ", it->first);
+        fprintf(stdout, "%12" PRIu64 " %10.1f %10.3f %10.3f %10.3f %9.3f %7.2f ",
+            s.count, (duration > 0.) ? (double)s.count / duration : 0.,
+            (double)s.minimum / 1.0E6, mean, (double)s.maximum / 1.0E6, deviation,
+            (duration > 0.) ? (double)s.busy * 100. / (duration * 1.0E9) : 0.);
+        for (int i = 0; i <= CANFD_MAX_DLC; i++)
+            if (s.dlc[i])
+                fprintf(stdout, " %i:%" PRIu64, i, s.dlc[i]);
+        fprintf(stdout, "\n");
+    }
+    /* bus-load time series: <time>,<load> (time in [s] since the first record) */
+    if (series) {
+        if (series == stdout)
+            fprintf(stdout, "\n");
+        fprintf(series, "time[s],load[%%]\n");
+        for (size_t i = 0U; i < bins; i++)
+            fprintf(series, "%.3f,%.2f\n", (double)i * interval / 1.0E9, (double)result.busy[i] * 100. / interval);
+    }
+}
+
+/** @brief       merges the captures of several channels (one per file) and
+ *               prints the messages in time-stamp order with the channel
+ *               number (the position of the file on the command line).
+ *
+ *  @param[in]   paths   - names of the capture files
+ *  @param[in]   window  - reorder window in [ms]
+ *  @param[in]   verbose - print the merge statistics
+ *
+ *  @returns     0 on success, or 1 if a file could not be opened or read.
+ */
+static int merge_captures(const std::vector<const char*> &paths, unsigned window, int verbose)
+{
+    CPeakCANMerge merger((uint32_t)window);
+    CPeakCANMerge::SStatistics statistics;
+    CANAPI_Message_t message;
+    CANAPI_Return_t rc;
+    int32_t channel;
+    uint64_t counter = 0U;
+    char *string;
+
+    for (size_t i = 0U; i < paths.size(); i++) {
+        if (merger.AddInput(paths[i], (int32_t)i) != CANERR_NOERROR) {
+            fprintf(stderr, "+++ error: capture file '%s' could not be opened (no capture or compact capture)\n", paths[i]);
+            return 1;
+        }
+        if (verbose)
+            fprintf(stdout, "Channel %i: %s\n", (int)i, paths[i]);
+    }
+    if (verbose)
+        fprintf(stdout, "Window=%ums\n\n", window);
+    while ((rc = merger.Next(message, channel)) == CANERR_NOERROR) {
+        if ((string = msg_format_message(&message, MSG_RX_MESSAGE, counter++, channel)) != NULL)
+            fprintf(stdout, "%s\n", string);
+    }
+    merger.GetStatistics(statistics);
+    if (verbose)
+        fprintf(stdout, "\nMerged %" PRIu64 " messages (late=%" PRIu64 " skipped=%" PRIu64 " pending=%" PRIu64 ")\n",
+            statistics.u64Messages, statistics.u64Late, statistics.u64Skipped, statistics.u64Pending);
+    if (rc != CANERR_RX_EMPTY) {
+        fprintf(stderr, "+++ error: compact capture file is corrupt\n");
+        return 1;
+    }
+    if (statistics.u64Late)
+        fprintf(stderr, "+++ warning: %" PRIu64 " message(s) later than the reorder window of %ums\n", statistics.u64Late, window);
+    return 0;
+}
+
+/** @brief       shows a help screen with all command-line options.
+ *
+ *  @param[in]   stream  - output stream (e.g. stdout)
+ *  @param[in]   program - base name of the program
+ */
+static void usage(FILE *stream, const char *program)
+{
+    fprintf(stream, "Usage:\n");
+    fprintf(stream, "  %-8s <file>  [/Interval=<ms>] [/Series=<csv>]\n", program);
+    fprintf(stream, "  %-8s         [/Threads=<n>] [/Verbose]\n", "");
+    fprintf(stream, "  %-8s         [/BauDrate=<baudrate> | /BitRate=<bitrate>]\n", "");
+    fprintf(stream, "  %-8s /Merge <file> <file>... [/Window=<ms>] [/TiMe=(ZERO|ABS|REL)] [/Verbose]\n", program);
+    fprintf(stream, "  %-8s (/HELP  | /?)\n", program);
+    fprintf(stream, "  %-8s (/ABOUT | /�)\n", program);
+    fprintf(stream, "Options:\n");
+    fprintf(stream, "  <file>      capture file of the black-box recorder (can_moni /RECORD),\n");
+    fprintf(stream, "              a snapshot (<file>.<number>), or a compact capture file\n");
+    fprintf(stream, "  <ms>        interval of the bus-load time series (default=%u), or\n", DEFAULT_INTERVAL);
+    fprintf(stream, "              reorder window of the merge (default=%u)\n", PEAKCAN_MERGE_WINDOW);
+    fprintf(stream, "  <csv>       file for the bus-load time series ('-' = standard output)\n");
+    fprintf(stream, "  <n>         number of worker threads (default=number of cores)\n");
+    fprintf(stream, "  /Merge      print the messages of several captures (one per channel) in\n");
+    fprintf(stream, "              time-stamp order; channel = position of the file (from 0)\n");
+    fprintf(stream, "  /TiMe       time-stamps of the merge: ZERO (default), ABS or REL\n");
+    fprintf(stream, "  <baudrate>  CAN baud rate index of the capture (default=3):\n");
+    fprintf(stream, "              0 = 1000 kbps\n");
+    fprintf(stream, "              1 = 800 kbps\n");
+    fprintf(stream, "              2 = 500 kbps\n");
+    fprintf(stream, "              3 = 250 kbps\n");
+    fprintf(stream, "              4 = 125 kbps\n");
+    fprintf(stream, "              5 = 100 kbps\n");
+    fprintf(stream, "              6 = 50 kbps\n");
+    fprintf(stream, "              7 = 20 kbps\n");
+    fprintf(stream, "              8 = 10 kbps\n");
+    fprintf(stream, "  <bitrate>   Comma-separated <key>=<value>-list:\n");
+    fprintf(stream, "              f_clock=<value>      Frequency in Hz or\n");
+    fprintf(stream, "              f_clock_mhz=<value>  Frequency in MHz\n");
+    fprintf(stream, "              nom_brp=<value>      Bit-rate prescaler (nominal)\n");
+    fprintf(stream, "              nom_tseg1=<value>    Time segment 1 (nominal)\n");
+    fprintf(stream, "              nom_tseg2=<value>    Time segment 2 (nominal)\n");
+    fprintf(stream, "              nom_sjw=<value>      Sync. jump width (nominal)\n");
+    fprintf(stream, "              nom_sam=<value>      Sampling (only SJA1000)\n");
+    fprintf(stream, "              data_brp=<value>     Bit-rate prescaler (FD data)\n");
+    fprintf(stream, "              data_tseg1=<value>   Time segment 1 (FD data)\n");
+    fprintf(stream, "              data_tseg2=<value>   Time segment 2 (FD data)\n");
+    fprintf(stream, "              data_sjw=<value>     Sync. jump width (FD data).\n");
+}
+
+/** @brief       shows version information of the program.
+ *
+ *  @param[in]   stream  - output stream (e.g. stdout)
+ *  @param[in]   program - base name of the program
+ */
+static void version(FILE *stream, const char *program)
+{
+    fprintf(stdout, "%s\n%s\n\n%s\n\n", APPLICATION, COPYRIGHT, LICENSE);
+    (void)program;
+    fprintf(stream, "Written by Uwe Vogt, UV Software, Berlin <http://www.uv-software.com/>\n");
+}
@@ -0,0 +1,157 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  Software for Industrial Communication, Motion Control and Automation
+//
+//  Copyright (c) 2021 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This class is dual-licensed under the BSD 2-Clause "Simplified" License and
+//  under the GNU General Public License v3.0 (or any later version).
+//  You can choose between one of them if you use this class.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS CLASS IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF THIS CLASS, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  This class is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This class is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this class.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "Histogram.h"
+
+#include <math.h>
+#include <inttypes.h>
+
+#define HALF  (1U << (SUB_BITS - 1U))  // buckets per power of two
+
+CHistogram::CHistogram() : m_Counts((64U - SUB_BITS + 2U) * HALF, 0U) {
+    Reset();
+}
+
+void CHistogram::Add(uint64_t u64Value) {
+    m_Counts[Index(u64Value)]++;
+    if(!m_u64Count || (u64Value < m_u64Min))
+        m_u64Min = u64Value;
+    if(u64Value > m_u64Max)
+        m_u64Max = u64Value;
+    m_dSum += (double)u64Value;
+    m_dSquares += (double)u64Value * (double)u64Value;
+    m_u64Count++;
+}
+
+void CHistogram::Reset() {
+    for(size_t i = 0; i < m_Counts.size(); i++)
+        m_Counts[i] = 0U;
+    m_u64Count = 0U;
+    m_u64Min = 0U;
+    m_u64Max = 0U;
+    m_dSum = 0.;
+    m_dSquares = 0.;
+}
+
+double CHistogram::Deviation() const {
+    if(!m_u64Count)
+        return 0.;
+    double dMean = Mean();
+    return sqrt(fabs(m_dSquares / (double)m_u64Count - dMean * dMean));
+}
+
+uint64_t CHistogram::Percentile(double dPercent) const {
+    uint64_t u64Total;
+    return Rank(dPercent, u64Total);
+}
+
+void CHistogram::Print(FILE *stream, double dScale) const {
+    uint64_t u64Value, u64Total = 0U;
+
+    fprintf(stream, "%12s %14s %10s %14s\n\n", "Value", "Percentile", "TotalCount", "1/(1-Percentile)");
+    // five ticks per half of the distance to 100 percent (like HdrHistogram)
+    for(double dPercent = 0.; m_u64Count && (u64Total < m_u64Count); ) {
+        u64Value = Rank(dPercent, u64Total);
+        if(u64Total >= m_u64Count)
+            break;
+        fprintf(stream, "%12.3f %14.12f %10" PRIu64 " %14.2f\n", (double)u64Value / dScale,
+                (double)u64Total / (double)m_u64Count, u64Total, 1. / (1. - (double)u64Total / (double)m_u64Count));
+        double dHalves = floor(log2(100. / (100. - dPercent))) + 1.;
+        dPercent += 100. / (5. * pow(2., dHalves));
+    }
+    if(m_u64Count)
+        fprintf(stream, "%12.3f %14.12f %10" PRIu64 "\n", (double)m_u64Max / dScale, 1., m_u64Count);
+    fprintf(stream, "#[Mean    = %12.3f, StdDeviation   = %12.3f]\n", Mean() / dScale, Deviation() / dScale);
+    fprintf(stream, "#[Max     = %12.3f, Total count    = %12" PRIu64 "]\n", (double)m_u64Max / dScale, m_u64Count);
+    fprintf(stream, "#[Buckets = %12u, SubBuckets     = %12u]\n", (unsigned)m_Counts.size() / HALF, HALF);
+}
+
+uint64_t CHistogram::Rank(double dPercent, uint64_t &u64Total) const {
+    u64Total = 0U;
+    if(!m_u64Count)
+        return 0U;
+    // rank of the value (nearest rank): at least one, at most all of them
+    double dRank = (dPercent / 100.) * (double)m_u64Count;
+    uint64_t u64Rank = (uint64_t)dRank;
+    if((double)u64Rank < dRank)
+        u64Rank++;
+    if(u64Rank < 1U)
+        u64Rank = 1U;
+    if(u64Rank > m_u64Count)
+        u64Rank = m_u64Count;
+    for(unsigned i = 0U; i < (unsigned)m_Counts.size(); i++) {
+        if((u64Total += m_Counts[i]) >= u64Rank)
+            return (Highest(i) < m_u64Max) ? Highest(i) : m_u64Max;
+    }
+    return m_u64Max;
+}
+
+unsigned CHistogram::Index(uint64_t u64Value) {
+    if(u64Value < (uint64_t)(HALF << 1U))
+        return (unsigned)u64Value;
+    // position of the most significant bit
+    unsigned uMsb = 0U;
+    for(unsigned uStep = 32U; uStep; uStep >>= 1U) {
+        if(u64Value >> (uMsb + uStep))
+            uMsb += uStep;
+    }
+    // shift, so that the value falls into [HALF, 2 * HALF)
+    unsigned uShift = uMsb - SUB_BITS + 1U;
+    return (uShift * HALF) + (unsigned)(u64Value >> uShift);
+}
+
+uint64_t CHistogram::Lowest(unsigned uIndex) {
+    if(uIndex < (HALF << 1U))
+        return (uint64_t)uIndex;
+    unsigned uShift = (uIndex / HALF) - 1U;
+    return (uint64_t)((uIndex % HALF) + HALF) << uShift;
+}
+
+uint64_t CHistogram::Highest(unsigned uIndex) {
+    if(uIndex < (HALF << 1U))
+        return (uint64_t)uIndex;
+    unsigned uShift = (uIndex / HALF) - 1U;
+    return Lowest(uIndex) + ((uint64_t)1 << uShift) - 1U;
+}
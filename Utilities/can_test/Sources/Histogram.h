@@ -0,0 +1,93 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  Software for Industrial Communication, Motion Control and Automation
+//
+//  Copyright (c) 2021 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This class is dual-licensed under the BSD 2-Clause "Simplified" License and
+//  under the GNU General Public License v3.0 (or any later version).
+//  You can choose between one of them if you use this class.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS CLASS IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF THIS CLASS, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  This class is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This class is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this class.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef HISTOGRAM_H_INCLUDED
+#define HISTOGRAM_H_INCLUDED
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <vector>
+
+// Log-linear histogram (HDR-style): values below 2^SUB_BITS are counted
+// exactly, above that every power of two is divided into 2^(SUB_BITS-1)
+// buckets, so the relative error of a percentile is below 2^-(SUB_BITS-1).
+class CHistogram {
+public:
+    static const unsigned SUB_BITS = 8U;  // < 1% relative error
+private:
+    std::vector<uint64_t> m_Counts;  // counts per bucket
+    uint64_t m_u64Count;  // number of values
+    uint64_t m_u64Min;  // smallest value
+    uint64_t m_u64Max;  // largest value
+    double m_dSum;  // sum of the values (for the mean)
+    double m_dSquares;  // sum of the squared values (for the deviation)
+public:
+    CHistogram();
+    virtual ~CHistogram() {};
+
+    void Add(uint64_t u64Value);        // count a value
+    void Reset();                       // clear all counts
+
+    uint64_t Count() const { return m_u64Count; }
+    uint64_t Min() const { return m_u64Count ? m_u64Min : 0U; }
+    uint64_t Max() const { return m_u64Max; }
+    double Mean() const { return m_u64Count ? m_dSum / (double)m_u64Count : 0.; }
+    double Deviation() const;
+    uint64_t Percentile(double dPercent) const;  // highest value of the bucket (at most Max)
+
+    void Print(FILE *stream, double dScale = 1.) const;  // percentile distribution (values / dScale)
+private:
+    static unsigned Index(uint64_t u64Value);
+    static uint64_t Lowest(unsigned uIndex);
+    static uint64_t Highest(unsigned uIndex);
+    uint64_t Rank(double dPercent, uint64_t &u64Total) const;
+};
+
+#endif // HISTOGRAM_H_INCLUDED
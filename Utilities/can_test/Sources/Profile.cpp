@@ -0,0 +1,193 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  Software for Industrial Communication, Motion Control and Automation
+//
+//  Copyright (c) 2021 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This class is dual-licensed under the BSD 2-Clause "Simplified" License and
+//  under the GNU General Public License v3.0 (or any later version).
+//  You can choose between one of them if you use this class.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS CLASS IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF THIS CLASS, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  This class is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This class is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this class.  If not, see <http://www.gnu.org/licenses/>.
+#include "Profile.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define MAX_LINE  1024
+#define MAX_FIELDS  8
+
+static char *trim(char *string) {
+    char *end;
+
+    while(isspace((unsigned char)*string))
+        string++;
+    end = string + strlen(string);
+    while((end > string) && isspace((unsigned char)end[-1]))
+        *--end = '\0';
+    return string;
+}
+
+int CProfile::Load(const char *pszFilename) {
+    char szLine[MAX_LINE], *pszLine;
+    int nLine = 0;
+    bool fFirst = true;
+    SStream stream;
+    FILE *fp;
+
+    if((fp = fopen(pszFilename, "r")) == NULL)
+        return -1;
+    m_Streams.clear();
+    while(fgets(szLine, MAX_LINE, fp) != NULL) {
+        nLine++;
+        szLine[strcspn(szLine, "#;\r\n")] = '\0';
+        pszLine = trim(szLine);
+        if(!*pszLine)
+            continue;  // empty line or comment
+        bool fHeading = fFirst && isalpha((unsigned char)*pszLine);
+        fFirst = false;
+        if(!ParseLine(pszLine, stream)) {
+            if(fHeading)
+                continue;  // heading (first line only, e.g. 'id,length,...')
+            fclose(fp);
+            return nLine;
+        }
+        m_Streams.push_back(stream);
+    }
+    fclose(fp);
+    return 0;
+}
+
+bool CProfile::ParseLine(char *pszLine, SStream &stream) {
+    char *field[MAX_FIELDS], *end;
+    int n = 0;
+
+    for(field[n++] = pszLine; *pszLine && (n <= MAX_FIELDS); pszLine++) {
+        if(*pszLine == ',') {
+            *pszLine = '\0';
+            if(n < MAX_FIELDS)
+                field[n] = pszLine + 1;
+            n++;
+        }
+    }
+    if((n < 2) || (n > MAX_FIELDS))
+        return false;
+    for(int i = 0; i < n; i++)
+        field[i] = trim(field[i]);
+    memset(&stream, 0, sizeof(stream));
+    stream.length = 8U;
+    stream.burst = 1U;
+    // <can-id> as C number or with suffix 'h' (hexadecimal)
+    size_t last = strlen(field[0]) - 1U;
+    bool suffix = (field[0][last] == 'h') || (field[0][last] == 'H');
+    unsigned long id = strtoul(field[0], &end, suffix ? 16 : 0);
+    if((end != (field[0] + last + (suffix ? 0U : 1U))) || !last || (id > 0x1FFFFFFFUL))
+        return false;
+    stream.id = (uint32_t)id;
+    stream.xtd = (id > 0x7FFUL);
+    // <period> and <jitter> in [ms]
+    if(!ParseTime(field[1], stream.period) || !stream.period)
+        return false;
+    if((n > 2) && *field[2] && !ParseTime(field[2], stream.jitter))
+        return false;
+    // <length> in bytes
+    if((n > 3) && *field[3]) {
+        unsigned long length = strtoul(field[3], &end, 10);
+        if(*end || (length > 64UL))
+            return false;
+        stream.length = (uint8_t)length;
+    }
+    // <payload> pattern or bytes
+    if((n > 4) && *field[4]) {
+        if(!strcmp(field[4], "zero"))
+            stream.pattern = PatternZero;
+        else if(!strcmp(field[4], "counter"))
+            stream.pattern = PatternCounter;
+        else if(!strcmp(field[4], "random"))
+            stream.pattern = PatternRandom;
+        else {
+            const char *hex = field[4];
+            size_t i;
+            if((hex[0] == '0') && ((hex[1] == 'x') || (hex[1] == 'X')))
+                hex += 2;
+            for(i = 0; hex[0] && hex[1] && (i < sizeof(stream.data)); i++, hex += 2) {
+                char byte[3] = { hex[0], hex[1], '\0' };
+                if(!isxdigit((unsigned char)hex[0]) || !isxdigit((unsigned char)hex[1]))
+                    return false;
+                stream.data[i] = (uint8_t)strtoul(byte, NULL, 16);
+            }
+            if(*hex || (i > stream.length))
+                return false;
+            stream.pattern = PatternZero;
+        }
+    }
+    // <burst> and <gap> in [ms]
+    if((n > 5) && *field[5]) {
+        unsigned long burst = strtoul(field[5], &end, 10);
+        if(*end || !burst || (burst > 65535UL))
+            return false;
+        stream.burst = (uint32_t)burst;
+    }
+    if((n > 6) && *field[6] && !ParseTime(field[6], stream.gap))
+        return false;
+    // <flags> separated by '+'
+    if((n > 7) && *field[7]) {
+        for(char *flag = strtok(field[7], "+| "); flag; flag = strtok(NULL, "+| ")) {
+            if(!strcmp(flag, "xtd")) stream.xtd = true;
+            else if(!strcmp(flag, "rtr")) stream.rtr = true;
+            else if(!strcmp(flag, "fdf")) stream.fdf = true;
+            else if(!strcmp(flag, "brs")) stream.brs = stream.fdf = true;
+            else return false;
+        }
+        if(stream.rtr && stream.fdf)
+            return false;  // no remote frames in CAN FD
+    }
+    if(!stream.fdf && (stream.length > 8U))
+        return false;
+    return true;
+}
+
+bool CProfile::ParseTime(const char *pszField, uint32_t &u32Time) {
+    char *end;
+    double ms = strtod(pszField, &end);
+
+    if(*end || (ms < 0.) || (ms > 4294967.))
+        return false;
+    u32Time = (uint32_t)(ms * 1000. + .5);  // in [us]
+    return true;
+}
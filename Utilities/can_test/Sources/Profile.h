@@ -0,0 +1,96 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  Software for Industrial Communication, Motion Control and Automation
+//
+//  Copyright (c) 2021 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This class is dual-licensed under the BSD 2-Clause "Simplified" License and
+//  under the GNU General Public License v3.0 (or any later version).
+//  You can choose between one of them if you use this class.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS CLASS IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF THIS CLASS, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  This class is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This class is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this class.  If not, see <http://www.gnu.org/licenses/>.
+#ifndef PROFILE_H_INCLUDED
+#define PROFILE_H_INCLUDED
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// Traffic profile: a CSV file with one message stream per line,
+//   <can-id>,<period>[,<jitter>[,<length>[,<payload>[,<burst>[,<gap>[,<flags>]]]]]]
+// with times in milliseconds (fractions allowed), the payload 'zero',
+// 'counter', 'random' or hexadecimal bytes, the number of messages per
+// period and the gap between them, and flags 'xtd', 'rtr', 'fdf', 'brs'
+// separated by '+'.  Empty lines and comments ('#' or ';') are skipped, so
+// is a heading: a first line starting with a letter that is not a stream.
+class CProfile {
+public:
+    enum EPattern {
+        PatternZero,  // all zero (or the given bytes)
+        PatternCounter,  // up-counter in the first 8 bytes
+        PatternRandom  // random bytes
+    };
+    struct SStream {
+        uint32_t id;  // identifier
+        bool xtd, rtr, fdf, brs;  // frame format
+        uint8_t length;  // data length in bytes
+        EPattern pattern;  // payload pattern
+        uint8_t data[64];  // payload (constant part)
+        uint32_t period;  // in [us]
+        uint32_t jitter;  // in [us]
+        uint32_t burst;  // messages per period
+        uint32_t gap;  // between the messages of a burst in [us]
+    };
+private:
+    std::vector<SStream> m_Streams;
+public:
+    CProfile() {};
+    virtual ~CProfile() {};
+
+    int Load(const char *pszFilename);  // 0 = success, -1 = file error, or the line number of the error
+
+    size_t Count() const { return m_Streams.size(); }
+    const SStream &operator[](size_t nIndex) const { return m_Streams[nIndex]; }
+private:
+    static bool ParseLine(char *pszLine, SStream &stream);
+    static bool ParseTime(const char *pszField, uint32_t &u32Time);
+};
+
+#endif // PROFILE_H_INCLUDED
@@ -0,0 +1,190 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  Software for Industrial Communication, Motion Control and Automation
+//
+//  Copyright (c) 2021 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This class is dual-licensed under the BSD 2-Clause "Simplified" License and
+//  under the GNU General Public License v3.0 (or any later version).
+//  You can choose between one of them if you use this class.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS CLASS IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF THIS CLASS, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  This class is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This class is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this class.  If not, see <http://www.gnu.org/licenses/>.
+#include "Random.h"
+#include "Timer.h"
+
+#include <string.h>
+#include <time.h>
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t splitmix64(uint64_t &x) {
+    uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+CRandom::CRandom(uint64_t u64Seed) {
+    Seed(u64Seed);
+}
+
+void CRandom::Seed(uint64_t u64Seed) {
+    uint64_t x = u64Seed;
+
+    m_u64Seed = u64Seed;
+    for(int i = 0; i < 4; i++)
+        m_u64State[i] = splitmix64(x);  // never all zero
+}
+
+uint64_t CRandom::Next() {
+    uint64_t result = rotl(m_u64State[1] * 5U, 7) * 9U;
+    uint64_t t = m_u64State[1] << 17;
+
+    m_u64State[2] ^= m_u64State[0];
+    m_u64State[3] ^= m_u64State[1];
+    m_u64State[1] ^= m_u64State[2];
+    m_u64State[0] ^= m_u64State[3];
+    m_u64State[2] ^= t;
+    m_u64State[3] = rotl(m_u64State[3], 45);
+    return result;
+}
+
+uint32_t CRandom::Below(uint32_t u32Range) {
+    // multiply-shift with the upper 32 bits (Lemire): no division, no modulo bias worth mentioning
+    return (uint32_t)(((Next() >> 32) * (uint64_t)u32Range) >> 32);
+}
+
+void CRandom::Fill(uint8_t *pBuffer, size_t nLength) {
+    uint64_t u64Bits;
+
+    for(; nLength >= 8U; pBuffer += 8, nLength -= 8U) {
+        u64Bits = Next();
+        memcpy(pBuffer, &u64Bits, 8U);  // byte order does not matter here
+    }
+    if(nLength) {
+        u64Bits = Next();
+        for(size_t i = 0; i < nLength; i++)
+            pBuffer[i] = (uint8_t)(u64Bits >> (i * 8));
+    }
+}
+
+uint64_t CRandom::MakeSeed() {
+    uint64_t x = CTimer::GetTime() ^ ((uint64_t)time(NULL) << 32);
+
+    return splitmix64(x);
+}
+
+bool CWeighted::Add(uint32_t u32Value, uint32_t u32Weight) {
+    for(size_t i = 0; i < m_Values.size(); i++) {
+        if(m_Values[i] == u32Value) {
+            if((m_Weights[i] + u32Weight) < m_Weights[i])
+                return false;
+            m_Weights[i] += u32Weight;
+            return true;
+        }
+    }
+    m_Values.push_back(u32Value);
+    m_Weights.push_back(u32Weight);
+    return true;
+}
+
+bool CWeighted::Build() {
+    size_t n = m_Values.size(), i;
+    std::vector<size_t> small, large;
+    std::vector<double> scaled(n);
+    double total = 0.;
+
+    for(i = 0; i < n; i++)
+        total += (double)m_Weights[i];
+    if(total <= 0.)
+        return false;
+    m_Thresholds.assign(n, 0U);
+    m_Aliases.assign(n, 0U);
+    // each slot keeps its value with probability p*n and lends the rest to a heavier one
+    for(i = 0; i < n; i++) {
+        scaled[i] = (double)m_Weights[i] * (double)n / total;
+        if(scaled[i] < 1.)
+            small.push_back(i);
+        else
+            large.push_back(i);
+    }
+    while(!small.empty() && !large.empty()) {
+        size_t s = small.back(), l = large.back();
+        small.pop_back();
+        m_Thresholds[s] = (uint64_t)(scaled[s] * 4294967296.);
+        m_Aliases[s] = (uint32_t)l;
+        scaled[l] -= 1. - scaled[s];
+        if(scaled[l] < 1.) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    // what is left keeps its own value (rounding errors)
+    for(i = 0; i < small.size(); i++)
+        m_Thresholds[small[i]] = 1ULL << 32;
+    for(i = 0; i < large.size(); i++)
+        m_Thresholds[large[i]] = 1ULL << 32;
+    return true;
+}
+
+void CWeighted::Clear() {
+    m_Values.clear();
+    m_Weights.clear();
+    m_Thresholds.clear();
+    m_Aliases.clear();
+}
+
+uint32_t CWeighted::Max() const {
+    uint32_t u32Max = 0U;
+
+    for(size_t i = 0; i < m_Values.size(); i++)
+        if(m_Values[i] > u32Max)
+            u32Max = m_Values[i];
+    return u32Max;
+}
+
+uint32_t CWeighted::Draw(CRandom &random) const {
+    uint64_t u64Bits = random.Next();
+    // upper half selects the slot, lower half decides between value and alias
+    size_t i = (size_t)(((u64Bits >> 32) * (uint64_t)m_Thresholds.size()) >> 32);
+
+    if((u64Bits & 0xFFFFFFFFU) < m_Thresholds[i])
+        return m_Values[i];
+    else
+        return m_Values[m_Aliases[i]];
+}
@@ -0,0 +1,100 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  Software for Industrial Communication, Motion Control and Automation
+//
+//  Copyright (c) 2021 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This class is dual-licensed under the BSD 2-Clause "Simplified" License and
+//  under the GNU General Public License v3.0 (or any later version).
+//  You can choose between one of them if you use this class.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  THIS CLASS IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF THIS CLASS, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  This class is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This class is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this class.  If not, see <http://www.gnu.org/licenses/>.
+#ifndef RANDOM_H_INCLUDED
+#define RANDOM_H_INCLUDED
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// Pseudo-random number generator xoshiro256** (Blackman & Vigna): 256 bits
+// of state, seeded from a 64-bit value with splitmix64, so that a run can be
+// repeated with the same seed.  Not for cryptographic use.
+class CRandom {
+private:
+    uint64_t m_u64State[4];  // generator state (never all zero)
+    uint64_t m_u64Seed;  // seed of the sequence
+public:
+    CRandom(uint64_t u64Seed = 0U);
+    virtual ~CRandom() {};
+
+    void Seed(uint64_t u64Seed);        // restart the sequence
+    uint64_t GetSeed() const { return m_u64Seed; }
+
+    uint64_t Next();                    // 64 random bits
+    uint32_t Below(uint32_t u32Range);  // in [0, u32Range)
+    bool Chance(uint32_t u32Percent) { return Below(100U) < u32Percent; }
+    void Fill(uint8_t *pBuffer, size_t nLength);  // random bytes
+
+    static uint64_t MakeSeed();         // from the clocks (when no seed is given)
+};
+
+// Weighted choice between values (alias method by Walker and Vose): after
+// Build() a value is drawn with one random number in constant time.
+class CWeighted {
+private:
+    std::vector<uint32_t> m_Values;  // values to choose from
+    std::vector<uint32_t> m_Weights;  // their weights
+    std::vector<uint64_t> m_Thresholds;  // keep the value below this (scaled to 2^32)
+    std::vector<uint32_t> m_Aliases;  // otherwise take this one
+public:
+    CWeighted() {};
+    virtual ~CWeighted() {};
+
+    bool Add(uint32_t u32Value, uint32_t u32Weight);  // add up the weight of a value
+    bool Build();                       // make the alias table (false if no weight)
+    void Clear();
+
+    bool IsEmpty() const { return m_Values.empty(); }
+    size_t Count() const { return m_Values.size(); }
+    uint32_t Max() const;               // highest value
+    uint32_t Draw(CRandom &random) const;  // a value (requires Build)
+};
+
+#endif // RANDOM_H_INCLUDED
@@ -54,6 +54,7 @@ static char THIS_FILE[]=__FILE__;
 #if !defined(_WIN32) && !defined(_WIN64)
 #include <unistd.h>
 #include <sys/time.h>
+#include <time.h>
 #endif
 
 // TODO: replace `gettimeofday' by `clock_gettime' and `usleep' by `clock_nanosleep'
@@ -173,4 +174,26 @@ bool CTimer::Delay(uint32_t u32Microseconds) {
 #endif
 }
 
+uint64_t CTimer::GetTime() {
+#if !defined(_WIN32) && !defined(_WIN64)
+    struct timespec ts;
+# if defined(CLOCK_MONOTONIC_RAW)
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);  // not slewed by NTP
+# else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+# endif
+    return ((uint64_t)ts.tv_sec * (uint64_t)1000000000) + (uint64_t)ts.tv_nsec;
+#else
+    LARGE_INTEGER largeFrequency;  // frequency in counts per second
+    LARGE_INTEGER largeCounter;    // high-resolution performance counter
+
+    if(!QueryPerformanceFrequency(&largeFrequency) || !QueryPerformanceCounter(&largeCounter))
+        return 0;
+    // seconds and remainder separately (no overflow of the 64-bit product)
+    return ((uint64_t)(largeCounter.QuadPart / largeFrequency.QuadPart) * (uint64_t)1000000000)
+         + ((uint64_t)(largeCounter.QuadPart % largeFrequency.QuadPart) * (uint64_t)1000000000)
+                                                                        / (uint64_t)largeFrequency.QuadPart;
+#endif
+}
+
 // $Id: Timer.cpp 710 2021-05-25 15:35:30Z eris $  Copyright (c) UV Software, Berlin //
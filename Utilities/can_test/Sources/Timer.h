@@ -80,6 +80,7 @@ public:
     bool Timeout();                     // time-out occurred?
 
     static bool Delay(uint32_t u32Delay); // delay timer
+    static uint64_t GetTime();            // monotonic time in nanoseconds
 };
 
 #endif // TIMER_H_INCLUDED
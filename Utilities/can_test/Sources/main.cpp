@@ -53,7 +53,12 @@ static const char LICENSE[]     = "This program is free software: you can redist
 
 #include "PeakCAN_Defines.h"
 #include "PeakCAN.h"
+#include "PeakCAN_Scheduler.h"
+#include "PeakCAN_BusLoad.h"
 #include "Timer.h"
+#include "Histogram.h"
+#include "Random.h"
+#include "Profile.h"
 
 #include <stdio.h>
 #include <stdint.h>
@@ -63,9 +68,18 @@ static const char LICENSE[]     = "This program is free software: you can redist
 #include <signal.h>
 #include <errno.h>
 #include <time.h>
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 #include <inttypes.h>
 
+#include <vector>
+#include <thread>
+
 #ifdef _MSC_VER
 //not #if defined(_WIN32) || defined(_WIN64) because we have strncasecmp in mingw
 #define strncasecmp _strnicmp
@@ -76,6 +90,15 @@ static const char LICENSE[]     = "This program is free software: you can redist
 #define TxMODE  (1)
 #define TxFRAMES  (2)
 #define TxRANDOM  (3)
+#define TxSEQUENCE  (4)
+#define TxPING  (5)
+#define RxECHO  (6)
+#define TxPROFILE  (7)
+
+#define SEQUENCE_WINDOW  1024U  // sequence numbers remembered per identifier (duplicates)
+#define MAX_IDS  256            // interleaved identifiers of the sequence test
+#define PING_TIMEOUT  100U      // time to wait for a response in [ms]
+#define PING_ERRORS   100U      // failed requests in a row before the test is aborted
 
 extern "C" {
 #include "dosopt.h"
@@ -124,11 +147,22 @@ extern "C" {
 #define LISTBOARDS_CHR  41
 #define TESTBOARDS_STR  42
 #define TESTBOARDS_CHR  43
-#define HELP            44
-#define QUESTION_MARK   45
-#define ABOUT           46
-#define CHARACTER_MJU   47
-#define MAX_OPTIONS     48
+#define SEQUENCE_STR    44
+#define SEQUENCE_CHR    45
+#define IDS_STR         46
+#define PING_STR        47
+#define ECHO_STR        48
+#define PEER_STR        49
+#define POLL_STR        50
+#define CPU_STR         51
+#define SEED_STR        52
+#define WEIGHTS_STR     53
+#define PROFILE_STR     54
+#define HELP            55
+#define QUESTION_MARK   56
+#define ABOUT           57
+#define CHARACTER_MJU   58
+#define MAX_OPTIONS     59
 
 static char* option[MAX_OPTIONS] = {
     (char*)"BAUDRATE", (char*)"bd",
@@ -152,15 +186,37 @@ static char* option[MAX_OPTIONS] = {
     (char*)"CAN-ID", (char*)"id", (char*)"i", (char*)"COP-ID",
     (char*)"LIST-BOARDS", (char*)"list",
     (char*)"TEST-BOARDS", (char*)"test",
+    (char*)"SEQUENCE", (char*)"seq",
+    (char*)"IDS",
+    (char*)"PING",
+    (char*)"ECHO",
+    (char*)"PEER",
+    (char*)"POLL",
+    (char*)"CPU",
+    (char*)"SEED",
+    (char*)"WEIGHTS",
+    (char*)"PROFILE",
     (char*)"HELP", (char*)"?",
     (char*)"ABOUT", (char*)"�"
 };
 
+struct TRandomTraffic {  // random test: weights of identifiers and lengths, flags in [%]
+    uint64_t seed;
+    CWeighted ids;
+    CWeighted dlcs;
+    uint32_t xtd, rtr, fdf, brs;
+};
+
 class CCanDriver : public CPeakCAN {
 public:
     uint64_t ReceiverTest(bool checkCounter = false, uint64_t expectedNumber = 0U, bool stopOnError = false);
     uint64_t TransmitterTest(time_t duration, CANAPI_OpMode_t opMode, uint32_t id = 0x100U, uint8_t dlc = 0U, uint32_t delay = 0U, uint64_t offset = 0U);
-    uint64_t TransmitterTest(uint64_t count, CANAPI_OpMode_t opMode, bool random = false, uint32_t id = 0x100U, uint8_t dlc = 0U, uint32_t delay = 0U, uint64_t offset = 0U);
+    uint64_t TransmitterTest(uint64_t count, CANAPI_OpMode_t opMode, const TRandomTraffic *random = NULL, uint32_t id = 0x100U, uint8_t dlc = 0U, uint32_t delay = 0U, uint64_t offset = 0U);
+    uint64_t SequenceTransmitterTest(uint64_t count, CANAPI_OpMode_t opMode, uint32_t id = 0x100U, uint32_t ids = 1U, uint8_t dlc = 8U, uint32_t delay = 0U, uint32_t first = 0U);
+    uint64_t SequenceReceiverTest(uint32_t id = 0x100U, uint32_t ids = 1U, bool stopOnError = false);
+    uint64_t PingPongTest(uint64_t count, CANAPI_OpMode_t opMode, uint32_t id = 0x100U, uint8_t dlc = 8U, uint32_t delay = 0U, bool poll = false);
+    uint64_t EchoResponder(uint32_t id = 0x100U, bool poll = false, bool quiet = false);
+    uint64_t ProfileTest(const CProfile &profile, const CANAPI_BusSpeed_t &speed, time_t duration = 0);
 public:
     static int ListCanDevices(const char *vendor = NULL);
     static int TestCanDevices(CANAPI_OpMode_t opMode, const char *vendor = NULL);
@@ -201,13 +257,17 @@ const CCanDriver::TCanDevice CCanDriver::m_CanDevices[] = {
 };
 
 static void sigterm(int signo);
+static bool pin_thread(int cpu);
+static bool parse_weights(const char *list, TRandomTraffic &traffic);
 static void usage(FILE *stream, const char *program);
 static void version(FILE *stream, const char *program);
 
 static const char *prompt[4] = {"-\b", "/\b", "|\b", "\\\b"};
 static volatile int running = 1;
+static volatile int echoing = 1;
 
 static CCanDriver canDriver = CCanDriver();
+static CCanDriver peerDriver = CCanDriver();
 
 // TODO: this code could be made more C++ alike
 int main(int argc, const char * argv[]) {
@@ -216,6 +276,13 @@ int main(int argc, const char * argv[]) {
     char *optarg;
 
     int channel = 0, hw = 0;
+    int peer = -1;
+    int poll = 0;
+    int cpu = -1;
+    int seed = 0, weights = 0;
+    TRandomTraffic traffic;
+    char *profile_file = NULL;
+    CProfile profile;
     int op = 0, rf = 0, xf = 0, ef = 0, lo = 0, sh = 0;
     int baudrate = CANBDR_250; int bd = 0;
     int mode = RxMODE, m = 0;
@@ -227,6 +294,8 @@ int main(int argc, const char * argv[]) {
     int delay = 0; int t = 0;
     int number = 0; int n = 0;
     int stop_on_error = 0;
+    int sequence = 0;
+    int ids = 1; int k = 0;
     int num_boards = 0;
     int show_version = 0;
     char *device, *firmware, *software;
@@ -237,6 +306,11 @@ int main(int argc, const char * argv[]) {
     opMode.byte = CANMODE_DEFAULT;
     CANAPI_Return_t retVal = 0;
 
+    /* default random traffic */
+    traffic.seed = 0U;
+    traffic.xtd = traffic.rtr = 0U;
+    traffic.fdf = traffic.brs = 100U;
+
     /* default bit-timing */
     CANAPI_BusSpeed_t speed = {};
     (void)CCanDriver::MapIndex2Bitrate(bitrate.index, bitrate);
@@ -649,6 +723,157 @@ int main(int argc, const char * argv[]) {
             num_boards = CCanDriver::TestCanDevices(opMode, getOptionParameter());
             fprintf(stdout, "Number of present CAN interfaces=%i\n", num_boards);
             return (num_boards >= 0) ? 0 : 1;
+        case SEQUENCE_STR:
+        case SEQUENCE_CHR:
+            if ((sequence++)) {
+                fprintf(stderr, "%s: duplicated option /SEQUENCE\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) == NULL)
+                break;  /* receiver: check sequence numbers */
+            if ((m++)) {
+                fprintf(stderr, "%s: duplicated option /SEQUENCE\n", basename(argv[0]));
+                return 1;
+            }
+            if (sscanf_s(optarg, "%i", &txframes) != 1) {
+                fprintf(stderr, "%s: illegal argument for option /SEQUENCE\n", basename(argv[0]));
+                return 1;
+            }
+            if (txframes < 0) {
+                fprintf(stderr, "%s: illegal argument for option /SEQUENCE\n", basename(argv[0]));
+                return 1;
+            }
+            mode = TxSEQUENCE;
+            break;
+        case IDS_STR:
+            if ((k++)) {
+                fprintf(stderr, "%s: duplicated option /IDS\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) == NULL) {
+                fprintf(stderr, "%s: missing argument for option /IDS\n", basename(argv[0]));
+                return 1;
+            }
+            if (sscanf_s(optarg, "%i", &ids) != 1) {
+                fprintf(stderr, "%s: illegal argument for option /IDS\n", basename(argv[0]));
+                return 1;
+            }
+            if ((ids < 1) || (MAX_IDS < ids)) {
+                fprintf(stderr, "%s: illegal argument for option /IDS\n", basename(argv[0]));
+                return 1;
+            }
+            break;
+        case PING_STR:
+            if ((m++)) {
+                fprintf(stderr, "%s: duplicated option /PING\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) == NULL) {
+                fprintf(stderr, "%s: missing argument for option /PING\n", basename(argv[0]));
+                return 1;
+            }
+            if (sscanf_s(optarg, "%i", &txframes) != 1) {
+                fprintf(stderr, "%s: illegal argument for option /PING\n", basename(argv[0]));
+                return 1;
+            }
+            if (txframes < 0) {
+                fprintf(stderr, "%s: illegal argument for option /PING\n", basename(argv[0]));
+                return 1;
+            }
+            mode = TxPING;
+            break;
+        case ECHO_STR:
+            if ((m++)) {
+                fprintf(stderr, "%s: duplicated option /ECHO\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) != NULL) {
+                fprintf(stderr, "%s: illegal argument for option /ECHO\n", basename(argv[0]));
+                return 1;
+            }
+            mode = RxECHO;
+            break;
+        case PEER_STR:
+            if (peer >= 0) {
+                fprintf(stderr, "%s: duplicated option /PEER\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) == NULL) {
+                fprintf(stderr, "%s: missing argument for option /PEER\n", basename(argv[0]));
+                return 1;
+            }
+            for (peer = 0; CCanDriver::m_CanDevices[peer].adapter != EOF; peer++) {
+                if (!_stricmp(optarg, CCanDriver::m_CanDevices[peer].name))
+                    break;
+            }
+            if (CCanDriver::m_CanDevices[peer].adapter == EOF) {
+                fprintf(stderr, "%s: illegal argument for option /PEER\n", basename(argv[0]));
+                return 1;
+            }
+            break;
+        case POLL_STR:
+            if (poll) {
+                fprintf(stderr, "%s: duplicated option /POLL\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) != NULL) {
+                fprintf(stderr, "%s: illegal argument for option /POLL\n", basename(argv[0]));
+                return 1;
+            }
+            poll = 1;
+            break;
+        case CPU_STR:
+            if (cpu >= 0) {
+                fprintf(stderr, "%s: duplicated option /CPU\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) == NULL) {
+                fprintf(stderr, "%s: missing argument for option /CPU\n", basename(argv[0]));
+                return 1;
+            }
+            if ((sscanf_s(optarg, "%i", &cpu) != 1) || (cpu < 0) || (cpu > 63)) {
+                fprintf(stderr, "%s: illegal argument for option /CPU\n", basename(argv[0]));
+                return 1;
+            }
+            break;
+        case SEED_STR:
+            if ((seed++)) {
+                fprintf(stderr, "%s: duplicated option /SEED\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) == NULL) {
+                fprintf(stderr, "%s: missing argument for option /SEED\n", basename(argv[0]));
+                return 1;
+            }
+            if (sscanf_s(optarg, "%" SCNu64, &traffic.seed) != 1) {
+                fprintf(stderr, "%s: illegal argument for option /SEED\n", basename(argv[0]));
+                return 1;
+            }
+            break;
+        case WEIGHTS_STR:
+            if ((weights++)) {
+                fprintf(stderr, "%s: duplicated option /WEIGHTS\n", basename(argv[0]));
+                return 1;
+            }
+            if ((optarg = getOptionParameter()) == NULL) {
+                fprintf(stderr, "%s: missing argument for option /WEIGHTS\n", basename(argv[0]));
+                return 1;
+            }
+            if (!parse_weights(optarg, traffic)) {
+                fprintf(stderr, "%s: illegal argument for option /WEIGHTS\n", basename(argv[0]));
+                return 1;
+            }
+            break;
+        case PROFILE_STR:
+            if (profile_file) {
+                fprintf(stderr, "%s: duplicated option /PROFILE\n", basename(argv[0]));
+                return 1;
+            }
+            if ((profile_file = getOptionParameter()) == NULL) {
+                fprintf(stderr, "%s: missing argument for option /PROFILE\n", basename(argv[0]));
+                return 1;
+            }
+            break;
         case HELP:
         case QUESTION_MARK:
             usage(stdout, basename(argv[0]));
@@ -697,25 +922,117 @@ int main(int argc, const char * argv[]) {
         else if (dlc > 12) dlc = 0xA;
         else if (dlc > 8) dlc = 0x9;
     }
+    /* - check sequence test options (sequence number and time-stamp need 8 bytes) */
+    if (sequence && (mode != RxMODE) && (mode != TxSEQUENCE)) {
+        fprintf(stderr, "%s: illegal option /SEQUENCE for this test\n", basename(argv[0]));
+        return 1;
+    }
+    if (k && !sequence) {
+        fprintf(stderr, "%s: option /IDS requires option /SEQUENCE\n", basename(argv[0]));
+        return 1;
+    }
+    if ((mode == TxSEQUENCE) && (dlc < CAN_MAX_DLC)) {
+        fprintf(stderr, "%s: illegal combination of options /SEQUENCE and /DLC (8 bytes at least)\n", basename(argv[0]));
+        return 1;
+    }
+    if (sequence && ((uint32_t)(id + ids - 1) > (uint32_t)CAN_MAX_XTD_ID)) {
+        fprintf(stderr, "%s: illegal combination of options /CAN-ID and /IDS\n", basename(argv[0]));
+        return 1;
+    }
+    /* - check ping-pong test options (sequence number needs 4 bytes) */
+    if ((peer >= 0) && (mode != TxPING)) {
+        fprintf(stderr, "%s: option /PEER requires option /PING\n", basename(argv[0]));
+        return 1;
+    }
+    if ((peer >= 0) && (peer == channel)) {
+        fprintf(stderr, "%s: illegal combination of <interface> and option /PEER\n", basename(argv[0]));
+        return 1;
+    }
+    if ((poll || (cpu >= 0)) && (mode != TxPING) && (mode != RxECHO)) {
+        fprintf(stderr, "%s: option /%s requires option /PING or /ECHO\n", basename(argv[0]), poll ? "POLL" : "CPU");
+        return 1;
+    }
+    if ((mode == TxPING) && (dlc < 4)) {
+        fprintf(stderr, "%s: illegal combination of options /PING and /DLC (4 bytes at least)\n", basename(argv[0]));
+        return 1;
+    }
+    if (((mode == TxPING) || (mode == RxECHO)) && ((uint32_t)id >= (uint32_t)CAN_MAX_XTD_ID)) {
+        fprintf(stderr, "%s: illegal combination of options /CAN-ID and /PING or /ECHO\n", basename(argv[0]));
+        return 1;
+    }
+    /* - check random test options (the seed is printed to repeat a run) */
+    if ((seed || weights) && (mode != TxRANDOM)) {
+        fprintf(stderr, "%s: option /%s requires option /RANDOM\n", basename(argv[0]), seed ? "SEED" : "WEIGHTS");
+        return 1;
+    }
+    if (mode == TxRANDOM) {
+        if (!seed)
+            traffic.seed = CRandom::MakeSeed();
+        if (traffic.ids.IsEmpty())
+            (void)traffic.ids.Add((uint32_t)id, 1U);
+        if (traffic.dlcs.IsEmpty()) {
+            for (int i = dlc; i <= CANFD_MAX_DLC; i++)
+                (void)traffic.dlcs.Add((uint32_t)i, 1U);
+        }
+        else if (!opMode.fdoe && (traffic.dlcs.Max() > CAN_MAX_DLC)) {
+            fprintf(stderr, "%s: illegal combination of options /MODE and /WEIGHTS\n", basename(argv[0]));
+            return 1;
+        }
+        if (!traffic.ids.Build() || !traffic.dlcs.Build()) {
+            fprintf(stderr, "%s: illegal argument for option /WEIGHTS (no weight)\n", basename(argv[0]));
+            return 1;
+        }
+    }
+    /* - check and load the traffic profile (duration from /TRANSMIT, if any) */
+    if (profile_file) {
+        if (((mode != RxMODE) && (mode != TxMODE)) || ((mode == RxMODE) && m)) {
+            fprintf(stderr, "%s: option /PROFILE can only be combined with option /TRANSMIT\n", basename(argv[0]));
+            return 1;
+        }
+        if ((i = profile.Load(profile_file)) != 0) {
+            if (i < 0)
+                fprintf(stderr, "%s: profile '%s' could not be read\n", basename(argv[0]), profile_file);
+            else
+                fprintf(stderr, "%s: syntax error in profile '%s' (line %i)\n", basename(argv[0]), profile_file, i);
+            return 1;
+        }
+        if (!profile.Count()) {
+            fprintf(stderr, "%s: no streams in profile '%s'\n", basename(argv[0]), profile_file);
+            return 1;
+        }
+        for (i = 0; i < (int)profile.Count(); i++) {
+            if (profile[i].fdf && !opMode.fdoe) {
+                fprintf(stderr, "%s: CAN FD stream in profile requires option /MODE=FDF (stream %i)\n", basename(argv[0]), i + 1);
+                return 1;
+            }
+            if (profile[i].brs && !opMode.brse) {
+                fprintf(stderr, "%s: bit-rate switching in profile requires option /MODE=FDF+BRS (stream %i)\n", basename(argv[0]), i + 1);
+                return 1;
+            }
+        }
+        if (mode == RxMODE)
+            txtime = 0;  /* until ^C */
+        mode = TxPROFILE;
+    }
     /* - check bit-timing index (n/a for CAN FD) */
     if (opMode.fdoe && (bitrate.btr.frequency <= 0)) {
         fprintf(stderr, "%s: illegal combination of options /MODE and /BAUDRATE\n", basename(argv[0]));
         return 1;
     }
     /* - check operation mode flags */
-    if ((mode != RxMODE) && opMode.mon) {
+    if ((mode != RxMODE) && (mode != RxECHO) && opMode.mon) {
         fprintf(stderr, "%s: illegal option /MON:YES alias /LISTEN-ONLY for transmitter test\n", basename(argv[0]));
         return 1;
     }
-    if ((mode != RxMODE) && opMode.err) {
+    if ((mode != RxMODE) && (mode != RxECHO) && opMode.err) {
         fprintf(stderr, "%s: illegal option /ERR:YES alias /ERROR-FRAMES for transmitter test\n", basename(argv[0]));
         return 1;
     }
-    if ((mode != RxMODE) && opMode.nxtd) {
+    if ((mode != RxMODE) && (mode != RxECHO) && opMode.nxtd) {
         fprintf(stderr, "%s: illegal option /XTD:NO for transmitter test\n", basename(argv[0]));
         return 1;
     }
-    if ((mode != RxMODE) && opMode.nrtr) {
+    if ((mode != RxMODE) && (mode != RxECHO) && opMode.nrtr) {
         fprintf(stderr, "%s: illegal option /RTR:NO for transmitter test\n", basename(argv[0]));
         return 1;
     }
@@ -811,13 +1128,59 @@ int main(int argc, const char * argv[]) {
         (void)canDriver.TransmitterTest((time_t)txtime, opMode, (uint32_t)id, (uint8_t)dlc, (uint32_t)delay, (uint64_t)number);
         break;
     case TxFRAMES:  /* transmitter test (frames) */
-        (void)canDriver.TransmitterTest((uint64_t)txframes, opMode, false, (uint32_t)id, (uint8_t)dlc, (uint32_t)delay, (uint64_t)number);
+        (void)canDriver.TransmitterTest((uint64_t)txframes, opMode, NULL, (uint32_t)id, (uint8_t)dlc, (uint32_t)delay, (uint64_t)number);
         break;
     case TxRANDOM:  /* transmitter test (random) */
-        (void)canDriver.TransmitterTest((uint64_t)txframes, opMode, true, (uint32_t)id, (uint8_t)dlc, (uint32_t)delay, (uint64_t)number);
+        (void)canDriver.TransmitterTest((uint64_t)txframes, opMode, &traffic, (uint32_t)id, (uint8_t)dlc, (uint32_t)delay, (uint64_t)number);
+        break;
+    case TxSEQUENCE:  /* transmitter test (sequence numbers and time-stamps) */
+        (void)canDriver.SequenceTransmitterTest((uint64_t)txframes, opMode, (uint32_t)id, (uint32_t)ids, (uint8_t)dlc, (uint32_t)delay, (uint32_t)number);
+        break;
+    case TxPING:    /* round-trip test (with an echo responder on the peer interface or elsewhere) */
+        if (peer >= 0) {
+            fprintf(stdout, "Peer=%s...", CCanDriver::m_CanDevices[peer].name);
+            fflush(stdout);
+            if (((retVal = peerDriver.InitializeChannel(CCanDriver::m_CanDevices[peer].adapter, opMode)) != CCANAPI::NoError) ||
+                ((retVal = peerDriver.StartController(bitrate)) != CCANAPI::NoError)) {
+                fprintf(stdout, "FAILED!\n");
+                fprintf(stderr, "+++ error: CAN Controller of the peer could not be started (%i)\n", retVal);
+                (void)peerDriver.TeardownChannel();
+                goto teardown;
+            }
+            fprintf(stdout, "OK!\n");
+        }
+        {
+            std::thread responder;
+            if (peer >= 0)
+                responder = std::thread([id, poll, cpu]() {
+                    if ((cpu >= 0) && !pin_thread(cpu + 1))
+                        fprintf(stderr, "+++ warning: responder could not be pinned to CPU %i\n", cpu + 1);
+                    (void)peerDriver.EchoResponder((uint32_t)id, (bool)poll, true);
+                });
+            if ((cpu >= 0) && !pin_thread(cpu))
+                fprintf(stderr, "+++ warning: test could not be pinned to CPU %i\n", cpu);
+            (void)canDriver.PingPongTest((uint64_t)txframes, opMode, (uint32_t)id, (uint8_t)dlc, (uint32_t)delay, (bool)poll);
+            if (peer >= 0) {
+                echoing = 0;
+                (void)peerDriver.SignalChannel();
+                responder.join();
+                (void)peerDriver.TeardownChannel();
+            }
+        }
+        break;
+    case TxPROFILE: /* traffic profile (for the given time or until Ctrl+C) */
+        (void)canDriver.ProfileTest(profile, speed, txtime);
+        break;
+    case RxECHO:    /* echo responder for the round-trip test (abort with Ctrl+C) */
+        if ((cpu >= 0) && !pin_thread(cpu))
+            fprintf(stderr, "+++ warning: responder could not be pinned to CPU %i\n", cpu);
+        (void)canDriver.EchoResponder((uint32_t)id, (bool)poll);
         break;
     default:        /* receiver test (abort with Ctrl+C) */
-        (void)canDriver.ReceiverTest((bool)n, (uint64_t)number, (bool)stop_on_error);
+        if (sequence)
+            (void)canDriver.SequenceReceiverTest((uint32_t)id, (uint32_t)ids, (bool)stop_on_error);
+        else
+            (void)canDriver.ReceiverTest((bool)n, (uint64_t)number, (bool)stop_on_error);
         break;
     }
     /* - show interface information */
@@ -973,16 +1336,18 @@ retry_tx_test:
     return frames;
 }
 
-uint64_t CCanDriver::TransmitterTest(uint64_t count, CANAPI_OpMode_t opMode, bool random, uint32_t id, uint8_t dlc, uint32_t delay, uint64_t offset) {
+uint64_t CCanDriver::TransmitterTest(uint64_t count, CANAPI_OpMode_t opMode, const TRandomTraffic *random, uint32_t id, uint8_t dlc, uint32_t delay, uint64_t offset) {
     CANAPI_Message_t message;
     CANAPI_Return_t retVal;
+    CRandom prng(random ? random->seed : 0U);
 
     time_t start = time(NULL);
     uint64_t frames = 0;
     uint64_t errors = 0;
     uint64_t calls = 0;
 
-    srand((unsigned int)time(NULL));
+    if (random)
+        fprintf(stdout, "Seed=%" PRIu64 "\n", prng.GetSeed());
 
     fprintf(stderr, "\nPress ^C to abort.\n");
     message.id  = id;
@@ -1002,9 +1367,18 @@ uint64_t CCanDriver::TransmitterTest(uint64_t count, CANAPI_OpMode_t opMode, boo
         message.data[5] = (uint8_t)((frames + offset) >> 40);
         message.data[6] = (uint8_t)((frames + offset) >> 48);
         message.data[7] = (uint8_t)((frames + offset) >> 56);
-        memset(&message.data[8], 0, CANFD_MAX_LEN - 8);
-        if (random)
-            message.dlc = dlc + (uint8_t)(rand() % ((CANFD_MAX_DLC - dlc) + 1));
+        if (random) {
+            /* identifier, flags and length as weighted, payload random (after the counter) */
+            message.id = random->ids.Draw(prng);
+            message.xtd = ((message.id > CAN_MAX_STD_ID) || prng.Chance(random->xtd)) ? 1 : 0;
+            message.fdf = (opMode.fdoe && prng.Chance(random->fdf)) ? 1 : 0;
+            message.brs = (message.fdf && opMode.brse && prng.Chance(random->brs)) ? 1 : 0;
+            message.rtr = (!message.fdf && prng.Chance(random->rtr)) ? 1 : 0;
+            message.dlc = (uint8_t)random->dlcs.Draw(prng);
+            prng.Fill(&message.data[8], CANFD_MAX_LEN - 8);
+        }
+        else
+            memset(&message.data[8], 0, CANFD_MAX_LEN - 8);
         /* transmit message (repeat when busy) */
 retry_tx_test:
         calls++;
@@ -1017,7 +1391,7 @@ retry_tx_test:
             errors++;
         /* pause between two messages, as you please */
         if (random)
-            CTimer::Delay(CTimer::USEC * (delay + (uint32_t)(rand() % 54945)));
+            CTimer::Delay(CTimer::USEC * (delay + prng.Below(54945U)));
         else
             CTimer::Delay(CTimer::USEC * delay);
         if (!running) {
@@ -1120,6 +1494,425 @@ uint64_t CCanDriver::ReceiverTest(bool checkCounter, uint64_t expectedNumber, bo
     }
 }
 
+uint64_t CCanDriver::SequenceTransmitterTest(uint64_t count, CANAPI_OpMode_t opMode, uint32_t id, uint32_t ids, uint8_t dlc, uint32_t delay, uint32_t first) {
+    CANAPI_Message_t message;
+    CANAPI_Return_t retVal;
+
+    uint64_t start = CTimer::GetTime();
+    uint64_t frames = 0;
+    uint64_t errors = 0;
+    uint64_t calls = 0;
+    uint32_t sequence, stamp;
+
+    fprintf(stderr, "\nPress ^C to abort.\n");
+    memset(&message, 0, sizeof(message));
+    message.xtd = 0;
+    message.rtr = 0;
+    message.fdf = opMode.fdoe;
+    message.brs = opMode.brse;
+    message.dlc = dlc;
+    fprintf(stdout, "\nTransmitting message(s)...");
+    fflush (stdout);
+    while (frames < count) {
+        /* identifiers round-robin, each with its own sequence number */
+        message.id = id + (uint32_t)(frames % ids);
+        sequence = first + (uint32_t)(frames / ids);
+        message.data[0] = (uint8_t)(sequence >> 0);
+        message.data[1] = (uint8_t)(sequence >> 8);
+        message.data[2] = (uint8_t)(sequence >> 16);
+        message.data[3] = (uint8_t)(sequence >> 24);
+        /* transmit message (repeat when busy) */
+retry_seq_test:
+        calls++;
+        stamp = (uint32_t)(CTimer::GetTime() / 1000U);  // TX time-stamp in [us] (modulo 2^32)
+        message.data[4] = (uint8_t)(stamp >> 0);
+        message.data[5] = (uint8_t)(stamp >> 8);
+        message.data[6] = (uint8_t)(stamp >> 16);
+        message.data[7] = (uint8_t)(stamp >> 24);
+        retVal = WriteMessage(message);
+        if (retVal == CCANAPI::NoError)
+            fprintf(stderr, "%s", prompt[(frames++ % 4)]);
+        else if ((retVal == CCANAPI::TransmitterBusy) && running)
+            goto retry_seq_test;
+        else
+            errors++;
+        /* pause between two messages, as you please */
+        CTimer::Delay(delay * CTimer::USEC);
+        if (!running)
+            break;
+    }
+    fprintf(stderr, "\b");
+    fprintf(stdout, "%s\n\n", running ? "OK!" : "STOP!");
+    fprintf(stdout, "Message(s)=%" PRIu64 "\n", frames);
+    fprintf(stdout, "Error(s)=%" PRIu64 "\n", errors);
+    fprintf(stdout, "Call(s)=%" PRIu64 "\n", calls);
+    fprintf(stdout, "Time=%.3fsec\n\n", (double)(CTimer::GetTime() - start) / 1.0E9);
+
+    if (running)
+        CTimer::Delay(1U * CTimer::SEC);  /* afterburner */
+    return frames;
+}
+
+uint64_t CCanDriver::SequenceReceiverTest(uint32_t id, uint32_t ids, bool stopOnError) {
+    struct TSequence {
+        bool synced;                            // first sequence number received
+        uint32_t expected;                      // next sequence number
+        uint64_t received, lost, duplicates, reordered, resyncs;
+        uint32_t seen[SEQUENCE_WINDOW / 32U];   // sequence numbers [expected - window, expected) received
+    };
+    std::vector<TSequence> streams((size_t)ids);
+    CHistogram latency;  // in [us]
+    CANAPI_Message_t message;
+    CANAPI_Return_t retVal;
+
+    uint64_t start = CTimer::GetTime();
+    uint64_t frames = 0U;
+    uint64_t errors = 0U;
+    uint64_t calls = 0U;
+    uint64_t ignored = 0U;
+    uint32_t sequence, stamp, now, i;
+    bool failed = false;
+
+    memset(&streams[0], 0, streams.size() * sizeof(TSequence));
+    fprintf(stderr, "\nPress ^C to abort.\n");
+    fprintf(stdout, "\nReceiving message(s)...");
+    fflush (stdout);
+    while (running && !failed) {
+        retVal = ReadMessage(message);
+        calls++;
+        if (retVal != CCANAPI::NoError) {
+            if (retVal != CCANAPI::ReceiverEmpty)
+                errors++;
+            continue;
+        }
+        now = (uint32_t)(CTimer::GetTime() / 1000U);
+        fprintf(stderr, "%s", prompt[(frames++ % 4)]);
+        if (message.sts || message.rtr || (message.dlc < CAN_MAX_DLC) ||
+            (message.id < id) || (message.id >= (id + ids))) {
+            ignored++;
+            continue;
+        }
+        TSequence &stream = streams[message.id - id];
+        sequence = (uint32_t)message.data[0] | ((uint32_t)message.data[1] << 8) |
+                   ((uint32_t)message.data[2] << 16) | ((uint32_t)message.data[3] << 24);
+        stamp = (uint32_t)message.data[4] | ((uint32_t)message.data[5] << 8) |
+                ((uint32_t)message.data[6] << 16) | ((uint32_t)message.data[7] << 24);
+        latency.Add((uint64_t)(uint32_t)(now - stamp));  // one-way (same host)
+        stream.received++;
+        if (!stream.synced) {
+            stream.synced = true;
+            stream.expected = sequence;
+        }
+        int32_t ahead = (int32_t)(sequence - stream.expected);
+        if (ahead >= 0) {
+            /* in order, or a gap: forget the skipped numbers */
+            uint32_t clear = ((uint32_t)ahead < SEQUENCE_WINDOW) ? ((uint32_t)ahead + 1U) : SEQUENCE_WINDOW;
+            for (i = 0U; i < clear; i++)
+                stream.seen[((stream.expected + i) % SEQUENCE_WINDOW) / 32U] &= ~(1U << ((stream.expected + i) % 32U));
+            stream.lost += (uint64_t)ahead;
+            stream.expected = sequence + 1U;
+            failed = (ahead > 0);
+        }
+        else if ((uint32_t)(-(int64_t)ahead) <= SEQUENCE_WINDOW) {
+            /* behind: received before (duplicate), or late (reordered, not lost) */
+            if (stream.seen[(sequence % SEQUENCE_WINDOW) / 32U] & (1U << (sequence % 32U)))
+                stream.duplicates++;
+            else {
+                stream.reordered++;
+                if (stream.lost)  // counted as lost by the gap
+                    stream.lost--;
+            }
+            failed = true;
+        }
+        else {
+            /* far behind (e.g. transmitter restarted): synchronize again */
+            memset(stream.seen, 0, sizeof(stream.seen));
+            stream.expected = sequence + 1U;
+            stream.resyncs++;
+        }
+        stream.seen[(sequence % SEQUENCE_WINDOW) / 32U] |= (1U << (sequence % 32U));
+        failed = failed && stopOnError;
+    }
+    uint64_t received = 0U, lost = 0U, duplicates = 0U, reordered = 0U, resyncs = 0U;
+    for (i = 0U; i < ids; i++) {
+        received += streams[i].received;
+        lost += streams[i].lost;
+        duplicates += streams[i].duplicates;
+        reordered += streams[i].reordered;
+        resyncs += streams[i].resyncs;
+    }
+    fprintf(stderr, "\b");
+    fprintf(stdout, "%s\n\n", !failed ? "OK!" : "ERROR!");
+    fprintf(stdout, "Message(s)=%" PRIu64 "\n", frames);
+    fprintf(stdout, "Error(s)=%" PRIu64 "\n", errors);
+    fprintf(stdout, "Call(s)=%" PRIu64 "\n", calls);
+    fprintf(stdout, "Time=%.3fsec\n\n", (double)(CTimer::GetTime() - start) / 1.0E9);
+    fprintf(stdout, "Sequence(s)=%" PRIu64 " (ignored=%" PRIu64 ")\n", received, ignored);
+    fprintf(stdout, "Lost=%" PRIu64 "\n", lost);
+    fprintf(stdout, "Duplicate(s)=%" PRIu64 "\n", duplicates);
+    fprintf(stdout, "Reordered=%" PRIu64 "\n", reordered);
+    if (resyncs)
+        fprintf(stdout, "Resync(s)=%" PRIu64 "\n", resyncs);
+    fprintf(stdout, "Latency=%" PRIu64 "us (p50), %" PRIu64 "us (p99), %" PRIu64 "us (max), %.1fus (mean)\n",
+        latency.Percentile(50.), latency.Percentile(99.), latency.Max(), latency.Mean());
+    if (ids > 1U) {
+        for (i = 0U; i < ids; i++)
+            fprintf(stdout, "  %03" PRIX32 "h: received=%" PRIu64 " lost=%" PRIu64 " duplicates=%" PRIu64 " reordered=%" PRIu64 "\n",
+                id + i, streams[i].received, streams[i].lost, streams[i].duplicates, streams[i].reordered);
+    }
+    fprintf(stdout, "\n");
+    return frames;
+}
+
+uint64_t CCanDriver::PingPongTest(uint64_t count, CANAPI_OpMode_t opMode, uint32_t id, uint8_t dlc, uint32_t delay, bool poll) {
+    CHistogram rtt;  // in [ns]
+    CANAPI_Message_t message, response;
+    CANAPI_Return_t retVal;
+
+    uint64_t start = CTimer::GetTime();
+    uint64_t frames = 0U;
+    uint64_t responses = 0U;
+    uint64_t lost = 0U;
+    uint64_t stale = 0U;
+    uint64_t errors = 0U;
+    uint64_t calls = 0U;
+    uint64_t failed = 0U;
+    uint64_t t0, t1, deadline;
+    uint32_t sequence;
+
+    fprintf(stderr, "\nPress ^C to abort.\n");
+    memset(&message, 0, sizeof(message));
+    message.id = id;
+    message.xtd = ((id + 1U) > CAN_MAX_STD_ID) ? 1 : 0;
+    message.rtr = 0;
+    message.fdf = opMode.fdoe;
+    message.brs = opMode.brse;
+    message.dlc = dlc;
+    fprintf(stdout, "\nPinging...");
+    fflush (stdout);
+    while ((frames < count) && (failed < PING_ERRORS) && running) {
+        sequence = (uint32_t)frames;
+        message.data[0] = (uint8_t)(sequence >> 0);
+        message.data[1] = (uint8_t)(sequence >> 8);
+        message.data[2] = (uint8_t)(sequence >> 16);
+        message.data[3] = (uint8_t)(sequence >> 24);
+        /* transmit request (repeat when busy) */
+retry_ping_test:
+        calls++;
+        t0 = CTimer::GetTime();
+        retVal = WriteMessage(message);
+        if ((retVal == CCANAPI::TransmitterBusy) && running)
+            goto retry_ping_test;
+        else if (retVal != CCANAPI::NoError) {
+            errors++;  // counts as an exchange (e.g. bus off)
+            failed++;
+        }
+        else
+            failed = 0U;
+        /* wait for the response (time-out counts as lost) */
+        deadline = t0 + ((uint64_t)PING_TIMEOUT * 1000000U);
+        while (!failed && running) {
+            if ((t1 = CTimer::GetTime()) >= deadline) {
+                lost++;
+                break;
+            }
+            retVal = ReadMessage(response, poll ? 0U : (uint16_t)((deadline - t1 + 999999U) / 1000000U));
+            calls++;
+            if (retVal == CCANAPI::NoError) {
+                t1 = CTimer::GetTime();
+                if (response.sts || response.rtr || (response.id != (id + 1U)))
+                    continue;  // other traffic
+                if ((response.dlc < 4U) ||
+                    ((uint32_t)response.data[0] | ((uint32_t)response.data[1] << 8) |
+                    ((uint32_t)response.data[2] << 16) | ((uint32_t)response.data[3] << 24)) != sequence) {
+                    stale++;  // response to an earlier (lost) request
+                    continue;
+                }
+                rtt.Add(t1 - t0);
+                responses++;
+                break;
+            }
+            else if (retVal != CCANAPI::ReceiverEmpty)
+                errors++;
+        }
+        /* update the prompt only now and then (console output takes time) */
+        if (!(frames++ % 1024U))
+            fprintf(stderr, "%s", prompt[((frames / 1024U) % 4)]);
+        /* pause between two requests, as you please */
+        if (delay)
+            CTimer::Delay(delay * CTimer::USEC);
+    }
+    fprintf(stderr, "\b");
+    fprintf(stdout, "%s\n\n", (failed >= PING_ERRORS) ? "FAILED!" : running ? "OK!" : "STOP!");
+    if (failed >= PING_ERRORS)
+        fprintf(stderr, "+++ error: %" PRIu64 " requests in a row could not be sent (%i)\n", failed, retVal);
+    fprintf(stdout, "Message(s)=%" PRIu64 "\n", frames);
+    fprintf(stdout, "Response(s)=%" PRIu64 "\n", responses);
+    fprintf(stdout, "Lost=%" PRIu64 "\n", lost);
+    if (stale)
+        fprintf(stdout, "Stale=%" PRIu64 "\n", stale);
+    fprintf(stdout, "Error(s)=%" PRIu64 "\n", errors);
+    fprintf(stdout, "Call(s)=%" PRIu64 "\n", calls);
+    fprintf(stdout, "Time=%.3fsec\n\n", (double)(CTimer::GetTime() - start) / 1.0E9);
+    fprintf(stdout, "Round-trip time in [us]:\n");
+    rtt.Print(stdout, 1000.);
+    fprintf(stdout, "\n");
+    return frames;
+}
+
+uint64_t CCanDriver::EchoResponder(uint32_t id, bool poll, bool quiet) {
+    CANAPI_Message_t message;
+    CANAPI_Return_t retVal;
+
+    uint64_t start = CTimer::GetTime();
+    uint64_t frames = 0U;
+    uint64_t errors = 0U;
+    uint64_t calls = 0U;
+    uint64_t ignored = 0U;
+
+    if (!quiet) {
+        fprintf(stderr, "\nPress ^C to abort.\n");
+        fprintf(stdout, "\nEchoing message(s)...");
+        fflush (stdout);
+    }
+    while (running && echoing) {
+        retVal = ReadMessage(message, poll ? 0U : CANREAD_INFINITE);
+        calls++;
+        if (retVal != CCANAPI::NoError) {
+            if (retVal != CCANAPI::ReceiverEmpty)
+                errors++;
+            continue;
+        }
+        if (message.sts || message.rtr || (message.id != id)) {
+            ignored++;
+            continue;
+        }
+        /* reply with the next identifier and the same data */
+        message.id = id + 1U;
+retry_echo_test:
+        calls++;
+        retVal = WriteMessage(message);
+        if (retVal == CCANAPI::NoError) {
+            if (!(frames++ % 1024U) && !quiet)
+                fprintf(stderr, "%s", prompt[((frames / 1024U) % 4)]);
+        }
+        else if ((retVal == CCANAPI::TransmitterBusy) && running && echoing)
+            goto retry_echo_test;
+        else
+            errors++;
+    }
+    if (!quiet) {
+        fprintf(stderr, "\b");
+        fprintf(stdout, "STOP!\n\n");
+        fprintf(stdout, "Message(s)=%" PRIu64 " (ignored=%" PRIu64 ")\n", frames, ignored);
+        fprintf(stdout, "Error(s)=%" PRIu64 "\n", errors);
+        fprintf(stdout, "Call(s)=%" PRIu64 "\n", calls);
+        fprintf(stdout, "Time=%.3fsec\n\n", (double)(CTimer::GetTime() - start) / 1.0E9);
+    }
+    return frames;
+}
+
+uint64_t CCanDriver::ProfileTest(const CProfile &profile, const CANAPI_BusSpeed_t &speed, time_t duration) {
+    struct TStream {  // scheduled stream
+        int handle;
+        uint32_t phase;  // in [us]
+        uint64_t frame;  // frame length in [ns]
+        CPeakCANScheduler::SStatistics stats;
+    };
+    std::vector<TStream> streams(profile.Count());
+    CRandom prng(CRandom::MakeSeed());
+    CANAPI_Message_t message;
+    uint32_t tick = 1000U;
+    size_t i, n = profile.Count();
+
+    /* scheduler tick of 1ms, or 100us when a time has a fraction of a millisecond */
+    for (i = 0; i < n; i++)
+        if ((profile[i].period % 1000U) || (profile[i].jitter % 1000U) || (profile[i].gap % 1000U))
+            tick = 100U;
+    CPeakCANScheduler scheduler(*this, tick);
+
+    double load = 0.;
+    for (i = 0; i < n; i++) {
+        const CProfile::SStream &stream = profile[i];
+        memset(&message, 0, sizeof(message));
+        message.id = stream.id;
+        message.xtd = stream.xtd ? 1 : 0;
+        message.rtr = stream.rtr ? 1 : 0;
+        message.fdf = stream.fdf ? 1 : 0;
+        message.brs = stream.brs ? 1 : 0;
+        message.dlc = CCANAPI::Len2Dlc(stream.length);
+        memcpy(message.data, stream.data, sizeof(stream.data));
+        CPeakCANScheduler::Update update;
+        if (stream.pattern == CProfile::PatternCounter) {
+            uint8_t bytes = (stream.length < 8U) ? stream.length : 8U;
+            memset(message.data, 0xFF, bytes);  // first update makes it zero
+            update = [bytes](CANAPI_Message_t &msg) {
+                for (uint8_t k = 0U; (k < bytes) && !++msg.data[k]; k++);
+            };
+        }
+        else if (stream.pattern == CProfile::PatternRandom) {
+            uint8_t bytes = stream.length;
+            update = [&prng, bytes](CANAPI_Message_t &msg) {
+                prng.Fill(msg.data, bytes);  // scheduler thread only
+            };
+        }
+        /* spread the streams over their period (a real bus is not synchronized) */
+        streams[i].phase = prng.Below(stream.period);
+        streams[i].frame = CPeakCANBusLoad::Nanoseconds(message, speed);
+        memset(&streams[i].stats, 0, sizeof(streams[i].stats));
+        if (((streams[i].handle = scheduler.Add(message, stream.period, streams[i].phase, update)) < 0) ||
+            (scheduler.SetShape(streams[i].handle, stream.jitter, stream.burst, stream.gap) != CANERR_NOERROR)) {
+            fprintf(stderr, "+++ error: stream %i could not be scheduled (period, jitter and burst)\n", (int)i + 1);
+            return 0U;
+        }
+        load += (double)streams[i].frame * (double)stream.burst / ((double)stream.period * 1000.);
+    }
+    fprintf(stderr, "\nPress ^C to abort.\n");
+    fprintf(stdout, "\nTransmitting profile (%u streams, %.1f%% bus load)...", (unsigned)n, load * 100.);
+    fflush (stdout);
+    uint64_t start = CTimer::GetTime();
+    uint64_t ticks = 0U;
+    (void)scheduler.Start();
+    while (running && (!duration || ((CTimer::GetTime() - start) < ((uint64_t)duration * 1000000000U)))) {
+        CTimer::Delay(100U * CTimer::MSEC);
+        fprintf(stderr, "%s", prompt[(ticks++ % 4)]);
+    }
+    (void)scheduler.Stop();
+    uint64_t elapsed = CTimer::GetTime() - start;
+
+    uint64_t frames = 0U, errors = 0U, late = 0U, skipped = 0U;
+    double achieved = 0.;
+    for (i = 0; i < n; i++) {
+        (void)scheduler.GetStatistics(streams[i].handle, streams[i].stats);
+        frames += streams[i].stats.u64Sent;
+        errors += streams[i].stats.u64Errors;
+        late += streams[i].stats.u64Late;
+        skipped += streams[i].stats.u64Skipped;
+        achieved += (double)streams[i].frame * (double)streams[i].stats.u64Sent;
+    }
+    fprintf(stderr, "\b");
+    fprintf(stdout, "%s\n\n", running ? "OK!" : "STOP!");
+    fprintf(stdout, "Message(s)=%" PRIu64 "\n", frames);
+    fprintf(stdout, "Error(s)=%" PRIu64 "\n", errors);
+    fprintf(stdout, "Late=%" PRIu64 " (skipped=%" PRIu64 ")\n", late, skipped);
+    fprintf(stdout, "Time=%.3fsec\n\n", (double)elapsed / 1.0E9);
+    fprintf(stdout, "Bus load=%.1f%% (configured), %.1f%% (achieved)\n", load * 100., elapsed ? achieved * 100. / (double)elapsed : 0.);
+    /* rate per stream: messages sent compared to the periods since its phase */
+    fprintf(stdout, "  %5s %9s %10s %10s %10s %8s %8s %8s %10s\n", "#", "can-id", "period[ms]", "expected", "sent", "dev[%]", "late", "errors", "jitter[us]");
+    for (i = 0; i < n; i++) {
+        const CProfile::SStream &stream = profile[i];
+        const CPeakCANScheduler::SStatistics &stats = streams[i].stats;
+        uint64_t usec = elapsed / 1000U;
+        uint64_t expected = (usec > streams[i].phase) ? (((usec - streams[i].phase) / stream.period + 1U) * stream.burst) : 0U;
+        double deviation = expected ? ((double)stats.u64Sent - (double)expected) * 100. / (double)expected : 0.;
+        fprintf(stdout, "  %5u %8" PRIX32 "%c %10.3f %10" PRIu64 " %10" PRIu64 " %+8.2f %8" PRIu64 " %8" PRIu64 " %10" PRIu64 "\n",
+            (unsigned)i + 1U, stream.id, stream.xtd ? 'x' : 'h', (double)stream.period / 1000., expected, stats.u64Sent,
+            deviation, stats.u64Late, stats.u64Errors, stats.u64JitterMax);
+    }
+    fprintf(stdout, "\n");
+    return frames;
+}
+
 /** @brief       signal handler to catch Ctrl+C.
  *
  *  @param[in]   signo - signal number (SIGINT, SIGHUP, SIGTERM)
@@ -1128,10 +1921,78 @@ static void sigterm(int signo)
 {
     //fprintf(stderr, "%s: got signal %d\n", __FILE__, signo);
     (void)canDriver.SignalChannel();
+    (void)peerDriver.SignalChannel();
     running = 0;
     (void)signo;
 }
 
+/** @brief       pins the calling thread to a CPU (core).
+ *
+ *  @param[in]   cpu - number of the CPU (0..63)
+ *
+ *  @returns     true if the thread was pinned, otherwise false.
+ */
+static bool pin_thread(int cpu)
+{
+#if defined(_WIN32) || defined(_WIN64)
+    return (SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0) ? true : false;
+#elif defined(__linux__)
+    cpu_set_t cpuset;
+
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    return (pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset) == 0) ? true : false;
+#else
+    (void)cpu;
+    return false;  // not supported
+#endif
+}
+
+/** @brief       parses the weights of the random test.
+ *
+ *  @param[in]   list    - comma-separated list of <key>=<weight>, with key
+ *                         id:<can-id> or dlc:<length> (relative weights),
+ *                         or xtd, rtr, fdf, brs (chance in percent)
+ *  @param[out]  traffic - weights of the random test
+ *
+ *  @returns     true if the list is valid, otherwise false.
+ */
+static bool parse_weights(const char *list, TRandomTraffic &traffic)
+{
+    const char *item = list;
+    char *end;
+    unsigned long key, weight;
+
+    while (*item) {
+        if (!strncmp(item, "id:", 3) || !strncmp(item, "dlc:", 4)) {
+            bool length = (item[0] == 'd');
+            key = strtoul(item + (length ? 4 : 3), &end, 0);
+            if ((*end != '=') || (length ? (key > CANFD_MAX_LEN) : (key > CAN_MAX_XTD_ID)))
+                return false;
+            weight = strtoul(end + 1, &end, 0);
+            if ((weight > UINT32_MAX) || ((*end != ',') && (*end != '\0')))
+                return false;
+            if (!(length ? traffic.dlcs.Add((uint32_t)CCANAPI::Len2Dlc((uint8_t)key), (uint32_t)weight)
+                         : traffic.ids.Add((uint32_t)key, (uint32_t)weight)))
+                return false;
+        }
+        else {
+            uint32_t *chance = !strncmp(item, "xtd=", 4) ? &traffic.xtd :
+                               !strncmp(item, "rtr=", 4) ? &traffic.rtr :
+                               !strncmp(item, "fdf=", 4) ? &traffic.fdf :
+                               !strncmp(item, "brs=", 4) ? &traffic.brs : NULL;
+            if (!chance)
+                return false;
+            weight = strtoul(item + 4, &end, 0);
+            if ((weight > 100U) || ((*end != ',') && (*end != '\0')))
+                return false;
+            *chance = (uint32_t)weight;
+        }
+        item = (*end == ',') ? end + 1 : end;
+    }
+    return true;
+}
+
 /** @brief       shows a help screen with all command-line options.
  *
  *  @param[in]   stream  - output stream (e.g. stdout)
@@ -1149,10 +2010,28 @@ static void usage(FILE *stream, const char *program)
     fprintf(stream, "  %-8s              [/BauDrate=<baudrate> | /BitRate=<bitrate>]\n", "");
     fprintf(stream, "  %-8s <interface>  (/TRANSMIT=<time> | /TX=<time> |\n", program);
     fprintf(stream, "  %-8s               /FRames=<frames> | /RANDom=<frames>)\n", "");
+    fprintf(stream, "  %-8s              [/SEED=<seed>] [/WEIGHTS=<list>]\n", "");
     fprintf(stream, "  %-8s              [/Cycle=<msec> | /Usec=<usec>] [/can-Id=<can-id>]\n", "");
     fprintf(stream, "  %-8s              [/Dlc=<length>] [/Number=<number>]\n", "");
     fprintf(stream, "  %-8s              [/Mode=(2.0|FDf[+BRS])] [/SHARED] [/Verbose]\n", "");
     fprintf(stream, "  %-8s              [/BauDrate=<baudrate> | /BitRate=<bitrate>]\n", "");
+    fprintf(stream, "  %-8s <interface>  (/RECEIVE | /RX) /SEQuence [/can-Id=<can-id>] [/IDS=<ids>]\n", program);
+    fprintf(stream, "  %-8s              [/Stop] [/Mode=(2.0|FDf[+BRS])] [/SHARED] [/Verbose]\n", "");
+    fprintf(stream, "  %-8s              [/BauDrate=<baudrate> | /BitRate=<bitrate>]\n", "");
+    fprintf(stream, "  %-8s <interface>  /SEQuence=<frames> [/can-Id=<can-id>] [/IDS=<ids>]\n", program);
+    fprintf(stream, "  %-8s              [/Cycle=<msec> | /Usec=<usec>] [/Dlc=<length>]\n", "");
+    fprintf(stream, "  %-8s              [/Number=<number>] [/Mode=(2.0|FDf[+BRS])] [/SHARED]\n", "");
+    fprintf(stream, "  %-8s              [/BauDrate=<baudrate> | /BitRate=<bitrate>]\n", "");
+    fprintf(stream, "  %-8s <interface>  /PING=<frames> [/PEER=<interface>] [/can-Id=<can-id>]\n", program);
+    fprintf(stream, "  %-8s              [/POLL] [/CPU=<cpu>] [/Cycle=<msec> | /Usec=<usec>]\n", "");
+    fprintf(stream, "  %-8s              [/Dlc=<length>] [/Mode=(2.0|FDf[+BRS])] [/SHARED]\n", "");
+    fprintf(stream, "  %-8s              [/BauDrate=<baudrate> | /BitRate=<bitrate>]\n", "");
+    fprintf(stream, "  %-8s <interface>  /ECHO [/can-Id=<can-id>] [/POLL] [/CPU=<cpu>]\n", program);
+    fprintf(stream, "  %-8s              [/Mode=(2.0|FDf[+BRS])] [/SHARED]\n", "");
+    fprintf(stream, "  %-8s              [/BauDrate=<baudrate> | /BitRate=<bitrate>]\n", "");
+    fprintf(stream, "  %-8s <interface>  /PROFILE=<file> [/TRANSMIT=<time> | /TX=<time>]\n", program);
+    fprintf(stream, "  %-8s              [/Mode=(2.0|FDf[+BRS])] [/SHARED]\n", "");
+    fprintf(stream, "  %-8s              [/BauDrate=<baudrate> | /BitRate=<bitrate>]\n", "");
 #if (OPTION_CANAPI_LIBRARY != 0)
     fprintf(stream, "  %-8s (/TEST-BOARDS[=<vendor>] | /TEST[=<vendor>])\n", program);
     fprintf(stream, "  %-8s (/LIST-BOARDS[=<vendor>] | /LIST[=<vendor>])\n", program);
@@ -1170,6 +2049,30 @@ static void usage(FILE *stream, const char *program)
     fprintf(stream, "  <can-id>    Send with given identifier (default=100h)\n");
     fprintf(stream, "  <length>    Send data of given length (default=8)\n");
     fprintf(stream, "  <number>    Set first up-counting number (default=0)\n");
+    fprintf(stream, "  <seed>      Repeat a random test (the seed is shown at each start)\n");
+    fprintf(stream, "  <list>      Weights of the random test, comma-separated <key>=<weight>:\n");
+    fprintf(stream, "              id:<can-id>=<weight>  Identifier (relative weight)\n");
+    fprintf(stream, "              dlc:<length>=<weight> Data length (relative weight)\n");
+    fprintf(stream, "              xtd=<percent>         Extended frames (default=0)\n");
+    fprintf(stream, "              rtr=<percent>         Remote frames (default=0)\n");
+    fprintf(stream, "              fdf=<percent>         CAN FD frames (default=100)\n");
+    fprintf(stream, "              brs=<percent>         Bit-rate switching (default=100)\n");
+    fprintf(stream, "  <ids>       Number of interleaved identifiers from <can-id> on (default=1)\n");
+    fprintf(stream, "  /SEQuence   Sequence test: the transmitter sends a sequence number per\n");
+    fprintf(stream, "              identifier and a time-stamp (8 bytes at least), the receiver\n");
+    fprintf(stream, "              reports lost, duplicated and reordered messages and the\n");
+    fprintf(stream, "              latency (both programs on the same computer)\n");
+    fprintf(stream, "  /PING       Round-trip test: sends requests with a sequence number (4 bytes\n");
+    fprintf(stream, "              at least) one at a time and waits for the response <can-id>+1\n");
+    fprintf(stream, "              from /ECHO (elsewhere) or from /PEER (in the same program)\n");
+    fprintf(stream, "  /POLL       Poll for messages instead of waiting (lower latency, busy CPU)\n");
+    fprintf(stream, "  <cpu>       Pin the test to this CPU (and the peer to the next one)\n");
+    fprintf(stream, "  <file>      Traffic profile (CSV) with one message stream per line:\n");
+    fprintf(stream, "              <can-id>,<period>[,<jitter>[,<length>[,<payload>[,<burst>\n");
+    fprintf(stream, "              [,<gap>[,<flags>]]]]]] - times in milliseconds, payload\n");
+    fprintf(stream, "              zero, counter, random or hex. bytes, burst messages per\n");
+    fprintf(stream, "              period with gap in between, flags xtd, rtr, fdf, brs (+);\n");
+    fprintf(stream, "              the rate deviation per stream is reported at the end\n");
     fprintf(stream, "  <interface> CAN interface board (list all with /LIST)\n");
     fprintf(stream, "  <baudrate>  CAN baud rate index (default=3):\n");
     fprintf(stream, "              0 = 1000 kbps\n");